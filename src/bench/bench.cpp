@@ -4,6 +4,9 @@
 
 #include "bench.h"
 
+#include <univalue.h>
+
+#include <algorithm>
 #include <iostream>
 #include <sys/time.h>
 
@@ -23,9 +26,12 @@ BenchRunner::BenchRunner(std::string name, BenchFunction func)
 }
 
 void
-BenchRunner::RunAll(double elapsedTimeForOne)
+BenchRunner::RunAll(double elapsedTimeForOne, bool fJson)
 {
-    std::cout << "Benchmark" << "," << "count" << "," << "min" << "," << "max" << "," << "average" << "\n";
+    UniValue results(UniValue::VARR);
+
+    if (!fJson)
+        std::cout << "Benchmark" << "," << "count" << "," << "min" << "," << "median" << "," << "p99" << "," << "max" << "," << "average" << "\n";
 
     for (std::map<std::string,BenchFunction>::iterator it = benchmarks.begin();
          it != benchmarks.end(); ++it) {
@@ -33,6 +39,29 @@ BenchRunner::RunAll(double elapsedTimeForOne)
         State state(it->first, elapsedTimeForOne);
         BenchFunction& func = it->second;
         func(state);
+
+        const Result& r = state.result;
+        if (!fJson) {
+            std::cout << r.name << "," << r.count << "," << r.min << "," << r.median << "," << r.p99 << "," << r.max << "," << r.average << "\n";
+            continue;
+        }
+
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("name", r.name));
+        entry.push_back(Pair("count", r.count));
+        entry.push_back(Pair("min", r.min));
+        entry.push_back(Pair("median", r.median));
+        entry.push_back(Pair("p99", r.p99));
+        entry.push_back(Pair("max", r.max));
+        entry.push_back(Pair("average", r.average));
+        results.push_back(entry);
+    }
+
+    if (fJson) {
+        UniValue doc(UniValue::VOBJ);
+        doc.push_back(Pair("unit", "seconds"));
+        doc.push_back(Pair("benchmarks", results));
+        std::cout << doc.write(2) << "\n";
     }
 }
 
@@ -53,7 +82,9 @@ bool State::KeepRunning()
         double elapsedOne = (now - lastTime)/timeCheckCount;
         if (elapsedOne < minTime) minTime = elapsedOne;
         if (elapsedOne > maxTime) maxTime = elapsedOne;
-        if (elapsedOne*timeCheckCount < maxElapsed/16) timeCheckCount *= 2;
+        samples.push_back(elapsedOne);
+        // keep the batches short enough to get a few hundred samples for the percentiles
+        if (elapsedOne*timeCheckCount < maxElapsed/256) timeCheckCount *= 2;
     }
     lastTime = now;
     ++count;
@@ -62,9 +93,15 @@ bool State::KeepRunning()
 
     --count;
 
-    // Output results
-    double average = (now-beginTime)/count;
-    std::cout << name << "," << count << "," << minTime << "," << maxTime << "," << average << "\n";
+    // Collect results
+    std::sort(samples.begin(), samples.end());
+    result.name = name;
+    result.count = count;
+    result.min = minTime;
+    result.max = maxTime;
+    result.average = (now-beginTime)/count;
+    result.median = samples.empty() ? result.average : samples[samples.size() / 2];
+    result.p99 = samples.empty() ? result.average : samples[(samples.size() * 99) / 100];
 
     return false;
 }
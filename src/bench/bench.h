@@ -7,6 +7,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <boost/function.hpp>
 #include <boost/preprocessor/cat.hpp>
@@ -36,6 +37,14 @@ BENCHMARK(CODE_TO_TIME);
  
 namespace benchmark {
 
+    // Timings of one benchmark in seconds per iteration. median and p99 are taken
+    // over the batches of iterations timed together.
+    struct Result {
+        std::string name;
+        int64_t count;
+        double min, median, p99, max, average;
+    };
+
     class State {
         std::string name;
         double maxElapsed;
@@ -43,7 +52,10 @@ namespace benchmark {
         double lastTime, minTime, maxTime;
         int64_t count;
         int64_t timeCheckCount;
+        std::vector<double> samples;
     public:
+        Result result;
+
         State(std::string _name, double _maxElapsed) : name(_name), maxElapsed(_maxElapsed), count(0) {
             minTime = std::numeric_limits<double>::max();
             maxTime = std::numeric_limits<double>::min();
@@ -61,7 +73,8 @@ namespace benchmark {
     public:
         BenchRunner(std::string name, BenchFunction func);
 
-        static void RunAll(double elapsedTimeForOne=1.0);
+        // Prints one CSV line per benchmark, or a JSON document at the end if fJson is set
+        static void RunAll(double elapsedTimeForOne=1.0, bool fJson=false);
     };
 }
 
@@ -4,18 +4,25 @@
 
 #include "bench.h"
 
+#include "chainparams.h"
 #include "key.h"
+#include "pubkey.h"
 #include "main.h"
 #include "util.h"
 
 int
 main(int argc, char** argv)
 {
+    ParseParameters(argc, argv);
+
     ECC_Start();
+    ECCVerifyHandle verifyHandle;
     SetupEnvironment();
+    SelectParams(CBaseChainParams::MAIN);
     fPrintToDebugLog = false; // don't want to write to debug.log file
 
-    benchmark::BenchRunner::RunAll();
+    // -json prints the results as one JSON document to track them between releases
+    benchmark::BenchRunner::RunAll(1.0, GetBoolArg("-json", false));
 
     ECC_Stop();
 }
@@ -0,0 +1,86 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "blockfactory.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "main.h"
+#include "poc.h"
+#include "random.h"
+#include "txmempool.h"
+#include "utiltime.h"
+
+#define BENCH_MEMPOOL_TXS 4000
+
+/* A synthetic mempool of BENCH_MEMPOOL_TXS transactions with different fees
+ * and priorities on top of a short chain. Every third transaction spends the
+ * output of the one before, so there are ancestors to sort out. */
+class CBenchMempool
+{
+public:
+    std::vector<CBlockIndex> vBlocks;
+    std::vector<uint256> vHashes;
+    CDynamicChainParams dynParamsSaved;
+
+    CBenchMempool() : vBlocks(20), vHashes(20)
+    {
+        dynParamsSaved = dynParams;
+        dynParams.nMaxBlockSize = 1000000;
+
+        for (size_t i = 0; i < vBlocks.size(); i++) {
+            CBlockIndex &index = vBlocks[i];
+            vHashes[i]       = GetRandHash();
+            index.phashBlock = &vHashes[i];
+            index.nHeight    = i;
+            index.pprev      = i ? &vBlocks[i - 1] : NULL;
+            index.nTime      = 1500000000 + i * 180;
+        }
+
+        const unsigned int nHeight = vBlocks.back().nHeight;
+        CScript scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0x42) << OP_EQUALVERIFY << OP_CHECKSIG;
+
+        uint256 hashPrevTx;
+        for (int i = 0; i < BENCH_MEMPOOL_TXS; i++) {
+            const bool fChild = (i % 3) == 2;
+            CMutableTransaction tx;
+            tx.vin.resize(1);
+            tx.vin[0].prevout = COutPoint(fChild ? hashPrevTx : GetRandHash(), 0);
+            tx.vin[0].scriptSig = CScript() << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+            tx.vout.resize(1);
+            tx.vout[0].nValue = 100000 + i;
+            tx.vout[0].scriptPubKey = scriptPubKey;
+
+            const CTransaction txFinal(tx);
+            const CAmount nFee = 1000 + GetRand(50000);
+            const CAmount nInChainInputValue = fChild ? 0 : txFinal.GetValueOut() + nFee;
+            CTxMemPoolEntry entry(txFinal, nFee, GetTime(), GetRand(100000000), nHeight, !fChild, nInChainInputValue, false, 1);
+
+            LOCK(mempool.cs);
+            mempool.addUnchecked(txFinal.GetHash(), entry);
+            hashPrevTx = txFinal.GetHash();
+        }
+    }
+
+    ~CBenchMempool()
+    {
+        mempool.clear();
+        dynParams = dynParamsSaved;
+    }
+};
+
+// filling a block template from the mempool
+static void PopulateBlockBench(benchmark::State& state)
+{
+    CBenchMempool pool;
+    CReserveScript feeScript;
+
+    while (state.KeepRunning()) {
+        CBlockTemplate blockTemplate(feeScript, &pool.vBlocks.back(), 1, pool.vBlocks.back().nTime + 180, 0, Params());
+        PopulateBlock(blockTemplate);
+        assert(blockTemplate.block.vtx.size() > 1);
+    }
+}
+
+BENCHMARK(PopulateBlockBench);
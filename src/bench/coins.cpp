@@ -0,0 +1,82 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "coins.h"
+#include "random.h"
+
+#include <vector>
+
+#define BENCH_NUM_COINS 200000
+
+/* A coins cache holding BENCH_NUM_COINS unspent transactions
+ * with two outputs each, on top of an empty view */
+class CBenchCoinsCache
+{
+public:
+    CCoinsView viewEmpty;
+    CCoinsViewCache cache;
+    std::vector<uint256> vHashes;
+    std::vector<uint256> vMissing;
+
+    CBenchCoinsCache() : cache(&viewEmpty), vHashes(BENCH_NUM_COINS), vMissing(BENCH_NUM_COINS)
+    {
+        for (int i = 0; i < BENCH_NUM_COINS; i++) {
+            vHashes[i] = GetRandHash();
+            vMissing[i] = GetRandHash();
+
+            CCoinsModifier coins = cache.ModifyCoins(vHashes[i]);
+            coins->nHeight = i;
+            coins->vout.resize(2);
+            coins->vout[0].nValue = 1;
+            coins->vout[1].nValue = 2;
+        }
+    }
+};
+
+static CBenchCoinsCache& GetBenchCoinsCache()
+{
+    static CBenchCoinsCache coinsCache;
+    return coinsCache;
+}
+
+static void CoinsCacheAccessHit(benchmark::State& state)
+{
+    CBenchCoinsCache& coinsCache = GetBenchCoinsCache();
+    unsigned int i = 0;
+    while (state.KeepRunning()) {
+        assert(coinsCache.cache.AccessCoins(coinsCache.vHashes[i]));
+        i = (i + 7919) % BENCH_NUM_COINS;
+    }
+}
+
+static void CoinsCacheAccessMiss(benchmark::State& state)
+{
+    CBenchCoinsCache& coinsCache = GetBenchCoinsCache();
+    unsigned int i = 0;
+    while (state.KeepRunning()) {
+        assert(!coinsCache.cache.AccessCoins(coinsCache.vMissing[i]));
+        i = (i + 7919) % BENCH_NUM_COINS;
+    }
+}
+
+/* Fill a map with 1000 entries and clear it again, as every
+ * short lived cache connecting a block or a transaction does */
+static void CoinsMapInsertClear(benchmark::State& state)
+{
+    CBenchCoinsCache& coinsCache = GetBenchCoinsCache();
+    CCoinsMap mapCoins;
+    while (state.KeepRunning()) {
+        for (int i = 0; i < 1000; i++) {
+            CCoinsCacheEntry& entry = mapCoins[coinsCache.vHashes[i]];
+            entry.coins.nHeight = i;
+            entry.flags = CCoinsCacheEntry::DIRTY;
+        }
+        mapCoins.clear();
+    }
+}
+
+BENCHMARK(CoinsCacheAccessHit);
+BENCHMARK(CoinsCacheAccessMiss);
+BENCHMARK(CoinsMapInsertClear);
@@ -0,0 +1,798 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "blockfactory.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "hash.h"
+#include "main.h"
+#include "poc.h"
+#include "pubkey.h"
+#include "random.h"
+
+#include <secp256k1.h>
+#include <secp256k1_schnorr.h>
+#include <boost/foreach.hpp>
+#include <boost/thread.hpp>
+
+#define BENCH_NUM_CVNS 100
+#define BENCH_CHAIN_LENGTH 200
+
+/* A chain of BENCH_CHAIN_LENGTH blocks created round-robin by
+ * BENCH_NUM_CVNS CVNs where every block misses a few signatures */
+class CBenchCreatorChain
+{
+public:
+    std::vector<CBlockIndex> vBlocks;
+    std::vector<uint256> vHashes;
+    CvnMapType mapCVNsSaved;
+    CDynamicChainParams dynParamsSaved;
+    CCvnSetInfoRef cvnSetInfoSaved;
+
+    CBenchCreatorChain() : vBlocks(BENCH_CHAIN_LENGTH), vHashes(BENCH_CHAIN_LENGTH)
+    {
+        mapCVNsSaved = mapCVNs;
+        dynParamsSaved = dynParams;
+        cvnSetInfoSaved = GetCvnSetInfo();
+
+        mapCVNs.clear();
+        for (uint32_t i = 1; i <= BENCH_NUM_CVNS; i++)
+            mapCVNs[i] = CCvnInfo(i, 0, CSchnorrPubKey());
+
+        dynParams.nBlockSpacing = 180;
+        dynParams.nBlockSpacingGracePeriod = 60;
+        dynParams.nMinSuccessiveSignatures = BENCH_NUM_CVNS / 2;
+        dynParams.nBlocksToConsiderForSigCheck = 144;
+        dynParams.nPercentageOfSignaturesMean = 70;
+
+        boost::shared_ptr<CCvnSetInfo> info(new CCvnSetInfo(*cvnSetInfoSaved));
+        info->mapCVNs = mapCVNs;
+        info->dynParams = dynParams;
+        SetCvnSetInfo(info);
+
+        for (int i = 0; i < BENCH_CHAIN_LENGTH; i++) {
+            CBlockIndex &index = vBlocks[i];
+            vHashes[i]       = GetRandHash();
+            index.phashBlock = &vHashes[i];
+            index.nHeight    = i;
+            index.pprev      = i ? &vBlocks[i - 1] : NULL;
+            index.nTime      = 1500000000 + i * dynParams.nBlockSpacing;
+            index.nStatus    = BLOCK_VALID_SCRIPTS;
+            index.nCreatorId = (i % BENCH_NUM_CVNS) + 1;
+            std::vector<uint32_t> vMissing;
+            for (int j = 0; j < 5; j++)
+                vMissing.push_back(((i * 7 + j * 13) % BENCH_NUM_CVNS) + 1);
+            index.SetMissingSignerIds(vMissing);
+            index.BuildSkip();
+        }
+    }
+
+    ~CBenchCreatorChain()
+    {
+        creatorTracker.SetNull();
+        mapCVNs = mapCVNsSaved;
+        dynParams = dynParamsSaved;
+        SetCvnSetInfo(cvnSetInfoSaved);
+    }
+
+    const CBlockIndex* Tip() const { return &vBlocks.back(); }
+};
+
+// CheckNextBlockCreator() walking back the last blocks for every call
+static void CheckNextBlockCreatorScan(benchmark::State& state)
+{
+    CBenchCreatorChain chain;
+    creatorTracker.SetNull();
+
+    while (state.KeepRunning()) {
+        CheckNextBlockCreator(chain.Tip(), chain.Tip()->nTime + dynParams.nBlockSpacing);
+    }
+}
+
+// CheckNextBlockCreator() answered by the incrementally maintained tracker
+static void CheckNextBlockCreatorTracked(benchmark::State& state)
+{
+    CBenchCreatorChain chain;
+    creatorTracker.SetNull();
+    const uint32_t nScannedCreatorId = CheckNextBlockCreator(chain.Tip(), chain.Tip()->nTime + dynParams.nBlockSpacing);
+
+    BOOST_FOREACH(const CBlockIndex& index, chain.vBlocks)
+        creatorTracker.ConnectTip(&index);
+    assert(CheckNextBlockCreator(chain.Tip(), chain.Tip()->nTime + dynParams.nBlockSpacing) == nScannedCreatorId);
+
+    while (state.KeepRunning()) {
+        CheckNextBlockCreator(chain.Tip(), chain.Tip()->nTime + dynParams.nBlockSpacing);
+    }
+}
+
+// advancing the tracker by one block back and forth (reorg of depth 1)
+static void CreatorTrackerReorg(benchmark::State& state)
+{
+    CBenchCreatorChain chain;
+    BOOST_FOREACH(const CBlockIndex& index, chain.vBlocks)
+        creatorTracker.ConnectTip(&index);
+
+    while (state.KeepRunning()) {
+        creatorTracker.DisconnectTip(chain.Tip());
+        creatorTracker.ConnectTip(chain.Tip());
+    }
+}
+
+/* The creator chain with its CVN set in the CVN info cache, signature checks
+ * consider the last MAX_BLOCKS_TO_CONSIDER_FOR_SIG_CHECK blocks */
+class CBenchSigCheckChain
+{
+public:
+    CBenchCreatorChain chain;
+    CvnInfoCacheType mapCVNInfoCacheSaved;
+    CvnEpochInfoMapType mapCvnEpochInfoSaved;
+
+    CBenchSigCheckChain(const bool fCumulative)
+    {
+        mapCVNInfoCacheSaved = mapCVNInfoCache;
+        mapCvnEpochInfoSaved = mapCvnEpochInfo;
+        mapCVNInfoCache.clear();
+        mapCvnEpochInfo.clear();
+
+        secp256k1_pubkey sum;
+        memset(sum.data, 0, sizeof(sum.data));
+        mapCVNInfoCache[0] = CvnInfoCache(sum, BENCH_NUM_CVNS);
+        mapCvnEpochInfo[chain.vBlocks[0].GetBlockHash()] = mapCVNInfoCache[0];
+        dynParams.nBlocksToConsiderForSigCheck = MAX_BLOCKS_TO_CONSIDER_FOR_SIG_CHECK;
+
+        if (!fCumulative)
+            return;
+
+        bool vWalked[BENCH_NUM_CVNS + 1];
+        for (uint32_t n = 0; n <= BENCH_NUM_CVNS; n++)
+            vWalked[n] = HasEnoughSignatures(Tip(), n);
+
+        BOOST_FOREACH(CBlockIndex& index, chain.vBlocks)
+            SetChainSigs(&index);
+
+        // both ways have to come to the same conclusion
+        for (uint32_t n = 0; n <= BENCH_NUM_CVNS; n++)
+            assert(HasEnoughSignatures(Tip(), n) == vWalked[n]);
+    }
+
+    ~CBenchSigCheckChain()
+    {
+        mapCVNInfoCache = mapCVNInfoCacheSaved;
+        mapCvnEpochInfo = mapCvnEpochInfoSaved;
+    }
+
+    CBlockIndex* Tip() { return &chain.vBlocks.back(); }
+};
+
+// the mean number of signatures summed up block by block
+static void HasEnoughSignaturesWalk(benchmark::State& state)
+{
+    CBenchSigCheckChain chain(false);
+
+    while (state.KeepRunning()) {
+        HasEnoughSignatures(chain.Tip(), BENCH_NUM_CVNS - 5);
+    }
+}
+
+// the mean number of signatures from the cumulative counters of two block indexes
+static void HasEnoughSignaturesCumulative(benchmark::State& state)
+{
+    CBenchSigCheckChain chain(true);
+
+    while (state.KeepRunning()) {
+        HasEnoughSignatures(chain.Tip(), BENCH_NUM_CVNS - 5);
+    }
+}
+
+/* BENCH_NUM_CVNS partial signatures of one signature set */
+class CBenchPartialSigs
+{
+public:
+    uint256 hash;
+    std::vector<CSchnorrSig> vSigs;
+    std::vector<CSchnorrPubKey> vPubKeys;
+    std::vector<CSchnorrNonce> vPubNonces;
+    std::vector<CSchnorrPubKey> vSumOthers;
+    std::vector<uint256> vSecKeys, vSecNonces;
+    CSchnorrPubKey sumAll;
+    CSchnorrPubKey sumPubKeys;
+
+    CBenchPartialSigs() : vSigs(BENCH_NUM_CVNS), vPubKeys(BENCH_NUM_CVNS), vPubNonces(BENCH_NUM_CVNS), vSumOthers(BENCH_NUM_CVNS),
+        vSecKeys(BENCH_NUM_CVNS), vSecNonces(BENCH_NUM_CVNS)
+    {
+        secp256k1_context *ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+        std::vector<const secp256k1_pubkey*> vNoncePtrs(BENCH_NUM_CVNS), vPubKeyPtrs(BENCH_NUM_CVNS);
+
+        hash = GetRandHash();
+        for (int i = 0; i < BENCH_NUM_CVNS; i++) {
+            do {
+                vSecKeys[i] = GetRandHash();
+            } while (!secp256k1_ec_seckey_verify(ctx, vSecKeys[i].begin()));
+            assert(secp256k1_ec_pubkey_create(ctx, (secp256k1_pubkey *)vPubKeys[i].begin(), vSecKeys[i].begin()));
+            assert(secp256k1_schnorr_generate_nonce_pair(ctx, (secp256k1_pubkey *)vPubNonces[i].begin(), vSecNonces[i].begin(), vSecKeys[i].begin(), hash.begin(), NULL, NULL));
+            vNoncePtrs[i] = (const secp256k1_pubkey *)vPubNonces[i].begin();
+            vPubKeyPtrs[i] = (const secp256k1_pubkey *)vPubKeys[i].begin();
+        }
+        assert(secp256k1_ec_pubkey_combine(ctx, (secp256k1_pubkey *)sumAll.begin(), &vNoncePtrs[0], BENCH_NUM_CVNS));
+        assert(secp256k1_ec_pubkey_combine(ctx, (secp256k1_pubkey *)sumPubKeys.begin(), &vPubKeyPtrs[0], BENCH_NUM_CVNS));
+
+        for (int i = 0; i < BENCH_NUM_CVNS; i++) {
+            std::vector<const secp256k1_pubkey*> vOthers(vNoncePtrs);
+            vOthers.erase(vOthers.begin() + i);
+            assert(secp256k1_ec_pubkey_combine(ctx, (secp256k1_pubkey *)vSumOthers[i].begin(), &vOthers[0], vOthers.size()));
+            assert(secp256k1_schnorr_partial_sign(ctx, vSigs[i].begin(), hash.begin(), vSecKeys[i].begin(), (secp256k1_pubkey *)vSumOthers[i].begin(), vSecNonces[i].begin()) == 1);
+        }
+
+        secp256k1_context_destroy(ctx);
+    }
+};
+
+// creating one partial signature
+static void SchnorrPartialSign(benchmark::State& state)
+{
+    CBenchPartialSigs set;
+    secp256k1_context *ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+
+    while (state.KeepRunning()) {
+        CSchnorrSig sig;
+        assert(secp256k1_schnorr_partial_sign(ctx, sig.begin(), set.hash.begin(), set.vSecKeys[0].begin(), (secp256k1_pubkey *)set.vSumOthers[0].begin(), set.vSecNonces[0].begin()) == 1);
+    }
+
+    secp256k1_context_destroy(ctx);
+}
+
+// combining the partial signatures of all CVNs into the chain signature
+static void SchnorrPartialCombine(benchmark::State& state)
+{
+    CBenchPartialSigs set;
+    std::vector<uint8_t*> vSigPtrs;
+    BOOST_FOREACH(CSchnorrSig& sig, set.vSigs)
+        vSigPtrs.push_back(sig.begin());
+
+    while (state.KeepRunning()) {
+        CSchnorrSig allsig;
+        assert(CombinePartialSignatures(allsig, &vSigPtrs[0], vSigPtrs.size()) == 1);
+    }
+}
+
+// verifying the combined chain signature against the sum of the signers public keys
+static void SchnorrVerify(benchmark::State& state)
+{
+    CBenchPartialSigs set;
+    std::vector<uint8_t*> vSigPtrs;
+    BOOST_FOREACH(CSchnorrSig& sig, set.vSigs)
+        vSigPtrs.push_back(sig.begin());
+
+    CSchnorrSig allsig;
+    assert(CombinePartialSignatures(allsig, &vSigPtrs[0], vSigPtrs.size()) == 1);
+
+    while (state.KeepRunning()) {
+        assert(CPubKey::VerifySchnorr(set.hash, allsig, set.sumPubKeys));
+    }
+}
+
+// one EC verification per partial signature
+static void VerifyPartialSigsSingle(benchmark::State& state)
+{
+    CBenchPartialSigs set;
+
+    while (state.KeepRunning()) {
+        for (int i = 0; i < BENCH_NUM_CVNS; i++)
+            assert(CPubKey::VerifyPartialSchnorr(set.hash, set.vSigs[i], set.vPubKeys[i], set.vSumOthers[i]));
+    }
+}
+
+// all partial signatures of the set with one multi-scalar multiplication
+static void VerifyPartialSigsBatch(benchmark::State& state)
+{
+    CBenchPartialSigs set;
+
+    while (state.KeepRunning()) {
+        assert(CPubKey::VerifyPartialSchnorrBatch(set.hash, set.vSigs, set.vPubKeys, set.vPubNonces, set.sumAll));
+    }
+}
+
+// batch verification with one bad signature that is found by bisection
+static void VerifyPartialSigsBatchBisect(benchmark::State& state)
+{
+    CBenchPartialSigs set;
+    set.vSigs[BENCH_NUM_CVNS / 3].begin()[40] ^= 1;
+
+    while (state.KeepRunning()) {
+        std::vector<size_t> vInvalid;
+        assert(!CPubKey::VerifyPartialSchnorrBatch(set.hash, set.vSigs, set.vPubKeys, set.vPubNonces, set.sumAll, &vInvalid));
+        assert(vInvalid.size() == 1 && vInvalid[0] == BENCH_NUM_CVNS / 3);
+    }
+}
+
+/* a CVN set of BENCH_NUM_CVNS CVNs with real public keys of which a few
+ * did not sign the block */
+class CBenchSignerSet
+{
+public:
+    CvnMapType mapCVNsSaved;
+    CvnInfoCacheType mapCVNInfoCacheSaved;
+    CCvnSetInfoRef cvnSetInfoSaved;
+    CBlock block;
+    std::vector<uint32_t> vMissingSignerIds;
+    secp256k1_context *ctx;
+
+    CBenchSignerSet()
+    {
+        mapCVNsSaved = mapCVNs;
+        mapCVNInfoCacheSaved = mapCVNInfoCache;
+        cvnSetInfoSaved = GetCvnSetInfo();
+
+        ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+        block.nVersion |= CBlock::CVN_PAYLOAD;
+
+        for (uint32_t i = 1; i <= BENCH_NUM_CVNS; i++)
+            block.vCvns.push_back(CCvnInfo(i, 0, NewPubKey()));
+
+        assert(AddToCvnInfoCache(&block, 1, block.GetHash()));
+        for (uint32_t i = 0; i < 5; i++)
+            vMissingSignerIds.push_back(i * 17 + 3);
+    }
+
+    CSchnorrPubKey NewPubKey() const
+    {
+        uint256 secKey;
+        CSchnorrPubKey pubKey;
+        do {
+            secKey = GetRandHash();
+        } while (!secp256k1_ec_seckey_verify(ctx, secKey.begin()));
+        assert(secp256k1_ec_pubkey_create(ctx, (secp256k1_pubkey *)pubKey.begin(), secKey.begin()));
+        return pubKey;
+    }
+
+    void Combine(secp256k1_pubkey &sum) const
+    {
+        std::vector<const secp256k1_pubkey *> vPubkeys;
+        BOOST_FOREACH(const CvnMapType::value_type& cvn, mapCVNs) {
+            if (find(vMissingSignerIds.begin(), vMissingSignerIds.end(), cvn.first) == vMissingSignerIds.end())
+                vPubkeys.push_back((const secp256k1_pubkey *)cvn.second.pubKey.begin());
+        }
+        assert(secp256k1_ec_pubkey_combine(ctx, &sum, &vPubkeys[0], vPubkeys.size()));
+    }
+
+    ~CBenchSignerSet()
+    {
+        secp256k1_context_destroy(ctx);
+        signerPubKeyCache.SetNull();
+        mapCVNs = mapCVNsSaved;
+        mapCVNInfoCache = mapCVNInfoCacheSaved;
+        SetCvnSetInfo(cvnSetInfoSaved);
+    }
+};
+
+// combining the public keys of all signers for every block
+static void SignerPubKeyCombine(benchmark::State& state)
+{
+    CBenchSignerSet set;
+
+    while (state.KeepRunning()) {
+        secp256k1_pubkey sum;
+        set.Combine(sum);
+    }
+}
+
+// subtracting the missing signers from the sum of all public keys (cache miss)
+static void SignerPubKeySubtract(benchmark::State& state)
+{
+    CBenchSignerSet set;
+    secp256k1_pubkey sumCombined;
+    set.Combine(sumCombined);
+
+    while (state.KeepRunning()) {
+        secp256k1_pubkey sum;
+        signerPubKeyCache.SetNull();
+        assert(GetSignersPubKey(sum, set.vMissingSignerIds));
+        assert(memcmp(sum.data, sumCombined.data, sizeof(sum.data)) == 0);
+    }
+}
+
+// the combined public key of the signers served from the cache
+static void SignerPubKeyCached(benchmark::State& state)
+{
+    CBenchSignerSet set;
+
+    while (state.KeepRunning()) {
+        secp256k1_pubkey sum;
+        assert(GetSignersPubKey(sum, set.vMissingSignerIds));
+    }
+}
+
+/* the CVN set of set with one CVN replaced by a new one, as it happens when a CVN is admitted */
+static void CvnSetUpdate(benchmark::State& state, const bool fIncremental)
+{
+    CBenchSignerSet set;
+    const CCvnSetInfoRef prev = GetCvnSetInfo();
+    const CCvnSetInfoRef empty(new CCvnSetInfo());
+
+    CBlock blockNext = set.block;
+    blockNext.vCvns[BENCH_NUM_CVNS / 2] = CCvnInfo(BENCH_NUM_CVNS + 1, 0, set.NewPubKey());
+
+    while (state.KeepRunning()) {
+        SetCvnSetInfo(fIncremental ? prev : empty);
+        assert(AddToCvnInfoCache(&blockNext, 2, blockNext.GetHash()));
+    }
+
+    std::vector<const secp256k1_pubkey *> vPubkeys;
+    BOOST_FOREACH(const CCvnInfo& cvnInfo, blockNext.vCvns)
+        vPubkeys.push_back((const secp256k1_pubkey *)cvnInfo.pubKey.begin());
+
+    secp256k1_pubkey sum;
+    assert(secp256k1_ec_pubkey_combine(set.ctx, &sum, &vPubkeys[0], vPubkeys.size()));
+    assert(memcmp(sum.data, GetCvnSetInfo()->sumOfAllPubKeys.data, sizeof(sum.data)) == 0);
+}
+
+// combining all public keys of a new CVN set
+static void CvnSetUpdateFull(benchmark::State& state)
+{
+    CvnSetUpdate(state, false);
+}
+
+// deriving the sum of the public keys of a new CVN set from the previous one
+static void CvnSetUpdateIncremental(benchmark::State& state)
+{
+    CvnSetUpdate(state, true);
+}
+
+/* A set of nCvns CVNs with keys and a current nonce each, ready to sign the
+ * next block of CVN 1 on top of a chain of BENCH_CHAIN_LENGTH blocks */
+class CBenchCvnRound
+{
+public:
+    CBenchCreatorChain chain;
+    CvnInfoCacheType mapCVNInfoCacheSaved;
+    CCvnSetInfoRef cvnSetInfoSaved;
+    CNoncePoolType mapNoncePoolSaved;
+    std::vector<uint256> vSecKeys, vSecNonces;
+    uint256 hashPrevBlock;
+    uint32_t nCreatorId;
+    secp256k1_context *ctx;
+
+    CBenchCvnRound(const int nCvns) : vSecKeys(nCvns), vSecNonces(nCvns), nCreatorId(1)
+    {
+        mapCVNInfoCacheSaved = mapCVNInfoCache;
+        cvnSetInfoSaved = GetCvnSetInfo();
+        mapNoncePoolSaved = mapNoncePool;
+        mapCVNInfoCache.clear();
+        mapNoncePool.clear();
+        nonceSumCache.SetNull();
+
+        CBlockIndex *pindexTip = &chain.vBlocks.back();
+        hashPrevBlock = pindexTip->GetBlockHash();
+        chainActive.SetTip(pindexTip);
+        mapBlockIndex.insert(std::make_pair(hashPrevBlock, pindexTip));
+
+        ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+        CBlock block;
+        block.nVersion |= CBlock::CVN_PAYLOAD;
+
+        for (int i = 0; i < nCvns; i++) {
+            const uint32_t nNodeId = i + 1;
+            CSchnorrPubKey pubKey;
+            do {
+                vSecKeys[i] = GetRandHash();
+            } while (!secp256k1_ec_seckey_verify(ctx, vSecKeys[i].begin()));
+            assert(secp256k1_ec_pubkey_create(ctx, (secp256k1_pubkey *)pubKey.begin(), vSecKeys[i].begin()));
+            block.vCvns.push_back(CCvnInfo(nNodeId, 0, pubKey));
+
+            CNoncePool &pool = mapNoncePool[nNodeId];
+            pool.nCvnId = nNodeId;
+            pool.nHeightAdded = pindexTip->nHeight;
+            pool.vPublicNonces.resize(1);
+            assert(secp256k1_schnorr_generate_nonce_pair(ctx, (secp256k1_pubkey *)pool.vPublicNonces[0].begin(), vSecNonces[i].begin(), vSecKeys[i].begin(), hashPrevBlock.begin(), NULL, NULL));
+        }
+
+        assert(AddToCvnInfoCache(&block, 0, block.GetHash()));
+    }
+
+    ~CBenchCvnRound()
+    {
+        secp256k1_context_destroy(ctx);
+        sigHolder.SetNull();
+        signerPubKeyCache.SetNull();
+        nonceSumCache.SetNull();
+        mapBlockIndex.erase(hashPrevBlock);
+        chainActive.SetTip(NULL);
+        mapCVNInfoCache = mapCVNInfoCacheSaved;
+        SetCvnSetInfo(cvnSetInfoSaved);
+        mapNoncePool = mapNoncePoolSaved;
+    }
+
+    static std::vector<uint32_t> MissingIds(const int nCvns, const int nMissing)
+    {
+        std::vector<uint32_t> vMissing;
+        for (int i = 0; i < nMissing; i++)
+            vMissing.push_back(nCvns - i);
+        return vMissing;
+    }
+
+    /* the partial signatures of all CVNs but the missing ones, created the way CvnSignPartial() does */
+    void Sign(std::vector<CCvnPartialSignature> &vSigs, const std::vector<uint32_t> &vMissing) const
+    {
+        CHashWriter hasher(SER_GETHASH, 0);
+        hasher << hashPrevBlock << nCreatorId;
+        if (!vMissing.empty()) {
+            uint64_t nSumNodeIds = 0;
+            BOOST_FOREACH(const uint32_t nMissingId, vMissing)
+                nSumNodeIds += nMissingId;
+            hasher << nSumNodeIds;
+        }
+        const uint256 hash = hasher.GetHash();
+
+        for (size_t i = 0; i < vSecKeys.size(); i++) {
+            const uint32_t nSignerId = i + 1;
+            if (find(vMissing.begin(), vMissing.end(), nSignerId) != vMissing.end())
+                continue;
+
+            std::vector<const secp256k1_pubkey *> vOthers;
+            BOOST_FOREACH(const CNoncePoolType::value_type &pool, mapNoncePool) {
+                if (pool.first != nSignerId && find(vMissing.begin(), vMissing.end(), pool.first) == vMissing.end())
+                    vOthers.push_back((const secp256k1_pubkey *)pool.second.vPublicNonces[0].begin());
+            }
+
+            secp256k1_pubkey sumOthers;
+            assert(secp256k1_ec_pubkey_combine(ctx, &sumOthers, &vOthers[0], vOthers.size()));
+
+            CCvnPartialSignature sig;
+            sig.nSignerId         = nSignerId;
+            sig.nCreatorId        = nCreatorId;
+            sig.hashPrevBlock     = hashPrevBlock;
+            sig.vMissingSignerIds = vMissing;
+            assert(secp256k1_schnorr_partial_sign(ctx, sig.signature.begin(), hash.begin(), vSecKeys[i].begin(), &sumOthers, vSecNonces[i].begin()) == 1);
+            vSigs.push_back(sig);
+        }
+    }
+
+    void CreateBlock(CBlock &block, const std::vector<uint32_t> &vMissing) const
+    {
+        std::vector<CCvnPartialSignature> vSigs;
+        Sign(vSigs, vMissing);
+
+        std::vector<uint8_t*> vSigPtrs;
+        BOOST_FOREACH(CCvnPartialSignature& sig, vSigs)
+            vSigPtrs.push_back(sig.signature.begin());
+
+        block.hashPrevBlock     = hashPrevBlock;
+        block.nCreatorId        = nCreatorId;
+        block.vMissingSignerIds = vMissing;
+        assert(CombinePartialSignatures(block.chainMultiSig, &vSigPtrs[0], vSigPtrs.size()) == 1);
+    }
+};
+
+// verifying the chain signature of a block of a CVN set of nCvns with nMissing missing signatures
+static void VerifyChainSignature(benchmark::State& state, const int nCvns, const int nMissing)
+{
+    CBenchCvnRound round(nCvns);
+    CBlock block;
+    round.CreateBlock(block, CBenchCvnRound::MissingIds(nCvns, nMissing));
+
+    while (state.KeepRunning()) {
+        assert(CvnVerifyChainSignature(block));
+    }
+}
+
+static void CvnVerifyChainSignature10(benchmark::State& state) { VerifyChainSignature(state, 10, 0); }
+static void CvnVerifyChainSignature50(benchmark::State& state) { VerifyChainSignature(state, 50, 0); }
+static void CvnVerifyChainSignature100(benchmark::State& state) { VerifyChainSignature(state, 100, 0); }
+static void CvnVerifyChainSignature10Missing2(benchmark::State& state) { VerifyChainSignature(state, 10, 2); }
+static void CvnVerifyChainSignature50Missing5(benchmark::State& state) { VerifyChainSignature(state, 50, 5); }
+static void CvnVerifyChainSignature100Missing10(benchmark::State& state) { VerifyChainSignature(state, 100, 10); }
+static void CvnVerifyChainSignature100Missing40(benchmark::State& state) { VerifyChainSignature(state, 100, 40); }
+
+// verifying the partial signatures of all 100 CVNs of a round one by one
+static void VerifyPartialSigsRound(benchmark::State& state, const bool fCached)
+{
+    CBenchCvnRound round(100);
+    std::vector<CCvnPartialSignature> vSigs;
+    round.Sign(vSigs, CBenchCvnRound::MissingIds(100, 2));
+
+    LOCK(cs_main);
+    while (state.KeepRunning()) {
+        BOOST_FOREACH(const CCvnPartialSignature& sig, vSigs) {
+            if (!fCached) {
+                LOCK(cs_mapNoncePool);
+                nonceSumCache.Invalidate();
+            }
+            assert(CvnVerifyPartialSignature(sig));
+        }
+    }
+}
+
+static void VerifyPartialSigsRoundCombine(benchmark::State& state) { VerifyPartialSigsRound(state, false); }
+static void VerifyPartialSigsRoundCached(benchmark::State& state) { VerifyPartialSigsRound(state, true); }
+
+// picking the best of 4 competing signature sets (common Rs) of 50 CVNs, none verified yet
+static void DetermineBestSignatureSetBench(benchmark::State& state)
+{
+    CBenchCvnRound round(50);
+    std::vector<CCvnPartialSignature> vSigs;
+    for (int nMissing = 1; nMissing <= 4; nMissing++)
+        round.Sign(vSigs, CBenchCvnRound::MissingIds(50, nMissing));
+
+    std::vector<uint256> vHashes;
+    BOOST_FOREACH(const CCvnPartialSignature& sig, vSigs)
+        vHashes.push_back(sig.GetHash());
+
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < vSigs.size(); i++)
+            sigHolder.AddSig(vSigs[i], vHashes[i]);
+
+        CBlock block;
+        block.hashPrevBlock = round.hashPrevBlock;
+        block.nCreatorId    = round.nCreatorId;
+        assert(DetermineBestSignatureSet(chainActive.Tip(), &block));
+        assert(block.vMissingSignerIds.size() == 1);
+    }
+}
+
+/* the creator and chain signature checks of a new block of 100 CVNs, as
+ * ProcessNewBlock() hands them to RunPocSignatureChecks() with nThreads
+ * script check threads */
+static void NewBlockPocChecks(benchmark::State& state, const int nThreads)
+{
+    CBenchCvnRound round(100);
+    CBlock block;
+    round.CreateBlock(block, CBenchCvnRound::MissingIds(100, 2));
+
+    const uint256 hashBlock = block.GetHash();
+    assert(secp256k1_schnorr_sign(round.ctx, block.creatorSignature.begin(), hashBlock.begin(), round.vSecKeys[0].begin(), NULL, NULL) == 1);
+
+    std::vector<CPocSignatureCheck> vBlockChecks;
+    CvnMapType::const_iterator it = GetCvnSetInfo()->mapCVNs.find(round.nCreatorId);
+    assert(it != GetCvnSetInfo()->mapCVNs.end());
+    vBlockChecks.push_back(CPocSignatureCheck(hashBlock, block.creatorSignature, it->second.pubKey, round.nCreatorId));
+    assert(CvnVerifyChainSignature(block, &vBlockChecks));
+
+    const int nScriptCheckThreadsSaved = nScriptCheckThreads;
+    nScriptCheckThreads = nThreads > 1 ? nThreads : 0;
+    boost::thread_group threadGroup;
+    for (int i = 0; i < nThreads - 1; i++)
+        threadGroup.create_thread(&ThreadPocSignatureCheck);
+
+    while (state.KeepRunning()) {
+        std::vector<CPocSignatureCheck> vChecks(vBlockChecks);
+        assert(RunPocSignatureChecks(vChecks));
+    }
+
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+    nScriptCheckThreads = nScriptCheckThreadsSaved;
+}
+
+static void NewBlockPocChecksSerial(benchmark::State& state) { NewBlockPocChecks(state, 1); }
+static void NewBlockPocChecksQueue(benchmark::State& state) { NewBlockPocChecks(state, 2); }
+
+/* the partial signatures of BENCH_NUM_CVNS CVNs for 4 signature sets of one
+ * round as they arrive from the network */
+class CBenchSigRound
+{
+public:
+    CvnMapType mapCVNsSaved;
+    uint256 hashPrevBlock;
+    std::vector<CCvnPartialSignature> vSigs;
+    std::vector<uint256> vHashes;
+
+    CBenchSigRound()
+    {
+        mapCVNsSaved = mapCVNs;
+        mapCVNs.clear();
+        for (uint32_t i = 1; i <= BENCH_NUM_CVNS; i++)
+            mapCVNs[i] = CCvnInfo(i, 0, CSchnorrPubKey());
+
+        hashPrevBlock = GetRandHash();
+        for (int nSet = 0; nSet < 4; nSet++) {
+            const uint256 commonRx = GetRandHash();
+            for (uint32_t i = 1; i <= BENCH_NUM_CVNS; i++) {
+                CCvnPartialSignature sig;
+                sig.nSignerId     = i;
+                sig.nCreatorId    = 1;
+                sig.hashPrevBlock = hashPrevBlock;
+                for (int j = 0; j < nSet; j++)
+                    sig.vMissingSignerIds.push_back(BENCH_NUM_CVNS - j);
+                GetRandBytes(sig.signature.begin(), 64);
+                memcpy(sig.signature.begin(), commonRx.begin(), 32);
+
+                vSigs.push_back(sig);
+                vHashes.push_back(sig.GetHash());
+            }
+        }
+    }
+
+    void AddAll()
+    {
+        for (size_t i = 0; i < vSigs.size(); i++)
+            sigHolder.AddSig(vSigs[i], vHashes[i]);
+    }
+
+    ~CBenchSigRound()
+    {
+        sigHolder.SetNull();
+        mapCVNs = mapCVNsSaved;
+    }
+};
+
+// collecting all signatures of a round and dropping the round
+static void SignatureHolderAddClear(benchmark::State& state)
+{
+    CBenchSigRound round;
+
+    while (state.KeepRunning()) {
+        round.AddAll();
+        sigHolder.clear(2);
+    }
+}
+
+// advertising the signatures of a round to a peer
+static void SignatureHolderHashes(benchmark::State& state)
+{
+    CBenchSigRound round;
+    round.AddAll();
+
+    while (state.KeepRunning()) {
+        std::vector<uint256> vHashes;
+        assert(sigHolder.GetSignatureHashes(vHashes, round.hashPrevBlock, 1));
+    }
+}
+
+static void SignatureHolderPoll()
+{
+    while (true) {
+        boost::this_thread::interruption_point();
+        std::vector<std::vector<uint32_t> > vSigSets;
+        sigHolder.HasCompleteSigSets(BENCH_NUM_CVNS);
+        sigHolder.HasSigSetsToContributeTo(vSigSets, BENCH_NUM_CVNS + 1, BENCH_NUM_CVNS);
+    }
+}
+
+// collecting the signatures while another thread polls the holder like the POC thread
+static void SignatureHolderAddContended(benchmark::State& state)
+{
+    CBenchSigRound round;
+    boost::thread poller(SignatureHolderPoll);
+
+    while (state.KeepRunning()) {
+        round.AddAll();
+        sigHolder.clear(2);
+    }
+
+    poller.interrupt();
+    poller.join();
+}
+
+BENCHMARK(SchnorrPartialSign);
+BENCHMARK(SchnorrPartialCombine);
+BENCHMARK(SchnorrVerify);
+BENCHMARK(CheckNextBlockCreatorScan);
+BENCHMARK(CheckNextBlockCreatorTracked);
+BENCHMARK(CreatorTrackerReorg);
+BENCHMARK(HasEnoughSignaturesWalk);
+BENCHMARK(HasEnoughSignaturesCumulative);
+BENCHMARK(VerifyPartialSigsSingle);
+BENCHMARK(VerifyPartialSigsBatch);
+BENCHMARK(VerifyPartialSigsBatchBisect);
+BENCHMARK(SignerPubKeyCombine);
+BENCHMARK(SignerPubKeySubtract);
+BENCHMARK(SignerPubKeyCached);
+BENCHMARK(CvnSetUpdateFull);
+BENCHMARK(CvnSetUpdateIncremental);
+BENCHMARK(CvnVerifyChainSignature10);
+BENCHMARK(CvnVerifyChainSignature50);
+BENCHMARK(CvnVerifyChainSignature100);
+BENCHMARK(CvnVerifyChainSignature10Missing2);
+BENCHMARK(CvnVerifyChainSignature50Missing5);
+BENCHMARK(CvnVerifyChainSignature100Missing10);
+BENCHMARK(CvnVerifyChainSignature100Missing40);
+BENCHMARK(NewBlockPocChecksSerial);
+BENCHMARK(NewBlockPocChecksQueue);
+BENCHMARK(VerifyPartialSigsRoundCombine);
+BENCHMARK(VerifyPartialSigsRoundCached);
+BENCHMARK(DetermineBestSignatureSetBench);
+BENCHMARK(SignatureHolderAddClear);
+BENCHMARK(SignatureHolderHashes);
+BENCHMARK(SignatureHolderAddContended);
@@ -70,7 +70,7 @@ public:
     }
 };
 
-static void PopulateBlock(CBlockTemplate& blocktemplate)
+void PopulateBlock(CBlockTemplate& blocktemplate)
 {
     CBlock *pblock = &blocktemplate.block; // pointer for convenience
 
@@ -361,82 +361,88 @@ static bool AddChainDataToBlock(CBlock *pblock, const CChainDataMsg& msg)
 
 typedef vector<vector<uint32_t> > MissingIdsCandidates;
 
-bool DetermineBestSignatureSet(CBlockIndex * const pindexPrev, CBlock *pblock)
+/**
+ * Tries each signature set of the round of the block. The sets with enough
+ * valid signatures are combined and remembered as candidates. Visit() only
+ * copies the signatures of each set, they are verified by Evaluate() after
+ * the shard locks are released.
+ */
+class CSigSetCandidates : public CSigSetVisitor
 {
-    LOCK(sigHolder.cs_sigHolder);
-
-    if (sigHolder.sigs.empty()) {
-        LogPrintf("Could not find signatures. Can not create block.\n");
-        return false;
-    }
-
-    vector<CSchnorrSig> sigCandidates;
+public:
+    CBlockIndex * const pindexPrev;
+    vector<vector<CCvnPartialSignature> > vSigSets;
+    vector<CSchnorrSig> vSigCandidates;
     MissingIdsCandidates vMissingSignerIdsCandidates;
 
-    /* check each signature set. If it's correct and contains enough sigs remember it */
-    BOOST_FOREACH(const MapSigCommonR::value_type& commonR, sigHolder.sigs) {
-        MapSigSigner *signatures = sigHolder.GetSignatureSet(commonR.first);
-        if (!signatures) {
-            LogPrintf("No signatures found. Trying next set.\n");
-            continue;
+    CSigSetCandidates(CBlockIndex * const pindexPrevIn) : pindexPrev(pindexPrevIn) {}
+
+    bool Visit(CSigRound &round, CSigSet &sigSet)
+    {
+        if (!sigSet.nSigs)
+            return true;
+
+        vSigSets.push_back(vector<CCvnPartialSignature>());
+        vector<CCvnPartialSignature> &vSigs = vSigSets.back();
+        vSigs.reserve(sigSet.nSigs);
+        for (const CSigSlot *slot = round.begin(sigSet); slot != round.end(sigSet); slot++) {
+            if (!slot->IsNull())
+                vSigs.push_back(round.GetSignature(sigSet, *slot));
         }
 
-        const CCvnPartialSignature &firstSig = commonR.second.begin()->second;
-        if (signatures->size() + firstSig.vMissingSignerIds.size() < mapCVNs.size()) {
+        return true;
+    }
+
+    void Evaluate(vector<CCvnPartialSignature> &vSigs)
+    {
+        const vector<uint32_t> &vSetMissingSignerIds = vSigs[0].vMissingSignerIds;
+
+        if (vSigs.size() + vSetMissingSignerIds.size() < mapCVNs.size()) {
             LogPrintf("Not enough signatures found. Trying next set.\n");
-            continue;
+            return;
         }
 
-        if (!HasEnoughSignatures(pindexPrev, signatures->size())) {
+        if (!HasEnoughSignatures(pindexPrev, vSigs.size())) {
             LogPrintf("Not enough signatures to continue blockchain. Trying next set.\n");
-            continue;
+            return;
         }
 
-        int count = 0;
-        bool fAllSigsValid = true;
-        uint8_t *sigs[MAX_NUMBER_OF_CVNS];
-        set<uint32_t> setSigners;
-
-        BOOST_FOREACH(const MapSigSigner::value_type& entry, *signatures) {
-            const CCvnPartialSignature& sig = entry.second;
+        // verify all signatures that have not been validated yet at once
+        vector<CCvnPartialSignature*> vSigsToVerify;
+        BOOST_FOREACH(CCvnPartialSignature &sig, vSigs) {
+            if (!sig.fValidated)
+                vSigsToVerify.push_back(&sig);
+        }
 
-            if (!sig.fValidated && !CvnVerifyPartialSignature(sig)) {
-                LogPrintf("Invalid signature found. Trying next set.\n%s\n", sig.ToString());
-                fAllSigsValid = false;
-                break;
-            }
+        vector<uint32_t> vInvalidSignerIds;
+        const bool fValid = CvnVerifyPartialSignatures(vSigsToVerify, vInvalidSignerIds);
 
-            if (!setSigners.insert(entry.first).second) {
-                LogPrintf("duplicate signature detected: %s\n%s\n", sig.ToString(), sigHolder.ToString());
-                fAllSigsValid = false;
-                break;
-            }
+        BOOST_FOREACH(const CCvnPartialSignature *sig, vSigsToVerify) {
+            if (sig->fValidated)
+                sigHolder.SetValidated(*sig);
+        }
 
-            if (sig.hashPrevBlock != pblock->hashPrevBlock) {
-                LogPrintf("Invalid signature found for wrong tip. Trying next set.\n%s\n", sig.ToString());
-                fAllSigsValid = false;
-                break;
-            }
+        if (!fValid) {
+            LogPrintf("Invalid signature(s) found by %s. Trying next set.\n", CreateSignerIdList(vInvalidSignerIds));
+            return;
+        }
 
-            if (sig.nCreatorId != pblock->nCreatorId) {
-                LogPrintf("Invalid signature found for wrong creator ID. Trying next set.\n%s\n", sig.ToString());
-                fAllSigsValid = false;
-                break;
-            }
+        int count = 0;
+        uint8_t *sigs[MAX_NUMBER_OF_CVNS];
+        set<uint32_t> setSigners;
 
-            sigs[count++] = (uint8_t *)&sig.signature.begin()[0];
+        BOOST_FOREACH(CCvnPartialSignature &sig, vSigs) {
+            setSigners.insert(sig.nSignerId);
+            sigs[count++] = sig.signature.begin();
         }
 
-        if (!fAllSigsValid)
-            continue;
-
         LogPrint("cvnsig", "all %d partial chain signatures in set found valid.\n", setSigners.size());
 
         CSchnorrSig allsig;
         int ret = CombinePartialSignatures(allsig, sigs, count);
         if (ret != 1) {
             LogPrintf("could not combine schnorr signatures: %d", ret);
-            continue;
+            return;
         }
 
         vector<uint32_t> vMissingSignerIds;
@@ -447,16 +453,29 @@ bool DetermineBestSignatureSet(CBlockIndex * const pindexPrev, CBlock *pblock)
             }
         }
 
-        sigCandidates.push_back(allsig);
+        vSigCandidates.push_back(allsig);
         vMissingSignerIdsCandidates.push_back(vMissingSignerIds);
     }
+};
+
+bool DetermineBestSignatureSet(CBlockIndex * const pindexPrev, CBlock *pblock)
+{
+    /* check each signature set. If it's correct and contains enough sigs remember it */
+    CSigSetCandidates candidates(pindexPrev);
+    sigHolder.ForEachSigSet(candidates, pblock->hashPrevBlock, pblock->nCreatorId);
+
+    BOOST_FOREACH(vector<CCvnPartialSignature> &vSigs, candidates.vSigSets)
+        candidates.Evaluate(vSigs);
+
+    const vector<CSchnorrSig> &sigCandidates = candidates.vSigCandidates;
+    const MissingIdsCandidates &vMissingSignerIdsCandidates = candidates.vMissingSignerIdsCandidates;
 
     /*
      * Try to find the best of the working set, meaning the one with the least missing signatures
      */
 
     if (vMissingSignerIdsCandidates.empty()) {
-        LogPrintf("no working signature set found out of %d. Cannot create block.\nPrinting Signature tree:\n%s\n", sigHolder.sigs.size(), sigHolder.ToString());
+        LogPrintf("no working signature set found out of %d. Cannot create block.\nPrinting Signature tree:\n%s\n", sigHolder.size(), sigHolder.ToString());
         return false;
     }
 
@@ -493,10 +512,99 @@ bool DetermineBestSignatureSet(CBlockIndex * const pindexPrev, CBlock *pblock)
     return true;
 }
 
-static bool CreateNewBlock(CBlockTemplate& blockTemplate)
+/* finds the first signature of the round of the block */
+class CSingleSigFinder : public CSigSetVisitor
+{
+public:
+    CSchnorrSig signature;
+
+    bool Visit(CSigRound &round, CSigSet &sigSet)
+    {
+        for (const CSigSlot *slot = round.begin(sigSet); slot != round.end(sigSet); slot++) {
+            if (!slot->IsNull()) {
+                signature = slot->signature;
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+CPreparedBlock preparedBlock;
+
+void UpdatePreparedBlock(const POCStateHolder& s)
 {
+    const int64_t nNow = GetTimeMillis();
+    const unsigned int nTransactionsUpdated = mempool.GetTransactionsUpdated();
+    {
+        LOCK(preparedBlock.cs);
+        if (s.nNextCreator != s.nNodeId) {
+            // release the transactions of a round this node did not create the block for
+            if (!preparedBlock.IsNull())
+                preparedBlock.SetNull();
+            return;
+        }
+
+        if (!preparedBlock.IsNull() && preparedBlock.block.hashPrevBlock == s.GetPrevBlockHash() &&
+                (preparedBlock.nTransactionsUpdated == nTransactionsUpdated || nNow - preparedBlock.nPopulated < BLOCK_TEMPLATE_REFRESH_MILLIS))
+            return;
+    }
+
+    const int64_t nStart = GetTimeMicros();
+
+    CBlockTemplate blockTemplate(s.feeScript, s.pindexPrev, s.nNodeId, GetAdjustedTime(), (rand() % 1000000 + 1), s.chainparams);
     PopulateBlock(blockTemplate);
+    blockTemplate.block.nCreatorId     = s.nNodeId;
+    blockTemplate.block.hashMerkleRoot = BlockMerkleRoot(blockTemplate.block);
+
+    LOCK(preparedBlock.cs);
+    preparedBlock.block.SetNull();
+    preparedBlock.block.vtx.swap(blockTemplate.block.vtx);
+    preparedBlock.block.nVersion       = blockTemplate.block.nVersion;
+    preparedBlock.block.hashPrevBlock  = blockTemplate.block.hashPrevBlock;
+    preparedBlock.block.hashMerkleRoot = blockTemplate.block.hashMerkleRoot;
+    preparedBlock.block.nCreatorId     = s.nNodeId;
+    preparedBlock.nTransactionsUpdated = nTransactionsUpdated;
+    preparedBlock.nPopulated           = GetTimeMillis();
+    preparedBlock.nRefreshes++;
+    preparedBlock.nTotalPopulateMicros += GetTimeMicros() - nStart;
+}
+
+/* moves the transactions of the prepared block into the block of the template if it was prepared for the same tip */
+static bool TakePreparedBlock(CBlockTemplate& blockTemplate)
+{
+    LOCK(preparedBlock.cs);
+
+    const CBlock& prepared = preparedBlock.block;
+    if (preparedBlock.IsNull() || prepared.hashPrevBlock != blockTemplate.pindexPrev->GetBlockHash() || prepared.nCreatorId != blockTemplate.nNodeId) {
+        preparedBlock.nPopulatedOnDemand++;
+        return false;
+    }
+
     CBlock *pblock = &blockTemplate.block;
+    pblock->vtx.swap(preparedBlock.block.vtx);
+    pblock->nVersion       = prepared.nVersion;
+    pblock->hashPrevBlock  = prepared.hashPrevBlock;
+    pblock->hashMerkleRoot = prepared.hashMerkleRoot;
+
+    // a prepared block is only used once
+    preparedBlock.SetNull();
+    preparedBlock.nUsed++;
+
+    return true;
+}
+
+static bool CreateNewBlock(CBlockTemplate& blockTemplate)
+{
+    CBlock *pblock = &blockTemplate.block;
+
+    /* the transactions of a block prepared for this tip are still valid,
+     * they are final with respect to the same median time past */
+    if (!TakePreparedBlock(blockTemplate)) {
+        PopulateBlock(blockTemplate);
+        pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
+    }
 
     pblock->nCreatorId = blockTemplate.nNodeId;
     pblock->nTime = blockTemplate.nCurrentTime;
@@ -504,16 +612,9 @@ static bool CreateNewBlock(CBlockTemplate& blockTemplate)
     uint256 hashBlock = pblock->hashPrevBlock;
     if (mapCVNs.size() == 1) {
         /* if we only have one CVN available (e.g. during bootstrap) we use a plain Schnorr signature */
-        LOCK(sigHolder.cs_sigHolder);
-        const MapSigCommonR &commonR = sigHolder.sigs;
-
-        if (!commonR.empty() && !commonR.begin()->second.empty()) {
-            const MapSigSigner &mapSigner = commonR.begin()->second;
-            if (!mapSigner.empty()) {
-                const CCvnPartialSignature &singleSig = mapSigner.begin()->second;
-                pblock->chainMultiSig = singleSig.signature;
-            }
-        }
+        CSingleSigFinder single;
+        sigHolder.ForEachSigSet(single, hashBlock, pblock->nCreatorId);
+        pblock->chainMultiSig = single.signature;
 
         if (pblock->chainMultiSig.IsNull()) {
             LogPrintf("CreateNewBlock : cannot create block. Single signature not available\n");
@@ -528,13 +629,17 @@ static bool CreateNewBlock(CBlockTemplate& blockTemplate)
         LOCK(cs_mapChainData);
         if (mapChainData.count(hashBlock)) {
             CChainDataMsg& msg = mapChainData[hashBlock];
+            const uint256 hashCoinbase = pblock->vtx[0].GetHash();
             if (!AddChainDataToBlock(pblock, msg)) {
                 LogPrintf("CreateNewBlock : could not add chain data to block\n");
             }
+
+            // a coin supply payload adds an output to the coinbase
+            if (pblock->vtx[0].GetHash() != hashCoinbase)
+                pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
         }
     }
 
-    pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
     pblock->hashPayload    = pblock->GetPayloadHash();
 
     if (!CvnSignBlock(*pblock)) {
@@ -565,10 +670,14 @@ static bool CreateNewBlock(CBlockTemplate& blockTemplate)
 
 bool CreateBlock(const POCStateHolder& s)
 {
+    const int64_t nStart = GetTimeMicros();
     CBlockTemplate blockTemplate(s.feeScript, chainActive.Tip(), s.nNodeId, GetAdjustedTime(), (rand() % 1000000 + 1), s.chainparams);
 
     if (!CreateNewBlock(blockTemplate))
         return false;
 
+    LOCK(preparedBlock.cs);
+    preparedBlock.nLastCreateMicros = GetTimeMicros() - nStart;
+
     return true;
 }
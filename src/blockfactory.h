@@ -9,6 +9,7 @@
 #include "primitives/block.h"
 #include "key.h"
 #include "chainparams.h"
+#include "sync.h"
 
 #include <stdint.h>
 
@@ -25,6 +26,9 @@ static const bool DEFAULT_GENERATE = false;
 
 static const bool DEFAULT_PRINTPRIORITY = false;
 
+/** How often the prepared block template of the next creator is checked for mempool changes, in ms */
+static const int64_t BLOCK_TEMPLATE_REFRESH_MILLIS = 2000;
+
 extern bool CreateBlock(const POCStateHolder& s);
 extern bool DetermineBestSignatureSet(CBlockIndex * const pindexPrev, CBlock *pblock);
 
@@ -49,4 +53,54 @@ public:
     }
 };
 
+/** Fill the block of the template with transactions from the mempool and create its coinbase */
+extern void PopulateBlock(CBlockTemplate& blocktemplate);
+
+/**
+ * The block this node is going to create next, populated with the mempool
+ * transactions and with its merkle root computed while the chain signatures
+ * are being collected. It is valid for its tip only and is refreshed whenever
+ * the mempool changed. Creating the block then only takes the signatures.
+ */
+class CPreparedBlock
+{
+public:
+    CCriticalSection cs;
+
+    CBlock block;                                           // without signatures and chain data
+    unsigned int nTransactionsUpdated;                      // mempool.GetTransactionsUpdated() when populated
+    int64_t nPopulated;                                     // time in ms it was populated
+
+    /* statistics */
+    uint64_t nRefreshes;
+    uint64_t nUsed;
+    uint64_t nPopulatedOnDemand;
+    int64_t nTotalPopulateMicros;
+    int64_t nLastCreateMicros;
+
+    CPreparedBlock()
+    {
+        SetNull();
+        nRefreshes = nUsed = nPopulatedOnDemand = 0;
+        nTotalPopulateMicros = nLastCreateMicros = 0;
+    }
+
+    void SetNull()
+    {
+        block.SetNull();
+        nTransactionsUpdated = 0;
+        nPopulated = 0;
+    }
+
+    bool IsNull() const
+    {
+        return block.hashPrevBlock.IsNull();
+    }
+};
+
+extern CPreparedBlock preparedBlock;
+
+/** Populates or refreshes the prepared block if this node creates the next block */
+extern void UpdatePreparedBlock(const POCStateHolder& s);
+
 #endif // BITCOIN_MINER_H
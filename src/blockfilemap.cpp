@@ -0,0 +1,113 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilemap.h"
+
+#include "main.h"
+#include "util.h"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CBlockFileMapCache blockFileMapCache;
+
+CMappedBlockFile::CMappedBlockFile(const boost::filesystem::path &path) : pdata(NULL), nSize(0)
+{
+#ifndef WIN32
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd == -1)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            pdata = (const char*)p;
+            nSize = st.st_size;
+        } else
+            LogPrintf("%s: unable to map %s\n", __func__, path.string());
+    }
+    close(fd);
+#endif
+}
+
+CMappedBlockFile::~CMappedBlockFile()
+{
+#ifndef WIN32
+    if (pdata)
+        munmap((void*)pdata, nSize);
+#endif
+}
+
+CMappedBlockFileRef CBlockFileMapCache::Get(int nFile, size_t nMinSize)
+{
+    LOCK(cs);
+    if (!nMaxFiles)
+        return CMappedBlockFileRef();
+
+    std::map<int, LruListType::iterator>::iterator mi = mapFiles.find(nFile);
+    if (mi != mapFiles.end()) {
+        LruListType::iterator it = mi->second;
+        if (it->second->size() >= nMinSize) {
+            listLru.splice(listLru.begin(), listLru, it);
+            nHits++;
+            return it->second;
+        }
+        // the file has grown since it was mapped
+        listLru.erase(it);
+        mapFiles.erase(mi);
+    }
+
+    CMappedBlockFileRef mapped(new CMappedBlockFile(GetBlockPosFilename(CDiskBlockPos(nFile, 0), "blk")));
+    if (mapped->IsNull() || mapped->size() < nMinSize)
+        return CMappedBlockFileRef();
+    nMaps++;
+
+    listLru.push_front(std::make_pair(nFile, mapped));
+    mapFiles[nFile] = listLru.begin();
+    while (listLru.size() > nMaxFiles) {
+        mapFiles.erase(listLru.back().first);
+        listLru.pop_back();
+    }
+
+    return mapped;
+}
+
+void CBlockFileMapCache::Erase(int nFile)
+{
+    LOCK(cs);
+    std::map<int, LruListType::iterator>::iterator mi = mapFiles.find(nFile);
+    if (mi != mapFiles.end()) {
+        listLru.erase(mi->second);
+        mapFiles.erase(mi);
+    }
+}
+
+void CBlockFileMapCache::Clear()
+{
+    LOCK(cs);
+    listLru.clear();
+    mapFiles.clear();
+}
+
+void CBlockFileMapCache::SetMaxFiles(size_t nMaxFilesIn)
+{
+    LOCK(cs);
+    nMaxFiles = nMaxFilesIn;
+    while (listLru.size() > nMaxFiles) {
+        mapFiles.erase(listLru.back().first);
+        listLru.pop_back();
+    }
+}
+
+void CBlockFileMapCache::GetStats(uint64_t &nHitsOut, uint64_t &nMapsOut) const
+{
+    LOCK(cs);
+    nHitsOut = nHits;
+    nMapsOut = nMaps;
+}
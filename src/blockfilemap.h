@@ -0,0 +1,76 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKFILEMAP_H
+#define BITCOIN_BLOCKFILEMAP_H
+
+#include "sync.h"
+
+#include <list>
+#include <map>
+#include <stdint.h>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/shared_ptr.hpp>
+
+/** Default number of block files kept mapped for reading (0 = read through stdio) */
+static const int DEFAULT_BLOCKFILE_MAPS = sizeof(void*) >= 8 ? 32 : 0;
+
+/** A block file mapped read-only into memory. Unmapped when the last reference is gone. */
+class CMappedBlockFile
+{
+private:
+    // Disallow copies
+    CMappedBlockFile(const CMappedBlockFile&);
+    CMappedBlockFile& operator=(const CMappedBlockFile&);
+
+    const char *pdata;
+    size_t nSize;
+
+public:
+    CMappedBlockFile(const boost::filesystem::path &path);
+    ~CMappedBlockFile();
+
+    bool IsNull() const         { return pdata == NULL; }
+    const char *begin() const   { return pdata; }
+    const char *end() const     { return pdata + nSize; }
+    size_t size() const         { return nSize; }
+};
+
+typedef boost::shared_ptr<const CMappedBlockFile> CMappedBlockFileRef;
+
+/**
+ * Least recently used set of mapped block files. A mapping covers the file as
+ * it was when it was mapped; Get() maps the file again when a caller needs
+ * bytes that were appended later. Files that are truncated or deleted must be
+ * dropped with Erase() before that happens, so that a mapping never extends
+ * past the end of its file.
+ */
+class CBlockFileMapCache
+{
+private:
+    typedef std::list<std::pair<int, CMappedBlockFileRef> > LruListType;
+
+    mutable CCriticalSection cs;
+    LruListType listLru;
+    std::map<int, LruListType::iterator> mapFiles;
+    size_t nMaxFiles;
+
+    uint64_t nHits;
+    uint64_t nMaps;
+
+public:
+    CBlockFileMapCache() : nMaxFiles(0), nHits(0), nMaps(0) {}
+
+    /** Return a mapping of block file nFile that is at least nMinSize bytes long, or an empty reference. */
+    CMappedBlockFileRef Get(int nFile, size_t nMinSize);
+    void Erase(int nFile);
+    void Clear();
+    void SetMaxFiles(size_t nMaxFilesIn);
+    void GetStats(uint64_t &nHitsOut, uint64_t &nMapsOut) const;
+};
+
+extern CBlockFileMapCache blockFileMapCache;
+
+#endif // BITCOIN_BLOCKFILEMAP_H
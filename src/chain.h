@@ -7,10 +7,12 @@
 #define BITCOIN_CHAIN_H
 
 #include "arith_uint256.h"
+#include "prevector.h"
 #include "primitives/block.h"
 #include "tinyformat.h"
 #include "uint256.h"
 
+#include <algorithm>
 #include <vector>
 
 #include <boost/foreach.hpp>
@@ -94,6 +96,9 @@ enum BlockStatus {
     BLOCK_FAILED_MASK        =   BLOCK_FAILED_VALID | BLOCK_FAILED_CHILD,
 };
 
+/** Most blocks miss only a few chain signatures, their IDs are stored inline */
+typedef prevector<8, uint32_t> MissingSignerIdsType;
+
 /** The block chain is a tree shaped structure starting with the
  * genesis block at the root, with each block potentially having multiple
  * candidates to be the next block. A blockindex may have multiple pprev pointing
@@ -146,11 +151,18 @@ public:
     unsigned int nCreatorId;
     CSchnorrSig creatorSig;
 
-    vector<uint32_t> vMissingSignerIds;
+    //! the IDs of the CVNs that did not sign the block, sorted
+    MissingSignerIdsType vMissingSignerIds;
 
     //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
     uint32_t nSequenceId;
 
+    //! (memory only) Number of chain signatures in the chain up to and including this block, -1 if not known (yet)
+    int64_t nChainSigs;
+
+    //! (memory only) pointer to the index of the block that set up the CVN set this block is signed by
+    CBlockIndex* pcvnepoch;
+
     void SetNull()
     {
         phashBlock = NULL;
@@ -165,6 +177,8 @@ public:
         nChainTx = 0;
         nStatus = 0;
         nSequenceId = 0;
+        nChainSigs = -1;
+        pcvnepoch = NULL;
 
         nVersion       = 0;
         hashMerkleRoot = uint256();
@@ -192,11 +206,23 @@ public:
         creatorSig         = creatorSigIn;
 
         if (vMissingSignerIdsIn)
-            vMissingSignerIds = *vMissingSignerIdsIn;
+            SetMissingSignerIds(*vMissingSignerIdsIn);
         else
             vMissingSignerIds.clear();
     }
 
+    template <typename T>
+    void SetMissingSignerIds(const T& vIds)
+    {
+        vMissingSignerIds.assign(vIds.begin(), vIds.end());
+        std::sort(vMissingSignerIds.begin(), vMissingSignerIds.end());
+    }
+
+    bool IsMissingSigner(const uint32_t nSignerId) const
+    {
+        return std::binary_search(vMissingSignerIds.begin(), vMissingSignerIds.end(), nSignerId);
+    }
+
     CDiskBlockPos GetBlockPos() const {
         CDiskBlockPos ret;
         if (nStatus & BLOCK_HAVE_DATA) {
@@ -0,0 +1,160 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "coinsflush.h"
+
+#include "memusage.h"
+#include "util.h"
+#include "utiltime.h"
+
+#include <boost/bind.hpp>
+
+CCoinsViewFlusher::CCoinsViewFlusher(CCoinsView *viewIn, bool fBackground) : CCoinsViewBacked(viewIn),
+    nFrozenUsage(0), fWritePending(false), fWriteFailed(false)
+{
+    if (fBackground)
+        threads.create_thread(boost::bind(&CCoinsViewFlusher::Thread, this));
+}
+
+CCoinsViewFlusher::~CCoinsViewFlusher()
+{
+    Sync();
+    threads.interrupt_all();
+    threads.join_all();
+}
+
+void CCoinsViewFlusher::Thread()
+{
+    RenameThread("faircoin-coinsflush");
+
+    while (true) {
+        boost::shared_ptr<CCoinsMap> pcoins;
+        uint256 hashBlock;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while (!fWritePending)
+                cond.wait(lock);
+
+            pcoins = pcoinsFrozen;
+            hashBlock = hashBlockFrozen;
+        }
+
+        int64_t nStart = GetTimeMicros();
+        bool fOk = false;
+        std::string strError = "write failed";
+        try {
+            fOk = base->BatchWrite(*pcoins, hashBlock);
+        } catch (const std::exception& e) {
+            strError = e.what();
+        }
+        LogPrint("coindb", "Background flush wrote %u coins in %.2fms\n", pcoins->size(), 0.001 * (GetTimeMicros() - nStart));
+
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (fOk) {
+            // the database has it now, pcoins releases the generation outside the lock
+            pcoinsFrozen.reset();
+            nFrozenUsage = 0;
+            fWriteFailed = false;
+        } else {
+            // keep serving the unwritten coins, the next flush reports the error
+            fWriteFailed = true;
+            strWriteError = strError;
+        }
+        fWritePending = false;
+        cond.notify_all();
+    }
+}
+
+bool CCoinsViewFlusher::WaitForWrite(boost::unique_lock<boost::mutex> &lock)
+{
+    while (fWritePending)
+        cond.wait(lock);
+
+    // try the failed generation once more, newer coins must not be written before it
+    if (fWriteFailed) {
+        LogPrintf("%s: writing the coins in the background failed: %s, retrying\n", __func__, strWriteError);
+        fWritePending = true;
+        cond.notify_all();
+        while (fWritePending)
+            cond.wait(lock);
+    }
+
+    if (fWriteFailed)
+        return error("%s: writing the coins in the background failed: %s", __func__, strWriteError);
+    return true;
+}
+
+bool CCoinsViewFlusher::GetCoins(const uint256 &txid, CCoins &coins) const
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (pcoinsFrozen) {
+            CCoinsMap::const_iterator it = pcoinsFrozen->find(txid);
+            if (it != pcoinsFrozen->end()) {
+                coins = it->second.coins;
+                return true;
+            }
+        }
+    }
+
+    return base->GetCoins(txid, coins);
+}
+
+bool CCoinsViewFlusher::HaveCoins(const uint256 &txid) const
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (pcoinsFrozen) {
+            CCoinsMap::const_iterator it = pcoinsFrozen->find(txid);
+            if (it != pcoinsFrozen->end())
+                return !it->second.coins.IsPruned();
+        }
+    }
+
+    return base->HaveCoins(txid);
+}
+
+uint256 CCoinsViewFlusher::GetBestBlock() const
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (pcoinsFrozen && !hashBlockFrozen.IsNull())
+            return hashBlockFrozen;
+    }
+
+    return base->GetBestBlock();
+}
+
+bool CCoinsViewFlusher::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock)
+{
+    if (!IsBackground())
+        return base->BatchWrite(mapCoins, hashBlock);
+
+    boost::unique_lock<boost::mutex> lock(mutex);
+    if (!WaitForWrite(lock))
+        return false;
+
+    pcoinsFrozen.reset(new CCoinsMap());
+    pcoinsFrozen->swap(mapCoins);
+    hashBlockFrozen = hashBlock;
+    nFrozenUsage = memusage::DynamicUsage(*pcoinsFrozen);
+    for (CCoinsMap::const_iterator it = pcoinsFrozen->begin(); it != pcoinsFrozen->end(); it++)
+        nFrozenUsage += it->second.coins.DynamicMemoryUsage();
+    fWritePending = true;
+    cond.notify_all();
+
+    return true;
+}
+
+size_t CCoinsViewFlusher::DynamicMemoryUsage() const
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    return nFrozenUsage;
+}
+
+bool CCoinsViewFlusher::Sync()
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    return WaitForWrite(lock);
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_COINSFLUSH_H
+#define BITCOIN_COINSFLUSH_H
+
+#include "coins.h"
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+/** Default for -backgroundflush */
+static const bool DEFAULT_BACKGROUND_FLUSH = true;
+
+/**
+ * A CCoinsView between the coins cache and the database that writes flushed
+ * coins on a background thread. BatchWrite() takes over the flushed entries
+ * as a frozen generation and returns at once, so blocks keep connecting
+ * against the emptied cache above while the generation is written. Until the
+ * write has committed, lookups are answered from the frozen generation first.
+ *
+ * At most one generation is in flight: a BatchWrite() that arrives while the
+ * previous one is still being written waits for it. A failed write is kept
+ * frozen, the next BatchWrite() or Sync() writes it again and reports an
+ * error only if that fails as well.
+ *
+ * The base view must not modify the map passed to its BatchWrite(), as it is
+ * read concurrently. CCoinsViewDB does not.
+ */
+class CCoinsViewFlusher : public CCoinsViewBacked
+{
+private:
+    mutable boost::mutex mutex;
+    boost::condition_variable cond;
+    boost::thread_group threads;
+
+    boost::shared_ptr<CCoinsMap> pcoinsFrozen;
+    uint256 hashBlockFrozen;
+    size_t nFrozenUsage;
+    bool fWritePending;
+    bool fWriteFailed;
+    std::string strWriteError;
+
+    void Thread();
+    bool WaitForWrite(boost::unique_lock<boost::mutex> &lock);
+
+public:
+    CCoinsViewFlusher(CCoinsView *viewIn, bool fBackground);
+    ~CCoinsViewFlusher();
+
+    bool GetCoins(const uint256 &txid, CCoins &coins) const;
+    bool HaveCoins(const uint256 &txid) const;
+    uint256 GetBestBlock() const;
+    bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock);
+
+    /** Wait until the frozen generation is written, returns false if the write failed */
+    bool Sync();
+    bool IsBackground() const { return threads.size() > 0; }
+    /** Memory held by the frozen generation until it is written */
+    size_t DynamicMemoryUsage() const;
+};
+
+#endif // BITCOIN_COINSFLUSH_H
@@ -0,0 +1,154 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "coinsprefetch.h"
+
+#include "memusage.h"
+#include "util.h"
+
+#include <boost/bind.hpp>
+
+CCoinsViewPrefetch::CCoinsViewPrefetch(CCoinsView *viewIn, int nThreads) : CCoinsViewBacked(viewIn),
+    nGeneration(0), nUsage(0), nRequested(0), nDropped(0), nFetched(0), nHits(0), nMisses(0)
+{
+    for (int i = 0; i < std::min(nThreads, MAX_PREFETCH_THREADS); i++)
+        threads.create_thread(boost::bind(&CCoinsViewPrefetch::Thread, this));
+}
+
+CCoinsViewPrefetch::~CCoinsViewPrefetch()
+{
+    threads.interrupt_all();
+    threads.join_all();
+}
+
+size_t CCoinsViewPrefetch::EntryUsage(const CCoins &coins)
+{
+    // a multi_index node with a sequenced and a hashed index, and its bucket
+    return memusage::MallocUsage(sizeof(CPrefetchedCoins) + 5 * sizeof(void*)) + coins.DynamicMemoryUsage();
+}
+
+void CCoinsViewPrefetch::Thread()
+{
+    RenameThread("faircoin-prefetch");
+
+    while (true) {
+        uint256 txid;
+        uint64_t nGenerationRead;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while (queue.empty())
+                cond.wait(lock);
+
+            txid = queue.front();
+            queue.pop_front();
+
+            if (mapPrefetched.get<1>().count(txid))
+                continue;
+
+            nGenerationRead = nGeneration;
+        }
+
+        CCoins coins;
+        if (!base->GetCoins(txid, coins))
+            continue;
+
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (nGenerationRead != nGeneration)
+            continue; // a write might have happened in between
+
+        // make room by dropping the coins that waited longest, they were most likely not needed
+        while (mapPrefetched.size() >= MAX_PREFETCH_COINS) {
+            nUsage -= EntryUsage(mapPrefetched.front().coins);
+            mapPrefetched.pop_front();
+        }
+
+        std::pair<PrefetchMapType::iterator, bool> ret = mapPrefetched.push_back(CPrefetchedCoins(txid));
+        if (!ret.second)
+            continue; // another thread read them in the meantime
+        ret.first->coins.swap(coins);
+        nUsage += EntryUsage(ret.first->coins);
+        nFetched++;
+    }
+}
+
+bool CCoinsViewPrefetch::GetCoins(const uint256 &txid, CCoins &coins) const
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        PrefetchMapType::nth_index<1>::type::iterator it = mapPrefetched.get<1>().find(txid);
+        if (it != mapPrefetched.get<1>().end()) {
+            nUsage -= EntryUsage(it->coins);
+            coins.swap(it->coins);
+            mapPrefetched.get<1>().erase(it);
+            nHits++;
+            return true;
+        }
+        nMisses++;
+    }
+
+    return base->GetCoins(txid, coins);
+}
+
+bool CCoinsViewPrefetch::HaveCoins(const uint256 &txid) const
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        PrefetchMapType::nth_index<1>::type::const_iterator it = mapPrefetched.get<1>().find(txid);
+        if (it != mapPrefetched.get<1>().end())
+            return !it->coins.IsPruned();
+    }
+
+    return base->HaveCoins(txid);
+}
+
+bool CCoinsViewPrefetch::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock)
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        nGeneration++;
+        mapPrefetched.clear();
+        nUsage = 0;
+    }
+
+    bool fResult = base->BatchWrite(mapCoins, hashBlock);
+
+    // lookups that overlapped with the write may have read either state
+    boost::unique_lock<boost::mutex> lock(mutex);
+    nGeneration++;
+    mapPrefetched.clear();
+    nUsage = 0;
+
+    return fResult;
+}
+
+void CCoinsViewPrefetch::Prefetch(const std::vector<uint256> &vTxids)
+{
+    if (!IsEnabled() || vTxids.empty())
+        return;
+
+    boost::unique_lock<boost::mutex> lock(mutex);
+    // whatever does not fit is looked up by ConnectBlock() as usual
+    size_t nQueue = std::min(vTxids.size(), MAX_PREFETCH_QUEUE - std::min(queue.size(), MAX_PREFETCH_QUEUE));
+    queue.insert(queue.end(), vTxids.begin(), vTxids.begin() + nQueue);
+    nRequested += nQueue;
+    nDropped += vTxids.size() - nQueue;
+    if (nQueue)
+        cond.notify_all();
+}
+
+size_t CCoinsViewPrefetch::DynamicMemoryUsage() const
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    return nUsage;
+}
+
+void CCoinsViewPrefetch::GetPrefetchStats(uint64_t &nRequestedOut, uint64_t &nDroppedOut, uint64_t &nFetchedOut, uint64_t &nHitsOut, uint64_t &nMissesOut) const
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    nRequestedOut = nRequested;
+    nDroppedOut   = nDropped;
+    nFetchedOut   = nFetched;
+    nHitsOut      = nHits;
+    nMissesOut    = nMisses;
+}
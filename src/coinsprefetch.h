@@ -0,0 +1,101 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_COINSPREFETCH_H
+#define BITCOIN_COINSPREFETCH_H
+
+#include "coins.h"
+
+#include <deque>
+#include <vector>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+/** Default number of threads reading the inputs of a block ahead of ConnectBlock() */
+static const int DEFAULT_PREFETCH_THREADS = 2;
+/** Maximum number of prefetch threads */
+static const int MAX_PREFETCH_THREADS = 8;
+/** Maximum number of coins held by the prefetch layer, the oldest are dropped first */
+static const size_t MAX_PREFETCH_COINS = 50000;
+/** Maximum number of txids waiting to be read, further requests are dropped */
+static const size_t MAX_PREFETCH_QUEUE = 20000;
+
+/** Coins read ahead by CCoinsViewPrefetch */
+struct CPrefetchedCoins
+{
+    uint256 txid;
+    mutable CCoins coins;
+
+    CPrefetchedCoins(const uint256 &txidIn) : txid(txidIn) {}
+};
+
+/**
+ * A CCoinsView between pcoinsTip and the coins database that reads the coins
+ * of a block's inputs on a few worker threads while the block is still being
+ * checked. ConnectBlock() then finds them here instead of waiting for the
+ * database. A prefetched entry is handed out once, after that the cache above
+ * holds it. Coins that are never asked for are dropped oldest first once
+ * MAX_PREFETCH_COINS are held.
+ *
+ * Every BatchWrite() drops all prefetched coins, before and after the write.
+ * A worker only stores its result if no write started since it looked the
+ * coins up, hence nothing older than the database is ever returned.
+ */
+class CCoinsViewPrefetch : public CCoinsViewBacked
+{
+private:
+    typedef boost::multi_index_container<
+        CPrefetchedCoins,
+        boost::multi_index::indexed_by<
+            // in the order they were read
+            boost::multi_index::sequenced<>,
+            // by txid
+            boost::multi_index::hashed_unique<
+                boost::multi_index::member<CPrefetchedCoins, uint256, &CPrefetchedCoins::txid>,
+                CCoinsKeyHasher
+            >
+        >
+    > PrefetchMapType;
+
+    mutable boost::mutex mutex;
+    boost::condition_variable cond;
+    boost::thread_group threads;
+
+    std::deque<uint256> queue;
+    mutable PrefetchMapType mapPrefetched;
+    uint64_t nGeneration;
+    mutable size_t nUsage;
+
+    uint64_t nRequested;
+    uint64_t nDropped;
+    uint64_t nFetched;
+    mutable uint64_t nHits;
+    mutable uint64_t nMisses;
+
+    void Thread();
+    static size_t EntryUsage(const CCoins &coins);
+
+public:
+    CCoinsViewPrefetch(CCoinsView *viewIn, int nThreads);
+    ~CCoinsViewPrefetch();
+
+    bool GetCoins(const uint256 &txid, CCoins &coins) const;
+    bool HaveCoins(const uint256 &txid) const;
+    bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock);
+
+    /** Queue the coins of vTxids to be read from the database, as far as the queue has room */
+    void Prefetch(const std::vector<uint256> &vTxids);
+    bool IsEnabled() const { return threads.size() > 0; }
+    //! Memory held by the prefetched coins, counted against -dbcache
+    size_t DynamicMemoryUsage() const;
+    void GetPrefetchStats(uint64_t &nRequestedOut, uint64_t &nDroppedOut, uint64_t &nFetchedOut, uint64_t &nHitsOut, uint64_t &nMissesOut) const;
+};
+
+#endif // BITCOIN_COINSPREFETCH_H
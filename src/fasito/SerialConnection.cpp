@@ -31,14 +31,14 @@ using namespace std;
 using namespace boost;
 
 SerialConnection::SerialConnection(): io(), port(io), timer(io),
-        timeout(posix_time::seconds(0)), result(resultInProgress), bytesTransferred(0) {}
+        timeout(posix_time::seconds(0)), result(resultInProgress), bytesTransferred(0), fOutOfSync(false) {}
 
 SerialConnection::SerialConnection(const std::string& devname, unsigned int baud_rate,
         asio::serial_port_base::parity opt_parity,
         asio::serial_port_base::character_size opt_csize,
         asio::serial_port_base::flow_control opt_flow,
         asio::serial_port_base::stop_bits opt_stop)
-        : io(), port(io), timer(io), timeout(posix_time::seconds(0))
+        : io(), port(io), timer(io), timeout(posix_time::seconds(0)), fOutOfSync(false)
 {
     open(devname,baud_rate,opt_parity,opt_csize,opt_flow,opt_stop);
 }
@@ -124,10 +124,12 @@ void SerialConnection::read(char *data, size_t size)
                 return;
             case resultTimeoutExpired:
                 port.cancel();
+                fOutOfSync=true;
                 throw(timeout_exception("Timeout expired"));
             case resultError:
                 timer.cancel();
                 port.cancel();
+                fOutOfSync=true;
                 throw(boost::system::system_error(boost::system::error_code(),
                         "Error while reading"));
             default:
@@ -186,10 +188,12 @@ std::string SerialConnection::readStringUntil(const std::string& delim)
                 }
             case resultTimeoutExpired:
                 port.cancel();
+                fOutOfSync=true;
                 throw(timeout_exception("Timeout expired"));
             case resultError:
                 timer.cancel();
                 port.cancel();
+                fOutOfSync=true;
                 throw(boost::system::system_error(boost::system::error_code(),
                         "Error while reading"));
             default:
@@ -250,11 +254,49 @@ void SerialConnection::readCompleted(const boost::system::error_code& error,
     result=resultError;
 }
 
+void SerialConnection::resync()
+{
+    // the device answers a command within the read timeout, so once nothing
+    // arrived for that long it has answered all commands written before
+    const posix_time::time_duration timeoutCommand = timeout;
+    const posix_time::time_duration quiet = timeout != posix_time::seconds(0) ? timeout : posix_time::seconds(1);
+    const posix_time::ptime end = posix_time::microsec_clock::universal_time() + quiet * 10;
+
+    setTimeout(quiet);
+    try {
+        while (true) {
+            readStringUntil("\r\n");
+            if (posix_time::microsec_clock::universal_time() > end) {
+                setTimeout(timeoutCommand);
+                throw std::runtime_error("device does not stop sending");
+            }
+        }
+    } catch (const timeout_exception&) {
+    }
+    setTimeout(timeoutCommand);
+
+    // drop the start of a line that was cut off
+    readData.consume(readData.size());
+    fOutOfSync = false;
+}
+
+void SerialConnection::writeCommand(const std::string& line)
+{
+    if (fOutOfSync)
+        resync();
+    writeString(line + "\r");
+}
+
 bool SerialConnection::sendAndReceive(const std::string line, vector<string> &vLines)
 {
     LOCK(cs_connection);
-    writeString(line + "\r");
+    writeCommand(line);
 
+    return receive(vLines);
+}
+
+bool SerialConnection::receive(vector<string> &vLines)
+{
     string s = readStringUntil("\r\n");
 
     vLines.push_back(s);
@@ -274,7 +316,7 @@ bool SerialConnection::sendAndReceive(const std::string line, vector<string> &vL
 
 bool SerialConnection::sendCommand(const std::string command) {
     LOCK(cs_connection);
-    writeString(command + "\r");
+    writeCommand(command);
     string s = readStringUntil("\r\n");
     while (s != "OK" && !boost::algorithm::starts_with(s, "ERROR")) {
         s = readStringUntil("\r\n");
@@ -168,11 +168,38 @@ public:
      */
     std::string readStringUntil(const std::string& delim="\n");
     
+    /**
+     * Mark the connection as out of step with the device. This happens when a
+     * read times out or fails, as the device may still answer the command
+     * later. Before the next command is written, those late answers are
+     * drained.
+     */
+    void setOutOfSync() { fOutOfSync = true; }
+
+    /**
+     * Read and drop input until the device was quiet for the read timeout
+     * \throws std::runtime_error if the device does not stop sending
+     */
+    void resync();
+
+    /**
+     * Write a command line, after draining the answers to earlier commands
+     * if the connection is out of step.
+     * \throws std::runtime_error if the device does not stop sending
+     */
+    void writeCommand(const std::string& line);
+
     /**
      * Send a line to the serial port and return all the resulting lines in vLines
      */
     bool sendAndReceive(const std::string line, std::vector<std::string> &vLines);
 
+    /**
+     * Read the response to a command that was written before, up to
+     * and including the terminating OK or ERROR line.
+     */
+    bool receive(std::vector<std::string> &vLines);
+
     /**
      * Send a line to the serial port and return true if 'OK' was received
      * or false if 'ERROR' was received
@@ -246,6 +273,7 @@ private:
     enum ReadResult result;  ///< Used by read with timeout
     size_t bytesTransferred; ///< Used by async read callback
     ReadSetupParameters setupParameters; ///< Global because used in the OSX fix
+    bool fOutOfSync; ///< Set if answers to earlier commands may still arrive
 };
 
 #endif  //TIMEOUTSERIAL_H
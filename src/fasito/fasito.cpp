@@ -18,6 +18,7 @@
 #include <stdint.h>
 
 #include <boost/algorithm/string/predicate.hpp> // for startswith() and endswith()
+#include <boost/bind.hpp>
 
 #define FASITO_DEBUG 0
 
@@ -37,30 +38,81 @@ static string bin2hex(const uint8_t *buf, const size_t len)
     return res;
 }
 
-bool CreateNonceWithFasito(const uint256& hashData, const uint8_t nKey, unsigned char *pPrivateData, CSchnorrNonce& noncePublic, const CSchnorrPubKey& pubKey)
+string GetFasitoNonceCommand(const uint256& hashData, const uint8_t nKey)
+{
+    CHashWriter hasher(SER_GETHASH, 0);
+    hasher << GetTimeMillis() << string("we need random nonces") << rand();
+
+    return strprintf("NONCE %d %s %s", nKey, bin2hex(&hashData.begin()[0], 32), bin2hex(&hasher.GetHash().begin()[0], 32));
+}
+
+/* response to NONCE: "<handle> <public nonce>" */
+bool ParseFasitoNonce(const vector<string>& vLines, uint8_t& nHandle, CSchnorrNonce& noncePublic)
+{
+    if (vLines.empty() || vLines[0].size() < 3 + 128) {
+        LogPrintf("%s : invalid response: %s\n", __func__, (!vLines.empty() ? vLines[0] : "response not available"));
+        return false;
+    }
+
+    nHandle = (uint8_t)atoi(vLines[0].substr(0,2).c_str());
+
+    vector<uint8_t> pubNonce = ParseHex(vLines[0].substr(3));
+    if (pubNonce.size() < 64) {
+        LogPrintf("%s : invalid public nonce: %s\n", __func__, vLines[0]);
+        return false;
+    }
+    memcpy(&noncePublic.begin()[0], &pubNonce.begin()[0], 64);
+
+    return true;
+}
+
+string GetFasitoSignCommand(const uint256& hashToSign, const uint8_t nKey)
+{
+    return strprintf("SCHNORR %d %s", nKey, bin2hex(&hashToSign.begin()[0], 32));
+}
+
+/* response to SCHNORR: "<signature>" */
+bool ParseFasitoSignature(const vector<string>& vLines, CSchnorrSig& signature)
+{
+    vector<uint8_t> vSig;
+    if (!vLines.empty())
+        vSig = ParseHex(vLines[0]);
+
+    if (vSig.size() < 64) {
+        LogPrintf("%s : invalid response: %s\n", __func__, (!vLines.empty() ? vLines[0] : "response not available"));
+        return false;
+    }
+    memcpy(&signature.begin()[0], &vSig.begin()[0], 64);
+
+    return true;
+}
+
+bool CheckFasitoNonceKey(const uint8_t nKey, const CSchnorrPubKey& pubKey)
 {
     if (!fasito.mapKeys.count(nKey) || fasito.mapKeys[nKey].pubKey != pubKey) {
-        LogPrintf("CreateNonceWithFasito : public key in Fasito does not match cvnInfo in blockchain: %s != %s\n", fasito.mapKeys[nKey].pubKey.ToString(), pubKey.ToString());
+        LogPrintf("%s : public key in Fasito does not match cvnInfo in blockchain: %s != %s\n", __func__, fasito.mapKeys[nKey].pubKey.ToString(), pubKey.ToString());
         return false;
     }
 
-    CHashWriter hasher(SER_GETHASH, 0);
-    hasher << GetTimeMillis() << string("we need random nonces") << rand();
+    return true;
+}
 
-    std::stringstream s;
-    s << strprintf("NONCE %d %s %s", nKey, bin2hex(&hashData.begin()[0], 32), bin2hex(&hasher.GetHash().begin()[0], 32));
+bool CreateNonceWithFasito(const uint256& hashData, const uint8_t nKey, unsigned char *pPrivateData, CSchnorrNonce& noncePublic, const CSchnorrPubKey& pubKey)
+{
+    if (!CheckFasitoNonceKey(nKey, pubKey))
+        return false;
 
     vector<string> res;
     try {
-        if (!fasito.sendAndReceive(s.str(), res)) {
+        if (!fasito.sendAndReceive(GetFasitoNonceCommand(hashData, nKey), res)) {
             LogPrintf("CreateNonceWithFasito : could not create nonce pair: %s\n", (!res.empty() ? res[0] : "error not available"));
             return false;
         }
-        int nHandle = atoi(res[0].substr(0,2).c_str());
-        *((uint8_t *)pPrivateData) = (uint8_t)nHandle;
 
-        vector<uint8_t> pubNonce = ParseHex(res[0].substr(3));
-        memcpy(&noncePublic.begin()[0], &pubNonce.begin()[0], 64);
+        uint8_t nHandle;
+        if (!ParseFasitoNonce(res, nHandle, noncePublic))
+            return false;
+        *((uint8_t *)pPrivateData) = nHandle;
     } catch(const std::exception &e) {
         LogPrintf("failed to send NONCE command: %s\n", e.what());
         return false;
@@ -83,19 +135,14 @@ bool CvnSignWithFasito(const uint256 &hashToSign, const uint8_t nKey, CSchnorrSi
         return false;
     }
 
-    std::stringstream s;
-
-    s << strprintf("SCHNORR %d %s", nKey, bin2hex(&hashToSign.begin()[0], 32));
     vector<string> res;
-    vector<uint8_t> vSig;
     try {
-        if (!fasito.sendAndReceive(s.str(), res)) {
+        if (!fasito.sendAndReceive(GetFasitoSignCommand(hashToSign, nKey), res)) {
             LogPrintf("CvnSignWithFasito : could not sign hash: %s\n", (!res.empty() ? res[0] : "error not available"));
             return false;
         }
-        vSig = ParseHex(res[0]);
-
-        memcpy(&signature.begin()[0], &vSig.begin()[0], 64);
+        if (!ParseFasitoSignature(res, signature))
+            return false;
     } catch(const std::exception &e) {
         LogPrintf("failed to send SCHNORR command: %s\n", e.what());
         return false;
@@ -110,7 +157,7 @@ bool CvnSignWithFasito(const uint256 &hashToSign, const uint8_t nKey, CSchnorrSi
     LogPrintf("CvnSignWithFasito : OK\n  Hash: %s\n  pubk: %s\n  nKey: %d\n   sig: %s\nrawsig: %s\nhexstr: %s\n",
             hashToSign.ToString(),
             fasito.mapKeys[nKey].pubKey.ToString(),
-            nKey, signature.ToString(), res[0], HexStr(vSig));
+            nKey, signature.ToString(), res[0], signature.ToString());
 #endif
    return true;
 }
@@ -245,9 +292,7 @@ void CFasito::emtpyInputBuffer()
     writeString("\r");
 
     try {
-        while (true) {
-            readStringUntil("\r\n");
-        }
+        resync();
     } catch(const std::exception &e) {
 
     }
@@ -279,6 +324,11 @@ void CFasito::open(const string &devname)
     LOCK(cs_connection);
     SerialConnection::open(devname, 230400);
 
+    {
+        boost::unique_lock<boost::mutex> lock(cs_queue);
+        fStopQueue = false;
+    }
+
     emtpyInputBuffer();
 
     int i = 0;
@@ -333,8 +383,130 @@ void CFasito::open(const string &devname)
     fInitialized = true;
 }
 
+uint64_t CFasito::SubmitCommand(const string& strCommand, const CFasitoCallback& callback)
+{
+    if (!fInitialized)
+        return 0;
+
+    uint64_t nId;
+    {
+        boost::unique_lock<boost::mutex> lock(cs_queue);
+        if (fStopQueue)
+            return 0;
+
+        if (!pQueueThread)
+            pQueueThread = new boost::thread(boost::bind(&CFasito::ThreadQueue, this));
+
+        nId = ++nLastRequestId;
+        queue.push_back(CFasitoRequest(nId, strCommand, callback));
+    }
+    condQueue.notify_one();
+
+    return nId;
+}
+
+size_t CFasito::GetQueueSize()
+{
+    boost::unique_lock<boost::mutex> lock(cs_queue);
+    return queue.size();
+}
+
+void CFasito::ExecuteBatch(vector<CFasitoRequest>& vBatch)
+{
+    LOCK(cs_connection);
+
+    size_t i = 0;
+    try {
+        BOOST_FOREACH(const CFasitoRequest& request, vBatch) {
+            writeCommand(request.strCommand);
+        }
+
+        for (; i < vBatch.size(); i++) {
+            CFasitoRequest& request = vBatch[i];
+            request.fSuccess = receive(request.vLines);
+            if (!request.fSuccess)
+                request.strError = request.vLines.back();
+        }
+    } catch(const std::exception &e) {
+        LogPrintf("%s : Fasito command \"%s\" failed: %s\n", __func__, vBatch[i].strCommand.substr(0, 7), e.what());
+
+        for (; i < vBatch.size(); i++) {
+            vBatch[i].fSuccess = false;
+            vBatch[i].strError = e.what();
+        }
+
+        // the Fasito may still answer the failed commands, these answers are
+        // drained before the next command is written
+        setOutOfSync();
+    }
+}
+
+void CFasito::ThreadQueue()
+{
+    RenameThread("faircoin-fasito");
+
+    const size_t nDepth = std::max((int64_t)1, std::min(GetArg("-fasitopipeline", DEFAULT_FASITO_PIPELINE_DEPTH), (int64_t)MAX_FASITO_PIPELINE_DEPTH));
+
+    while (true) {
+        vector<CFasitoRequest> vBatch;
+        {
+            boost::unique_lock<boost::mutex> lock(cs_queue);
+            while (queue.empty() && !fStopQueue)
+                condQueue.wait(lock);
+
+            if (fStopQueue)
+                return;
+
+            while (!queue.empty() && vBatch.size() < nDepth) {
+                vBatch.push_back(queue.front());
+                queue.pop_front();
+            }
+        }
+
+        ExecuteBatch(vBatch);
+
+        BOOST_FOREACH(const CFasitoRequest& request, vBatch) {
+            LogPrint("fasito", "request %d %s: %s\n", request.nId, request.fSuccess ? "completed" : "failed", request.strCommand.substr(0, 7));
+            if (!request.callback.empty())
+                request.callback(request);
+        }
+    }
+}
+
+void CFasito::StopQueue()
+{
+    boost::thread *thread;
+    {
+        boost::unique_lock<boost::mutex> lock(cs_queue);
+        thread = pQueueThread;
+        pQueueThread = NULL;
+        fStopQueue = true;
+    }
+    condQueue.notify_all();
+
+    if (thread) {
+        thread->join();
+        delete thread;
+    }
+
+    // callbacks that submit a new command get a failure, the queue stays stopped
+    std::deque<CFasitoRequest> pending;
+    {
+        boost::unique_lock<boost::mutex> lock(cs_queue);
+        pending.swap(queue);
+    }
+
+    BOOST_FOREACH(CFasitoRequest& request, pending) {
+        request.strError = "Fasito closed";
+        if (!request.callback.empty())
+            request.callback(request);
+    }
+}
+
 void CFasito::close()
 {
+    StopQueue();
+
     LOCK(cs_connection);
 
     if (fLoggedIn)
@@ -378,7 +550,7 @@ bool InitFasito(const string& strPassword, string& strError)
 
     try {
         fasito.open(strDevice);
-        fasito.setTimeout(boost::posix_time::seconds(2));
+        fasito.setTimeout(boost::posix_time::seconds(FASITO_TIMEOUT));
 
         LogPrintf("detected Fasito %s, serial number: %s, user-PIN status: %s, protection status: %s\n",
                 fasito.strFasitoVersion, fasito.strSerialNumber, fasito.strPinStatus, fasito.strProtectionStatus);
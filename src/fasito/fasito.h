@@ -9,6 +9,17 @@
 #include "SerialConnection.h"
 #include "key.h"
 
+#include <deque>
+
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+/** Seconds to wait for a response of the Fasito */
+static const unsigned int FASITO_TIMEOUT = 2;
+/** Default for -fasitopipeline, the number of queued commands written to the Fasito before their responses are read */
+static const unsigned int DEFAULT_FASITO_PIPELINE_DEPTH = 4;
+static const unsigned int MAX_FASITO_PIPELINE_DEPTH = 16;
+
 enum CFasitoKeyStatus {
     EMPTY,
     SEEDED,
@@ -41,8 +52,58 @@ public:
     std::string ToString() const;
 };
 
+class CFasitoRequest;
+typedef boost::function<void (const CFasitoRequest&)> CFasitoCallback;
+
+/** A command that was queued for asynchronous execution on the Fasito */
+class CFasitoRequest
+{
+public:
+    uint64_t nId;
+    string strCommand;
+    CFasitoCallback callback;
+
+    bool fSuccess;
+    vector<string> vLines;
+    string strError;
+
+    CFasitoRequest()
+    {
+        nId = 0;
+        fSuccess = false;
+    }
+
+    CFasitoRequest(const uint64_t nIdIn, const string& strCommandIn, const CFasitoCallback& callbackIn) :
+        nId(nIdIn), strCommand(strCommandIn), callback(callbackIn), fSuccess(false) {}
+};
+
 class CFasito : public SerialConnection
 {
+private:
+    /**
+     * Commands are executed in the order they were submitted by the queue
+     * thread. Up to -fasitopipeline commands are written to the device before
+     * the first response is read. The Fasito processes them one after the
+     * other, the responses are therefore matched to the requests by their
+     * order. If a command times out, the connection is resynchronised before
+     * the next command is written (see SerialConnection::writeCommand()) and
+     * the other commands of its batch fail. The completion callbacks are run
+     * on the queue thread, one at a time and without holding cs_connection.
+     *
+     * The queue thread is stopped by StopQueue(), which Shutdown() calls
+     * while the state the callbacks use is still around. After that no
+     * commands are accepted until the Fasito is opened again.
+     */
+    CWaitableCriticalSection cs_queue;
+    CConditionVariable condQueue;
+    std::deque<CFasitoRequest> queue;
+    uint64_t nLastRequestId;
+    boost::thread *pQueueThread;
+    bool fStopQueue;
+
+    void ThreadQueue();
+    void ExecuteBatch(vector<CFasitoRequest>& vBatch);
+
 public:
     bool fInitialized;
     bool fLoggedIn;
@@ -62,11 +123,17 @@ public:
 
     vector<uint8_t> vNonceHandles;
 
-    CFasito()
+    CFasito() : nLastRequestId(0), pQueueThread(NULL), fStopQueue(false)
     {
         SetNull();
     }
 
+    ~CFasito()
+    {
+        // the callbacks must not run during static destruction
+        assert(!pQueueThread);
+    }
+
     void SetNull()
     {
         fInitialized = false;
@@ -90,10 +157,26 @@ public:
     bool login(const string& strPassword, string &strError);
     bool logout();
     void emtpyInputBuffer();
+
+    /**
+     * Queue a command for execution on the Fasito. The callback is run once the
+     * response is available or the command failed. Returns the ID of the request
+     * or 0 if the Fasito is not open.
+     */
+    uint64_t SubmitCommand(const string& strCommand, const CFasitoCallback& callback);
+    size_t GetQueueSize();
+
+    /** Wait for the queue thread and fail the requests that were not executed */
+    void StopQueue();
 };
 
 extern bool InitFasito(const string& strPassword, string& strError);
 extern uint32_t InitCVNWithFasito(const string &strFasitoPassword);
+extern bool CheckFasitoNonceKey(const uint8_t nKey, const CSchnorrPubKey& pubKey);
+extern string GetFasitoNonceCommand(const uint256& hashData, const uint8_t nKey);
+extern bool ParseFasitoNonce(const vector<string>& vLines, uint8_t& nHandle, CSchnorrNonce& noncePublic);
+extern string GetFasitoSignCommand(const uint256& hashToSign, const uint8_t nKey);
+extern bool ParseFasitoSignature(const vector<string>& vLines, CSchnorrSig& signature);
 extern bool CreateNonceWithFasito(const uint256& hashData, const uint8_t nKey, unsigned char *pPrivateData, CSchnorrNonce& noncePublic, const CSchnorrPubKey& pubKey);
 extern bool CvnSignWithFasito(const uint256 &hashToSign, const uint8_t nKey, CSchnorrSig& signaturee);
 extern bool CvnSignPartialWithFasito(const uint256& hashUnsignedBlock, const uint8_t nKey, const CSchnorrPubKey& sumPublicNoncesOthers, CSchnorrSig& signature, const int nPoolOffset);
@@ -0,0 +1,351 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_FLATHASHMAP_H
+#define BITCOIN_FLATHASHMAP_H
+
+#if defined(HAVE_CONFIG_H)
+#include "config/faircoin-config.h"
+#endif
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <iterator>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <boost/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+
+/**
+ * Hash map with open addressing and linear probing.
+ *
+ * The table is a flat array of 64-bit slots, each holding the low 32 bits of
+ * the key's hash and the index of the element. A lookup walks this array and
+ * only reads an element when the hash bits match. The elements themselves live
+ * in chunks of 64 that are never moved, so iterators, pointers and references
+ * to an element stay valid until it is erased, even when the table grows. The
+ * chunks also keep the hash of every element, so growing the table and erasing
+ * never hash a key again. Erased elements leave a tombstone in the table unless
+ * the next slot is empty, and their place in the chunk is reused later.
+ *
+ * Only the part of the std::unordered_map interface needed for CCoinsMap is
+ * provided. The order of iteration is the order of the element indexes.
+ */
+template<typename K, typename T, typename Hash>
+class CFlatHashMap
+{
+public:
+    typedef K key_type;
+    typedef T mapped_type;
+    typedef std::pair<const K, T> value_type;
+    typedef size_t size_type;
+
+private:
+    static const unsigned int CHUNK_BITS = 6;
+    static const uint32_t CHUNK_SIZE = 1 << CHUNK_BITS;
+    static const uint32_t END_INDEX = 0xffffffff;
+
+    // The low word of a slot is either one of these or the element index plus SLOT_FIRST_INDEX
+    static const uint32_t SLOT_EMPTY = 0;
+    static const uint32_t SLOT_DELETED = 1;
+    static const uint32_t SLOT_FIRST_INDEX = 2;
+
+    static const size_t MIN_SLOTS = 16;
+
+    struct Chunk
+    {
+        uint64_t nUsed; // bit i is set if element i is constructed
+        uint32_t hashes[CHUNK_SIZE];
+        typename boost::aligned_storage<sizeof(value_type), boost::alignment_of<value_type>::value>::type elements[CHUNK_SIZE];
+
+        Chunk() : nUsed(0) {}
+    };
+
+    Hash hasher;
+    std::vector<uint64_t> vSlots; // empty or a power of two in size
+    std::vector<Chunk*> vChunks;
+    std::vector<uint32_t> vFree;  // indexes of erased elements below nHighWater
+    uint32_t nHighWater;          // elements at or above this index were never used
+    size_t nSize;
+    size_t nDeleted;
+
+    static unsigned int CountTrailingZeros(uint64_t n)
+    {
+#if HAVE_DECL___BUILTIN_CLZLL
+        return 63 - __builtin_clzll(n & (~n + 1));
+#else
+        unsigned int nZeros = 0;
+        while (!(n & 1)) {
+            n >>= 1;
+            nZeros++;
+        }
+        return nZeros;
+#endif
+    }
+
+    static uint32_t SlotIndex(uint64_t nSlot) { return (uint32_t)nSlot; }
+    static uint32_t SlotHash(uint64_t nSlot) { return (uint32_t)(nSlot >> 32); }
+
+    uint32_t HashKey(const K& key) const { return (uint32_t)hasher(key); }
+    uint32_t& ElementHash(uint32_t idx) const { return vChunks[idx >> CHUNK_BITS]->hashes[idx & (CHUNK_SIZE - 1)]; }
+
+    value_type* Element(uint32_t idx) const
+    {
+        return reinterpret_cast<value_type*>(&vChunks[idx >> CHUNK_BITS]->elements[idx & (CHUNK_SIZE - 1)]);
+    }
+
+    /** Index of the first element at or after idx, END_INDEX if there is none */
+    uint32_t NextUsed(uint32_t idx) const
+    {
+        while (idx < nHighWater) {
+            uint64_t nUsed = vChunks[idx >> CHUNK_BITS]->nUsed >> (idx & (CHUNK_SIZE - 1));
+            if (nUsed)
+                return idx + CountTrailingZeros(nUsed);
+            idx = (idx | (CHUNK_SIZE - 1)) + 1;
+        }
+        return END_INDEX;
+    }
+
+    uint32_t Lookup(const K& key, uint32_t nHash) const
+    {
+        if (!nSize)
+            return END_INDEX;
+
+        size_t nMask = vSlots.size() - 1;
+        for (size_t pos = nHash & nMask; ; pos = (pos + 1) & nMask) {
+            uint64_t nSlot = vSlots[pos];
+            uint32_t nIndex = SlotIndex(nSlot);
+            if (nIndex == SLOT_EMPTY)
+                return END_INDEX;
+            if (nIndex != SLOT_DELETED && SlotHash(nSlot) == nHash && Element(nIndex - SLOT_FIRST_INDEX)->first == key)
+                return nIndex - SLOT_FIRST_INDEX;
+        }
+    }
+
+    /** Put element idx with hash nHash into the first free slot of its probe sequence */
+    void Link(uint32_t idx, uint32_t nHash)
+    {
+        size_t nMask = vSlots.size() - 1;
+        size_t pos = nHash & nMask;
+        while (SlotIndex(vSlots[pos]) > SLOT_DELETED)
+            pos = (pos + 1) & nMask;
+        if (SlotIndex(vSlots[pos]) == SLOT_DELETED)
+            nDeleted--;
+        vSlots[pos] = ((uint64_t)nHash << 32) | (idx + SLOT_FIRST_INDEX);
+    }
+
+    void Rehash(size_t nSlots)
+    {
+        std::vector<uint64_t>(nSlots, 0).swap(vSlots);
+        nDeleted = 0;
+        for (uint32_t idx = NextUsed(0); idx != END_INDEX; idx = NextUsed(idx + 1))
+            Link(idx, ElementHash(idx));
+    }
+
+    /** Add a copy of value, whose key must not be present yet and hashes to nHash */
+    uint32_t Emplace(const value_type& value, uint32_t nHash)
+    {
+        // Keep at most three quarters of the slots in use, and at least a
+        // quarter free right after a rehash
+        if ((nSize + nDeleted + 1) * 4 > vSlots.size() * 3) {
+            size_t nSlots = MIN_SLOTS;
+            while ((nSize + 1) * 2 > nSlots)
+                nSlots *= 2;
+            Rehash(nSlots);
+        }
+
+        uint32_t idx;
+        if (!vFree.empty()) {
+            idx = vFree.back();
+            vFree.pop_back();
+        } else {
+            assert(nHighWater < 0x80000000);
+            idx = nHighWater;
+            if ((idx >> CHUNK_BITS) == vChunks.size())
+                vChunks.push_back(new Chunk());
+            nHighWater++;
+        }
+
+        try {
+            new (Element(idx)) value_type(value);
+        } catch (...) {
+            vFree.push_back(idx);
+            throw;
+        }
+        vChunks[idx >> CHUNK_BITS]->nUsed |= (uint64_t)1 << (idx & (CHUNK_SIZE - 1));
+        ElementHash(idx) = nHash;
+        nSize++;
+
+        Link(idx, nHash);
+        return idx;
+    }
+
+    void Erase(uint32_t idx)
+    {
+        value_type* pelement = Element(idx);
+
+        size_t nMask = vSlots.size() - 1;
+        size_t pos = ElementHash(idx) & nMask;
+        while (SlotIndex(vSlots[pos]) != idx + SLOT_FIRST_INDEX)
+            pos = (pos + 1) & nMask;
+        // no probe sequence runs through this slot if the next one is empty
+        if (SlotIndex(vSlots[(pos + 1) & nMask]) == SLOT_EMPTY) {
+            vSlots[pos] = SLOT_EMPTY;
+        } else {
+            vSlots[pos] = SLOT_DELETED;
+            nDeleted++;
+        }
+
+        pelement->~value_type();
+        vChunks[idx >> CHUNK_BITS]->nUsed &= ~((uint64_t)1 << (idx & (CHUNK_SIZE - 1)));
+        vFree.push_back(idx);
+        nSize--;
+    }
+
+public:
+    template<typename V>
+    class iterator_base
+    {
+    private:
+        friend class CFlatHashMap;
+        template<typename> friend class iterator_base;
+
+        const CFlatHashMap* map;
+        uint32_t idx;
+
+        iterator_base(const CFlatHashMap* mapIn, uint32_t idxIn) : map(mapIn), idx(idxIn) {}
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef V value_type;
+        typedef ptrdiff_t difference_type;
+        typedef V* pointer;
+        typedef V& reference;
+
+        iterator_base() : map(NULL), idx(END_INDEX) {}
+        // iterator converts to const_iterator
+        iterator_base(const iterator_base<typename CFlatHashMap::value_type>& it) : map(it.map), idx(it.idx) {}
+
+        V& operator*() const { return *map->Element(idx); }
+        V* operator->() const { return map->Element(idx); }
+        iterator_base& operator++() { idx = map->NextUsed(idx + 1); return *this; }
+        iterator_base operator++(int) { iterator_base copy(*this); ++(*this); return copy; }
+
+        template<typename W>
+        bool operator==(const iterator_base<W>& it) const { return idx == it.idx; }
+        template<typename W>
+        bool operator!=(const iterator_base<W>& it) const { return idx != it.idx; }
+    };
+
+    typedef iterator_base<value_type> iterator;
+    typedef iterator_base<const value_type> const_iterator;
+
+    CFlatHashMap() : nHighWater(0), nSize(0), nDeleted(0) {}
+
+    CFlatHashMap(const CFlatHashMap& other) : hasher(other.hasher), nHighWater(0), nSize(0), nDeleted(0)
+    {
+        for (uint32_t idx = other.NextUsed(0); idx != END_INDEX; idx = other.NextUsed(idx + 1))
+            Emplace(*other.Element(idx), other.ElementHash(idx));
+    }
+
+    CFlatHashMap& operator=(const CFlatHashMap& other)
+    {
+        if (this != &other) {
+            CFlatHashMap copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    ~CFlatHashMap()
+    {
+        clear();
+    }
+
+    size_t size() const { return nSize; }
+    bool empty() const { return nSize == 0; }
+
+    iterator begin() { return iterator(this, NextUsed(0)); }
+    const_iterator begin() const { return const_iterator(this, NextUsed(0)); }
+    iterator end() { return iterator(this, END_INDEX); }
+    const_iterator end() const { return const_iterator(this, END_INDEX); }
+
+    iterator find(const K& key) { return iterator(this, Lookup(key, HashKey(key))); }
+    const_iterator find(const K& key) const { return const_iterator(this, Lookup(key, HashKey(key))); }
+    size_t count(const K& key) const { return Lookup(key, HashKey(key)) != END_INDEX; }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        uint32_t nHash = HashKey(value.first);
+        uint32_t idx = Lookup(value.first, nHash);
+        if (idx != END_INDEX)
+            return std::make_pair(iterator(this, idx), false);
+        return std::make_pair(iterator(this, Emplace(value, nHash)), true);
+    }
+
+    T& operator[](const K& key)
+    {
+        uint32_t nHash = HashKey(key);
+        uint32_t idx = Lookup(key, nHash);
+        if (idx == END_INDEX)
+            idx = Emplace(value_type(key, T()), nHash);
+        return Element(idx)->second;
+    }
+
+    iterator erase(const_iterator it)
+    {
+        uint32_t idx = it.idx;
+        Erase(idx);
+        return iterator(this, NextUsed(idx + 1));
+    }
+
+    size_t erase(const K& key)
+    {
+        uint32_t idx = Lookup(key, HashKey(key));
+        if (idx == END_INDEX)
+            return 0;
+        Erase(idx);
+        return 1;
+    }
+
+    /** Destroy all elements and release all memory */
+    void clear()
+    {
+        for (uint32_t idx = NextUsed(0); idx != END_INDEX; idx = NextUsed(idx + 1))
+            Element(idx)->~value_type();
+        for (size_t i = 0; i < vChunks.size(); i++)
+            delete vChunks[i];
+
+        std::vector<uint64_t>().swap(vSlots);
+        std::vector<Chunk*>().swap(vChunks);
+        std::vector<uint32_t>().swap(vFree);
+        nHighWater = 0;
+        nSize = 0;
+        nDeleted = 0;
+    }
+
+    void swap(CFlatHashMap& other)
+    {
+        std::swap(hasher, other.hasher);
+        vSlots.swap(other.vSlots);
+        vChunks.swap(other.vChunks);
+        vFree.swap(other.vFree);
+        std::swap(nHighWater, other.nHighWater);
+        std::swap(nSize, other.nSize);
+        std::swap(nDeleted, other.nDeleted);
+    }
+
+    //! Allocations, for memusage::DynamicUsage()
+    size_t slot_bytes() const { return vSlots.capacity() * sizeof(uint64_t); }
+    size_t chunk_count() const { return vChunks.size(); }
+    static size_t chunk_bytes() { return sizeof(Chunk); }
+    size_t chunk_list_bytes() const { return vChunks.capacity() * sizeof(Chunk*); }
+    size_t free_list_bytes() const { return vFree.capacity() * sizeof(uint32_t); }
+};
+
+#endif // BITCOIN_FLATHASHMAP_H
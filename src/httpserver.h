@@ -112,6 +112,8 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+    /** Write HTTP reply with the nSize bytes at pdata as body, see above. */
+    void WriteReply(int nStatus, const char* pdata, size_t nSize);
 };
 
 /** Event handler closure.
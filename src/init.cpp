@@ -11,9 +11,12 @@
 
 #include "addrman.h"
 #include "amount.h"
+#include "blockfilemap.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "checkpoints.h"
+#include "coinsflush.h"
+#include "coinsprefetch.h"
 #include "compat/sanity.h"
 #include "consensus/validation.h"
 #include "httpserver.h"
@@ -202,6 +205,10 @@ void Shutdown()
     if (pwalletMain)
         pwalletMain->Flush(false);
 #endif
+#ifdef USE_FASITO
+    // the queued callbacks use the nonce pools and the chain state
+    fasito.StopQueue();
+#endif
 #ifdef USE_CVN
     RunPOCThread(false, Params(), 0);
 #endif // USE_CVN
@@ -227,6 +234,10 @@ void Shutdown()
         }
         delete pcoinsTip;
         pcoinsTip = NULL;
+        delete pcoinsPrefetch;
+        pcoinsPrefetch = NULL;
+        delete pcoinsFlusher;
+        pcoinsFlusher = NULL;
         delete pcoinscatcher;
         pcoinscatcher = NULL;
         delete pcoinsdbview;
@@ -332,7 +343,9 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-version", _("Print version and exit"));
     strUsage += HelpMessageOpt("-alerts", strprintf(_("Receive and display P2P network alerts (default: %u)"), DEFAULT_ALERTS));
     strUsage += HelpMessageOpt("-alertnotify=<cmd>", _("Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)"));
+    strUsage += HelpMessageOpt("-backgroundflush", strprintf(_("Write the UTXO cache to disk in the background while new blocks are connected (default: %u)"), DEFAULT_BACKGROUND_FLUSH));
     strUsage += HelpMessageOpt("-bannedcvnnotify=<cmd>", _("Execute command when a malicious CVN is banned from the network (%s in cmd is replaced by CVN ID)"));
+    strUsage += HelpMessageOpt("-blockmapfiles=<n>", strprintf(_("Keep up to <n> block files mapped into memory for reading blocks (default: %d, 0 = read through the file system)"), DEFAULT_BLOCKFILE_MAPS));
     strUsage += HelpMessageOpt("-blocknotify=<cmd>", _("Execute command when the best block changes (%s in cmd is replaced by block hash)"));
     if (showDebug)
         strUsage += HelpMessageOpt("-blocksonly", strprintf(_("Whether to operate in a blocks only mode (default: %u)"), DEFAULT_BLOCKSONLY));
@@ -351,6 +364,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
     strUsage += HelpMessageOpt("-maxmempool=<n>", strprintf(_("Keep the transaction memory pool below <n> megabytes (default: %u)"), DEFAULT_MAX_MEMPOOL_SIZE));
     strUsage += HelpMessageOpt("-mempoolexpiry=<n>", strprintf(_("Do not keep transactions in the mempool longer than <n> hours (default: %u)"), DEFAULT_MEMPOOL_EXPIRY));
+    strUsage += HelpMessageOpt("-prefetchthreads=<n>", strprintf(_("Set the number of threads reading the inputs of a block ahead of connecting it (0 to %d, default: %d)"),
+        MAX_PREFETCH_THREADS, DEFAULT_PREFETCH_THREADS));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
 #ifndef WIN32
@@ -360,6 +375,7 @@ std::string HelpMessage(HelpMessageMode mode)
             "Warning: Reverting this setting requires re-downloading the entire blockchain. "
             "(default: 0 = disable pruning blocks, >%u = target size in MiB to use for block files)"), MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024));
     strUsage += HelpMessageOpt("-reindex", _("Rebuild block chain index from current blk000??.dat files on startup"));
+    strUsage += HelpMessageOpt("-reindex-cvnstate", _("Rebuild the CVN, chain admin, chain parameter and coin supply records of the block index from the blk000??.dat files on startup"));
 #ifndef WIN32
     strUsage += HelpMessageOpt("-sysperms", _("Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)"));
 #endif
@@ -371,6 +387,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-bantime=<n>", strprintf(_("Number of seconds to keep misbehaving peers from reconnecting (default: %u)"), DEFAULT_MISBEHAVING_BANTIME));
     strUsage += HelpMessageOpt("-bind=<addr>", _("Bind to given address and always listen on it. Use [host]:port notation for IPv6"));
     strUsage += HelpMessageOpt("-connect=<ip>", _("Connect only to the specified node(s); -noconnect or -connect=0 alone to disable automatic connections"));
+    strUsage += HelpMessageOpt("-cvnoverlay", strprintf(_("Keep connections to the other CVNs and send chain signatures straight to the next block creator (default: %u)"), DEFAULT_CVN_OVERLAY));
+    strUsage += HelpMessageOpt("-cvnoverlayaddr=<addr>", _("Address the other CVNs connect to for the CVN overlay (default: the best local address)"));
     strUsage += HelpMessageOpt("-discover", _("Discover own IP addresses (default: 1 when listening and no -externalip or -proxy)"));
     strUsage += HelpMessageOpt("-dns", _("Allow DNS lookups for -addnode, -seednode and -connect") + " " + strprintf(_("(default: %u)"), DEFAULT_NAME_LOOKUP));
     strUsage += HelpMessageOpt("-dnsseed", _("Query for peer addresses via DNS lookup, if low on addresses (default: 1 unless -connect/-noconnect)"));
@@ -1142,7 +1160,7 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler, const str
 
 #if 0
     CBlock genesisBlock = chainparams.GenesisBlock();
-    UpdateCvnInfo(&genesisBlock, 0);
+    UpdateCvnInfo(&genesisBlock, 0, genesisBlock.GetHash());
     UpdateChainAdmins(&genesisBlock);
 
     string strError;
@@ -1171,6 +1189,8 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler, const str
     if (nScriptCheckThreads) {
         for (int i=0; i<nScriptCheckThreads-1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
+        // a block carries two PoC signatures, the master of the queue verifies one of them
+        threadGroup.create_thread(&ThreadPocSignatureCheck);
     }
 
     // Start the lightweight task scheduler thread
@@ -1348,11 +1368,12 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler, const str
     // initialize CVN and chain parameters
     LogPrintf("Initialize CVN and chain parameters\n");
     CBlock genesis = chainparams.GenesisBlock();
-    UpdateCvnInfo(&genesis, 0);
+    UpdateCvnInfo(&genesis, 0, genesis.GetHash());
     UpdateChainParameters(&genesis);
     UpdateChainAdmins(&genesis);
 
     fReindex = GetBoolArg("-reindex", false);
+    fReindexCvnState = GetBoolArg("-reindex-cvnstate", false);
 
     // Upgrading to 0.8; hard-link the old blknnnn.dat files into /blocks/
     boost::filesystem::path blocksDir = GetDataDir() / "blocks";
@@ -1397,6 +1418,8 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler, const str
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set\n", nCoinCacheUsage * (1.0 / 1024 / 1024));
 
+    blockFileMapCache.SetMaxFiles(std::max(GetArg("-blockmapfiles", DEFAULT_BLOCKFILE_MAPS), (int64_t)0));
+
     bool fLoaded = false;
     while (!fLoaded) {
         bool fReset = fReindex;
@@ -1409,6 +1432,8 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler, const str
             try {
                 UnloadBlockIndex();
                 delete pcoinsTip;
+                delete pcoinsPrefetch;
+                delete pcoinsFlusher;
                 delete pcoinsdbview;
                 delete pcoinscatcher;
                 delete pblocktree;
@@ -1416,7 +1441,9 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler, const str
                 pblocktree = new CBlockTreeDB(nBlockTreeDBCache, false, fReindex);
                 pcoinsdbview = new CCoinsViewDB(nCoinDBCache, false, fReindex);
                 pcoinscatcher = new CCoinsViewErrorCatcher(pcoinsdbview);
-                pcoinsTip = new CCoinsViewCache(pcoinscatcher);
+                pcoinsFlusher = new CCoinsViewFlusher(pcoinscatcher, GetBoolArg("-backgroundflush", DEFAULT_BACKGROUND_FLUSH));
+                pcoinsPrefetch = new CCoinsViewPrefetch(pcoinsFlusher, GetArg("-prefetchthreads", DEFAULT_PREFETCH_THREADS));
+                pcoinsTip = new CCoinsViewCache(pcoinsPrefetch);
 
                 if (fReindex) {
                     pblocktree->WriteReindexing(true);
@@ -1471,7 +1498,7 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler, const str
                     }
                 }
 
-                if (!CVerifyDB().VerifyDB(chainparams, pcoinsdbview, GetArg("-checklevel", DEFAULT_CHECKLEVEL),
+                if (!CVerifyDB().VerifyDB(chainparams, pcoinsFlusher, GetArg("-checklevel", DEFAULT_CHECKLEVEL),
                               GetArg("-checkblocks", DEFAULT_CHECKBLOCKS))) {
                     strLoadError = _("Corrupted block database detected");
                     break;
@@ -9,9 +9,12 @@
 #include "addrman.h"
 #include "alert.h"
 #include "arith_uint256.h"
+#include "blockfilemap.h"
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "checkqueue.h"
+#include "coinsflush.h"
+#include "coinsprefetch.h"
 #include "consensus/consensus.h"
 #include "consensus/merkle.h"
 #include "consensus/validation.h"
@@ -67,6 +70,7 @@ CConditionVariable cvBlockChange;
 int nScriptCheckThreads = 0;
 bool fImporting = false;
 bool fReindex = false;
+bool fReindexCvnState = false;
 bool fTxIndex = false;
 bool fHavePruned = false;
 bool fPruneMode = false;
@@ -91,6 +95,7 @@ std::deque<std::pair<int64_t, uint256> > vRelayExpiration;
 CCriticalSection cs_mapRelay;
 
 map<uint256, CNoncePool> mapRelayNonces;
+map<uint256, CNoncePoolDelta> mapRelayNonceDeltas;
 deque<pair<int64_t, uint256> > vRelayExpirationNonces;
 CCriticalSection cs_mapRelayNonces;
 
@@ -289,6 +294,9 @@ struct CNodeState {
     bool fPreferredDownload;
     //! Whether this peer wants invs or headers (when possible) for block announcements.
     bool fPreferHeaders;
+    //! Full nonce pools requested from this peer since nNoncePoolRequestsSince, after their deltas did not apply.
+    unsigned int nNoncePoolRequests;
+    int64_t nNoncePoolRequestsSince;
 
     CNodeState() {
         fCurrentlyConnected = false;
@@ -305,6 +313,8 @@ struct CNodeState {
         nBlocksInFlightValidHeaders = 0;
         fPreferredDownload = false;
         fPreferHeaders = false;
+        nNoncePoolRequests = 0;
+        nNoncePoolRequestsSince = 0;
     }
 };
 
@@ -620,6 +630,8 @@ CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& loc
 }
 
 CCoinsViewCache *pcoinsTip = NULL;
+CCoinsViewPrefetch *pcoinsPrefetch = NULL;
+CCoinsViewFlusher *pcoinsFlusher = NULL;
 CBlockTreeDB *pblocktree = NULL;
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1371,10 +1383,55 @@ bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHea
     return true;
 }
 
+/**
+ * Locate the block stored at pos in a mapping of its block file. The block is
+ * preceded by the network magic and its size, which bound the returned range.
+ * Returns false if block files are not mapped or the prefix does not match.
+ */
+static bool GetMappedBlock(const CDiskBlockPos& pos, CMappedBlockFileRef& mapped, const char*& pbegin, unsigned int& nSize)
+{
+    if (pos.IsNull() || pos.nPos < MESSAGE_START_SIZE + sizeof(nSize))
+        return false;
+
+    mapped = blockFileMapCache.Get(pos.nFile, pos.nPos);
+    if (!mapped)
+        return false;
+
+    const char *pprefix = mapped->begin() + pos.nPos - MESSAGE_START_SIZE - sizeof(nSize);
+    if (memcmp(pprefix, Params().MessageStart(), MESSAGE_START_SIZE))
+        return false;
+    nSize = ReadLE32((const unsigned char*)pprefix + MESSAGE_START_SIZE);
+
+    if ((uint64_t)pos.nPos + nSize > mapped->size()) {
+        // the block was appended after the file was mapped
+        mapped = blockFileMapCache.Get(pos.nFile, (uint64_t)pos.nPos + nSize);
+        if (!mapped)
+            return false;
+    }
+
+    pbegin = mapped->begin() + pos.nPos;
+    return true;
+}
+
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
 {
     block.SetNull();
 
+    // Deserialize straight from the mapped file if possible
+    CMappedBlockFileRef mapped;
+    const char *pbegin;
+    unsigned int nSize;
+    if (GetMappedBlock(pos, mapped, pbegin, nSize)) {
+        try {
+            CBufferReader reader(pbegin, pbegin + nSize, SER_DISK, CLIENT_VERSION);
+            reader >> block;
+        }
+        catch (const std::exception& e) {
+            return error("%s: Deserialize error - %s at %s", __func__, e.what(), pos.ToString());
+        }
+        return true;
+    }
+
     // Open history file to read
     CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
     if (filein.IsNull())
@@ -1406,6 +1463,56 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus
     return true;
 }
 
+bool ReadRawBlockFromDisk(CRawBlock& block, const CBlockIndex* pindex)
+{
+    block.SetNull();
+
+    const CDiskBlockPos pos = pindex->GetBlockPos();
+    const char *pbegin;
+    unsigned int nSize;
+    if (GetMappedBlock(pos, block.mapped, pbegin, nSize)) {
+        block.pbegin = pbegin;
+        block.pend = pbegin + nSize;
+    } else {
+        if (pos.IsNull() || pos.nPos < MESSAGE_START_SIZE + sizeof(nSize))
+            return error("%s: invalid block position %s", __func__, pos.ToString());
+
+        // Open history file to read, starting at the magic and size in front of the block
+        CAutoFile filein(OpenBlockFile(CDiskBlockPos(pos.nFile, pos.nPos - MESSAGE_START_SIZE - sizeof(nSize)), true), SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+            return error("%s: OpenBlockFile failed for %s", __func__, pos.ToString());
+
+        try {
+            CMessageHeader::MessageStartChars messageStart;
+            filein >> FLATDATA(messageStart) >> nSize;
+            if (memcmp(messageStart, Params().MessageStart(), MESSAGE_START_SIZE) || nSize > MAX_SIZE)
+                return error("%s: invalid block prefix at %s", __func__, pos.ToString());
+
+            block.vchData.resize(nSize);
+            filein.read(begin_ptr(block.vchData), nSize);
+        }
+        catch (const std::exception& e) {
+            return error("%s: I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        }
+        block.pbegin = begin_ptr(block.vchData);
+        block.pend = end_ptr(block.vchData);
+    }
+
+    // Check the header
+    CBlockHeader header;
+    try {
+        CBufferReader reader(block.begin(), block.end(), SER_DISK, CLIENT_VERSION);
+        reader >> header;
+    }
+    catch (const std::exception& e) {
+        return error("%s: Deserialize error - %s at %s", __func__, e.what(), pos.ToString());
+    }
+    if (header.GetHash() != pindex->GetBlockHash())
+        return error("ReadRawBlockFromDisk(CRawBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
+                pindex->ToString(), pos.ToString());
+    return true;
+}
+
 bool IsInitialBlockDownload()
 {
     const CChainParams& chainParams = Params();
@@ -1946,6 +2053,10 @@ void static FlushBlockFile(bool fFinalize = false)
 
     CDiskBlockPos posOld(nLastBlockFile, 0);
 
+    // drop the mapping before truncating, pages past the new end would raise SIGBUS
+    if (fFinalize)
+        blockFileMapCache.Erase(nLastBlockFile);
+
     FILE *fileOld = OpenBlockFile(posOld);
     if (fileOld) {
         if (fFinalize)
@@ -1972,6 +2083,33 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+static CCheckQueue<CPocSignatureCheck> pocsigcheckqueue(16);
+
+/** Held by the master of the PoC signature check queue while it adds and waits for its checks */
+static CCriticalSection cs_pocsigcheckqueue;
+
+void ThreadPocSignatureCheck() {
+    RenameThread("faircoin-pocsigch");
+    pocsigcheckqueue.Thread();
+}
+
+bool RunPocSignatureChecks(std::vector<CPocSignatureCheck>& vChecks)
+{
+    // blocks may be processed by several threads, the others check serially
+    TRY_LOCK(cs_pocsigcheckqueue, lockQueue);
+    if (!nScriptCheckThreads || !lockQueue) {
+        BOOST_FOREACH(CPocSignatureCheck& check, vChecks) {
+            if (!check())
+                return false;
+        }
+        return true;
+    }
+
+    CCheckQueueControl<CPocSignatureCheck> pocControl(&pocsigcheckqueue);
+    pocControl.Add(vChecks);
+    return pocControl.Wait();
+}
+
 static int64_t nTimeCheck = 0;
 static int64_t nTimeForks = 0;
 static int64_t nTimeVerify = 0;
@@ -1987,8 +2125,10 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 
     int64_t nTimeStart = GetTimeMicros();
 
-    // Check it again in case a previous version let a bad block in
-    if (!CheckBlock(block, state, !fJustCheck, !fJustCheck))
+    // Check it again in case a previous version let a bad block in. The creator
+    // and chain signatures are verified once the script checks are queued.
+    std::vector<CPocSignatureCheck> vPocChecks;
+    if (!CheckBlock(block, state, !fJustCheck, !fJustCheck, nScriptCheckThreads ? &vPocChecks : NULL))
         return false;
 
     // verify that the view's current state corresponds to the previous block
@@ -2078,6 +2218,11 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     }
     int64_t nTime3 = GetTimeMicros(); nTimeConnect += nTime3 - nTime2;
     LogPrint("bench", "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs]\n", (unsigned)block.vtx.size(), 0.001 * (nTime3 - nTime2), 0.001 * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : 0.001 * (nTime3 - nTime2) / (nInputs-1), nTimeConnect * 0.000001);
+    if (fDebug && pcoinsPrefetch && pcoinsPrefetch->IsEnabled()) {
+        uint64_t nRequested, nDropped, nFetched, nHits, nMisses;
+        pcoinsPrefetch->GetPrefetchStats(nRequested, nDropped, nFetched, nHits, nMisses);
+        LogPrint("bench", "      - Prefetch: %u requested, %u dropped, %u fetched, %u hits, %u misses\n", nRequested, nDropped, nFetched, nHits, nMisses);
+    }
 
     if (block.HasCoinSupplyPayload()) {
         if (block.vtx[0].vout.size() != 2)
@@ -2126,8 +2271,13 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                                block.vtx[0].GetValueOut(), nFees),
                                REJECT_INVALID, "bad-cb-amount");
 
+    // the script check threads are busy with this block in the meantime
+    const bool fPocValid = RunPocSignatureChecks(vPocChecks);
     if (!control.Wait())
         return state.DoS(100, false);
+    if (!fPocValid)
+        return state.DoS(2, error("ConnectBlock(): poc signature check failed"),
+                         REJECT_INVALID, "poc-failed", true);
     uint64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
     LogPrint("bench", "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs]\n", nInputs - 1, 0.001 * (nTime4 - nTime2), nInputs <= 1 ? 0 : 0.001 * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * 0.000001);
 
@@ -2222,6 +2372,11 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode) {
         nLastSetChain = nNow;
     }
     size_t cacheSize = pcoinsTip->DynamicMemoryUsage();
+    if (pcoinsPrefetch)
+        cacheSize += pcoinsPrefetch->DynamicMemoryUsage();
+    // A generation still being written in the background counts against -dbcache too.
+    if (pcoinsFlusher)
+        cacheSize += pcoinsFlusher->DynamicMemoryUsage();
     // The cache is large and close to the limit, but we have time now (not in the middle of a block processing).
     bool fCacheLarge = mode == FLUSH_STATE_PERIODIC && cacheSize * (10.0/9) > nCoinCacheUsage;
     // The cache is over the limit, we have to write now.
@@ -2272,8 +2427,12 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode) {
         if (!CheckDiskSpace(128 * 2 * 2 * pcoinsTip->GetCacheSize()))
             return state.Error("out of disk space");
         // Flush the chainstate (which may refer to block index entries).
+        // The coins are written in the background unless the caller relies
+        // on the database being up to date, or block files are being pruned.
         if (!pcoinsTip->Flush())
             return AbortNode(state, "Failed to write to coin database");
+        if ((mode == FLUSH_STATE_ALWAYS || fFlushForPrune) && pcoinsFlusher && !pcoinsFlusher->Sync())
+            return AbortNode(state, "Failed to write to coin database");
         nLastFlush = nNow;
     }
     if (fDoFullFlush || ((mode == FLUSH_STATE_ALWAYS || mode == FLUSH_STATE_PERIODIC) && nNow > nLastSetChain + (int64_t)DATABASE_WRITE_INTERVAL * 1000000)) {
@@ -2382,8 +2541,19 @@ bool static DisconnectTip(CValidationState& state, const Consensus::Params& cons
     // UpdateTransactionsFromBlock finds descendants of any transactions in this
     // block that were added back and cleans up the mempool state.
     mempool.UpdateTransactionsFromBlock(vHashUpdate);
+    // Restore the CVN set, chain admins and chain parameters of the new tip
+    if (block.HasCoinSupplyPayload() && block.coinSupply.fFinalCoinsSupply)
+        fCoinSupplyFinal = false;
+    if (block.nVersion & CBlock::CVN_PAYLOAD)
+        RemoveFromCvnInfoCache(pindexDelete);
+    if (block.nVersion & (CBlock::CVN_PAYLOAD | CBlock::CHAIN_PARAMETERS_PAYLOAD | CBlock::CHAIN_ADMINS_PAYLOAD)) {
+        if (!SetMostRecentCVNData(Params(), pindexDelete->pprev))
+            return error("DisconnectTip(): could not restore the CVN data of %s", pindexDelete->pprev->GetBlockHash().ToString());
+    }
     // Update chainActive and related variables.
     UpdateTip(pindexDelete->pprev);
+    creatorTracker.DisconnectTip(pindexDelete);
+    cvnAdmissions.DisconnectTip(pindexDelete);
     // Let wallets know transactions went from 1-confirmed to
     // 0-confirmed or conflicted:
     BOOST_FOREACH(const CTransaction &tx, block.vtx) {
@@ -2442,7 +2612,11 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
     list<CTransaction> txConflicted;
     mempool.removeForBlock(pblock->vtx, pindexNew->nHeight, txConflicted, !IsInitialBlockDownload());
     // Update chainActive & related variables.
+    if (pindexNew->nChainSigs < 0)
+        SetChainSigs(pindexNew);
     UpdateTip(pindexNew);
+    creatorTracker.ConnectTip(pindexNew);
+    cvnAdmissions.ConnectTip(pindexNew, *pblock);
     // Tell wallet about transactions that went from mempool
     // to conflicted:
     BOOST_FOREACH(const CTransaction &tx, txConflicted) {
@@ -2457,14 +2631,18 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
     LogPrint("bench", "  - Connect postprocess: %.2fms [%.2fs]\n", (nTime6 - nTime5) * 0.001, nTimePostConnect * 0.000001);
     LogPrint("bench", "- Connect block: %.2fms [%.2fs]\n", (nTime6 - nTime1) * 0.001, nTimeTotal * 0.000001);
 
-    if (pblock->HasCvnInfo())
-        UpdateCvnInfo(pblock, pindexNew->nHeight);
+    {
+        CCvnSetInfoBatch batch;
+
+        if (pblock->HasCvnInfo())
+            UpdateCvnInfo(pblock, pindexNew->nHeight, pindexNew->GetBlockHash());
 
-    if (pblock->HasChainParameters())
-        UpdateChainParameters(pblock);
+        if (pblock->HasChainParameters())
+            UpdateChainParameters(pblock);
 
-    if (pblock->HasChainAdmins())
-        UpdateChainAdmins(pblock);
+        if (pblock->HasChainAdmins())
+            UpdateChainAdmins(pblock);
+    }
 
     if (pblock->HasCoinSupplyPayload()) {
         SetCoinSupplyStatus(pblock);
@@ -2483,6 +2661,7 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
 
         CheckNoncePools(pindexNew);
         ExpireChainAdminData();
+        sigLatencyStats.NewTip(pindexNew->GetBlockHash());
     }
 
     return true;
@@ -2817,6 +2996,7 @@ CBlockIndex* AddToBlockIndex(const CBlockHeader& block, const vector<uint32_t>*
         pindexNew->BuildSkip();
     }
     pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 1) + GetBlockProof(*pindexNew);
+    SetChainSigs(pindexNew);
     pindexNew->RaiseValidity(BLOCK_VALID_TREE);
     if (pindexBestHeader == NULL || pindexBestHeader->nChainWork < pindexNew->nChainWork)
         pindexBestHeader = pindexNew;
@@ -2981,7 +3161,7 @@ bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, bool f
     return true;
 }
 
-bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOC, bool fCheckMerkleRoot)
+bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOC, bool fCheckMerkleRoot, std::vector<CPocSignatureCheck> *pvPocChecks)
 {
     // These are checks that are independent of context.
 
@@ -2995,7 +3175,7 @@ bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOC, bo
 
     if (fCheckPOC) {
         // check for correct signature of the block hash by the creator
-        if (!CheckProofOfCooperation(block, Params().GetConsensus()))
+        if (!CheckProofOfCooperation(block, Params().GetConsensus(), pvPocChecks))
             return state.DoS(2, error("CheckBlock(): poc failed"),
                     REJECT_INVALID, "poc-failed", true);;
 
@@ -3096,7 +3276,8 @@ bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOC, bo
 
     }
 
-    if (fCheckPOC && fCheckMerkleRoot)
+    // deferred signature checks have not been done yet
+    if (fCheckPOC && fCheckMerkleRoot && (!pvPocChecks || pvPocChecks->empty()))
         block.fChecked = true;
 
     return true;
@@ -3124,10 +3305,18 @@ bool HasEnoughSignatures(CBlockIndex * const pindexPrev, const uint32_t nSignatu
 
     // calculate the mean of the number of the signatures from
     // the last dynParams.nBlocksToConsiderForSigCheck blocks
-    while (nBlocks < dynParams.nBlocksToConsiderForSigCheck && pindex != NULL) {
-        nSignatures += GetNumChainSigs(pindex);
-        pindex = pindex->pprev;
-        nBlocks++;
+    const int nFirstHeight = pindexPrev ? pindexPrev->nHeight - (int)dynParams.nBlocksToConsiderForSigCheck : -1;
+    const CBlockIndex *pindexFirst = nFirstHeight >= 0 ? pindexPrev->GetAncestor(nFirstHeight) : NULL;
+
+    if (pindexPrev && pindexPrev->nChainSigs >= 0 && (!pindexFirst || pindexFirst->nChainSigs >= 0)) {
+        nSignatures = pindexPrev->nChainSigs - (pindexFirst ? pindexFirst->nChainSigs : 0);
+        nBlocks = pindexPrev->nHeight - (pindexFirst ? nFirstHeight : -1);
+    } else {
+        while (nBlocks < dynParams.nBlocksToConsiderForSigCheck && pindex != NULL) {
+            nSignatures += GetNumChainSigs(pindex);
+            pindex = pindex->pprev;
+            nBlocks++;
+        }
     }
 
     float nSignaturesMean = nBlocks ? (float) nSignatures / (float) nBlocks : 0.0f;
@@ -3191,7 +3380,7 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
 
             // if we have received the header first vMissingSignerIds was not set
             if (vMissingSignerIds && !vMissingSignerIds->empty())
-                pindex->vMissingSignerIds = *vMissingSignerIds;
+                pindex->SetMissingSignerIds(*vMissingSignerIds);
 
             // same goes for creatorSig (which is not set initially when receiving block header)
             if (!creatorSig.IsNull())
@@ -3231,6 +3420,42 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
     return true;
 }
 
+/** Keep the admin payload of a block in the block tree DB, see CCvnStateRecord */
+static bool WriteCvnStateRecord(const CBlock& block)
+{
+    CCvnStateRecord record;
+    if (!record.FromBlock(block))
+        return false;
+
+    if (!pblocktree->WriteCvnState(block.GetHash(), record))
+        return error("%s: failed to write CVN state record of block %s", __func__, block.GetHash().ToString());
+
+    return true;
+}
+
+/**
+ * Get the admin payload of a block from the block tree DB. If there is no record
+ * of the current version or fFromDisk is set, the block is read from disk and its
+ * record is (re)written.
+ */
+static bool ReadCvnStateRecord(CCvnStateRecord& record, const CBlockIndex* pindex, const Consensus::Params& consensusParams, const bool fFromDisk = false)
+{
+    if (!fFromDisk && pblocktree->ReadCvnState(pindex->GetBlockHash(), record))
+        return true;
+
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, consensusParams))
+        return error("%s: ReadBlockFromDisk failed at %d, hash=%s", __func__, pindex->nHeight, pindex->GetBlockHash().ToString());
+
+    if (!record.FromBlock(block))
+        return false;
+
+    if (!pblocktree->WriteCvnState(pindex->GetBlockHash(), record))
+        LogPrintf("%s: failed to write CVN state record of block %s\n", __func__, pindex->GetBlockHash().ToString());
+
+    return true;
+}
+
 /** Store block on disk. If dbp is non-NULL, the file is known to already reside on disk */
 static bool AcceptBlock(const CBlock& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, CDiskBlockPos* dbp)
 {
@@ -3285,6 +3510,8 @@ static bool AcceptBlock(const CBlock& block, CValidationState& state, const CCha
                 AbortNode(state, "Failed to write block");
         if (!ReceivedBlockTransactions(block, state, pindex, blockPos))
             return error("AcceptBlock(): ReceivedBlockTransactions failed");
+        if (block.HasAdminPayload() && !WriteCvnStateRecord(block))
+            return AbortNode(state, "Failed to write CVN state record");
     } catch (const std::runtime_error& e) {
         return AbortNode(state, std::string("System error: ") + e.what());
     }
@@ -3340,10 +3567,78 @@ bool CheckDuplicateBlock(CValidationState &state, const CChainParams& chainparam
     return true;
 }
 
+/**
+ * Start reading the coins spent by pblock from the database while it is checked.
+ * Only blocks signed by their creator are read ahead, so a peer can not make
+ * us read coins for blocks nobody created.
+ */
+static void PrefetchBlockInputs(const CBlock* pblock)
+{
+    if (!pcoinsPrefetch || !pcoinsPrefetch->IsEnabled() || pblock->vtx.size() < 2)
+        return;
+
+    CValidationState stateDummy;
+    if (!CheckBlockHeader(*pblock, stateDummy, true) || !CvnVerifySignature(pblock->GetHash(), pblock->creatorSignature, pblock->nCreatorId))
+        return;
+
+    std::set<uint256> setBlockTxids;
+    BOOST_FOREACH(const CTransaction& tx, pblock->vtx)
+        setBlockTxids.insert(tx.GetHash());
+
+    std::vector<uint256> vTxids;
+    BOOST_FOREACH(const CTransaction& tx, pblock->vtx) {
+        if (tx.IsCoinBase())
+            continue;
+        BOOST_FOREACH(const CTxIn& txin, tx.vin) {
+            // outputs created within the block are not in the database
+            if (!setBlockTxids.count(txin.prevout.hash))
+                vTxids.push_back(txin.prevout.hash);
+        }
+    }
+
+    std::sort(vTxids.begin(), vTxids.end());
+    vTxids.erase(std::unique(vTxids.begin(), vTxids.end()), vTxids.end());
+
+    // coins the cache already holds would never be asked for
+    std::vector<uint256> vMissing;
+    {
+        LOCK(cs_main);
+        BOOST_FOREACH(const uint256& txid, vTxids) {
+            if (!pcoinsTip->HaveCoinsInCache(txid))
+                vMissing.push_back(txid);
+        }
+    }
+    pcoinsPrefetch->Prefetch(vMissing);
+}
+
+/**
+ * CheckBlock() for a new block with its PoC signatures verified on the
+ * signature check queue. The block is marked as checked, ConnectBlock() does
+ * not verify them again.
+ */
+static bool CheckNewBlock(const CBlock& block, CValidationState& state)
+{
+    std::vector<CPocSignatureCheck> vPocChecks;
+    if (!CheckBlock(block, state, true, true, &vPocChecks))
+        return false;
+
+    if (vPocChecks.empty())
+        return true;
+
+    if (!RunPocSignatureChecks(vPocChecks))
+        return state.DoS(2, error("CheckBlock(): poc signature check failed"),
+                         REJECT_INVALID, "poc-failed", true);
+
+    block.fChecked = true;
+    return true;
+}
+
 bool ProcessNewBlock(CValidationState& state, const CChainParams& chainparams, const CNode* pfrom, const CBlock* pblock, bool fForceProcessing, CDiskBlockPos* dbp)
 {
+    PrefetchBlockInputs(pblock);
+
     // Preliminary checks
-    bool checked = CheckBlock(*pblock, state);
+    bool checked = CheckNewBlock(*pblock, state);
 
     CBlockIndex *pindex = NULL;
     {
@@ -3450,6 +3745,7 @@ void UnlinkPrunedFiles(std::set<int>& setFilesToPrune)
 {
     for (set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         CDiskBlockPos pos(*it, 0);
+        blockFileMapCache.Erase(*it);
         boost::filesystem::remove(GetBlockPosFilename(pos, "blk"));
         boost::filesystem::remove(GetBlockPosFilename(pos, "rev"));
         LogPrintf("Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
@@ -3592,22 +3888,29 @@ bool static LoadBlockIndexDB()
     {
         CBlockIndex* pindex = item.second;
 
-        if ((pindex->nVersion & CBlock::CVN_PAYLOAD) && pindex->IsValid(BLOCK_VALID_TRANSACTIONS)) {
-            CachedCvnType::iterator it = mapChachedCVNInfoBlocks.find(pindex->GetBlockHash());
+        if ((pindex->nVersion & CBlock::ADMIN_PAYLOAD_MASK) && pindex->IsValid(BLOCK_VALID_TRANSACTIONS)) {
+            const bool fCvnPayload = pindex->nVersion & CBlock::CVN_PAYLOAD;
 
-            if (it == mapChachedCVNInfoBlocks.end()) {
-                CBlock block;
-                if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus())) {
+            if (fReindexCvnState || (fCvnPayload && !mapChachedCVNInfoBlocks.count(pindex->GetBlockHash()))) {
+                // the CVN state records spare us from reading the blocks from disk
+                CCvnStateRecord record;
+                if (!ReadCvnStateRecord(record, pindex, chainparams.GetConsensus(), fReindexCvnState)) {
                     LogPrintf("FATAL: Failed to read block %s\n", pindex->GetBlockHash().ToString());
                     return false;
                 }
-                mapChachedCVNInfoBlocks[pindex->GetBlockHash()] = block.vCvns;
-                if (!AddToCvnInfoCache(&block, pindex->nHeight))
-                    return false;
+
+                if (fCvnPayload) {
+                    CBlock block;
+                    record.ToBlock(block);
+                    mapChachedCVNInfoBlocks[pindex->GetBlockHash()] = record.vCvns;
+                    if (!AddToCvnInfoCache(&block, pindex->nHeight, pindex->GetBlockHash(), &record.sumOfAllPubKeys))
+                        return false;
+                }
             }
         }
 
         pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
+        SetChainSigs(pindex);
 #if 0
         LogPrintf("LoadBlockIndexDB : nVersion: 0x%08x, nHeight: %u, nChainwork: %s, nStatus: %u, blockHash: %s, sigs: %u\n",
                 pindex->nVersion, pindex->nHeight, pindex->nChainWork.ToString(), pindex->nStatus, pindex->GetBlockHash().ToString(),
@@ -3638,6 +3941,11 @@ bool static LoadBlockIndexDB()
             pindexBestHeader = pindex;
     }
 
+    if (fReindexCvnState) {
+        LogPrintf("%s: CVN state records rebuilt\n", __func__);
+        fReindexCvnState = false;
+    }
+
     // Load block file info
     pblocktree->ReadLastBlockFile(nLastBlockFile);
     vinfoBlockFile.resize(nLastBlockFile + 1);
@@ -3713,18 +4021,22 @@ CVerifyDB::~CVerifyDB()
     uiInterface.ShowProgress("", 100);
 }
 
-bool CVerifyDB::SetMostRecentCVNData(const CChainParams& chainparams, CBlockIndex* pindexStart)
+bool SetMostRecentCVNData(const CChainParams& chainparams, CBlockIndex* pindexStart)
 {
     bool fFoundCvnInfoPayload = false, fFoundDynamicChainParamsPayload = false, fFoundChainAdminsPayload = false;
+    CCvnSetInfoBatch batch;
 
     for (CBlockIndex* pindex = pindexStart; pindex; pindex = pindex->pprev) {
         if (pindex->nVersion & (CBlock::CVN_PAYLOAD | CBlock::CHAIN_PARAMETERS_PAYLOAD | CBlock::CHAIN_ADMINS_PAYLOAD)) {
+            CCvnStateRecord record;
+            if (!ReadCvnStateRecord(record, pindex, chainparams.GetConsensus()))
+                return error("SetMostrecentCVNData(): *** ReadCvnStateRecord failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+
             CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
-                return error("SetMostrecentCVNData(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+            record.ToBlock(block);
 
             if (!fFoundCvnInfoPayload && block.HasCvnInfo()) {
-                UpdateCvnInfo(&block, pindex->nHeight);
+                UpdateCvnInfo(&block, pindex->nHeight, pindex->GetBlockHash(), &record.sumOfAllPubKeys);
                 fFoundCvnInfoPayload = true;
             }
 
@@ -3754,11 +4066,16 @@ bool CVerifyDB::SetMostRecentCVNData(const CChainParams& chainparams, CBlockInde
 
     for (CBlockIndex* pindex = pindexStart; pindex; pindex = pindex->pprev) {
         if (pindex->nVersion & CBlock::COIN_SUPPLY_PAYLOAD) {
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
-                return error("SetMostrecentCVNData(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+            CCvnStateRecord record;
+            if (!ReadCvnStateRecord(record, pindex, chainparams.GetConsensus()))
+                return error("SetMostrecentCVNData(): *** ReadCvnStateRecord failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
 
+            CBlock block;
+            record.ToBlock(block);
             SetCoinSupplyStatus(&block);
+
+            // no coin supply is accepted after a final one, the most recent one tells
+            break;
         }
     }
 
@@ -3854,14 +4171,18 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
             if (!ConnectBlock(block, state, pindex, coins))
                 return error("VerifyDB(): *** found unconnectable block at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
 
-            if (block.HasCvnInfo())
-                UpdateCvnInfo(&block, pindex->nHeight);
+            {
+                CCvnSetInfoBatch batch;
 
-            if (block.HasChainParameters())
-                UpdateChainParameters(&block);
+                if (block.HasCvnInfo())
+                    UpdateCvnInfo(&block, pindex->nHeight, pindex->GetBlockHash());
 
-            if (block.HasChainAdmins())
-                UpdateChainAdmins(&block);
+                if (block.HasChainParameters())
+                    UpdateChainParameters(&block);
+
+                if (block.HasChainAdmins())
+                    UpdateChainAdmins(&block);
+            }
 
             if (block.HasCoinSupplyPayload())
                 SetCoinSupplyStatus(&block);
@@ -3872,6 +4193,10 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
     if (!SetMostRecentCVNData(chainparams, chainActive.Tip()))
         return error("VerifyDB(): *** final SetMostRecentCVNData failed at %d, hash=%s", chainActive.Tip()->nHeight, chainActive.Tip()->GetBlockHash().ToString());
 
+    creatorTracker.Rebuild(chainActive.Tip());
+    if (!cvnAdmissions.Load(chainActive.Tip()))
+        LogPrintf("VerifyDB(): could not load the CVN admission index\n");
+
     LogPrintf("No coin database inconsistencies in last %i blocks (%i transactions)\n", chainActive.Height() - pindexState->nHeight, nGoodTransactions);
 
     return true;
@@ -4346,6 +4671,7 @@ bool static AlreadyHave(const CInv& inv) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
     case MSG_BLOCK:
         return mapBlockIndex.count(inv.hash);
     case MSG_CVN_PUB_NONCE_POOL:
+    case MSG_CVN_PUB_NONCE_POOL_DELTA:
         return mapRelayNonces.count(inv.hash);
     case MSG_CVN_SIGNATURE:
         return mapRelaySigs.count(inv.hash);
@@ -4378,16 +4704,10 @@ void static AdvertiseNoncesAndSigs(CNode *pfrom)
     const uint256 hashPrevBlock = tip->GetBlockHash();
     const uint32_t nNextCreator = CheckNextBlockCreator(tip, GetAdjustedTime());
 
-    vector<CCvnPartialSignature> sigs;
-    if (sigHolder.GetSignatures(sigs)) {
-        BOOST_FOREACH(const CCvnPartialSignature &s, sigs) {
-            if (s.hashPrevBlock != hashPrevBlock || s.nCreatorId != nNextCreator) {
-                LogPrintf("AdvertiseSigsAndNonces : not sending outdated signature: 0x%08x vs 0x%08x, %s vs %s\n", s.nCreatorId, nNextCreator, s.hashPrevBlock.ToString(), hashPrevBlock.ToString());
-                continue;
-            }
-
-            pfrom->PushInventory(CInv(MSG_CVN_SIGNATURE, s.GetHash()));
-        }
+    vector<uint256> vSigHashes;
+    if (sigHolder.GetSignatureHashes(vSigHashes, hashPrevBlock, nNextCreator)) {
+        BOOST_FOREACH(const uint256 &hash, vSigHashes)
+            pfrom->PushInventory(CInv(MSG_CVN_SIGNATURE, hash));
     }
 }
 
@@ -4452,12 +4772,15 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
                 // it's available before trying to send.
                 if (send && (mi->second->nStatus & BLOCK_HAVE_DATA))
                 {
-                    // Send block from disk
+                    // Send block from disk, full blocks are passed through without decoding them
                     CBlock block;
-                    if (!ReadBlockFromDisk(block, (*mi).second, consensusParams))
+                    if (inv.type != MSG_BLOCK && !ReadBlockFromDisk(block, (*mi).second, consensusParams))
                         assert(!"cannot load block from disk");
                     if (inv.type == MSG_BLOCK) {
-                        pfrom->PushMessage(NetMsgType::BLOCK, block);
+                        CRawBlock rawBlock;
+                        if (!ReadRawBlockFromDisk(rawBlock, (*mi).second))
+                            assert(!"cannot load block from disk");
+                        pfrom->PushMessage(NetMsgType::BLOCK, rawBlock);
                         pfrom->nTimeSinceLastBlockSent = GetTime();
                     }
                     else if(inv.type == MSG_FILTERED_EXTENDED_BLOCK) {
@@ -4520,15 +4843,25 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
                     AdvertiseNoncesAndSigs(pfrom);
                 }
             }
-            else if (inv.type == MSG_CVN_PUB_NONCE_POOL) {
+            else if (inv.type == MSG_CVN_PUB_NONCE_POOL || inv.type == MSG_CVN_PUB_NONCE_POOL_DELTA) {
                 CNoncePool *noncePool = NULL;
+                CNoncePoolDelta *noncePoolDelta = NULL;
                 {
                     LOCK(cs_mapRelayNonces);
                     map<uint256, CNoncePool>::iterator mi = mapRelayNonces.find(inv.hash);
                     if (mi != mapRelayNonces.end())
                         noncePool = &(*mi).second;
+
+                    if (inv.type == MSG_CVN_PUB_NONCE_POOL_DELTA) {
+                        map<uint256, CNoncePoolDelta>::iterator md = mapRelayNonceDeltas.find(inv.hash);
+                        if (md != mapRelayNonceDeltas.end())
+                            noncePoolDelta = &(*md).second;
+                    }
                 }
-                if (noncePool)
+                // the delta is only of use if the peer has seen the pool it is based on
+                if (noncePoolDelta && pfrom->HasInventoryKnown(noncePoolDelta->hashPrevPool))
+                    pfrom->PushMessage(NetMsgType::NONCEPOOLDELTA, *noncePoolDelta);
+                else if (noncePool)
                     pfrom->PushMessage(NetMsgType::NONCEPOOL, *noncePool);
                 else
                     vNotFound.push_back(inv);
@@ -4633,6 +4966,45 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
     }
 }
 
+/** When a full nonce pool was last requested because its delta did not apply, protected by cs_main */
+static map<uint256, int64_t> mapNoncePoolRequested;
+
+/**
+ * Whether the full nonce pool hashPool may be requested from a peer after its
+ * delta did not apply. A delta is cheap to send and the pool is not, so the
+ * requests are limited per pool and per peer. Limiting per pool, not per CVN,
+ * keeps a replayed old delta from blocking the request for the current pool.
+ */
+static bool AllowNoncePoolRequest(NodeId nodeid, const uint256& hashPool)
+{
+    AssertLockHeld(cs_main);
+    const int64_t nNow = GetTime();
+
+    map<uint256, int64_t>::iterator it = mapNoncePoolRequested.begin();
+    while (it != mapNoncePoolRequested.end()) {
+        if (nNow - it->second >= NONCE_POOL_REQUEST_INTERVAL)
+            mapNoncePoolRequested.erase(it++);
+        else
+            it++;
+    }
+
+    if (mapNoncePoolRequested.count(hashPool))
+        return false;
+
+    CNodeState *state = State(nodeid);
+    if (nNow - state->nNoncePoolRequestsSince >= NONCE_POOL_REQUEST_INTERVAL) {
+        state->nNoncePoolRequestsSince = nNow;
+        state->nNoncePoolRequests = 0;
+    }
+
+    if (state->nNoncePoolRequests >= MAX_NONCE_POOL_REQUESTS_PER_PEER)
+        return false;
+
+    state->nNoncePoolRequests++;
+    mapNoncePoolRequested[hashPool] = nNow;
+    return true;
+}
+
 bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams)
 {
     LogPrint("net", "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->id);
@@ -4762,6 +5134,9 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
 
         pfrom->fSuccessfullyConnected = true;
 
+        // the POC thread waits for peers before it starts
+        NotifyPocThread();
+
         string remoteAddr;
         if (fLogIPs)
             remoteAddr = ", peeraddr=" + pfrom->addr.ToString();
@@ -4806,6 +5181,12 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
         // Advertise the chain signatures and public nonces we've got
         if (pfrom->fRelayPoCMessages && pfrom->nStartingHeight == chainActive.Height())
             AdvertiseNoncesAndSigs(pfrom);
+
+        // and the addresses of the CVNs that accept overlay connections
+        if (pfrom->fRelayPoCMessages) {
+            AdvertiseCvnAddrs(pfrom);
+            SendCvnChallenge(pfrom);
+        }
     }
 
 
@@ -4934,8 +5315,13 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
             else if (!IsInitialBlockDownload() &&
                     (inv.type == MSG_CVN_PUB_NONCE_POOL || inv.type == MSG_CVN_SIGNATURE ||
                             inv.type == MSG_CHAIN_ADMIN_NONCE || inv.type == MSG_CHAIN_ADMIN_SIGNATURE || inv.type == MSG_POC_CHAIN_DATA)) {
-                if (!fAlreadyHave && !fImporting && !fReindex)
-                    pfrom->AskFor(inv);
+                if (!fAlreadyHave && !fImporting && !fReindex) {
+                    // peers that know about deltas only send the new nonces of a pool
+                    if (inv.type == MSG_CVN_PUB_NONCE_POOL && pfrom->nVersion >= NONCEPOOL_DELTA_VERSION)
+                        pfrom->AskFor(CInv(MSG_CVN_PUB_NONCE_POOL_DELTA, inv.hash));
+                    else
+                        pfrom->AskFor(inv);
+                }
             }
             else
             {
@@ -5170,8 +5556,9 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
         if (!AlreadyHave(inv)) {
             if (!mapBannedCVNs.count(msg.nCvnId)) {
                 LogPrint("net", "received nonce pool %s for CvnID 0x%08x\n", msg.GetHash().ToString(), msg.nCvnId);
-                if (AddNoncePool(msg)) {
-                    RelayNoncePool(msg);
+                CNoncePoolDelta delta;
+                if (AddNoncePool(msg, &delta)) {
+                    RelayNoncePool(msg, &delta);
                 } else {
                     LogPrintf("received invalid nonce pool %s\n", msg.ToString());
                     Misbehaving(pfrom->GetId(), 50);
@@ -5186,6 +5573,60 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
     }
 
 
+    else if (strCommand == NetMsgType::NONCEPOOLDELTA)
+    {
+        CNoncePoolDelta msg;
+        vRecv >> msg;
+
+        CInv inv(MSG_CVN_PUB_NONCE_POOL, msg.hashPool);
+        pfrom->AddInventoryKnown(inv);
+
+        LOCK(cs_main);
+
+        pfrom->setAskFor.erase(inv.hash);
+        mapAlreadyAskedFor.erase(inv.hash);
+
+        if (!AlreadyHave(inv)) {
+            if (!mapBannedCVNs.count(msg.nCvnId)) {
+                CNoncePool pool;
+                bool fMalformed = false;
+                // the signature covers the announced pool, a peer can not make us fetch pools the CVN did not create
+                if (!CvnVerifySignature(msg.hashPool, msg.msgSig, msg.nCvnId)) {
+                    LogPrintf("received nonce pool delta with invalid signature %s\n", msg.ToString());
+                    Misbehaving(pfrom->GetId(), 50);
+                } else if (!ApplyNoncePoolDelta(msg, pool, fMalformed)) {
+                    if (fMalformed) {
+                        LogPrintf("received malformed nonce pool delta %s from peer=%d\n", msg.ToString(), pfrom->id);
+                        Misbehaving(pfrom->GetId(), 20);
+                    } else if (!IsNewerNoncePool(msg)) {
+                        LogPrint("net", "ignoring outdated nonce pool delta %s from peer=%d\n", msg.ToString(), pfrom->id);
+                    } else if (AllowNoncePoolRequest(pfrom->GetId(), msg.hashPool)) {
+                        // we do not have the pool the delta is based on, fetch the whole pool
+                        LogPrint("net", "could not apply nonce pool delta %s, requesting full pool from peer=%d\n", msg.ToString(), pfrom->id);
+                        pfrom->PushMessage(NetMsgType::GETDATA, vector<CInv>(1, inv));
+                    } else {
+                        LogPrint("net", "could not apply nonce pool delta %s, full pool was requested recently\n", msg.ToString());
+                    }
+                } else {
+                    LogPrint("net", "received nonce pool delta %s for CvnID 0x%08x, %d new nonces\n", msg.hashPool.ToString(), msg.nCvnId, msg.vAppendedNonces.size());
+                    CNoncePoolDelta delta;
+                    if (AddNoncePool(pool, &delta)) {
+                        RelayNoncePool(pool, &delta);
+                    } else {
+                        LogPrintf("received invalid nonce pool delta %s\n", msg.ToString());
+                        Misbehaving(pfrom->GetId(), 50);
+                    }
+                }
+            } else {
+                LogPrintf("Ignoring nonce pool delta of banned CvnID 0x%08x\n", msg.nCvnId);
+                Misbehaving(pfrom->GetId(), 20);
+            }
+        } else {
+            LogPrint("net", "AlreadyHave nonce pool for CvnID 0x%08x\n", msg.nCvnId);
+        }
+    }
+
+
     else if (strCommand == NetMsgType::SIG)
     {
         CCvnPartialSignature msg;
@@ -5206,6 +5647,7 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
                 } else {
                     LogPrint("net", "received chain signature %s for tip %s\n", msg.GetHash().ToString(), msg.hashPrevBlock.ToString());
                     if (AddCvnSignature(msg)) {
+                        sigLatencyStats.Add(msg, IsCvnNode(pfrom, msg.nSignerId));
                         RelayCvnSignature(msg);
                     } else {
                         LogPrintf("received invalid signature data %s\n", msg.ToString());
@@ -5221,6 +5663,46 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
     }
 
 
+    else if (strCommand == NetMsgType::CVNADDR)
+    {
+        CCvnAddrMsg msg;
+        vRecv >> msg;
+
+        LOCK(cs_main);
+
+        if (!HaveCvnAddr(msg)) {
+            CValidationState state;
+            int nDoS = 0;
+            if (AddCvnAddr(msg, state))
+                RelayCvnAddr(msg, pfrom);
+            else if (state.IsInvalid(nDoS) && nDoS > 0)
+                Misbehaving(pfrom->GetId(), nDoS);
+            else
+                LogPrint("net", "ignoring CVN address announcement %s from peer=%d\n", msg.ToString(), pfrom->id);
+        }
+    }
+
+
+    else if (strCommand == NetMsgType::CVNCHALLENGE)
+    {
+        uint256 hashChallenge;
+        vRecv >> hashChallenge;
+
+        AnswerCvnChallenge(pfrom, hashChallenge);
+    }
+
+
+    else if (strCommand == NetMsgType::CVNHELLO)
+    {
+        CCvnHelloMsg msg;
+        vRecv >> msg;
+
+        LOCK(cs_main);
+        if (!AcceptCvnHello(pfrom, msg))
+            Misbehaving(pfrom->GetId(), 50);
+    }
+
+
     else if (strCommand == NetMsgType::NONCEADMIN)
     {
         CAdminNonce msg;
@@ -6264,6 +6746,7 @@ bool SendMessages(CNode* pto)
                         // Expire old relay messages
                         while (!vRelayExpirationNonces.empty() && vRelayExpirationNonces.front().first < GetTime()) {
                             mapRelayNonces.erase(vRelayExpirationNonces.front().second);
+                            mapRelayNonceDeltas.erase(vRelayExpirationNonces.front().second);
                             vRelayExpirationNonces.pop_front();
                         }
 
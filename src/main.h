@@ -11,6 +11,7 @@
 #endif
 
 #include "amount.h"
+#include "blockfilemap.h"
 #include "chain.h"
 #include "coins.h"
 #include "net.h"
@@ -31,8 +32,11 @@
 class CBlockIndex;
 class CBlockTreeDB;
 class CBloomFilter;
+class CCoinsViewFlusher;
+class CCoinsViewPrefetch;
 class CChainParams;
 class CInv;
+class CPocSignatureCheck;
 class CScriptCheck;
 class CTxMemPool;
 class CValidationInterface;
@@ -127,6 +131,11 @@ static const bool DEFAULT_ENABLE_REPLACEMENT = true;
 /** Maximum number of headers to announce when relaying blocks with headers message.*/
 static const unsigned int MAX_BLOCKS_TO_ANNOUNCE = 8;
 
+/** Minimum time in seconds between two requests for the full nonce pool of a CVN after its delta did not apply */
+static const int64_t NONCE_POOL_REQUEST_INTERVAL = 60;
+/** Maximum number of full nonce pools requested from one peer per NONCE_POOL_REQUEST_INTERVAL */
+static const unsigned int MAX_NONCE_POOL_REQUESTS_PER_PEER = 10;
+
 struct BlockHasher
 {
     size_t operator()(const uint256& hash) const { return hash.GetCheapHash(); }
@@ -144,6 +153,7 @@ extern CWaitableCriticalSection csBestBlock;
 extern CConditionVariable cvBlockChange;
 extern bool fImporting;
 extern bool fReindex;
+extern bool fReindexCvnState;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
 extern bool fIsBareMultisigStd;
@@ -158,6 +168,7 @@ extern bool fEnableReplacement;
 extern int64_t nMaxTipAge;
 
 extern map<uint256, CNoncePool> mapRelayNonces;
+extern map<uint256, CNoncePoolDelta> mapRelayNonceDeltas;
 extern CCriticalSection cs_mapRelayNonces;
 extern map<uint256, CCvnPartialSignature> mapRelaySigs;
 extern CCriticalSection cs_mapRelaySigs;
@@ -241,6 +252,10 @@ bool ProcessMessages(CNode* pfrom);
 bool SendMessages(CNode* pto);
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the PoC signature checking thread */
+void ThreadPocSignatureCheck();
+/** Run PoC signature checks on the check queue, or serially if it is disabled or in use */
+bool RunPocSignatureChecks(std::vector<CPocSignatureCheck>& vChecks);
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Format a string that describes several potential problems detected by the core.
@@ -410,10 +425,53 @@ public:
 };
 
 
+/**
+ * The serialization of a block as it is stored on disk, which is also its
+ * network serialization. Points into a mapped block file when possible,
+ * otherwise into its own copy. Serializing it writes the bytes unchanged.
+ */
+class CRawBlock
+{
+public:
+    CMappedBlockFileRef mapped; // keeps the mapping alive
+    std::vector<char> vchData;  // used if the block file is not mapped
+    const char *pbegin;
+    const char *pend;
+
+    CRawBlock()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        mapped.reset();
+        vchData.clear();
+        pbegin = pend = NULL;
+    }
+
+    const char *begin() const { return pbegin; }
+    const char *end() const { return pend; }
+    unsigned int size() const { return pend - pbegin; }
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const
+    {
+        return size();
+    }
+
+    template<typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        s.write(pbegin, size());
+    }
+};
+
 /** Functions for disk access for blocks */
 bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart);
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+/** Read the serialized block without decoding it, only its size and header hash are checked */
+bool ReadRawBlockFromDisk(CRawBlock& block, const CBlockIndex* pindex);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -428,7 +486,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 
 /** Context-independent validity checks */
 bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, bool fCheckPOC = true);
-bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
+bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW = true, bool fCheckMerkleRoot = true, std::vector<CPocSignatureCheck> *pvPocChecks = NULL);
 
 /** Context-dependent validity checks */
 bool HasEnoughSignatures(CBlockIndex * const pindexPrev, const uint32_t nSignaturesToCheck);
@@ -499,9 +557,11 @@ public:
     CVerifyDB();
     ~CVerifyDB();
     bool VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview, int nCheckLevel, int nCheckDepth);
-    bool SetMostRecentCVNData(const CChainParams& chainparams, CBlockIndex* pindexStart);
 };
 
+/** Load the CVN set, chain admins and chain parameters that are in effect at pindexStart */
+bool SetMostRecentCVNData(const CChainParams& chainparams, CBlockIndex* pindexStart);
+
 /** Find the last common block between the parameter chain and a locator. */
 CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& locator);
 
@@ -517,6 +577,11 @@ extern CChain chainActive;
 /** Global variable that points to the active CCoinsView (protected by cs_main) */
 extern CCoinsViewCache *pcoinsTip;
 
+/** The layer below pcoinsTip the inputs of incoming blocks are prefetched into */
+extern CCoinsViewPrefetch *pcoinsPrefetch;
+/** Writes flushed coins to the database in the background */
+extern CCoinsViewFlusher *pcoinsFlusher;
+
 /** Global variable that points to the active block tree (protected by cs_main) */
 extern CBlockTreeDB *pblocktree;
 
@@ -5,6 +5,8 @@
 #ifndef BITCOIN_MEMUSAGE_H
 #define BITCOIN_MEMUSAGE_H
 
+#include "flathashmap.h"
+
 #include <stdlib.h>
 
 #include <map>
@@ -127,6 +129,12 @@ static inline size_t DynamicUsage(const boost::unordered_map<X, Y, Z>& m)
     return MallocUsage(sizeof(boost_unordered_node<std::pair<const X, Y> >)) * m.size() + MallocUsage(sizeof(void*) * m.bucket_count());
 }
 
+template<typename X, typename Y, typename Z>
+static inline size_t DynamicUsage(const CFlatHashMap<X, Y, Z>& m)
+{
+    return MallocUsage(m.slot_bytes()) + MallocUsage(m.chunk_bytes()) * m.chunk_count() + MallocUsage(m.chunk_list_bytes()) + MallocUsage(m.free_list_bytes());
+}
+
 }
 
 #endif // BITCOIN_MEMUSAGE_H
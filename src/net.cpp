@@ -103,6 +103,7 @@ NodeId nLastNodeId = 0;
 CCriticalSection cs_nLastNodeId;
 
 static CSemaphore *semOutbound = NULL;
+static CSemaphore *semCvnOverlay = NULL;
 boost::condition_variable messageHandlerCondition;
 
 // Signals for message handling
@@ -1698,6 +1699,19 @@ bool OpenNetworkConnection(const CAddress& addrConnect, CSemaphoreGrant *grantOu
     return true;
 }
 
+/** Opens a connection to another CVN, these are limited by MAX_CVN_OVERLAY_CONNECTIONS instead of the outbound slots */
+bool OpenCvnOverlayConnection(const CService& addrConnect)
+{
+    if (!semCvnOverlay)
+        return false;
+
+    CSemaphoreGrant grant(*semCvnOverlay, true);
+    if (!grant)
+        return false;
+
+    return OpenNetworkConnection(CAddress(addrConnect), &grant, addrConnect.ToStringIPPort().c_str());
+}
+
 
 void ThreadMessageHandler()
 {
@@ -1947,6 +1961,9 @@ void StartNode(boost::thread_group& threadGroup, CScheduler& scheduler)
         semOutbound = new CSemaphore(nMaxOutbound);
     }
 
+    if (semCvnOverlay == NULL)
+        semCvnOverlay = new CSemaphore(MAX_CVN_OVERLAY_CONNECTIONS);
+
     if (pnodeLocalHost == NULL)
         pnodeLocalHost = new CNode(INVALID_SOCKET, CAddress(CService("127.0.0.1", 0), nLocalServices));
 
@@ -2027,6 +2044,8 @@ public:
         vhListenSocket.clear();
         delete semOutbound;
         semOutbound = NULL;
+        delete semCvnOverlay;
+        semCvnOverlay = NULL;
         delete pnodeLocalHost;
         pnodeLocalHost = NULL;
 
@@ -2342,6 +2361,8 @@ CNode::CNode(SOCKET hSocketIn, const CAddress& addrIn, const std::string& addrNa
     nNextAddrSend = 0;
     nNextInvSend = 0;
     fRelayTxes = false;
+    nCvnId = 0;
+    fCvnHelloSent = false;
     pfilter = new CBloomFilter();
     nPingNonceSent = 0;
     nPingUsecStart = 0;
@@ -2403,7 +2424,7 @@ void CNode::AskFor(const CInv& inv)
 
     // Each retry is 2 minutes after the last
     int64_t nRetryInterval = 2 * 60;
-    if (inv.type == MSG_CVN_PUB_NONCE_POOL || inv.type == MSG_CVN_SIGNATURE || inv.type == MSG_CHAIN_ADMIN_NONCE || inv.type == MSG_CHAIN_ADMIN_SIGNATURE || inv.type == MSG_POC_CHAIN_DATA)
+    if (inv.type == MSG_CVN_PUB_NONCE_POOL || inv.type == MSG_CVN_PUB_NONCE_POOL_DELTA || inv.type == MSG_CVN_SIGNATURE || inv.type == MSG_CHAIN_ADMIN_NONCE || inv.type == MSG_CHAIN_ADMIN_SIGNATURE || inv.type == MSG_POC_CHAIN_DATA)
         nRetryInterval = 10;
     nRequestTime = std::max(nRequestTime + nRetryInterval * 1000000, nNow);
     if (it != mapAlreadyAskedFor.end())
@@ -62,6 +62,8 @@ static const size_t MAPASKFOR_MAX_SZ = MAX_INV_SZ;
 static const size_t SETASKFOR_MAX_SZ = 2 * MAX_INV_SZ;
 /** The maximum number of peer connections to maintain. */
 static const unsigned int DEFAULT_MAX_PEER_CONNECTIONS = 125;
+/** Maximum number of outbound connections to other CVNs, on top of the regular outbound connections */
+static const int MAX_CVN_OVERLAY_CONNECTIONS = 32;
 /** The default for -maxuploadtarget. 0 = Unlimited */
 static const uint64_t DEFAULT_MAX_UPLOAD_TARGET = 0;
 /** Default for blocks only*/
@@ -85,6 +87,7 @@ CNode* FindNode(const std::string& addrName);
 CNode* FindNode(const CService& ip);
 CNode* ConnectNode(CAddress addrConnect, const char *pszDest = NULL);
 bool OpenNetworkConnection(const CAddress& addrConnect, CSemaphoreGrant *grantOutbound = NULL, const char *strDest = NULL, bool fOneShot = false);
+bool OpenCvnOverlayConnection(const CService& addrConnect);
 void MapPort(bool fUseUPnP);
 unsigned short GetListenPort();
 bool BindListenPort(const CService &bindAddr, std::string& strError, bool fWhitelisted = false);
@@ -357,6 +360,11 @@ public:
     //    unless it loads a bloom filter.
     bool fRelayTxes;
     bool fRelayPoCMessages;
+    // the challenge sent to the peer to prove its CVN ID, null if there is none pending
+    uint256 hashCvnChallenge;
+    // the CVN ID the peer proved with a cvnhello, 0 if it did not
+    uint32_t nCvnId;
+    bool fCvnHelloSent;
     CSemaphoreGrant grantOutbound;
     CCriticalSection cs_filter;
     CBloomFilter* pfilter;
@@ -518,6 +526,12 @@ public:
         }
     }
 
+    bool HasInventoryKnown(const uint256& hash)
+    {
+        LOCK(cs_inventory);
+        return filterInventoryKnown.contains(hash);
+    }
+
     void PushInventory(const CInv& inv)
     {
         LOCK(cs_inventory);
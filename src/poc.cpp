@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "consensus/consensus.h"
+#include "consensus/validation.h"
 #include "util.h"
 #include "poc.h"
 #include "main.h"
@@ -15,6 +16,7 @@
 #include "clientversion.h"
 #include "validationinterface.h"
 #include "blockfactory.h"
+#include "txdb.h"
 
 #ifdef USE_FASITO
 #include "fasito/fasito.h"
@@ -23,20 +25,30 @@
 #include <secp256k1.h>
 #include <secp256k1_schnorr.h>
 #include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/static_assert.hpp>
 #include <stdio.h>
 #include <set>
+#include <algorithm>
 
 // changing this is a consensus change
 #define POC_BLOCKS_TO_SCAN 200
 
 #define POC_DEBUG 0
 
+/* upper bound of the time the POC thread waits for an event or timeout */
+static const int64_t POC_MAX_WAIT_MILLIS = 10000;
+
 uint32_t nCvnNodeId = 0;
 uint32_t nChainAdminId = 0;
 bool fNoncePoolInitialsed = false;
 bool fCoinSupplyFinal = false;
 
 CvnInfoCacheType mapCVNInfoCache;
+CvnEpochInfoMapType mapCvnEpochInfo;
+CSignerPubKeyCache signerPubKeyCache;
 CachedCvnType mapChachedCVNInfoBlocks;
 
 CCriticalSection cs_mapChainAdmins;
@@ -67,6 +79,8 @@ MapSigAdmin mapAdminSigs;
 /* private nonces when starting faircoind with -cvn=file */
 static vector<CSchnorrPrivNonce> vNoncePrivate;
 static secp256k1_context *secp256k1_context_none = NULL;
+/* height of the CVN set that is currently loaded into mapCVNs */
+static uint32_t nCvnSetHeight = 0;
 
 bool static CvnSignPartialWithKey(const uint256& hashToSign, const CKey& cvnPrivKey, const CSchnorrPubKey& sumPublicNoncesOthers, CSchnorrSig& signature, const int nPoolOffset);
 
@@ -108,34 +122,242 @@ void printHex(const uint8_t *buf, const size_t len, const bool addLF = false)
 }
 #endif
 
-bool AddToCvnInfoCache(const CBlock *pblock, const uint32_t nHeight)
+static bool CombineCvnPubKeys(secp256k1_pubkey &sumOfAllSignersPubkeys, const vector<CCvnInfo> &vCvns)
 {
-    if (!pblock->HasCvnInfo())
+    if (vCvns.empty())
         return false;
 
-    LOCK(cs_mapCVNs);
+    if (vCvns.size() == 1) {
+        memcpy(sumOfAllSignersPubkeys.data, &vCvns[0].pubKey.begin()[0], 64);
+        return true;
+    }
 
-    mapCVNs.clear();
     int count = 0;
     secp256k1_pubkey *allSignersPubkeys[MAX_NUMBER_OF_CVNS];
 
-    BOOST_FOREACH(const CCvnInfo &cvnInfo, pblock->vCvns) {
-        mapCVNs.insert(std::make_pair(cvnInfo.nNodeId, cvnInfo));
+    BOOST_FOREACH(const CCvnInfo &cvnInfo, vCvns) {
+        if (count == MAX_NUMBER_OF_CVNS)
+            return false;
         allSignersPubkeys[count++] = (secp256k1_pubkey *)&cvnInfo.pubKey.begin()[0];
     }
 
-    secp256k1_pubkey sumOfAllSignersPubkeys;
-    if (count == 1) {
-        memcpy(sumOfAllSignersPubkeys.data, &pblock->vCvns[0].pubKey.begin()[0], 64);
-    } else {
-        if (!secp256k1_ec_pubkey_combine(secp256k1_context_none, &sumOfAllSignersPubkeys, allSignersPubkeys, count))
+    return secp256k1_ec_pubkey_combine(secp256k1_context_none, &sumOfAllSignersPubkeys, allSignersPubkeys, count);
+}
+
+void CCvnSetInfo::SetNull()
+{
+    nEpoch = 0;
+    nHeight = 0;
+    memset(sumOfAllPubKeys.data, 0, sizeof(sumOfAllPubKeys.data));
+    mapCVNs.clear();
+    mapChainAdmins.clear();
+    dynParams.SetNull();
+}
+
+static CCriticalSection cs_cvnSetInfo;
+static CCvnSetInfoRef pcvnSetInfo(new CCvnSetInfo());
+
+/* the snapshot the writers are working on, only touched while cs_main is held */
+static boost::shared_ptr<CCvnSetInfo> pcvnSetInfoPending;
+static int nCvnSetInfoBatches = 0;
+
+CCvnSetInfoRef GetCvnSetInfo()
+{
+    LOCK(cs_cvnSetInfo);
+    return pcvnSetInfo;
+}
+
+void SetCvnSetInfo(const CCvnSetInfoRef &info)
+{
+    LOCK(cs_cvnSetInfo);
+    pcvnSetInfo = info;
+    pcvnSetInfoPending.reset();
+}
+
+/** A private copy of the current snapshot the writers can modify */
+static CCvnSetInfo &ModifyCvnSetInfo()
+{
+    if (!pcvnSetInfoPending)
+        pcvnSetInfoPending.reset(new CCvnSetInfo(*GetCvnSetInfo()));
+
+    return *pcvnSetInfoPending;
+}
+
+static void PublishCvnSetInfo()
+{
+    if (nCvnSetInfoBatches || !pcvnSetInfoPending)
+        return;
+
+    boost::shared_ptr<CCvnSetInfo> info;
+    info.swap(pcvnSetInfoPending);
+
+    LOCK(cs_cvnSetInfo);
+    info->nEpoch = pcvnSetInfo->nEpoch + 1;
+    pcvnSetInfo = info;
+}
+
+CCvnSetInfoBatch::CCvnSetInfoBatch()
+{
+    nCvnSetInfoBatches++;
+}
+
+CCvnSetInfoBatch::~CCvnSetInfoBatch()
+{
+    if (--nCvnSetInfoBatches == 0)
+        PublishCvnSetInfo();
+}
+
+/**
+ * The sum of the public keys of vCvns derived from the sum of the previous CVN
+ * set: the keys that were added are added to it, the ones that were removed or
+ * replaced are subtracted. All keys are combined if that is not cheaper.
+ */
+static bool UpdateCvnPubKeySum(secp256k1_pubkey &sum, const CCvnSetInfo &prev, const vector<CCvnInfo> &vCvns)
+{
+    static const secp256k1_pubkey nullPubKey = {{0}};
+    if (prev.mapCVNs.empty() || !memcmp(prev.sumOfAllPubKeys.data, nullPubKey.data, sizeof(nullPubKey.data)))
+        return CombineCvnPubKeys(sum, vCvns);
+
+    vector<secp256k1_pubkey> vChanged;
+    set<uint32_t> setIds;
+
+    BOOST_FOREACH(const CCvnInfo &cvnInfo, vCvns) {
+        // the sum contains every entry, the map only the first of an ID
+        if (!setIds.insert(cvnInfo.nNodeId).second)
+            return CombineCvnPubKeys(sum, vCvns);
+
+        CvnMapType::const_iterator it = prev.mapCVNs.find(cvnInfo.nNodeId);
+        if (it != prev.mapCVNs.end() && it->second.pubKey == cvnInfo.pubKey)
+            continue;
+
+        if (it != prev.mapCVNs.end()) {
+            vChanged.push_back(*(const secp256k1_pubkey *)it->second.pubKey.begin());
+            if (!secp256k1_ec_pubkey_negate(secp256k1_context_none, &vChanged.back()))
+                return false;
+        }
+
+        vChanged.push_back(*(const secp256k1_pubkey *)cvnInfo.pubKey.begin());
+    }
+
+    for (CvnMapType::const_iterator it = prev.mapCVNs.begin(); it != prev.mapCVNs.end(); it++) {
+        if (setIds.count(it->first))
+            continue;
+
+        vChanged.push_back(*(const secp256k1_pubkey *)it->second.pubKey.begin());
+        if (!secp256k1_ec_pubkey_negate(secp256k1_context_none, &vChanged.back()))
+            return false;
+    }
+
+    if (vChanged.size() >= vCvns.size())
+        return CombineCvnPubKeys(sum, vCvns);
+
+    if (vChanged.empty()) {
+        sum = prev.sumOfAllPubKeys;
+        return true;
+    }
+
+    vector<const secp256k1_pubkey *> vPubkeys;
+    vPubkeys.reserve(vChanged.size() + 1);
+    vPubkeys.push_back(&prev.sumOfAllPubKeys);
+    BOOST_FOREACH(const secp256k1_pubkey &pubkey, vChanged)
+        vPubkeys.push_back(&pubkey);
+
+    if (secp256k1_ec_pubkey_combine(secp256k1_context_none, &sum, &vPubkeys[0], vPubkeys.size()))
+        return true;
+
+    return CombineCvnPubKeys(sum, vCvns);
+}
+
+/**
+ * Replace the current CVN set by the one of pblock, which has the hash
+ * hashBlock, and add it to the CVN info cache. If pSumOfAllPubKeys is not NULL it is used as the sum of all public keys
+ * (e.g. when restored from the block tree DB) instead of deriving it from the
+ * previous CVN set.
+ */
+bool AddToCvnInfoCache(const CBlock *pblock, const uint32_t nHeight, const uint256 &hashBlock, const CSchnorrPubKey *pSumOfAllPubKeys)
+{
+    if (!pblock->HasCvnInfo())
+        return false;
+
+    CCvnSetInfo &info = ModifyCvnSetInfo();
+
+    secp256k1_pubkey sum;
+    if (pSumOfAllPubKeys)
+        memcpy(sum.data, pSumOfAllPubKeys->begin(), 64);
+    else if (!UpdateCvnPubKeySum(sum, info, pblock->vCvns))
+        return error("%s : could not combine signers public keys", __func__);
+
+    info.nHeight = nHeight;
+    info.sumOfAllPubKeys = sum;
+    info.mapCVNs.clear();
+
+    BOOST_FOREACH(const CCvnInfo &cvnInfo, pblock->vCvns) {
+        info.mapCVNs.insert(std::make_pair(cvnInfo.nNodeId, cvnInfo));
+    }
+
+    {
+        LOCK(cs_mapCVNs);
+        mapCVNs = info.mapCVNs;
+        mapCVNInfoCache[nHeight] = CvnInfoCache(info.sumOfAllPubKeys, mapCVNs.size());
+        mapCvnEpochInfo[hashBlock] = mapCVNInfoCache[nHeight];
+        nCvnSetHeight = nHeight;
+        signerPubKeyCache.EraseFrom(nHeight);
+    }
+
+    PublishCvnSetInfo();
+    return true;
+}
+
+/**
+ * Forget the CVN sets introduced at or above the height of pindexDelete, which
+ * is being disconnected. The cumulative number of chain signatures of the
+ * blocks that were counted with one of these sets is unknown again, it is
+ * filled in when they get connected. mapCvnEpochInfo keeps the sets, they
+ * stay valid for the blocks of the disconnected fork.
+ */
+void RemoveFromCvnInfoCache(const CBlockIndex *pindexDelete)
+{
+    const uint32_t nHeight = pindexDelete->nHeight;
+    {
+        LOCK(cs_mapCVNs);
+        mapCVNInfoCache.erase(mapCVNInfoCache.lower_bound(nHeight), mapCVNInfoCache.end());
+    }
+
+    BOOST_FOREACH(const BlockMap::value_type& item, mapBlockIndex) {
+        CBlockIndex *pindex = item.second;
+        if (pindex->pcvnepoch && pindex->pcvnepoch->nHeight >= (int)nHeight)
+            pindex->nChainSigs = -1;
+    }
+}
+
+bool CCvnStateRecord::FromBlock(const CBlock &block)
+{
+    SetNull();
+    nPayload = block.nVersion & CBlock::ADMIN_PAYLOAD_MASK;
+
+    if (block.HasCvnInfo()) {
+        secp256k1_pubkey sum;
+        if (!CombineCvnPubKeys(sum, block.vCvns))
             return error("%s : could not combine signers public keys", __func__);
+        vCvns = block.vCvns;
+        sumOfAllPubKeys = CSchnorrPubKey(sum.data);
     }
 
-    mapCVNInfoCache[nHeight] = CvnInfoCache(sumOfAllSignersPubkeys, mapCVNs.size());
+    vChainAdmins       = block.vChainAdmins;
+    dynamicChainParams = block.dynamicChainParams;
+    coinSupply         = block.coinSupply;
     return true;
 }
 
+void CCvnStateRecord::ToBlock(CBlock &block) const
+{
+    block.nVersion           = nPayload;
+    block.vCvns              = vCvns;
+    block.vChainAdmins       = vChainAdmins;
+    block.dynamicChainParams = dynamicChainParams;
+    block.coinSupply         = coinSupply;
+}
+
 static bool GetCvnInfoCache(CvnInfoCache **cache, const uint32_t nHeight)
 {
     if (mapCVNInfoCache.empty()) {
@@ -161,10 +383,24 @@ static bool GetCvnInfoCache(CvnInfoCache **cache, const uint32_t nHeight)
     return false;
 }
 
+/**
+ * The CVN info of the epoch of pindex, NULL if it is not in the cache (yet).
+ * Looked up by the hash of the epoch block, a block on another fork at the
+ * same height may have introduced a different CVN set.
+ */
+static CvnInfoCache *GetCvnEpochInfo(const CBlockIndex *pindex)
+{
+    if (!pindex->pcvnepoch)
+        return NULL;
+
+    CvnEpochInfoMapType::iterator it = mapCvnEpochInfo.find(pindex->pcvnepoch->GetBlockHash());
+    return it != mapCvnEpochInfo.end() ? &it->second : NULL;
+}
+
 uint32_t GetNumChainSigs(const CBlockIndex *pindex)
 {
-    CvnInfoCache *info;
-    if (!GetCvnInfoCache(&info, pindex->nHeight)) {
+    CvnInfoCache *info = GetCvnEpochInfo(pindex);
+    if (!info && !GetCvnInfoCache(&info, pindex->nHeight)) {
         LogPrintf("%s : could not find CVN information\n", __func__);
         return 0;
     }
@@ -172,6 +408,30 @@ uint32_t GetNumChainSigs(const CBlockIndex *pindex)
     return info->nActiveCvns - pindex->vMissingSignerIds.size();
 }
 
+/**
+ * Set the CVN set epoch and the cumulative number of chain signatures of
+ * pindex. The number stays unknown if the CVN set of the epoch was not
+ * cached yet, e.g. for a header whose ancestors are not connected. It is
+ * filled in again when the block gets connected.
+ */
+void SetChainSigs(CBlockIndex *pindex)
+{
+    CBlockIndex *pindexPrev = pindex->pprev;
+
+    if (!pindexPrev)
+        pindex->pcvnepoch = pindex; // the genesis block brings its own CVN set
+    else
+        pindex->pcvnepoch = (pindexPrev->nVersion & CBlock::CVN_PAYLOAD) ? pindexPrev : pindexPrev->pcvnepoch;
+
+    const int64_t nPrevChainSigs = pindexPrev ? pindexPrev->nChainSigs : 0;
+    const CvnInfoCache *info = GetCvnEpochInfo(pindex);
+
+    if (nPrevChainSigs < 0 || !info)
+        pindex->nChainSigs = -1;
+    else
+        pindex->nChainSigs = nPrevChainSigs + info->nActiveCvns - pindex->vMissingSignerIds.size();
+}
+
 uint32_t GetNumChainSigs(const CBlock *pblock)
 {
     BlockMap::iterator miPrev = mapBlockIndex.find(pblock->hashPrevBlock);
@@ -211,96 +471,266 @@ void CvnInfoCache::SetNull()
     memset(sumOfAllpubKeys.data, 0, sizeof(sumOfAllpubKeys.data));
 }
 
-void CSignatureHolder::AddSig(const CCvnPartialSignature &sig)
+int CSigRound::GetSlot(const uint32_t nSignerId) const
 {
-    LOCK(cs_sigHolder);
+    vector<uint32_t>::const_iterator it = std::lower_bound(vSlotIds.begin(), vSlotIds.end(), nSignerId);
 
-    MapSigSigner& mapSigner   = sigs[sig.signature.GetRx()];
+    if (it == vSlotIds.end() || *it != nSignerId)
+        return -1;
 
-    mapSigner[sig.nSignerId]  = sig;
+    return it - vSlotIds.begin();
 }
 
-MapSigSigner* CSignatureHolder::GetSignatureSet(const CSchnorrRx &commonRx)
+/* Extend the slot IDs of the round by vIds. This only happens if the CVN set
+ * changed after the round was created, so the arena is simply laid out anew. */
+void CSigRound::SetSlotIds(const vector<uint32_t> &vIds)
 {
-    LOCK(cs_sigHolder);
+    vector<uint32_t> vNewSlotIds(vSlotIds);
+    vNewSlotIds.insert(vNewSlotIds.end(), vIds.begin(), vIds.end());
+    std::sort(vNewSlotIds.begin(), vNewSlotIds.end());
+    vNewSlotIds.erase(std::unique(vNewSlotIds.begin(), vNewSlotIds.end()), vNewSlotIds.end());
 
-    if (!sigs.count(commonRx))
-        return NULL;
+    if (vNewSlotIds == vSlotIds)
+        return;
+
+    vector<CSigSlot> vNewArena(vSets.size() * vNewSlotIds.size());
+    for (size_t i = 0; i < vSets.size(); i++) {
+        CSigSet &set = vSets[i];
+        const size_t nNewOffset = i * vNewSlotIds.size();
+
+        for (const CSigSlot *slot = begin(set); slot != end(set); slot++) {
+            if (slot->IsNull())
+                continue;
+
+            const size_t nSlot = std::lower_bound(vNewSlotIds.begin(), vNewSlotIds.end(), slot->nSignerId) - vNewSlotIds.begin();
+            vNewArena[nNewOffset + nSlot] = *slot;
+        }
+
+        set.nOffset = nNewOffset;
+    }
 
-    return &sigs[commonRx];
+    vSlotIds.swap(vNewSlotIds);
+    vArena.swap(vNewArena);
 }
 
-CCvnPartialSignature* CSignatureHolder::GetSignature(const uint32_t nSignerId, const CSchnorrRx &commonRx)
+CSigSet* CSigRound::GetSet(const CSchnorrRx &commonRx)
 {
-    if (!sigs.count(commonRx))
-        return NULL;
+    BOOST_FOREACH(CSigSet &set, vSets) {
+        if (set.commonRx == commonRx)
+            return &set;
+    }
 
-    MapSigSigner& mapSigner = sigs[commonRx];
+    return NULL;
+}
 
-    if (!mapSigner.count(nSignerId))
-        return NULL;
+CSigSet& CSigRound::AddSet(const CSchnorrRx &commonRx, const vector<uint32_t> &vMissingSignerIds)
+{
+    vSets.push_back(CSigSet());
+
+    CSigSet &set          = vSets.back();
+    set.commonRx          = commonRx;
+    set.vMissingSignerIds = vMissingSignerIds;
+    set.nOffset           = vArena.size();
+
+    vArena.resize(vArena.size() + vSlotIds.size());
+
+    return set;
+}
 
-    return &mapSigner[nSignerId];
+CCvnPartialSignature CSigRound::GetSignature(const CSigSet &set, const CSigSlot &slot) const
+{
+    CCvnPartialSignature sig;
+
+    sig.nVersion          = slot.nVersion;
+    sig.nSignerId         = slot.nSignerId;
+    sig.nCreatorId        = nCreatorId;
+    sig.hashPrevBlock     = hashPrevBlock;
+    sig.signature         = slot.signature;
+    sig.nCreationTime     = slot.nCreationTime;
+    sig.fValidated        = slot.fValidated;
+    sig.vMissingSignerIds = set.vMissingSignerIds;
+    sig.msgSig            = slot.msgSig;
+
+    return sig;
 }
 
-bool CSignatureHolder::GetSignatures(vector<CCvnPartialSignature> &vSigs)
+void CSignatureHolder::SetNull()
 {
-    LOCK(cs_sigHolder);
+    for (int i = 0; i < SHARDS; i++) {
+        LOCK(shards[i].cs_shard);
+        shards[i].mapRounds.clear();
+    }
+}
 
-    if (sigs.empty())
-        return false;
+CSigRound* CSignatureHolder::GetRound(CShard &shard, const uint256 &hashPrevBlock, const uint32_t nCreatorId)
+{
+    RoundMapType::iterator it = shard.mapRounds.find(std::make_pair(hashPrevBlock, nCreatorId));
 
-    MapSigSigner& mapSigner = sigs.begin()->second;
-    if (mapSigner.empty())
-        return false;
+    if (it == shard.mapRounds.end())
+        return NULL;
 
-    BOOST_FOREACH(const MapSigCommonR::value_type &entry, sigs) {
-        BOOST_FOREACH(const MapSigSigner::value_type &s, entry.second) {
-            vSigs.push_back(s.second);
+    return &it->second;
+}
+
+static void StoreSig(CSigRound &round, const CCvnPartialSignature &sig, const uint256 &hash)
+{
+    const CSchnorrRx commonRx = sig.signature.GetRx();
+
+    CSigSet *set = round.GetSet(commonRx);
+    if (!set)
+        set = &round.AddSet(commonRx, sig.vMissingSignerIds);
+
+    CSigSlot &slot = round.vArena[set->nOffset + round.GetSlot(sig.nSignerId)];
+    if (slot.IsNull())
+        set->nSigs++;
+
+    slot.nSignerId     = sig.nSignerId;
+    slot.nCreationTime = sig.nCreationTime;
+    slot.nVersion      = sig.nVersion;
+    slot.fValidated    = sig.fValidated;
+    slot.signature     = sig.signature;
+    slot.msgSig        = sig.msgSig;
+    slot.hash          = hash;
+}
+
+void CSignatureHolder::AddSig(const CCvnPartialSignature &sig, const uint256 &hash)
+{
+    CShard &shard = GetShard(sig.signature.GetRx());
+
+    {
+        LOCK(shard.cs_shard);
+        CSigRound *round = GetRound(shard, sig.hashPrevBlock, sig.nCreatorId);
+        if (round && round->GetSlot(sig.nSignerId) >= 0) {
+            StoreSig(*round, sig, hash);
+            return;
         }
     }
 
-    return !vSigs.empty();
+    // first signature of the round (or of a CVN added since). Take the CVN IDs
+    // for the slots without holding the shard lock
+    vector<uint32_t> vSlotIds;
+    {
+        LOCK(cs_mapCVNs);
+        vSlotIds.reserve(mapCVNs.size() + 1);
+        BOOST_FOREACH(const CvnMapType::value_type &cvn, mapCVNs)
+            vSlotIds.push_back(cvn.first);
+    }
+    vSlotIds.push_back(sig.nSignerId);
+
+    LOCK(shard.cs_shard);
+    CSigRound &round = shard.mapRounds[std::make_pair(sig.hashPrevBlock, sig.nCreatorId)];
+    round.hashPrevBlock = sig.hashPrevBlock;
+    round.nCreatorId    = sig.nCreatorId;
+
+    if (round.GetSlot(sig.nSignerId) < 0)
+        round.SetSlotIds(vSlotIds);
+
+    StoreSig(round, sig, hash);
 }
 
-bool CSignatureHolder::HasSigSetsToContributeTo(vector<vector<uint32_t> > &vSigSetsToContributeTo, const uint32_t nNodeId, const uint32_t nActiveCVNs)
+void CSignatureHolder::SetValidated(const CCvnPartialSignature &sig)
 {
-    LOCK(sigHolder.cs_sigHolder);
+    const CSchnorrRx commonRx = sig.signature.GetRx();
+    CShard &shard = GetShard(commonRx);
 
-    if (sigs.empty())
-        return false;
+    LOCK(shard.cs_shard);
+    CSigRound *round = GetRound(shard, sig.hashPrevBlock, sig.nCreatorId);
+    if (!round)
+        return;
+
+    CSigSet *set = round->GetSet(commonRx);
+    const int nSlot = round->GetSlot(sig.nSignerId);
+    if (!set || nSlot < 0)
+        return;
 
-    BOOST_FOREACH(const MapSigCommonR::value_type &entry, sigs) {
-        const MapSigSigner &s = entry.second;
-        const CCvnPartialSignature &sigFirst = s.begin()->second;
+    // the slot may have been replaced since the copy was taken
+    CSigSlot &slot = round->vArena[set->nOffset + nSlot];
+    if (!slot.IsNull() && slot.signature == sig.signature)
+        slot.fValidated = true;
+}
+
+void CSignatureHolder::ForEachSigSet(CSigSetVisitor &visitor, const uint256 &hashPrevBlock, const uint32_t nCreatorId)
+{
+    for (int i = 0; i < SHARDS; i++) {
+        LOCK(shards[i].cs_shard);
 
-        if (s.empty() || (nActiveCVNs - sigFirst.vMissingSignerIds.size()) == s.size())
+        CSigRound *round = GetRound(shards[i], hashPrevBlock, nCreatorId);
+        if (!round)
             continue;
 
-        if (s.find(nNodeId) == s.end()) {
-            vSigSetsToContributeTo.push_back(sigFirst.vMissingSignerIds);
+        BOOST_FOREACH(CSigSet &set, round->vSets) {
+            if (!visitor.Visit(*round, set))
+                return;
         }
     }
-
-    return !vSigSetsToContributeTo.empty();
 }
 
-bool CSignatureHolder::HasCompleteSigSets(const uint32_t nMaxSignatures) const
+void CSignatureHolder::ForEachSigSet(CSigSetVisitor &visitor)
 {
-    LOCK(sigHolder.cs_sigHolder);
+    for (int i = 0; i < SHARDS; i++) {
+        LOCK(shards[i].cs_shard);
 
-    if (sigs.empty())
-        return false;
+        BOOST_FOREACH(RoundMapType::value_type &entry, shards[i].mapRounds) {
+            BOOST_FOREACH(CSigSet &set, entry.second.vSets) {
+                if (!visitor.Visit(entry.second, set))
+                    return;
+            }
+        }
+    }
+}
+
+bool CSignatureHolder::GetSignatureHashes(vector<uint256> &vHashes, const uint256 &hashPrevBlock, const uint32_t nCreatorId)
+{
+    for (int i = 0; i < SHARDS; i++) {
+        LOCK(shards[i].cs_shard);
 
-    BOOST_FOREACH(const MapSigCommonR::value_type &entry, sigs) {
-        const MapSigSigner &s = entry.second;
-        if (s.empty())
+        const CSigRound *round = GetRound(shards[i], hashPrevBlock, nCreatorId);
+        if (!round)
             continue;
 
-        const CCvnPartialSignature &sigFirst = s.begin()->second;
+        BOOST_FOREACH(const CSigSet &set, round->vSets) {
+            for (const CSigSlot *slot = round->begin(set); slot != round->end(set); slot++) {
+                if (!slot->IsNull())
+                    vHashes.push_back(slot->hash);
+            }
+        }
+    }
+
+    return !vHashes.empty();
+}
 
-        if ((nMaxSignatures - sigFirst.vMissingSignerIds.size()) == s.size()) {
-            return true;
+bool CSignatureHolder::HasSigSetsToContributeTo(vector<vector<uint32_t> > &vSigSetsToContributeTo, const uint32_t nNodeId, const uint32_t nActiveCVNs)
+{
+    for (int i = 0; i < SHARDS; i++) {
+        LOCK(shards[i].cs_shard);
+
+        BOOST_FOREACH(const RoundMapType::value_type &entry, shards[i].mapRounds) {
+            const CSigRound &round = entry.second;
+            const int nSlot = round.GetSlot(nNodeId);
+
+            BOOST_FOREACH(const CSigSet &set, round.vSets) {
+                if (!set.nSigs || (nActiveCVNs - set.vMissingSignerIds.size()) == set.nSigs)
+                    continue;
+
+                if (nSlot < 0 || round.vArena[set.nOffset + nSlot].IsNull())
+                    vSigSetsToContributeTo.push_back(set.vMissingSignerIds);
+            }
+        }
+    }
+
+    return !vSigSetsToContributeTo.empty();
+}
+
+bool CSignatureHolder::HasCompleteSigSets(const uint32_t nActiveCVNs)
+{
+    for (int i = 0; i < SHARDS; i++) {
+        LOCK(shards[i].cs_shard);
+
+        BOOST_FOREACH(const RoundMapType::value_type &entry, shards[i].mapRounds) {
+            BOOST_FOREACH(const CSigSet &set, entry.second.vSets) {
+                if (set.nSigs && (nActiveCVNs - set.vMissingSignerIds.size()) == set.nSigs)
+                    return true;
+            }
         }
     }
 
@@ -317,79 +747,90 @@ bool CSignatureHolder::HasCompleteSigSets(const uint32_t nMaxSignatures) const
  */
 bool CSignatureHolder::GetAllMissing(vector<uint32_t> &vMissingSignerIds, const uint32_t nNodeId, const vector<CSchnorrRx> &commonRxs, const CNoncePoolType &mapNoncePool, const uint32_t nActiveCVNs)
 {
-    LOCK(sigHolder.cs_sigHolder);
-
-    if (sigs.empty())
-        return false;
-
-    set<uint32_t> sMissing;
+    vector<uint32_t> vMissing;
 
     BOOST_FOREACH(const CSchnorrRx &commonRx, commonRxs) {
-        if (sigs.find(commonRx) == sigs.end())
-            continue;
+        CShard &shard = GetShard(commonRx);
+        LOCK(shard.cs_shard);
 
-        const MapSigSigner &s = sigs[commonRx];
+        BOOST_FOREACH(RoundMapType::value_type &entry, shard.mapRounds) {
+            CSigRound &round = entry.second;
+            const CSigSet *set = round.GetSet(commonRx);
 
-        if (s.empty())
-            continue;
-
-        const CCvnPartialSignature &sigFirst = s.begin()->second;
+            if (!set || !set->nSigs)
+                continue;
 
-        if (nActiveCVNs - sigFirst.vMissingSignerIds.size() == s.size())
-            continue; // no missing IDs for this commonR
+            if (nActiveCVNs - set->vMissingSignerIds.size() == set->nSigs)
+                continue; // no missing IDs for this commonR
 
-        BOOST_FOREACH(const CNoncePoolType::value_type& p, mapNoncePool) {
-            if (s.find(p.first) != s.end())
-                continue;
+            BOOST_FOREACH(const CNoncePoolType::value_type& p, mapNoncePool) {
+                const int nSlot = round.GetSlot(p.first);
+                if (nSlot >= 0 && !round.vArena[set->nOffset + nSlot].IsNull())
+                    continue;
 
-            sMissing.insert(p.first);
+                vMissing.push_back(p.first);
+            }
         }
     }
 
-    if (sMissing.empty())
+    if (vMissing.empty())
         return false;
 
-    vMissingSignerIds.resize(sMissing.size());
-    copy(sMissing.begin(), sMissing.end(), vMissingSignerIds.begin());
+    sort(vMissing.begin(), vMissing.end());
+    vMissing.erase(unique(vMissing.begin(), vMissing.end()), vMissing.end());
+    vMissingSignerIds.swap(vMissing);
     return true;
 }
 
+/* Drop all rounds that are not for the block of nNextCreator. The arena of a
+ * round goes with it, without touching the single signatures. */
 void CSignatureHolder::clear(const uint32_t nNextCreator)
 {
-    LOCK(cs_sigHolder);
-
-    MapSigCommonR::iterator ci = sigs.begin();
-
-    while(ci != sigs.end()) {
-        MapSigSigner &m = ci->second;
-        MapSigSigner::iterator mi = m.begin();
+    for (int i = 0; i < SHARDS; i++) {
+        LOCK(shards[i].cs_shard);
 
-        while(mi != m.end()) {
-            const CCvnPartialSignature& sig = mi->second;
-            if (sig.nCreatorId != nNextCreator) {
-                m.erase(mi++);
+        RoundMapType::iterator it = shards[i].mapRounds.begin();
+        while (it != shards[i].mapRounds.end()) {
+            if (it->second.nCreatorId != nNextCreator) {
+                shards[i].mapRounds.erase(it++);
             } else {
-                ++mi;
+                ++it;
             }
         }
+    }
+}
 
-        if (m.empty()) {
-            sigs.erase(ci++);
-        } else {
-            ++ci;
-        }
+/* the number of signature sets held */
+size_t CSignatureHolder::size()
+{
+    size_t nSets = 0;
+
+    for (int i = 0; i < SHARDS; i++) {
+        LOCK(shards[i].cs_shard);
+        BOOST_FOREACH(const RoundMapType::value_type &entry, shards[i].mapRounds)
+            nSets += entry.second.vSets.size();
     }
+
+    return nSets;
 }
 
 string CSignatureHolder::ToString()
 {
     std::stringstream s;
 
-    LOCK(cs_sigHolder);
-    BOOST_FOREACH(const MapSigCommonR::value_type& commonRx, sigs) {
-        s << strprintf("commonRx    (%02d): %s\n", commonRx.second.size(), commonRx.first.ToString());
-        BOOST_FOREACH(const MapSigSigner::value_type& signer, commonRx.second) {
-            s << strprintf(" signer         : 0x%08x (%s)\n", signer.first, signer.second.ToString());
+    for (int i = 0; i < SHARDS; i++) {
+        LOCK(shards[i].cs_shard);
+
+        BOOST_FOREACH(const RoundMapType::value_type &entry, shards[i].mapRounds) {
+            const CSigRound &round = entry.second;
+
+            BOOST_FOREACH(const CSigSet &set, round.vSets) {
+                s << strprintf("commonRx    (%02d): %s\n", set.nSigs, set.commonRx.ToString());
+                for (const CSigSlot *slot = round.begin(set); slot != round.end(set); slot++) {
+                    if (!slot->IsNull())
+                        s << strprintf(" signer         : 0x%08x (%s)\n", slot->nSignerId, round.GetSignature(set, *slot).ToString());
+                }
+            }
         }
     }
 
@@ -459,46 +900,147 @@ const CSchnorrNonce *GetCurrnetPublicNonce(const uint32_t nNodeId)
     return &pool.vPublicNonces[nPoolOffset];
 }
 
-bool CreateSumPublicNoncesOthers(CSchnorrPubKey &sumPublicNoncesOthers, const uint32_t& nNextCreator, const uint32_t& nNodeId, const vector<uint32_t> &vMissingSignerIds)
+void CNonceSumCache::SetNull()
 {
-    LOCK(cs_mapNoncePool);
-    vector<secp256k1_pubkey *> allPubOtherNonces;
+    Invalidate();
+    hashTip.SetNull();
+    nCvnSetHeight = 0;
+    nHits = nMisses = 0;
+}
 
-    BOOST_FOREACH(const CvnMapType::value_type& cvn, mapCVNs) {
-        if (cvn.first == nNodeId)
-            continue;
+void CNonceSumCache::Invalidate()
+{
+    mapSums.clear();
+    nGeneration++;
+}
+
+const CNonceSumCache::CNonceSum* CNonceSumCache::Get(const uint256 &hashTipIn, const uint32_t nCvnSetHeightIn, const uint256 &hashMissing)
+{
+    if (hashTipIn != hashTip || nCvnSetHeightIn != nCvnSetHeight) {
+        Invalidate();
+        hashTip       = hashTipIn;
+        nCvnSetHeight = nCvnSetHeightIn;
+    }
+
+    std::map<uint256, CNonceSum>::const_iterator it = mapSums.find(hashMissing);
+    if (it == mapSums.end()) {
+        nMisses++;
+        return NULL;
+    }
+
+    nHits++;
+    return &it->second;
+}
+
+const CNonceSumCache::CNonceSum* CNonceSumCache::Put(const uint256 &hashMissing, const CNonceSum &entry)
+{
+    // a round only sees a few different sets of missing signers
+    if (mapSums.size() >= MAX_ENTRIES)
+        mapSums.clear();
+
+    return &(mapSums[hashMissing] = entry);
+}
+
+CNonceSumCache nonceSumCache;
+
+/* the sum of the current public nonces of all CVNs not listed in vMissing (sorted), requires cs_mapNoncePool */
+static bool CreateSumPublicNonces(CNonceSumCache::CNonceSum &entry, const vector<uint32_t> &vMissing)
+{
+    vector<const secp256k1_pubkey *> allPubNonces;
+    entry.vWithoutPool.clear();
 
-        if (find(vMissingSignerIds.begin(), vMissingSignerIds.end(), cvn.first) != vMissingSignerIds.end()) {
+    BOOST_FOREACH(const CvnMapType::value_type& cvn, mapCVNs) {
+        if (binary_search(vMissing.begin(), vMissing.end(), cvn.first))
             continue;
-        }
 
         if (mapNoncePool.find(cvn.first) == mapNoncePool.end()) {
-            LogPrintf("%s : nonce pool unavailable for 0x%08x\n", __func__, cvn.first);
-            return false;;
+            entry.vWithoutPool.push_back(cvn.first);
+            continue;
         }
 
         const CSchnorrNonce *nonce = GetCurrnetPublicNonce(cvn.first);
         if (nonce == NULL)
             continue;
 
-        allPubOtherNonces.push_back((secp256k1_pubkey *)nonce);
+        allPubNonces.push_back((const secp256k1_pubkey *)nonce->begin());
     }
 
-    LogPrint("cvn", "%s : %s are missing\n", __func__, CreateSignerIdList(vMissingSignerIds));
+    entry.nNonces = allPubNonces.size();
+    memset(entry.sum.data, 0, sizeof(entry.sum.data));
 
-    memset(&sumPublicNoncesOthers.begin()[0], 0, 64);
-    if (allPubOtherNonces.size() > 1) {
-        if (!secp256k1_ec_pubkey_combine(secp256k1_context_none, (secp256k1_pubkey *)&sumPublicNoncesOthers.begin()[0], &allPubOtherNonces[0], allPubOtherNonces.size())) {
+    if (allPubNonces.size() > 1) {
+        if (!secp256k1_ec_pubkey_combine(secp256k1_context_none, &entry.sum, &allPubNonces[0], allPubNonces.size())) {
             LogPrintf("%s : could not combine nonces\n", __func__);
             return false;
         }
-    } else if (allPubOtherNonces.size() == 1) {
-        memcpy(&sumPublicNoncesOthers.begin()[0], allPubOtherNonces[0], 64);
-    } else {
+    } else if (allPubNonces.size() == 1) {
+        memcpy(entry.sum.data, allPubNonces[0]->data, sizeof(entry.sum.data));
+    }
+
+    return true;
+}
+
+/**
+ * The sum of the current public nonces of all CVNs but nNodeId and the ones
+ * listed in vMissingSignerIds. The sum of all of them is calculated once per
+ * tip and set of missing signers, the nonce of nNodeId is subtracted from it.
+ */
+bool CreateSumPublicNoncesOthers(CSchnorrPubKey &sumPublicNoncesOthers, const uint32_t& nNextCreator, const uint32_t& nNodeId, const vector<uint32_t> &vMissingSignerIds)
+{
+    LOCK(cs_mapNoncePool);
+
+    vector<uint32_t> vMissing(vMissingSignerIds);
+    sort(vMissing.begin(), vMissing.end());
+    vMissing.erase(unique(vMissing.begin(), vMissing.end()), vMissing.end());
+
+    CHashWriter hasher(SER_GETHASH, 0);
+    hasher << vMissing;
+    const uint256 hashMissing = hasher.GetHash();
+
+    const CNonceSumCache::CNonceSum *entry = nonceSumCache.Get(chainActive.Tip()->GetBlockHash(), nCvnSetHeight, hashMissing);
+    if (!entry) {
+        CNonceSumCache::CNonceSum newEntry;
+        if (!CreateSumPublicNonces(newEntry, vMissing))
+            return false;
+        entry = nonceSumCache.Put(hashMissing, newEntry);
+    }
+
+    BOOST_FOREACH(const uint32_t& nWithoutPool, entry->vWithoutPool) {
+        if (nWithoutPool != nNodeId) {
+            LogPrintf("%s : nonce pool unavailable for 0x%08x\n", __func__, nWithoutPool);
+            return false;
+        }
+    }
+
+    LogPrint("cvn", "%s : %s are missing\n", __func__, CreateSignerIdList(vMissingSignerIds));
+
+    // the signer's own nonce is part of the sum unless it is missing or has none
+    const CSchnorrNonce *nonce = NULL;
+    if (mapCVNs.count(nNodeId) && !binary_search(vMissing.begin(), vMissing.end(), nNodeId) && mapNoncePool.count(nNodeId))
+        nonce = GetCurrnetPublicNonce(nNodeId);
+
+    if (entry->nNonces < (nonce ? 2U : 1U)) {
         LogPrintf("%s : no nonces avaialbe\n", __func__);
         return false;
     }
 
+    secp256k1_pubkey *pSum = (secp256k1_pubkey *)sumPublicNoncesOthers.begin();
+    if (!nonce) {
+        *pSum = entry->sum;
+        return true;
+    }
+
+    secp256k1_pubkey negatedNonce;
+    memcpy(negatedNonce.data, nonce->begin(), sizeof(negatedNonce.data));
+    if (!secp256k1_ec_pubkey_negate(secp256k1_context_none, &negatedNonce))
+        return error("%s : could not negate public nonce of CVN 0x%08x", __func__, nNodeId);
+
+    const secp256k1_pubkey *vPubNonces[2] = { &entry->sum, &negatedNonce };
+    if (!secp256k1_ec_pubkey_combine(secp256k1_context_none, pSum, vPubNonces, 2)) {
+        LogPrintf("%s : could not combine nonces\n", __func__);
+        return false;
+    }
+
     return true;
 }
 
@@ -522,19 +1064,171 @@ static void UpdateHashWithMissingIDs(CHashWriter &hasher, const vector<uint32_t>
     hasher << nSumNodeIds;
 }
 
-bool CvnVerifyChainSignature(const CBlock& block)
+void CSignerPubKeyCache::SetNull()
+{
+    LOCK(cs_cache);
+
+    listEntries.clear();
+    mapEntries.clear();
+    nHits = nMisses = nSubtracted = nCombined = nEvicted = 0;
+}
+
+void CSignerPubKeyCache::EraseFrom(const uint32_t nHeight)
+{
+    LOCK(cs_cache);
+
+    std::map<CacheKeyType, CacheListType::iterator>::iterator it = mapEntries.lower_bound(std::make_pair(nHeight, uint256()));
+
+    while (it != mapEntries.end()) {
+        listEntries.erase(it->second);
+        mapEntries.erase(it++);
+    }
+}
+
+bool CSignerPubKeyCache::Get(const uint32_t nHeight, const uint256 &hashMissing, secp256k1_pubkey &pubKey)
+{
+    LOCK(cs_cache);
+
+    std::map<CacheKeyType, CacheListType::iterator>::iterator it = mapEntries.find(std::make_pair(nHeight, hashMissing));
+    if (it == mapEntries.end()) {
+        nMisses++;
+        return false;
+    }
+
+    listEntries.splice(listEntries.begin(), listEntries, it->second);
+    pubKey = it->second->second;
+    nHits++;
+    return true;
+}
+
+void CSignerPubKeyCache::Put(const uint32_t nHeight, const uint256 &hashMissing, const secp256k1_pubkey &pubKey, const bool fSubtracted)
+{
+    LOCK(cs_cache);
+
+    if (fSubtracted)
+        nSubtracted++;
+    else
+        nCombined++;
+
+    const CacheKeyType key = std::make_pair(nHeight, hashMissing);
+    std::map<CacheKeyType, CacheListType::iterator>::iterator it = mapEntries.find(key);
+    if (it != mapEntries.end()) {
+        it->second->second = pubKey;
+        listEntries.splice(listEntries.begin(), listEntries, it->second);
+        return;
+    }
+
+    listEntries.push_front(std::make_pair(key, pubKey));
+    mapEntries[key] = listEntries.begin();
+
+    while (mapEntries.size() > nMaxSize) {
+        mapEntries.erase(listEntries.back().first);
+        listEntries.pop_back();
+        nEvicted++;
+    }
+}
+
+/**
+ * Get the combined public key of all CVNs of the current CVN set that are not
+ * listed in vMissingSignerIds. If less than half of the CVNs are missing the
+ * public keys of the missing ones are subtracted from the cached sum of all
+ * public keys, otherwise the public keys of the signers are combined.
+ */
+bool GetSignersPubKey(secp256k1_pubkey &sumOfSignersPubkeys, const vector<uint32_t> &vMissingSignerIds)
+{
+    const CCvnSetInfoRef info = GetCvnSetInfo();
+    const CvnMapType &mapCvns = info->mapCVNs;
+
+    /* IDs that are not part of the current CVN set do not affect the result */
+    vector<uint32_t> vMissing;
+    vMissing.reserve(vMissingSignerIds.size());
+    BOOST_FOREACH(const uint32_t& nMissingId, vMissingSignerIds) {
+        if (mapCvns.count(nMissingId))
+            vMissing.push_back(nMissingId);
+    }
+    sort(vMissing.begin(), vMissing.end());
+    vMissing.erase(unique(vMissing.begin(), vMissing.end()), vMissing.end());
+
+    if (vMissing.size() >= mapCvns.size())
+        return false;
+
+    CHashWriter hasher(SER_GETHASH, 0);
+    hasher << vMissing;
+    const uint256 hashMissing = hasher.GetHash();
+
+    if (signerPubKeyCache.Get(info->nHeight, hashMissing, sumOfSignersPubkeys))
+        return true;
+
+    const bool fSubtract = vMissing.size() < mapCvns.size() - vMissing.size();
+
+    if (fSubtract) {
+        vector<secp256k1_pubkey> vNegatedPubkeys(vMissing.size());
+        vector<const secp256k1_pubkey *> vPubkeys;
+        vPubkeys.reserve(vMissing.size() + 1);
+        vPubkeys.push_back(&info->sumOfAllPubKeys);
+
+        for (size_t i = 0; i < vMissing.size(); i++) {
+            memcpy(vNegatedPubkeys[i].data, mapCvns.find(vMissing[i])->second.pubKey.begin(), sizeof(vNegatedPubkeys[i].data));
+            if (!secp256k1_ec_pubkey_negate(secp256k1_context_none, &vNegatedPubkeys[i]))
+                return error("%s : could not negate public key of CVN 0x%08x", __func__, vMissing[i]);
+            vPubkeys.push_back(&vNegatedPubkeys[i]);
+        }
+
+        if (vPubkeys.size() == 1)
+            sumOfSignersPubkeys = info->sumOfAllPubKeys;
+        else if (!secp256k1_ec_pubkey_combine(secp256k1_context_none, &sumOfSignersPubkeys, &vPubkeys[0], vPubkeys.size()))
+            return false;
+    } else {
+        vector<const secp256k1_pubkey *> vPubkeys;
+        vPubkeys.reserve(mapCvns.size() - vMissing.size());
+
+        for (CvnMapType::const_iterator it = mapCvns.begin(); it != mapCvns.end(); it++) {
+            if (binary_search(vMissing.begin(), vMissing.end(), it->first))
+                continue;
+
+            vPubkeys.push_back((const secp256k1_pubkey *)it->second.pubKey.begin());
+        }
+
+        if (!secp256k1_ec_pubkey_combine(secp256k1_context_none, &sumOfSignersPubkeys, &vPubkeys[0], vPubkeys.size()))
+            return false;
+    }
+
+    signerPubKeyCache.Put(info->nHeight, hashMissing, sumOfSignersPubkeys, fSubtract);
+    return true;
+}
+
+bool CPocSignatureCheck::operator()()
+{
+    if (!CvnVerifySignature(hash, sig, pubKey))
+        return error("%s : could not verify signature %s for hash %s signed by 0x%08x", __func__, sig.ToString(), hash.ToString(), nSignerId);
+
+    return true;
+}
+
+/**
+ * Verify the chain signature of a block against the current CVN set. If pvChecks
+ * is not NULL the verification itself is appended to it instead of done here.
+ */
+bool CvnVerifyChainSignature(const CBlock& block, std::vector<CPocSignatureCheck> *pvChecks)
 {
     CHashWriter hasher(SER_GETHASH, 0);
     hasher << block.hashPrevBlock << block.nCreatorId;
 
     /* special case when bootstrapping the blockchain we only have one CVN ID */
-    if (mapCVNs.size() == 1) {
-        if (!mapCVNs.count(block.nCreatorId)) {
+    const CCvnSetInfoRef info = GetCvnSetInfo();
+    if (info->mapCVNs.size() == 1) {
+        CvnMapType::const_iterator it = info->mapCVNs.find(block.nCreatorId);
+        if (it == info->mapCVNs.end()) {
             LogPrintf("CvnVerifyChainSignature : could not find CvnInfo for signer ID 0x%08x\n", block.nCreatorId);
             return false;
         }
 
-        if (!CPubKey::VerifySchnorr(hasher.GetHash(), block.chainMultiSig, mapCVNs[block.nCreatorId].pubKey)) {
+        if (pvChecks) {
+            pvChecks->push_back(CPocSignatureCheck(hasher.GetHash(), block.chainMultiSig, it->second.pubKey, block.nCreatorId));
+            return true;
+        }
+
+        if (!CPubKey::VerifySchnorr(hasher.GetHash(), block.chainMultiSig, it->second.pubKey)) {
             LogPrintf("CvnVerifyChainSignature : could not verify single sig %s for hash %s for node Id 0x%08x\n", block.chainMultiSig.ToString(), hasher.GetHash().ToString(), block.nCreatorId);
             return false;
         } else {
@@ -546,8 +1240,8 @@ bool CvnVerifyChainSignature(const CBlock& block)
     secp256k1_pubkey sumOfAllSignersPubkeys;
 
     /* if there are no missing signatures we can use the cached
-     * combined pubkeys from the CvnInfoCache, otherwise we combine
-     * them
+     * combined pubkeys from the CvnInfoCache, otherwise we get
+     * them from the signer pubkey cache
      */
     if (vMissingSignersIds.empty()) {
         BlockMap::iterator mi = mapBlockIndex.find(block.hashPrevBlock);
@@ -558,18 +1252,7 @@ bool CvnVerifyChainSignature(const CBlock& block)
         GetCvnInfoCache(&cache, (*mi).second->nHeight + 1);
         sumOfAllSignersPubkeys = cache->sumOfAllpubKeys;
     } else {
-        int count = 0;
-        secp256k1_pubkey *allSignersPubkeys[MAX_NUMBER_OF_CVNS];
-
-        BOOST_FOREACH(const CvnMapType::value_type& cvn, mapCVNs)
-        {
-            if (!vMissingSignersIds.empty() && find(vMissingSignersIds.begin(), vMissingSignersIds.end(), cvn.first) != vMissingSignersIds.end())
-                continue;
-
-            allSignersPubkeys[count++] = (secp256k1_pubkey *)&cvn.second.pubKey.begin()[0];
-        }
-
-        if (!secp256k1_ec_pubkey_combine(secp256k1_context_none, &sumOfAllSignersPubkeys, allSignersPubkeys, count))
+        if (!GetSignersPubKey(sumOfAllSignersPubkeys, vMissingSignersIds))
             return error("CvnVerifyChainSignature : could not combine signers public keys");
 
         UpdateHashWithMissingIDs(hasher, vMissingSignersIds);
@@ -578,6 +1261,11 @@ bool CvnVerifyChainSignature(const CBlock& block)
     uint256 hash = hasher.GetHash();
 
     CSchnorrPubKey pubKey(sumOfAllSignersPubkeys.data);
+    if (pvChecks) {
+        pvChecks->push_back(CPocSignatureCheck(hash, block.chainMultiSig, pubKey));
+        return true;
+    }
+
     if (!CvnVerifySignature(hash, block.chainMultiSig, pubKey))
         return error("CvnVerifyChainSignature : could not verify chain signature for block: %s sig: %s missing: %s)", hash.ToString(), block.chainMultiSig.ToString(), CreateSignerIdList(block.vMissingSignerIds));
 
@@ -604,12 +1292,14 @@ bool VerifyPartialSignature(const uint256 &hash, const CSchnorrSig &sig, const C
 
 bool CvnVerifySignature(const uint256 &hash, const CSchnorrSig &sig, const uint32_t nCvnId)
 {
-    if (!mapCVNs.count(nCvnId)) {
+    const CCvnSetInfoRef info = GetCvnSetInfo();
+    CvnMapType::const_iterator it = info->mapCVNs.find(nCvnId);
+    if (it == info->mapCVNs.end()) {
         LogPrintf("ERROR: could not find CvnInfo for signer ID 0x%08x\n", nCvnId);
         return false;
     }
 
-    if (!CvnVerifySignature(hash, sig, mapCVNs[nCvnId].pubKey)) {
+    if (!CvnVerifySignature(hash, sig, it->second.pubKey)) {
         LogPrintf("could not verify sig %s for hash %s for node Id 0x%08x\n", sig.ToString(), hash.ToString(), nCvnId);
         return false;
     }
@@ -619,12 +1309,14 @@ bool CvnVerifySignature(const uint256 &hash, const CSchnorrSig &sig, const uint3
 
 bool VerifyAdminSignature(const uint256 &hash, const CSchnorrSig &sig, const uint32_t nAdminId)
 {
-    if (!mapChainAdmins.count(nAdminId)) {
+    const CCvnSetInfoRef info = GetCvnSetInfo();
+    ChainAdminMapType::const_iterator it = info->mapChainAdmins.find(nAdminId);
+    if (it == info->mapChainAdmins.end()) {
         LogPrintf("ERROR: could not find chain admin for signer ID 0x%08x\n", nAdminId);
         return false;
     }
 
-    if (!CvnVerifySignature(hash, sig, mapChainAdmins[nAdminId].pubKey)) {
+    if (!CvnVerifySignature(hash, sig, it->second.pubKey)) {
         LogPrintf("could not verify sig %s for hash %s for admin Id 0x%08x\n", sig.ToString(), hash.ToString(), nAdminId);
         return false;
     }
@@ -632,7 +1324,7 @@ bool VerifyAdminSignature(const uint256 &hash, const CSchnorrSig &sig, const uin
     return true;
 }
 
-bool CvnVerifyAdminSignature(const vector<uint32_t> &vAdminIds, const uint256& hashAdmin, const CSchnorrSig& sig)
+bool CvnVerifyAdminSignature(const CCvnSetInfo &info, const vector<uint32_t> &vAdminIds, const uint256& hashAdmin, const CSchnorrSig& sig)
 {
     if (vAdminIds.empty()) {
         LogPrintf("%s : no admin IDs avaialbe for hash: %s\n", __func__, hashAdmin.ToString());
@@ -640,15 +1332,11 @@ bool CvnVerifyAdminSignature(const vector<uint32_t> &vAdminIds, const uint256& h
     }
 
     /* special case when bootstrapping the blockchain we have one chain admin ID only */
-    if (mapChainAdmins.size() == 1) {
-        const uint32_t nAdminId = mapChainAdmins.begin()->first;
-        if (!mapChainAdmins.count(nAdminId)) {
-            LogPrintf("%s : could not find CChainAdmin for admin ID 0x%08x\n", __func__, nAdminId);
-            return false;
-        }
+    if (info.mapChainAdmins.size() == 1) {
+        const CChainAdmin &admin = info.mapChainAdmins.begin()->second;
 
-        if (!CPubKey::VerifySchnorr(hashAdmin, sig, mapChainAdmins[nAdminId].pubKey)) {
-            LogPrintf("%s : could not verify single sig %s for hash %s for admin Id 0x%08x (%s)\n", __func__, sig.ToString(), hashAdmin.ToString(), nAdminId, mapChainAdmins[nAdminId].pubKey.ToString());
+        if (!CPubKey::VerifySchnorr(hashAdmin, sig, admin.pubKey)) {
+            LogPrintf("%s : could not verify single sig %s for hash %s for admin Id 0x%08x (%s)\n", __func__, sig.ToString(), hashAdmin.ToString(), admin.nAdminId, admin.pubKey.ToString());
             return false;
         } else {
             return true;
@@ -659,7 +1347,7 @@ bool CvnVerifyAdminSignature(const vector<uint32_t> &vAdminIds, const uint256& h
     secp256k1_pubkey *allSignersPubkeys[MAX_NUMBER_OF_CHAIN_ADMINS];
 
     // TODO: we should really cache this...
-    BOOST_FOREACH(const ChainAdminMapType::value_type& entry, mapChainAdmins)
+    BOOST_FOREACH(const ChainAdminMapType::value_type& entry, info.mapChainAdmins)
     {
         if (find(vAdminIds.begin(), vAdminIds.end(), entry.first) == vAdminIds.end())
             continue;
@@ -697,25 +1385,26 @@ void RelayChainData(const CChainDataMsg& msg)
 
 bool CheckAdminSignature(const vector<uint32_t> &vAdminIds, const uint256 &hashAdmin, const CSchnorrSig &sig, const bool fCoinSupply)
 {
+    const CCvnSetInfoRef info = GetCvnSetInfo();
     const uint32_t nSigs = vAdminIds.size();
 
-    if (nSigs < dynParams.nMinAdminSigs) {
-        LogPrintf("%s : not enough admin signatures supplied (got %u signatures, but need at least %u to sign)\n", __func__, nSigs, dynParams.nMinAdminSigs);
+    if (nSigs < info->dynParams.nMinAdminSigs) {
+        LogPrintf("%s : not enough admin signatures supplied (got %u signatures, but need at least %u to sign)\n", __func__, nSigs, info->dynParams.nMinAdminSigs);
         return false;
     }
 
-    if (nSigs > dynParams.nMaxAdminSigs) {
-        LogPrintf("%s : too many admin signatures supplied %u (%u max)\n", __func__, nSigs, dynParams.nMaxAdminSigs);
+    if (nSigs > info->dynParams.nMaxAdminSigs) {
+        LogPrintf("%s : too many admin signatures supplied %u (%u max)\n", __func__, nSigs, info->dynParams.nMaxAdminSigs);
         return false;
     }
 
-    if (fCoinSupply && nSigs < mapChainAdmins.size()) {
+    if (fCoinSupply && nSigs < info->mapChainAdmins.size()) {
         LogPrintf("%s : not enough admin signatures supplied (got %u signatures, but need at least %u to sign for coin supply)\n", __func__,
-            nSigs, mapChainAdmins.size());
+            nSigs, info->mapChainAdmins.size());
         return false;
     }
 
-    return CvnVerifyAdminSignature(vAdminIds, hashAdmin, sig);
+    return CvnVerifyAdminSignature(*info, vAdminIds, hashAdmin, sig);
 }
 
 bool AddChainData(const CChainDataMsg& msg)
@@ -749,6 +1438,7 @@ bool AddChainData(const CChainDataMsg& msg)
         sigHolder.SetNull();
     }
 
+    NotifyPocThread();
     return true;
 }
 
@@ -767,6 +1457,50 @@ static void printNoncesTree()
 }
 #endif
 
+CCriticalSection cs_mapCvnAddrs;
+CvnAddrMapType mapCvnAddrs;
+
+/** Set while this node runs as a CVN with overlay connections, it then asks its peers for their CVN IDs and tells its own */
+static bool fCvnOverlay = false;
+
+uint256 CCvnAddrMsgUnsigned::GetHash() const
+{
+    return SerializeHash(*this);
+}
+
+string CCvnAddrMsgUnsigned::ToString() const
+{
+    return strprintf("CCvnAddrMsg(ver=%d, nodeId=0x%08x, addr=%s, creationTime=%u)", nVersion, nNodeId, addr.ToString(), nCreationTime);
+}
+
+uint256 CCvnHelloMsg::GetHash() const
+{
+    CHashWriter hasher(SER_GETHASH, 0);
+    hasher << string("cvnhello") << nNodeId << hashChallenge;
+
+    return hasher.GetHash();
+}
+
+/** The connection to a CVN that proved its ID with a cvnhello, requires cs_vNodes */
+static CNode* FindCvnNode(const uint32_t nNodeId)
+{
+    if (!nNodeId)
+        return NULL;
+
+    BOOST_FOREACH(CNode* pnode, vNodes) {
+        if (!pnode->fDisconnect && pnode->nCvnId == nNodeId)
+            return pnode;
+    }
+
+    return NULL;
+}
+
+bool IsCvnNode(const CNode* pnode, const uint32_t nNodeId)
+{
+    LOCK(cs_vNodes);
+    return FindCvnNode(nNodeId) == pnode;
+}
+
 void RelayCvnSignature(const CCvnPartialSignature& msg)
 {
     CInv inv(MSG_CVN_SIGNATURE, msg.GetHash());
@@ -776,14 +1510,159 @@ void RelayCvnSignature(const CCvnPartialSignature& msg)
     }
 
     LOCK(cs_vNodes);
+    CNode* pnodeCreator = FindCvnNode(msg.nCreatorId);
+
     BOOST_FOREACH(CNode* pnode, vNodes)
     {
         if(!pnode->fRelayPoCMessages)
             continue;
+
+        // the creator of the next block gets the signature right away, the inv is the fallback for everyone else
+        if (pnode == pnodeCreator && !pnode->HasInventoryKnown(inv.hash)) {
+            pnode->AddInventoryKnown(inv);
+            pnode->PushMessage(NetMsgType::SIG, msg);
+            continue;
+        }
+
         pnode->PushInventory(inv);
     }
 }
 
+/** Asks a peer to prove the CVN ID it runs as, only CVNs on the overlay need to know */
+void SendCvnChallenge(CNode* pto)
+{
+    if (!fCvnOverlay || pto->nVersion < CVN_OVERLAY_VERSION)
+        return;
+
+    GetStrongRandBytes(pto->hashCvnChallenge.begin(), 32);
+    pto->PushMessage(NetMsgType::CVNCHALLENGE, pto->hashCvnChallenge);
+}
+
+#ifdef USE_CVN
+/**
+ * Whether a peer is at the announced address of a CVN. These are the overlay
+ * connections we opened, or inbound connections from the IP of a CVN.
+ */
+static bool IsCvnAddrPeer(const CNode* pnode)
+{
+    LOCK(cs_mapCvnAddrs);
+    BOOST_FOREACH(const CvnAddrMapType::value_type& entry, mapCvnAddrs) {
+        const CService& addr = entry.second.addr;
+        if (pnode->fInbound ? (CNetAddr)pnode->addr == (CNetAddr)addr : (CService)pnode->addr == addr)
+            return true;
+    }
+
+    return false;
+}
+#endif
+
+void AnswerCvnChallenge(CNode* pfrom, const uint256& hashChallenge)
+{
+#ifdef USE_CVN
+    // signing blocks the message handler while the Fasito is busy, only
+    // answer once per connection and only to peers at the address of a CVN
+    if (!fCvnOverlay || !nCvnNodeId || pfrom->fCvnHelloSent)
+        return;
+
+    if (!IsCvnAddrPeer(pfrom)) {
+        LogPrint("cvn", "%s : ignoring CVN challenge from peer=%d, not a CVN address\n", __func__, pfrom->id);
+        return;
+    }
+    pfrom->fCvnHelloSent = true;
+
+    CCvnHelloMsg msg;
+    msg.nNodeId       = nCvnNodeId;
+    msg.hashChallenge = hashChallenge;
+
+    if (!CvnSignHash(msg.GetHash(), msg.msgSig)) {
+        LogPrintf("%s : could not sign CVN hello for peer=%d\n", __func__, pfrom->id);
+        return;
+    }
+
+    pfrom->PushMessage(NetMsgType::CVNHELLO, msg);
+#endif
+}
+
+/** Sets the CVN ID of a peer that answered our challenge, returns false if the answer is not valid */
+bool AcceptCvnHello(CNode* pfrom, const CCvnHelloMsg& msg)
+{
+    if (pfrom->hashCvnChallenge.IsNull() || msg.hashChallenge != pfrom->hashCvnChallenge)
+        return error("%s : unexpected CVN hello from peer=%d", __func__, pfrom->id);
+
+    if (mapBannedCVNs.count(msg.nNodeId) || !CvnVerifySignature(msg.GetHash(), msg.msgSig, msg.nNodeId))
+        return error("%s : invalid CVN hello for 0x%08x from peer=%d", __func__, msg.nNodeId, pfrom->id);
+
+    pfrom->hashCvnChallenge.SetNull();
+    pfrom->nCvnId = msg.nNodeId;
+    LogPrint("cvn", "%s : peer=%d is CVN 0x%08x\n", __func__, pfrom->id, msg.nNodeId);
+
+    return true;
+}
+
+bool HaveCvnAddr(const CCvnAddrMsg& msg)
+{
+    LOCK(cs_mapCvnAddrs);
+    CvnAddrMapType::const_iterator it = mapCvnAddrs.find(msg.nNodeId);
+
+    return it != mapCvnAddrs.end() && it->second.nCreationTime >= msg.nCreationTime;
+}
+
+/**
+ * Adds the overlay address of a CVN. state is invalid with a DoS score for
+ * announcements no honest peer relays, outdated ones are ignored without.
+ */
+bool AddCvnAddr(const CCvnAddrMsg& msg, CValidationState& state)
+{
+    const int64_t nNow = GetAdjustedTime();
+
+    if (msg.nVersion > CCvnAddrMsg::CURRENT_VERSION || msg.nCreationTime > nNow + 10 * 60 || msg.nCreationTime + CVN_ADDR_MAX_AGE < nNow) {
+        LogPrint("cvn", "%s : ignoring outdated or unsupported %s\n", __func__, msg.ToString());
+        return false;
+    }
+
+    // CVNs on regtest are allowed to announce local addresses
+    if (!msg.addr.IsValid() || (!msg.addr.IsRoutable() && Params().NetworkIDString() != "regtest"))
+        return state.DoS(20, error("%s : invalid address %s", __func__, msg.ToString()));
+
+    if (mapBannedCVNs.count(msg.nNodeId))
+        return state.DoS(20, error("%s : address of banned CVN %s", __func__, msg.ToString()));
+
+    if (!CvnVerifySignature(msg.GetHash(), msg.msgSig, msg.nNodeId))
+        return state.DoS(50, error("%s : invalid signature %s", __func__, msg.ToString()));
+
+    LOCK(cs_mapCvnAddrs);
+    CvnAddrMapType::iterator it = mapCvnAddrs.find(msg.nNodeId);
+    if (it != mapCvnAddrs.end() && it->second.nCreationTime >= msg.nCreationTime)
+        return false;
+
+    LogPrint("cvn", "%s : CVN 0x%08x accepts overlay connections on %s\n", __func__, msg.nNodeId, msg.addr.ToString());
+    mapCvnAddrs[msg.nNodeId] = msg;
+
+    return true;
+}
+
+void RelayCvnAddr(const CCvnAddrMsg& msg, const CNode* pfrom)
+{
+    LOCK(cs_vNodes);
+    BOOST_FOREACH(CNode* pnode, vNodes)
+    {
+        if (pnode == pfrom || !pnode->fRelayPoCMessages || pnode->nVersion < CVN_OVERLAY_VERSION)
+            continue;
+
+        pnode->PushMessage(NetMsgType::CVNADDR, msg);
+    }
+}
+
+void AdvertiseCvnAddrs(CNode* pto)
+{
+    if (pto->nVersion < CVN_OVERLAY_VERSION)
+        return;
+
+    LOCK(cs_mapCvnAddrs);
+    BOOST_FOREACH(const CvnAddrMapType::value_type& entry, mapCvnAddrs)
+        pto->PushMessage(NetMsgType::CVNADDR, entry.second);
+}
+
 bool CvnVerifyPartialSignature(const CCvnPartialSignature& sig)
 {
     CHashWriter hasher(SER_GETHASH, 0);
@@ -806,9 +1685,86 @@ bool CvnVerifyPartialSignature(const CCvnPartialSignature& sig)
     if (!CreateSumPublicNoncesOthers(sumPublicNoncesOthers, sig.nCreatorId, sig.nSignerId, sig.vMissingSignerIds))
         return false;
 
-    UpdateHashWithMissingIDs(hasher, sig.vMissingSignerIds);
+    UpdateHashWithMissingIDs(hasher, sig.vMissingSignerIds);
+
+    return VerifyPartialSignature(hasher.GetHash(), sig.signature, mapCVNs[sig.nSignerId].pubKey, sumPublicNoncesOthers);
+}
+
+/* Verify the partial signatures of a signature set in one go. They must have been
+ * created for the same tip, creator and missing signers. Verified signatures are
+ * marked as validated, the IDs of the signers of invalid ones are returned in
+ * vInvalidSignerIds. */
+bool CvnVerifyPartialSignatures(const vector<CCvnPartialSignature*> &vSigs, vector<uint32_t> &vInvalidSignerIds)
+{
+    if (vSigs.empty())
+        return true;
+
+    const CCvnPartialSignature &firstSig = *vSigs[0];
+    bool fSingleVerify = mapCVNs.size() == 1 || vSigs.size() == 1;
+    BOOST_FOREACH(const CCvnPartialSignature* sig, vSigs) {
+        if (sig->hashPrevBlock != firstSig.hashPrevBlock || sig->nCreatorId != firstSig.nCreatorId || sig->vMissingSignerIds != firstSig.vMissingSignerIds) {
+            fSingleVerify = true;
+            break;
+        }
+    }
+
+    CSchnorrPubKey sumPublicNonces;
+    if (!fSingleVerify && (!mapCVNs.count(firstSig.nCreatorId) || !CreateSumPublicNoncesOthers(sumPublicNonces, firstSig.nCreatorId, 0, firstSig.vMissingSignerIds)))
+        fSingleVerify = true;
+
+    if (fSingleVerify) {
+        BOOST_FOREACH(CCvnPartialSignature* sig, vSigs) {
+            sig->fValidated = CvnVerifyPartialSignature(*sig);
+            if (!sig->fValidated)
+                vInvalidSignerIds.push_back(sig->nSignerId);
+        }
+
+        return vInvalidSignerIds.empty();
+    }
+
+    vector<CSchnorrSig> vSchnorrSigs;
+    vector<CSchnorrPubKey> vPubKeys;
+    vector<CSchnorrNonce> vPubNonces;
+    vector<CCvnPartialSignature*> vBatch;
+    {
+        LOCK(cs_mapNoncePool);
+        BOOST_FOREACH(CCvnPartialSignature* sig, vSigs) {
+            CvnMapType::const_iterator it = mapCVNs.find(sig->nSignerId);
+            const CSchnorrNonce *nonce = GetCurrnetPublicNonce(sig->nSignerId);
+
+            if (it == mapCVNs.end() || !nonce) {
+                LogPrintf("%s : signer CVN or its nonce not found 0x%08x\n", __func__, sig->nSignerId);
+                vInvalidSignerIds.push_back(sig->nSignerId);
+                continue;
+            }
+
+            vSchnorrSigs.push_back(sig->signature);
+            vPubKeys.push_back(it->second.pubKey);
+            vPubNonces.push_back(*nonce);
+            vBatch.push_back(sig);
+        }
+    }
+
+    if (!vBatch.empty()) {
+        CHashWriter hasher(SER_GETHASH, 0);
+        hasher << firstSig.hashPrevBlock << firstSig.nCreatorId;
+        UpdateHashWithMissingIDs(hasher, firstSig.vMissingSignerIds);
+
+        vector<size_t> vInvalid;
+        CPubKey::VerifyPartialSchnorrBatch(hasher.GetHash(), vSchnorrSigs, vPubKeys, vPubNonces, sumPublicNonces, &vInvalid);
+
+        BOOST_FOREACH(CCvnPartialSignature* sig, vBatch)
+            sig->fValidated = true;
+
+        BOOST_FOREACH(const size_t &i, vInvalid) {
+            vBatch[i]->fValidated = false;
+            vInvalidSignerIds.push_back(vBatch[i]->nSignerId);
+        }
+
+        LogPrint("cvnsig", "%s : verified %u partial signatures, %u invalid\n", __func__, vBatch.size(), vInvalid.size());
+    }
 
-    return VerifyPartialSignature(hasher.GetHash(), sig.signature, mapCVNs[sig.nSignerId].pubKey, sumPublicNoncesOthers);
+    return vInvalidSignerIds.empty();
 }
 
 bool VerifyPartialAdminSignature(const CAdminPartialSignature& sig, const uint256 hash2Sign)
@@ -836,14 +1792,21 @@ bool VerifyPartialAdminSignature(const CAdminPartialSignature& sig, const uint25
 
 bool AddCvnSignature(CCvnPartialSignature& msg)
 {
-    if (!CvnVerifySignature(msg.GetHash(), msg.msgSig, msg.nSignerId))
+    const uint256 hashMsg = msg.GetHash();
+    if (!CvnVerifySignature(hashMsg, msg.msgSig, msg.nSignerId))
         return false;
 
-    msg.fValidated = CvnVerifyPartialSignature(msg);
-    if (!msg.fValidated)
-        LogPrintf("%s : invalid signature received for 0x%08x by 0x%08x, hash %s. Marked as invalid.\n", __func__, msg.nCreatorId, msg.nSignerId, msg.hashPrevBlock.ToString());
+    // signatures for our own block are batch verified when the block is created
+    if (nCvnNodeId && msg.nCreatorId == nCvnNodeId) {
+        msg.fValidated = false;
+    } else {
+        msg.fValidated = CvnVerifyPartialSignature(msg);
+        if (!msg.fValidated)
+            LogPrintf("%s : invalid signature received for 0x%08x by 0x%08x, hash %s. Marked as invalid.\n", __func__, msg.nCreatorId, msg.nSignerId, msg.hashPrevBlock.ToString());
+    }
 
-    sigHolder.AddSig(msg);
+    sigHolder.AddSig(msg, hashMsg);
+    NotifyPocThread();
 
     LogPrint("cvnsig", "%s : add sig for 0x%08x by 0x%08x, hash %s, missing: %s\n", __func__, msg.nCreatorId, msg.nSignerId,
             msg.hashPrevBlock.ToString(),
@@ -866,7 +1829,7 @@ void PrintAllChainAdmins()
     }
 }
 
-void UpdateCvnInfo(const CBlock* pblock, const uint32_t nHeight)
+void UpdateCvnInfo(const CBlock* pblock, const uint32_t nHeight, const uint256 &hashBlock, const CSchnorrPubKey *pSumOfAllPubKeys)
 {
     LogPrint("cvn", "UpdateCvnInfo : updating CVN data at height %d\n", nHeight);
 
@@ -875,7 +1838,7 @@ void UpdateCvnInfo(const CBlock* pblock, const uint32_t nHeight)
         return;
     }
 
-    AddToCvnInfoCache(pblock, nHeight);
+    AddToCvnInfoCache(pblock, nHeight, hashBlock, pSumOfAllPubKeys);
     PrintAllCVNs();
 }
 
@@ -888,14 +1851,19 @@ void UpdateChainAdmins(const CBlock* pblock)
         return;
     }
 
-    LOCK(cs_mapChainAdmins);
-
-    mapChainAdmins.clear();
+    CCvnSetInfo &info = ModifyCvnSetInfo();
+    info.mapChainAdmins.clear();
 
     BOOST_FOREACH(const CChainAdmin &admin, pblock->vChainAdmins) {
-        mapChainAdmins.insert(std::make_pair(admin.nAdminId, admin));
+        info.mapChainAdmins.insert(std::make_pair(admin.nAdminId, admin));
+    }
+
+    {
+        LOCK(cs_mapChainAdmins);
+        mapChainAdmins = info.mapChainAdmins;
     }
 
+    PublishCvnSetInfo();
     PrintAllChainAdmins();
 }
 
@@ -939,9 +1907,12 @@ void UpdateChainParameters(const CBlock* pblock)
     dynParams.strDescription               = pblock->dynamicChainParams.strDescription;
 
     ::minRelayTxFee = CFeeRate(dynParams.nTransactionFee);
+
+    ModifyCvnSetInfo().dynParams = dynParams;
+    PublishCvnSetInfo();
 }
 
-bool CheckProofOfCooperation(const CBlock& block, const Consensus::Params& params)
+bool CheckProofOfCooperation(const CBlock& block, const Consensus::Params& params, std::vector<CPocSignatureCheck> *pvChecks)
 {
     const uint256 hashBlock = block.GetHash();
 
@@ -967,10 +1938,17 @@ bool CheckProofOfCooperation(const CBlock& block, const Consensus::Params& param
         return true;
     }
 
-    if (!CvnVerifySignature(hashBlock, block.creatorSignature, block.nCreatorId))
+    if (pvChecks) {
+        const CCvnSetInfoRef info = GetCvnSetInfo();
+        CvnMapType::const_iterator it = info->mapCVNs.find(block.nCreatorId);
+        if (it == info->mapCVNs.end())
+            return error("%s : could not find CvnInfo for creator ID 0x%08x", __func__, block.nCreatorId);
+
+        pvChecks->push_back(CPocSignatureCheck(hashBlock, block.creatorSignature, it->second.pubKey, block.nCreatorId));
+    } else if (!CvnVerifySignature(hashBlock, block.creatorSignature, block.nCreatorId))
         return error("%s : invalid creator signature", __func__);
 
-    if (!CvnVerifyChainSignature(block))
+    if (!CvnVerifyChainSignature(block, pvChecks))
         return error("%s : invalid chain signature", __func__);
 
     // check if creator ID matches consensus rules
@@ -1058,8 +2036,9 @@ bool CheckForDuplicateAdminSigs(const CBlock& block)
     if (block.vAdminIds.empty() || block.vAdminIds.size() == 1)
         return true;
 
-    if (block.vAdminIds.size() > mapChainAdmins.size())
-        return error("detected too many admin sigs: %d/%d", block.vAdminIds.size(), mapChainAdmins.size());
+    const size_t nChainAdmins = GetCvnSetInfo()->mapChainAdmins.size();
+    if (block.vAdminIds.size() > nChainAdmins)
+        return error("detected too many admin sigs: %d/%d", block.vAdminIds.size(), nChainAdmins);
 
     boost::unordered_set<uint32_t> sNodeIds;
 
@@ -1075,14 +2054,16 @@ bool CheckForDuplicateMissingChainSigs(const CBlock& block)
     if (block.vMissingSignerIds.empty() || block.vMissingSignerIds.size() == 1)
         return true;
 
-    if (block.vMissingSignerIds.size() > mapCVNs.size())
-        return error("detected too many missing creators sigs: %d/%d", block.vMissingSignerIds.size(), mapCVNs.size());
+    const size_t nCvns = GetCvnSetInfo()->GetActiveCvns();
+    if (block.vMissingSignerIds.size() > nCvns)
+        return error("detected too many missing creators sigs: %d/%d", block.vMissingSignerIds.size(), nCvns);
 
-    boost::unordered_set<uint32_t> sNodeIds;
+    vector<uint32_t> vMissing(block.vMissingSignerIds);
+    sort(vMissing.begin(), vMissing.end());
 
-    BOOST_FOREACH(const uint32_t &id, block.vMissingSignerIds)
-        if (!sNodeIds.insert(id).second)
-            return error("detected duplicate missing chains sig Id: 0x%08x", id);
+    vector<uint32_t>::const_iterator it = adjacent_find(vMissing.begin(), vMissing.end());
+    if (it != vMissing.end())
+        return error("detected duplicate missing chains sig Id: 0x%08x", *it);
 
     return true;
 }
@@ -1098,45 +2079,63 @@ bool CheckForDuplicateChainAdmins(const CBlock& block)
     return true;
 }
 
-static uint32_t FindNewlyAddedCVN(const CBlockIndex* pindexStart)
+/** Get the CVN set of a CVN_PAYLOAD block, from the cache if possible */
+static bool GetCvnInfoFromBlock(const CBlockIndex* pindex, vector<CCvnInfo>& vCvns)
+{
+    CachedCvnType::iterator it = mapChachedCVNInfoBlocks.find(pindex->GetBlockHash());
+
+    if (it != mapChachedCVNInfoBlocks.end()) {
+        vCvns = it->second;
+        return true;
+    }
+
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+        LogPrintf("FATAL: Failed to read block %s\n", pindex->GetBlockHash().ToString());
+        return false;
+    }
+    mapChachedCVNInfoBlocks[pindex->GetBlockHash()] = block.vCvns;
+    vCvns = block.vCvns;
+
+    return true;
+}
+
+/** The CVN that was added by the block at pindex, 0 if none */
+static uint32_t GetAdmittedCVN(const CBlockIndex* pindex, const vector<CCvnInfo>& vCvns)
 {
-    const CChainParams& chainparams = Params();
+    BOOST_FOREACH(const CCvnInfo& cvn, vCvns)
+    {
+        if (cvn.nHeightAdded == (uint32_t)pindex->nHeight) {
+#if POC_DEBUG
+            LogPrintf("last added CVN: 0x%08x at height: %u\n%s\n", cvn.nNodeId, pindex->nHeight, cvn.ToString());
+#endif
+            return cvn.nNodeId;
+        }
+    }
+
+    return 0;
+}
 
+static uint32_t FindNewlyAddedCVN(const CBlockIndex* pindexStart)
+{
     uint32_t nLastAddedNode = 0;
+    if (cvnAdmissions.GetNewlyAddedCVN(pindexStart, nLastAddedNode))
+        return nLastAddedNode;
+
     const CBlockIndex* pindexFound = NULL;
 
     // find the CVN that was added last
     for (const CBlockIndex* pindex = pindexStart; pindex; pindex = pindex->pprev) {
         if (pindex->nVersion & CBlock::CVN_PAYLOAD) {
             vector<CCvnInfo> vCvnInfoFromBlock;
-            CachedCvnType::iterator it = mapChachedCVNInfoBlocks.find(pindex->GetBlockHash());
-
-            if (it == mapChachedCVNInfoBlocks.end()) {
-                CBlock block;
-                if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus())) {
-                    LogPrintf("FATAL: Failed to read block %s\n", pindex->GetBlockHash().ToString());
-                    return 0;
-                }
-                mapChachedCVNInfoBlocks[pindex->GetBlockHash()] = block.vCvns;
-                vCvnInfoFromBlock = block.vCvns;
-            } else {
-                vCvnInfoFromBlock = it->second;
-            }
-
-            BOOST_FOREACH(const CCvnInfo& cvn, vCvnInfoFromBlock)
-            {
-                if (cvn.nHeightAdded == (uint32_t)pindex->nHeight) {
-                    nLastAddedNode = cvn.nNodeId;
-                    pindexFound = pindex;
-#if POC_DEBUG
-                    LogPrintf("last added CVN: 0x%08x at height: %u\n%s\n", nLastAddedNode, pindex->nHeight, cvn.ToString());
-#endif
-                    break;
-                }
-            }
+            if (!GetCvnInfoFromBlock(pindex, vCvnInfoFromBlock))
+                return 0;
 
-            if (nLastAddedNode)
+            nLastAddedNode = GetAdmittedCVN(pindex, vCvnInfoFromBlock);
+            if (nLastAddedNode) {
+                pindexFound = pindex;
                 break;
+            }
         }
     }
 
@@ -1187,43 +2186,510 @@ static uint32_t FindDormantNode(const CBlockIndex* pindexStart, const map<uint32
     return 0;
 }
 
-static uint32_t GetCandidateOffset(const uint64_t nPrevBlockTime, const int64_t nTimeToTest)
+static uint32_t GetCandidateOffset(const CDynamicChainParams &params, const uint64_t nPrevBlockTime, const int64_t nTimeToTest)
 {
-    int nOverdue = nTimeToTest - nPrevBlockTime - dynParams.nBlockSpacing;
+    int nOverdue = nTimeToTest - nPrevBlockTime - params.nBlockSpacing;
 
-    if (nOverdue < (int)dynParams.nBlockSpacingGracePeriod)
+    if (nOverdue < (int)params.nBlockSpacingGracePeriod)
         return 0;
 
-    return nOverdue / dynParams.nBlockSpacingGracePeriod;
+    return nOverdue / params.nBlockSpacingGracePeriod;
+}
+
+static uint32_t GetSigWindowSize(const CCvnSetInfo &info)
+{
+    return std::min((uint32_t)POC_BLOCKS_TO_SCAN, info.dynParams.nMinSuccessiveSignatures);
+}
+
+void CCreatorCandidateTracker::SetNull()
+{
+    pindexTip = NULL;
+    nSigWindow = 0;
+    nSigBlocks = 0;
+    mapCreatedHeights.clear();
+    mapCandidatesByHeight.clear();
+    mapMissingSigs.clear();
+    mapSigWindowCreators.clear();
+
+    pinfo.reset();
+    nBannedCVNs = 0;
+    mapEligibleByHeight.clear();
+    nIneligibleSigWindowCreators = 0;
+    mapLastSigs.clear();
+    fLastSigsDirty = true;
+}
+
+bool CCreatorCandidateTracker::IsEligible(const uint32_t nCreatorId) const
+{
+    return pinfo && pinfo->mapCVNs.count(nCreatorId) && !mapBannedCVNs.count(nCreatorId);
+}
+
+void CCreatorCandidateTracker::AddCreated(const CBlockIndex *pindex, const bool fFront)
+{
+    std::deque<int> &vHeights = mapCreatedHeights[pindex->nCreatorId];
+
+    if (!vHeights.empty()) {
+        mapCandidatesByHeight.erase(vHeights.back());
+        mapEligibleByHeight.erase(vHeights.back());
+    }
+
+    if (fFront)
+        vHeights.push_front(pindex->nHeight);
+    else
+        vHeights.push_back(pindex->nHeight);
+
+    mapCandidatesByHeight[vHeights.back()] = pindex->nCreatorId;
+    if (IsEligible(pindex->nCreatorId))
+        mapEligibleByHeight[vHeights.back()] = pindex->nCreatorId;
+}
+
+void CCreatorCandidateTracker::RemoveCreated(const CBlockIndex *pindex, const bool fFront)
+{
+    std::map<uint32_t, std::deque<int> >::iterator it = mapCreatedHeights.find(pindex->nCreatorId);
+    if (it == mapCreatedHeights.end() || it->second.empty())
+        return;
+
+    std::deque<int> &vHeights = it->second;
+    mapCandidatesByHeight.erase(vHeights.back());
+    mapEligibleByHeight.erase(vHeights.back());
+
+    if (fFront)
+        vHeights.pop_front();
+    else
+        vHeights.pop_back();
+
+    if (vHeights.empty()) {
+        mapCreatedHeights.erase(it);
+    } else {
+        mapCandidatesByHeight[vHeights.back()] = pindex->nCreatorId;
+        if (IsEligible(pindex->nCreatorId))
+            mapEligibleByHeight[vHeights.back()] = pindex->nCreatorId;
+    }
+}
+
+void CCreatorCandidateTracker::UpdateSigWindow(const CBlockIndex *pindex, const int nDelta)
+{
+    const bool fWasInWindow = mapSigWindowCreators.count(pindex->nCreatorId);
+    if ((mapSigWindowCreators[pindex->nCreatorId] += nDelta) == 0)
+        mapSigWindowCreators.erase(pindex->nCreatorId);
+
+    if (fWasInWindow != (bool)mapSigWindowCreators.count(pindex->nCreatorId) && !IsEligible(pindex->nCreatorId))
+        nIneligibleSigWindowCreators += fWasInWindow ? -1 : 1;
+
+    BOOST_FOREACH(const uint32_t &nSignerId, pindex->vMissingSignerIds) {
+        if ((mapMissingSigs[nSignerId] += nDelta) == 0)
+            mapMissingSigs.erase(nSignerId);
+    }
+}
+
+/* the signature counts of all CVNs change while the chain is shorter than the window */
+void CCreatorCandidateTracker::SetSigBlocks(const CBlockIndex *pindex)
+{
+    const uint32_t nSigBlocksNew = pindex ? std::min(nSigWindow, (uint32_t)pindex->nHeight + 1) : 0;
+    if (nSigBlocksNew != nSigBlocks)
+        fLastSigsDirty = true;
+    nSigBlocks = nSigBlocksNew;
+}
+
+/* only the signers missing in a block that entered or left the window change their count */
+void CCreatorCandidateTracker::UpdateLastSigs(const CBlockIndex *pindex)
+{
+    if (fLastSigsDirty || !pinfo)
+        return;
+
+    BOOST_FOREACH(const uint32_t &nSignerId, pindex->vMissingSignerIds) {
+        if (!pinfo->mapCVNs.count(nSignerId))
+            continue;
+
+        map_t::const_iterator it = mapMissingSigs.find(nSignerId);
+        const uint32_t nSigs = nSigBlocks - (it == mapMissingSigs.end() ? 0 : it->second);
+        if (nSigs)
+            mapLastSigs[nSignerId] = nSigs;
+        else
+            mapLastSigs.erase(nSignerId);
+    }
+}
+
+/* filter the tracked creators anew for a changed CVN set or banned CVNs */
+void CCreatorCandidateTracker::Refilter(const CCvnSetInfoRef &info)
+{
+    pinfo = info;
+    nBannedCVNs = mapBannedCVNs.size();
+
+    mapEligibleByHeight.clear();
+    for (std::map<int, uint32_t>::const_iterator it = mapCandidatesByHeight.begin(); it != mapCandidatesByHeight.end(); it++) {
+        if (IsEligible(it->second))
+            mapEligibleByHeight.insert(mapEligibleByHeight.end(), *it);
+    }
+
+    nIneligibleSigWindowCreators = 0;
+    BOOST_FOREACH(const map_t::value_type &creator, mapSigWindowCreators) {
+        if (!IsEligible(creator.first))
+            nIneligibleSigWindowCreators++;
+    }
+
+    fLastSigsDirty = true;
+}
+
+void CCreatorCandidateTracker::Rebuild(const CBlockIndex *pindexNew)
+{
+    LOCK(cs_tracker);
+    SetNull();
+
+    if (!pindexNew)
+        return;
+
+    pinfo = GetCvnSetInfo();
+    nBannedCVNs = mapBannedCVNs.size();
+    nSigWindow = GetSigWindowSize(*pinfo);
+
+    const CBlockIndex *pindex = pindexNew;
+    for (unsigned int i = 0; pindex && i < POC_BLOCKS_TO_SCAN; pindex = pindex->pprev, i++) {
+        // walking backwards, hence the blocks are added to the front
+        AddCreated(pindex, true);
+        if (i < nSigWindow)
+            UpdateSigWindow(pindex, 1);
+    }
+
+    pindexTip = pindexNew;
+    SetSigBlocks(pindexTip);
+}
+
+void CCreatorCandidateTracker::ConnectTip(const CBlockIndex *pindexNew)
+{
+    LOCK(cs_tracker);
+    if (!pindexTip || pindexTip != pindexNew->pprev || nSigWindow != GetSigWindowSize(*GetCvnSetInfo())) {
+        Rebuild(pindexNew);
+        return;
+    }
+
+    SetSigBlocks(pindexNew);
+
+    AddCreated(pindexNew, false);
+    if (pindexNew->nHeight >= POC_BLOCKS_TO_SCAN)
+        RemoveCreated(pindexNew->GetAncestor(pindexNew->nHeight - POC_BLOCKS_TO_SCAN), true);
+
+    if (nSigWindow) {
+        UpdateSigWindow(pindexNew, 1);
+        UpdateLastSigs(pindexNew);
+        if (pindexNew->nHeight >= (int)nSigWindow) {
+            const CBlockIndex *pindexLeft = pindexNew->GetAncestor(pindexNew->nHeight - nSigWindow);
+            UpdateSigWindow(pindexLeft, -1);
+            UpdateLastSigs(pindexLeft);
+        }
+    }
+
+    pindexTip = pindexNew;
+}
+
+void CCreatorCandidateTracker::DisconnectTip(const CBlockIndex *pindexDelete)
+{
+    LOCK(cs_tracker);
+    if (!pindexTip || pindexTip != pindexDelete) {
+        SetNull();
+        return;
+    }
+
+    SetSigBlocks(pindexDelete->pprev);
+
+    RemoveCreated(pindexDelete, false);
+    if (pindexDelete->nHeight >= POC_BLOCKS_TO_SCAN)
+        AddCreated(pindexDelete->GetAncestor(pindexDelete->nHeight - POC_BLOCKS_TO_SCAN), true);
+
+    if (nSigWindow) {
+        UpdateSigWindow(pindexDelete, -1);
+        UpdateLastSigs(pindexDelete);
+        if (pindexDelete->nHeight >= (int)nSigWindow) {
+            const CBlockIndex *pindexEntered = pindexDelete->GetAncestor(pindexDelete->nHeight - nSigWindow);
+            UpdateSigWindow(pindexEntered, 1);
+            UpdateLastSigs(pindexEntered);
+        }
+    }
+
+    pindexTip = pindexDelete->pprev;
+}
+
+bool CCreatorCandidateTracker::GetCandidates(const CCvnSetInfoRef &info, const CBlockIndex *pindexStart, vector<uint32_t> &vCreatorCandidates, TimeWeightSetType &setCreatorCandidates, map<uint32_t, uint32_t> &mapLastSignatures)
+{
+    LOCK(cs_tracker);
+    if (!pindexTip || pindexTip != pindexStart)
+        return false;
+
+    if (nSigWindow != GetSigWindowSize(*info))
+        Rebuild(pindexTip);
+
+    // a newer CVN set info was published in the meantime
+    if (nSigWindow != GetSigWindowSize(*info))
+        return false;
+
+    if (pinfo != info || nBannedCVNs != mapBannedCVNs.size())
+        Refilter(info);
+
+    // blocks of deactivated or banned CVNs are skipped while counting signatures,
+    // which shifts the window. Leave these rare cases to the full scan.
+    if (nIneligibleSigWindowCreators)
+        return false;
+
+    // most recent creator first, the last entry has the highest time-weight
+    for (std::map<int, uint32_t>::reverse_iterator it = mapEligibleByHeight.rbegin(); it != mapEligibleByHeight.rend(); ++it) {
+        if (setCreatorCandidates.insert(it->second).second)
+            vCreatorCandidates.push_back(it->second);
+    }
+
+    if (!nSigWindow)
+        return true;
+
+    if (fLastSigsDirty) {
+        mapLastSigs.clear();
+        BOOST_FOREACH(const CvnMapType::value_type& cvn, pinfo->mapCVNs) {
+            map_t::const_iterator it = mapMissingSigs.find(cvn.first);
+            const uint32_t nSigs = nSigBlocks - (it == mapMissingSigs.end() ? 0 : it->second);
+            if (nSigs)
+                mapLastSigs.insert(mapLastSigs.end(), std::make_pair(cvn.first, nSigs));
+        }
+        fLastSigsDirty = false;
+    }
+    mapLastSignatures = mapLastSigs;
+
+    return true;
+}
+
+CCreatorCandidateTracker creatorTracker;
+
+/** Forks of the active chain deeper than this are answered by walking the chain */
+static const int MAX_ADMISSION_FORK_DEPTH = 100;
+
+CCvnAdmissionIndex cvnAdmissions;
+
+CCvnAdmission::CCvnAdmission(const CBlockIndex *pindex, const uint32_t nNodeIdIn)
+{
+    nHeight = pindex->nHeight;
+    hashBlock = pindex->GetBlockHash();
+    nNodeId = nNodeIdIn;
+    nFirstCreatedHeight = 0;
+}
+
+static bool AdmissionHeightLess(const int nHeight, const CCvnAdmission &admission)
+{
+    return nHeight < admission.nHeight;
+}
+
+static bool AdmissionHeightOrder(const CCvnAdmission &a, const CCvnAdmission &b)
+{
+    return a.nHeight < b.nHeight;
+}
+
+void CCvnAdmissionIndex::SetNull()
+{
+    pindexTip = NULL;
+    vAdmissions.clear();
+}
+
+/* advance the index by one block, pvCvns is read from the block if not supplied */
+bool CCvnAdmissionIndex::Apply(const CBlockIndex *pindex, const vector<CCvnInfo> *pvCvns, vector<CCvnAdmission> &vChanged)
+{
+    if (!vAdmissions.empty()) {
+        CCvnAdmission &last = vAdmissions.back();
+        if (!last.nFirstCreatedHeight && pindex->nCreatorId == last.nNodeId) {
+            last.nFirstCreatedHeight = pindex->nHeight;
+            vChanged.push_back(last);
+        }
+    }
+
+    if (!(pindex->nVersion & CBlock::CVN_PAYLOAD))
+        return true;
+
+    vector<CCvnInfo> vCvns;
+    if (!pvCvns) {
+        if (!GetCvnInfoFromBlock(pindex, vCvns))
+            return false;
+        pvCvns = &vCvns;
+    }
+
+    const uint32_t nNodeId = GetAdmittedCVN(pindex, *pvCvns);
+    if (nNodeId) {
+        vAdmissions.push_back(CCvnAdmission(pindex, nNodeId));
+        vChanged.push_back(vAdmissions.back());
+    }
+
+    return true;
 }
 
 /**
- * The rules are as follows:
- * 1. If there is any newly added CVN it is its turn
- * 1. Find the node with the highest time-weight. That's the
- *    node that created its last block the furthest in the past.
- * 2. It must have co-signed the last nCreatorMinSignatures blocks
- *    to proof it's cooperation.
+ * Load the index from the block tree DB and catch up to pindexNew. If the
+ * stored index does not belong to the chain of pindexNew it is rebuilt.
  */
-//TODO: we should really make sure some lock is held here
-uint32_t CheckNextBlockCreator(const CBlockIndex* pindexStart, const int64_t nTimeToTest, CCvnStatus* state)
+bool CCvnAdmissionIndex::Load(const CBlockIndex *pindexNew)
 {
-    TimeWeightSetType setCreatorCandidates(mapCVNs.size());
-    vector<uint32_t> vCreatorCandidates;
-    map<uint32_t, uint32_t> mapLastSignatures; // key: signerId, value: # of sigs
-    uint32_t nMinSignatures = dynParams.nMinSuccessiveSignatures;
+    LOCK(cs_admissions);
+    SetNull();
+
+    if (!pindexNew)
+        return true;
+
+    vector<CCvnAdmission> vStored;
+    uint256 hashBestBlock;
+    const CBlockIndex *pindexBest = NULL;
+
+    if (pblocktree->ReadCvnAdmissions(vStored, hashBestBlock)) {
+        BlockMap::const_iterator mi = mapBlockIndex.find(hashBestBlock);
+        if (mi != mapBlockIndex.end() && pindexNew->GetAncestor(mi->second->nHeight) == mi->second)
+            pindexBest = mi->second;
+    }
+
+    vector<int> vErase;
+    BOOST_FOREACH(const CCvnAdmission &admission, vStored) {
+        const CBlockIndex *pindex = pindexBest && admission.nHeight <= pindexBest->nHeight ? pindexNew->GetAncestor(admission.nHeight) : NULL;
+        if (pindex && pindex->GetBlockHash() == admission.hashBlock)
+            vAdmissions.push_back(admission);
+        else
+            vErase.push_back(admission.nHeight);
+    }
+    sort(vAdmissions.begin(), vAdmissions.end(), AdmissionHeightOrder);
+
+    if (!vErase.empty() && pindexBest) {
+        LogPrintf("%s : stored CVN admission index does not match the active chain, rebuilding\n", __func__);
+        vAdmissions.clear();
+        pindexBest = NULL;
+    }
+
+    vector<CCvnAdmission> vChanged;
+    const int nFirstHeight = pindexBest ? pindexBest->nHeight + 1 : 0;
+    for (int nHeight = nFirstHeight; nHeight <= pindexNew->nHeight; nHeight++) {
+        if (!Apply(pindexNew->GetAncestor(nHeight), NULL, vChanged)) {
+            SetNull();
+            return false;
+        }
+    }
+
+    if (!pindexBest) {
+        // start from scratch, remove whatever is left of the stored index
+        vChanged = vAdmissions;
+        vErase.clear();
+        BOOST_FOREACH(const CCvnAdmission &admission, vStored)
+            vErase.push_back(admission.nHeight);
+    }
+
+    if (!pblocktree->WriteCvnAdmissions(vChanged, vErase, pindexNew->GetBlockHash()))
+        LogPrintf("%s : could not write CVN admission index\n", __func__);
+
+    LogPrint("cvn", "%s : %u CVN admissions, indexed %d blocks up to height %d\n", __func__, vAdmissions.size(), pindexNew->nHeight - nFirstHeight + 1, pindexNew->nHeight);
+    pindexTip = pindexNew;
+
+    return true;
+}
+
+void CCvnAdmissionIndex::ConnectTip(const CBlockIndex *pindexNew, const CBlock &block)
+{
+    LOCK(cs_admissions);
+    if (!pindexTip || pindexTip != pindexNew->pprev) {
+        Load(pindexNew);
+        return;
+    }
+
+    vector<CCvnAdmission> vChanged;
+    Apply(pindexNew, &block.vCvns, vChanged);
+    pindexTip = pindexNew;
+
+    if (!pblocktree->WriteCvnAdmissions(vChanged, vector<int>(), pindexNew->GetBlockHash()))
+        LogPrintf("%s : could not write CVN admission index\n", __func__);
+}
+
+void CCvnAdmissionIndex::DisconnectTip(const CBlockIndex *pindexDelete)
+{
+    LOCK(cs_admissions);
+    if (!pindexTip || pindexTip != pindexDelete) {
+        SetNull();
+        return;
+    }
+
+    vector<CCvnAdmission> vChanged;
+    vector<int> vErase;
+
+    if (!vAdmissions.empty() && vAdmissions.back().nHeight == pindexDelete->nHeight) {
+        vErase.push_back(pindexDelete->nHeight);
+        vAdmissions.pop_back();
+    }
+
+    if (!vAdmissions.empty() && vAdmissions.back().nFirstCreatedHeight == pindexDelete->nHeight) {
+        vAdmissions.back().nFirstCreatedHeight = 0;
+        vChanged.push_back(vAdmissions.back());
+    }
+
+    pindexTip = pindexDelete->pprev;
+
+    if (!pblocktree->WriteCvnAdmissions(vChanged, vErase, pindexTip->GetBlockHash()))
+        LogPrintf("%s : could not write CVN admission index\n", __func__);
+}
+
+bool CCvnAdmissionIndex::GetNewlyAddedCVN(const CBlockIndex *pindexStart, uint32_t &nNodeId)
+{
+    LOCK(cs_admissions);
+    if (!pindexTip || !pindexStart)
+        return false;
+
+    // the blocks of pindexStart that are not in the indexed chain, newest first
+    vector<const CBlockIndex*> vFork;
+    const CBlockIndex *pindexFork = pindexStart;
+    while (pindexFork && (pindexFork->nHeight > pindexTip->nHeight || pindexTip->GetAncestor(pindexFork->nHeight) != pindexFork)) {
+        if (vFork.size() >= (size_t)MAX_ADMISSION_FORK_DEPTH)
+            return false;
+        vFork.push_back(pindexFork);
+        pindexFork = pindexFork->pprev;
+    }
+
+    uint32_t nLastAddedNode = 0;
+    bool fCreated = false;
+
+    // the last admission up to the fork point
+    if (pindexFork) {
+        vector<CCvnAdmission>::const_iterator it = upper_bound(vAdmissions.begin(), vAdmissions.end(), pindexFork->nHeight, AdmissionHeightLess);
+        if (it != vAdmissions.begin()) {
+            --it;
+            nLastAddedNode = it->nNodeId;
+            fCreated = it->nFirstCreatedHeight && it->nFirstCreatedHeight <= pindexFork->nHeight;
+        }
+    }
+
+    // followed by the blocks of the fork
+    BOOST_REVERSE_FOREACH(const CBlockIndex *pindex, vFork) {
+        if (nLastAddedNode && pindex->nCreatorId == nLastAddedNode)
+            fCreated = true;
+
+        if (pindex->nVersion & CBlock::CVN_PAYLOAD) {
+            vector<CCvnInfo> vCvns;
+            if (!GetCvnInfoFromBlock(pindex, vCvns))
+                return false;
+
+            const uint32_t nAdded = GetAdmittedCVN(pindex, vCvns);
+            if (nAdded) {
+                nLastAddedNode = nAdded;
+                fCreated = false;
+            }
+        }
+    }
+
+    nNodeId = fCreated ? 0 : nLastAddedNode;
+    return true;
+}
+
+/* walk back the chain from pindexStart and collect the creator candidates
+ * and the number of signatures within the nMinSuccessiveSignatures range */
+static bool ScanCreatorCandidates(const CCvnSetInfo &info, const CBlockIndex* pindexStart, vector<uint32_t> &vCreatorCandidates, TimeWeightSetType &setCreatorCandidates, map<uint32_t, uint32_t> &mapLastSignatures)
+{
+    uint32_t nMinSignatures = info.dynParams.nMinSuccessiveSignatures;
 
     // create a list of creator candidates
     // scan no more than the last 200 blocks
     unsigned int nBlocksToScan = POC_BLOCKS_TO_SCAN;
-    size_t nRegisteredCVNs = mapCVNs.size();
+    size_t nRegisteredCVNs = info.mapCVNs.size();
     for (const CBlockIndex* pindex = pindexStart; pindex && nBlocksToScan; pindex = pindex->pprev, nBlocksToScan--) {
         if ((pindex->nStatus & BLOCK_VALID_MASK) < BLOCK_VALID_SCRIPTS) {
             LogPrintf("%s : block not on a connected chain. Unable to determine the correct creator ID: %s\n", __func__, pindex->ToString());
-            return 0;
+            return false;
         }
 
-        if (!mapCVNs.count(pindex->nCreatorId) || mapBannedCVNs.count(pindex->nCreatorId))
+        if (!info.mapCVNs.count(pindex->nCreatorId) || mapBannedCVNs.count(pindex->nCreatorId))
             continue; // ignore CVNs that were deactivated or banned
 
         // if the creator has not been considered yet add it to the list of candidates
@@ -1233,18 +2699,50 @@ uint32_t CheckNextBlockCreator(const CBlockIndex* pindexStart, const int64_t nTi
         // record the number of signatures within the nMinSuccessiveSignatures range
         if (nMinSignatures) {
             nMinSignatures--;
-            vector<uint32_t> vMissing = pindex->vMissingSignerIds;
-            BOOST_FOREACH(const CvnMapType::value_type& cvn, mapCVNs)
+            BOOST_FOREACH(const CvnMapType::value_type& cvn, info.mapCVNs)
             {
-                if (!vMissing.empty() && find(vMissing.begin(), vMissing.end(), cvn.first) != vMissing.end())
+                if (pindex->IsMissingSigner(cvn.first))
                     continue;
 
                 mapLastSignatures[cvn.first]++;
             }
         }
 
-        if (vCreatorCandidates.size() == nRegisteredCVNs && !nMinSignatures)
-            break; // no more work to do
+        if (vCreatorCandidates.size() == nRegisteredCVNs && !nMinSignatures)
+            break; // no more work to do
+    }
+
+    return true;
+}
+
+/**
+ * The rules are as follows:
+ * 1. If there is any newly added CVN it is its turn
+ * 1. Find the node with the highest time-weight. That's the
+ *    node that created its last block the furthest in the past.
+ * 2. It must have co-signed the last nCreatorMinSignatures blocks
+ *    to proof it's cooperation.
+ * The CVN set and the chain parameters are taken from one snapshot of the
+ * CVN set info, hence no lock needs to be held by the caller.
+ */
+uint32_t CheckNextBlockCreator(const CBlockIndex* pindexStart, const int64_t nTimeToTest, CCvnStatus* state)
+{
+    const CCvnSetInfoRef info = GetCvnSetInfo();
+    const CDynamicChainParams &params = info->dynParams;
+
+    TimeWeightSetType setCreatorCandidates(info->mapCVNs.size());
+    vector<uint32_t> vCreatorCandidates;
+    map<uint32_t, uint32_t> mapLastSignatures; // key: signerId, value: # of sigs
+    uint32_t nMinSignatures = params.nMinSuccessiveSignatures;
+    size_t nRegisteredCVNs = info->mapCVNs.size();
+
+    // the tracker answers for the active chain tip, anything else needs a full scan
+    if (!creatorTracker.GetCandidates(info, pindexStart, vCreatorCandidates, setCreatorCandidates, mapLastSignatures)) {
+        vCreatorCandidates.clear();
+        setCreatorCandidates.clear();
+        mapLastSignatures.clear();
+        if (!ScanCreatorCandidates(*info, pindexStart, vCreatorCandidates, setCreatorCandidates, mapLastSignatures))
+            return 0;
     }
 
     uint32_t nNextCreatorId = FindNewlyAddedCVN(pindexStart);
@@ -1253,7 +2751,7 @@ uint32_t CheckNextBlockCreator(const CBlockIndex* pindexStart, const int64_t nTi
         LogPrint("cvnnext", "%s : CVN 0x%08x needs to be bootstrapped\n", __func__, nNextCreatorId);
         vCreatorCandidates.push_back(nNextCreatorId);
     } else if (vCreatorCandidates.size() < nRegisteredCVNs) {
-        nNextCreatorId = FindDormantNode(pindexStart, mapLastSignatures, setCreatorCandidates, dynParams.nMinSuccessiveSignatures);
+        nNextCreatorId = FindDormantNode(pindexStart, mapLastSignatures, setCreatorCandidates, params.nMinSuccessiveSignatures);
 
         if (nNextCreatorId) {
             LogPrintf("%s : dormant CVN 0x%08x detected - activating...\n", __func__, nNextCreatorId);
@@ -1269,7 +2767,7 @@ uint32_t CheckNextBlockCreator(const CBlockIndex* pindexStart, const int64_t nTi
         return 0;
     }
 
-    uint32_t nCandidateOffset = GetCandidateOffset(pindexStart->nTime, nTimeToTest);
+    uint32_t nCandidateOffset = GetCandidateOffset(params, pindexStart->nTime, nTimeToTest);
     if (nCandidateOffset >= vCreatorCandidates.size()) {
         LogPrint("cvnnext", "%s : WARN, CandidateOffset exceeds limits: %u >= %u\n", __func__, nCandidateOffset, vCreatorCandidates.size());
         nCandidateOffset %= vCreatorCandidates.size();
@@ -1277,7 +2775,7 @@ uint32_t CheckNextBlockCreator(const CBlockIndex* pindexStart, const int64_t nTi
     }
 
     itCandidates += nCandidateOffset;
-    nMinSignatures = dynParams.nMinSuccessiveSignatures; // reset
+    nMinSignatures = params.nMinSuccessiveSignatures; // reset
     do {
         uint32_t nCreatorCandidate = *(itCandidates ++);
 
@@ -1306,7 +2804,7 @@ uint32_t CheckNextBlockCreator(const CBlockIndex* pindexStart, const int64_t nTi
         state->nBlockSigned = mapLastSignatures[state->nNodeId];
 
         uint32_t nPredictedNextBlock = chainActive.Tip()->nHeight + 1;
-        nMinSignatures = dynParams.nMinSuccessiveSignatures;
+        nMinSignatures = params.nMinSuccessiveSignatures;
         itCandidates = vCreatorCandidates.rbegin();
 
         do {
@@ -1425,7 +2923,11 @@ int32_t GetPoolAge(const CNoncePool &pool, CBlockIndex *pTip)
     return -1;
 }
 
-bool AddNoncePool(CNoncePool& msg)
+/**
+ * Adds or replaces the nonce pool of a CVN. If pdelta is given it is set to the
+ * difference to the replaced pool, or left null if there is no such pool.
+ */
+bool AddNoncePool(CNoncePool& msg, CNoncePoolDelta *pdelta)
 {
     if (!CvnVerifySignature(msg.GetHash(), msg.msgSig, msg.nCvnId))
         return false;
@@ -1471,18 +2973,52 @@ bool AddNoncePool(CNoncePool& msg)
             (mapNoncePool.count(msg.nCvnId) ? "replacing" : "adding"),
             msg.nCvnId, nPoolAge, msg.vPublicNonces.size(), msg.nCreationTime, msg.hashRootBlock.ToString());
 
+    if (pdelta && mapNoncePool.count(msg.nCvnId))
+        pdelta->Create(mapNoncePool[msg.nCvnId], msg);
+
     mapNoncePool[msg.nCvnId] = msg;
+    nonceSumCache.Invalidate();
+    NotifyPocThread();
 
     return true;
 }
 
-void RelayNoncePool(const CNoncePool& msg)
+/**
+ * Rebuilds the pool a delta announces from the pool of the CVN we currently have.
+ * fMalformed is set if the delta is based on that pool but does not result in
+ * the pool it announces.
+ */
+bool ApplyNoncePoolDelta(const CNoncePoolDelta& delta, CNoncePool& pool, bool& fMalformed)
+{
+    LOCK(cs_mapNoncePool);
+    fMalformed = false;
+
+    CNoncePoolType::const_iterator it = mapNoncePool.find(delta.nCvnId);
+    if (it == mapNoncePool.end() || !delta.AppliesTo(it->second))
+        return false;
+
+    fMalformed = !delta.Apply(it->second, pool);
+    return !fMalformed;
+}
+
+/** Whether a delta announces a pool created after the one of the CVN we have, true if we have none */
+bool IsNewerNoncePool(const CNoncePoolDelta& delta)
+{
+    LOCK(cs_mapNoncePool);
+
+    CNoncePoolType::const_iterator it = mapNoncePool.find(delta.nCvnId);
+    return it == mapNoncePool.end() || delta.nCreationTime > it->second.nCreationTime;
+}
+
+void RelayNoncePool(const CNoncePool& msg, const CNoncePoolDelta *pdelta)
 {
     CInv inv(MSG_CVN_PUB_NONCE_POOL, msg.GetHash());
 
     {
         LOCK(cs_mapRelayNonces);
         mapRelayNonces.insert(std::make_pair(inv.hash, msg));
+        if (pdelta && !pdelta->IsNull())
+            mapRelayNonceDeltas.insert(std::make_pair(inv.hash, *pdelta));
     }
 
     LOCK(cs_vNodes);
@@ -1541,6 +3077,7 @@ void CheckNoncePools(CBlockIndex *pindex)
         if (fCvnRemoved || nPoolAge >= p.vPublicNonces.size()) {
             LogPrintf("%s, removing pool for 0x%08x.\n", (fCvnRemoved ? "CVN has been removed from the network" : "nonce pool expired"), itErase->first);
             mapNoncePool.erase(itErase);
+            nonceSumCache.Invalidate();
         }
     }
 
@@ -1558,6 +3095,111 @@ void CheckNoncePools(CBlockIndex *pindex)
     }
 }
 
+CPocStateStats pocStateStats;
+CSigLatencyStats sigLatencyStats;
+
+/* set and signalled whenever something arrived the POC thread might be waiting for */
+static CWaitableCriticalSection csPocEvent;
+static CConditionVariable condPocEvent;
+static bool fPocEvent = false;
+
+void NotifyPocThread()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(csPocEvent);
+        fPocEvent = true;
+    }
+    condPocEvent.notify_one();
+}
+
+void CPocStateStats::SetNull()
+{
+    LOCK(cs_stats);
+
+    currentState = UNDEFINED;
+    memset(nCount, 0, sizeof(nCount));
+    memset(nTotalMicros, 0, sizeof(nTotalMicros));
+    memset(nMaxMicros, 0, sizeof(nMaxMicros));
+    memset(nBuckets, 0, sizeof(nBuckets));
+    nPrepared = nPreparedUsed = 0;
+    nSavedMicros = nMaxSavedMicros = 0;
+}
+
+void CPocStateStats::Add(const POCState state, const int64_t nMicros, const POCState nextState)
+{
+    LOCK(cs_stats);
+
+    currentState = nextState;
+    if (state >= UNDEFINED)
+        return;
+
+    int nBucket = 0;
+    for (int64_t nLimit = 1000; nBucket < NUM_BUCKETS - 1 && nMicros >= nLimit; nLimit *= 10)
+        nBucket++;
+
+    nCount[state]++;
+    nTotalMicros[state] += nMicros;
+    nMaxMicros[state] = std::max(nMaxMicros[state], nMicros);
+    nBuckets[state][nBucket]++;
+}
+
+void CPocStateStats::AddPrepared(const bool fUsed, const int64_t nMicros)
+{
+    LOCK(cs_stats);
+
+    if (!fUsed) {
+        nPrepared++;
+        return;
+    }
+
+    nPreparedUsed++;
+    nSavedMicros += nMicros;
+    nMaxSavedMicros = std::max(nMaxSavedMicros, nMicros);
+}
+
+static const int64_t nSigLatencyBucketLimits[CSigLatencyStats::NUM_BUCKETS - 1] = { 100, 200, 500, 1000, 2000, 5000, 10000 };
+
+void CSigLatencyStats::SetNull()
+{
+    LOCK(cs_stats);
+
+    hashTip.SetNull();
+    memset(nCount, 0, sizeof(nCount));
+    memset(nTotalMillis, 0, sizeof(nTotalMillis));
+    memset(nMaxMillis, 0, sizeof(nMaxMillis));
+    memset(nBuckets, 0, sizeof(nBuckets));
+}
+
+void CSigLatencyStats::NewTip(const uint256& hash)
+{
+    LOCK(cs_stats);
+
+    hashTip = hash;
+}
+
+void CSigLatencyStats::Add(const CCvnPartialSignature& sig, const bool fDirect)
+{
+    LOCK(cs_stats);
+
+    // late signatures for an older tip would only skew the histogram
+    if (sig.hashPrevBlock != hashTip || !sig.nCreationTime)
+        return;
+
+    // nCreationTime has a resolution of one second, assume the middle of it
+    const int nRoute = fDirect ? DIRECT : RELAYED;
+    const int64_t nNowMillis = GetTimeMillis() + GetTimeOffset() * 1000;
+    const int64_t nMillis = std::max((int64_t)0, nNowMillis - ((int64_t)sig.nCreationTime * 1000 + 500));
+
+    int nBucket = 0;
+    while (nBucket < NUM_BUCKETS - 1 && nMillis >= nSigLatencyBucketLimits[nBucket])
+        nBucket++;
+
+    nCount[nRoute]++;
+    nTotalMillis[nRoute] += nMillis;
+    nMaxMillis[nRoute] = std::max(nMaxMillis[nRoute], nMillis);
+    nBuckets[nRoute][nBucket]++;
+}
+
 #ifdef USE_CVN
 static bool GetFeeScript(CReserveScript &script)
 {
@@ -1588,55 +3230,362 @@ static bool GetFeeScript(CReserveScript &script)
 }
 
 //
-// CNoncesPoolDB
+// CNonceRingFile
 //
-CNoncesPoolDB::CNoncesPoolDB()
+static const unsigned char NONCE_RING_MAGIC[4] = { 'F', 'C', 'N', 'R' };
+static const uint32_t NONCE_RING_VERSION = 1;
+
+static const uint32_t NONCE_RING_HAS_PRIVATE = 1 << 0;
+static const uint32_t NONCE_RING_HAS_HANDLES = 1 << 1;
+
+/* layout of the nonce ring file (in host byte order) */
+struct NonceRingHeader
+{
+    unsigned char pchMagic[4];
+    uint32_t nVersion;
+    unsigned char pchMessageStart[4];
+    uint32_t nCvnId;
+    uint32_t nSlots;
+    uint32_t nReserved[3];
+};
+
+struct NonceRingHead
+{
+    uint64_t nSeq;                                                  // 0 if unused
+    uint32_t nHead;
+    uint32_t nCount;
+    uint32_t nCreationTime;
+    uint32_t nFlags;
+    unsigned char hashRootBlock[32];
+    unsigned char msgSig[64];
+    unsigned char checksum[32];
+};
+
+struct NonceRingSlot
+{
+    uint64_t nSeq;                                                  // of the head record the slot was written for
+    unsigned char publicNonce[64];
+    unsigned char privateNonce[32];
+    uint8_t nHandle;
+    uint8_t nReserved[7];
+    unsigned char checksum[32];
+};
+
+static const size_t NONCE_RING_HEADS_OFFSET = sizeof(NonceRingHeader);
+static const size_t NONCE_RING_SLOTS_OFFSET = 512;
+static const size_t NONCE_RING_FILE_SIZE = NONCE_RING_SLOTS_OFFSET + CNonceRingFile::RING_SLOTS * sizeof(NonceRingSlot);
+
+BOOST_STATIC_ASSERT(NONCE_RING_HEADS_OFFSET + 2 * sizeof(NonceRingHead) <= NONCE_RING_SLOTS_OFFSET);
+
+static NonceRingHeader *GetRingHeader(unsigned char *base)
+{
+    return (NonceRingHeader *)base;
+}
+
+static NonceRingHead *GetRingHead(unsigned char *base, const int n)
+{
+    return (NonceRingHead *)(base + NONCE_RING_HEADS_OFFSET) + n;
+}
+
+static NonceRingSlot *GetRingSlot(unsigned char *base, const uint32_t n)
+{
+    return (NonceRingSlot *)(base + NONCE_RING_SLOTS_OFFSET) + (n % CNonceRingFile::RING_SLOTS);
+}
+
+static uint256 GetRingHeadChecksum(const NonceRingHead &head)
+{
+    return Hash(BEGIN(head), BEGIN(head.checksum));
+}
+
+static uint256 GetRingSlotChecksum(const NonceRingSlot &slot, const uint32_t nSlot)
+{
+    CHashWriter hasher(SER_GETHASH, 0);
+    hasher << nSlot;
+    hasher.write(BEGIN(slot), BEGIN(slot.checksum) - BEGIN(slot));
+    return hasher.GetHash();
+}
+
+/* a head record is usable if it and all slots of its pool are intact */
+static bool IsValidRingHead(unsigned char *base, const int n)
+{
+    const NonceRingHead *head = GetRingHead(base, n);
+
+    if (!head->nSeq || head->nHead >= CNonceRingFile::RING_SLOTS || head->nCount > MAX_NONCE_POOL_SIZE)
+        return false;
+
+    if (memcmp(GetRingHeadChecksum(*head).begin(), head->checksum, 32))
+        return false;
+
+    for (uint32_t i = 0; i < head->nCount; i++) {
+        const uint32_t nSlot = (head->nHead + i) % CNonceRingFile::RING_SLOTS;
+        const NonceRingSlot *slot = GetRingSlot(base, nSlot);
+
+        if (slot->nSeq > head->nSeq || memcmp(GetRingSlotChecksum(*slot, nSlot).begin(), slot->checksum, 32))
+            return false;
+    }
+
+    return true;
+}
+
+CNonceRingFile nonceRing;
+
+CNonceRingFile::CNonceRingFile() : pRegion(NULL), nActiveHead(-1)
+{
+}
+
+CNonceRingFile::~CNonceRingFile()
+{
+    delete pRegion;
+}
+
+/* clear the mapped file and write a new header for this CVN */
+void CNonceRingFile::Init()
 {
-    pathNonces = GetDataDir() / "pool.dat";
+    unsigned char *base = (unsigned char *)pRegion->get_address();
+    memset(base, 0, NONCE_RING_FILE_SIZE);
+
+    NonceRingHeader *header = GetRingHeader(base);
+    memcpy(header->pchMagic, NONCE_RING_MAGIC, sizeof(header->pchMagic));
+    memcpy(header->pchMessageStart, Params().MessageStart(), sizeof(header->pchMessageStart));
+    header->nVersion = NONCE_RING_VERSION;
+    header->nCvnId   = nCvnNodeId;
+    header->nSlots   = RING_SLOTS;
+
+    nActiveHead = -1;
+    pRegion->flush(0, 0, false);
 }
 
-bool CNoncesPoolDB::Write(const CNoncePool& pool, const vector<CSchnorrPrivNonce>& vPrivateNonces, const vector<uint8_t>& vNonceHandles)
+/* a file that was created but never written to has a header of zeroes */
+static bool IsEmptyRingHeader(const NonceRingHeader &header)
 {
-    // Generate random temporary filename
-    unsigned short randv = 0;
-    GetRandBytes((unsigned char*)&randv, sizeof(randv));
-    std::string tmpfn = strprintf("pool.dat.%04x", randv);
+    const unsigned char *p = (const unsigned char *)&header;
+    for (size_t i = 0; i < sizeof(header); i++) {
+        if (p[i])
+            return false;
+    }
+    return true;
+}
 
-    // serialize nonces, checksum data up to that point, then append the checksum
-    CDataStream ssNonces(SER_DISK, CLIENT_VERSION);
-    ssNonces << FLATDATA(Params().MessageStart());
-    ssNonces << pool;
-    ssNonces << vPrivateNonces;
-    ssNonces << vNonceHandles;
+/*
+ * Map the ring file, or create it if there is none. A file that belongs to
+ * another CVN or network is never overwritten, it holds private nonces that
+ * were handed out already.
+ */
+bool CNonceRingFile::Open()
+{
+    AssertLockHeld(cs_ring);
 
-    uint256 hash = Hash(ssNonces.begin(), ssNonces.end());
-    ssNonces << hash;
+    if (pRegion)
+        return true;
 
-    // open temp output file, and associate with CAutoFile
-    boost::filesystem::path pathTmp = GetDataDir() / tmpfn;
-    FILE *file = fopen(pathTmp.string().c_str(), "wb");
-    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("%s: Failed to open file %s", __func__, pathTmp.string());
+    if (pathRing.empty())
+        pathRing = GetDataDir() / "noncering.dat";
 
-    // Write and commit header, data
     try {
-        fileout << ssNonces;
+        if (!boost::filesystem::exists(pathRing)) {
+            FILE *file = fopen(pathRing.string().c_str(), "wb");
+            if (!file)
+                return error("%s: Failed to create file %s", __func__, pathRing.string());
+            fclose(file);
+        }
+
+        const uint64_t nFileSize = boost::filesystem::file_size(pathRing);
+        if (nFileSize && nFileSize != NONCE_RING_FILE_SIZE)
+            return error("%s: Unexpected size %u of nonce ring file %s, not touching it", __func__, nFileSize, pathRing.string());
+        if (!nFileSize)
+            boost::filesystem::resize_file(pathRing, NONCE_RING_FILE_SIZE);
+
+        boost::interprocess::file_mapping mapping(pathRing.string().c_str(), boost::interprocess::read_write);
+        pRegion = new boost::interprocess::mapped_region(mapping, boost::interprocess::read_write, 0, NONCE_RING_FILE_SIZE);
     }
     catch (const std::exception& e) {
-        return error("%s: Serialize or I/O error - %s", __func__, e.what());
+        return error("%s: Failed to map file %s - %s", __func__, pathRing.string(), e.what());
+    }
+
+    unsigned char *base = (unsigned char *)pRegion->get_address();
+    const NonceRingHeader *header = GetRingHeader(base);
+
+    if (IsEmptyRingHeader(*header)) {
+        LogPrintf("%s : initialising nonce ring file %s\n", __func__, pathRing.string());
+        Init();
+        return true;
+    }
+
+    std::string strError;
+    if (memcmp(header->pchMagic, NONCE_RING_MAGIC, sizeof(header->pchMagic)) || header->nVersion != NONCE_RING_VERSION ||
+            header->nSlots != RING_SLOTS)
+        strError = "unknown file format";
+    else if (memcmp(header->pchMessageStart, Params().MessageStart(), sizeof(header->pchMessageStart)))
+        strError = "file belongs to another network";
+    else if (header->nCvnId != nCvnNodeId)
+        strError = strprintf("file belongs to CVN 0x%08x, but this node is CVN 0x%08x. Check -cvn and the configured CVN ID", header->nCvnId, nCvnNodeId);
+
+    if (!strError.empty()) {
+        delete pRegion;
+        pRegion = NULL;
+        return error("%s: Refusing to use nonce ring file %s: %s", __func__, pathRing.string(), strError);
+    }
+
+    // use the newest head record that is intact
+    const int nNewest = GetRingHead(base, 0)->nSeq >= GetRingHead(base, 1)->nSeq ? 0 : 1;
+    if (IsValidRingHead(base, nNewest)) {
+        nActiveHead = nNewest;
+    } else if (IsValidRingHead(base, 1 - nNewest)) {
+        LogPrintf("%s : latest nonce pool is incomplete, using the previous one\n", __func__);
+        nActiveHead = 1 - nNewest;
+    }
+
+    return true;
+}
+
+/* write a range of the mapping back to disk and wait until it is there */
+bool CNonceRingFile::SyncRange(const size_t nOffset, const size_t nSize)
+{
+    // msync() wants a page aligned address, the mapping starts at the beginning of the file
+    const size_t nPageOffset = nOffset % boost::interprocess::mapped_region::get_page_size();
+    if (!pRegion->flush(nOffset - nPageOffset, nSize + nPageOffset, false))
+        return error("%s: could not flush %u bytes at %u of nonce ring file %s", __func__, nSize, nOffset, pathRing.string());
+    return true;
+}
+
+/**
+ * Store the pool in the ring. The nonces the pool has in common with the
+ * current one stay where they are, the others are written to the slots
+ * following the current pool before the new head record is put in place.
+ * Both are on disk when this returns true, so the pool may be relayed.
+ */
+bool CNonceRingFile::Write(const CNoncePool& pool, const vector<CSchnorrPrivNonce>& vPrivateNonces, const vector<uint8_t>& vNonceHandles)
+{
+    LOCK(cs_ring);
+
+    if (!Open())
+        return false;
+
+    const uint32_t nSize = pool.vPublicNonces.size();
+    if (nSize > MAX_NONCE_POOL_SIZE)
+        return error("%s: nonce pool too large: %u", __func__, nSize);
+
+    unsigned char *base = (unsigned char *)pRegion->get_address();
+    if (GetRingHeader(base)->nCvnId != pool.nCvnId)
+        return error("%s: CVN ID mismatch", __func__);
+
+    uint64_t nSeq = 1;
+    uint32_t nHead = 0, nKeep = 0;
+
+    if (nActiveHead >= 0) {
+        const NonceRingHead *current = GetRingHead(base, nActiveHead);
+        nSeq  = current->nSeq + 1;
+        nHead = current->nHead + current->nCount;
+
+        for (uint32_t k = 0; nSize && k < current->nCount; k++) {
+            if (!memcmp(GetRingSlot(base, current->nHead + k)->publicNonce, pool.vPublicNonces[0].begin(), 64)) {
+                nHead = current->nHead + k;
+                nKeep = std::min(current->nCount - k, nSize);
+                break;
+            }
+        }
+
+        for (uint32_t i = 0; i < nKeep; i++) {
+            if (memcmp(GetRingSlot(base, nHead + i)->publicNonce, pool.vPublicNonces[i].begin(), 64)) {
+                nHead = current->nHead + current->nCount;
+                nKeep = 0;
+                break;
+            }
+        }
+    }
+
+    for (uint32_t i = nKeep; i < nSize; i++) {
+        const uint32_t nSlot = (nHead + i) % RING_SLOTS;
+        NonceRingSlot *slot = GetRingSlot(base, nSlot);
+
+        memset(slot, 0, sizeof(NonceRingSlot));
+        slot->nSeq = nSeq;
+        memcpy(slot->publicNonce, pool.vPublicNonces[i].begin(), sizeof(slot->publicNonce));
+        if (i < vPrivateNonces.size())
+            memcpy(slot->privateNonce, vPrivateNonces[i].begin(), sizeof(slot->privateNonce));
+        if (i < vNonceHandles.size())
+            slot->nHandle = vNonceHandles[i];
+        memcpy(slot->checksum, GetRingSlotChecksum(*slot, nSlot).begin(), sizeof(slot->checksum));
+    }
+
+    // the new slots have to be on disk before the head record that refers to them
+    if (nKeep < nSize) {
+        const uint32_t nFirst = (nHead + nKeep) % RING_SLOTS;
+        const uint32_t nCount = std::min(nSize - nKeep, RING_SLOTS - nFirst);
+        if (!SyncRange(NONCE_RING_SLOTS_OFFSET + nFirst * sizeof(NonceRingSlot), nCount * sizeof(NonceRingSlot)))
+            return false;
+        if (nCount < nSize - nKeep && !SyncRange(NONCE_RING_SLOTS_OFFSET, (nSize - nKeep - nCount) * sizeof(NonceRingSlot)))
+            return false;
     }
-    FileCommit(fileout.Get());
-    fileout.fclose();
 
-    // replace existing nonces.dat, if any, with new nonces.dat.XXXX
-    if (!RenameOver(pathTmp, pathNonces))
-        return error("%s: Rename-into-place failed", __func__);
+    const int nNextHead = nActiveHead == 0 ? 1 : 0;
+    NonceRingHead *head = GetRingHead(base, nNextHead);
+
+    memset(head, 0, sizeof(NonceRingHead));
+    head->nSeq          = nSeq;
+    head->nHead         = nHead % RING_SLOTS;
+    head->nCount        = nSize;
+    head->nCreationTime = pool.nCreationTime;
+    head->nFlags        = (nSize && vPrivateNonces.size() == nSize ? NONCE_RING_HAS_PRIVATE : 0) |
+                          (nSize && vNonceHandles.size() == nSize ? NONCE_RING_HAS_HANDLES : 0);
+    memcpy(head->hashRootBlock, pool.hashRootBlock.begin(), sizeof(head->hashRootBlock));
+    memcpy(head->msgSig, pool.msgSig.begin(), sizeof(head->msgSig));
+    memcpy(head->checksum, GetRingHeadChecksum(*head).begin(), sizeof(head->checksum));
+
+    if (!SyncRange(NONCE_RING_HEADS_OFFSET + nNextHead * sizeof(NonceRingHead), sizeof(NonceRingHead)))
+        return false;
+
+    nActiveHead = nNextHead;
+
+    return true;
+}
+
+bool CNonceRingFile::Read(CNoncePool& pool, vector<CSchnorrPrivNonce>& vPrivateNonces, vector<uint8_t>& vNonceHandles)
+{
+    LOCK(cs_ring);
+
+    if (!Open())
+        return false;
+
+    if (nActiveHead < 0)
+        return error("%s: No nonce pool found in %s", __func__, pathRing.string());
+
+    unsigned char *base = (unsigned char *)pRegion->get_address();
+    const NonceRingHead *head = GetRingHead(base, nActiveHead);
+
+    pool.SetNull();
+    pool.nCvnId        = GetRingHeader(base)->nCvnId;
+    pool.nCreationTime = head->nCreationTime;
+    memcpy(pool.hashRootBlock.begin(), head->hashRootBlock, sizeof(head->hashRootBlock));
+    memcpy(pool.msgSig.begin(), head->msgSig, sizeof(head->msgSig));
+
+    vPrivateNonces.clear();
+    vNonceHandles.clear();
+
+    for (uint32_t i = 0; i < head->nCount; i++) {
+        const NonceRingSlot *slot = GetRingSlot(base, head->nHead + i);
+
+        pool.vPublicNonces.push_back(CSchnorrNonce(poc_storage<64>(slot->publicNonce)));
+        if (head->nFlags & NONCE_RING_HAS_PRIVATE)
+            vPrivateNonces.push_back(CSchnorrPrivNonce(poc_storage<32>(slot->privateNonce)));
+        if (head->nFlags & NONCE_RING_HAS_HANDLES)
+            vNonceHandles.push_back(slot->nHandle);
+    }
 
     return true;
 }
 
-bool CNoncesPoolDB::Read(CNoncePool& pool, vector<CSchnorrPrivNonce>& vPrivateNonces, vector<uint8_t>& vNonceHandles)
+/* write the whole mapped file back to disk */
+void CNonceRingFile::Flush()
+{
+    LOCK(cs_ring);
+
+    if (pRegion && !pRegion->flush(0, 0, false))
+        LogPrintf("%s : could not flush nonce ring file\n", __func__);
+}
+
+/* read the pool.dat of previous versions, to move it over to the nonce ring file */
+static bool ReadLegacyNoncesPool(const boost::filesystem::path &pathNonces, CNoncePool& pool, vector<CSchnorrPrivNonce>& vPrivateNonces, vector<uint8_t>& vNonceHandles)
 {
     // open input file, and associate with CAutoFile
     FILE *file = fopen(pathNonces.string().c_str(), "rb");
@@ -1695,20 +3644,28 @@ bool CNoncesPoolDB::Read(CNoncePool& pool, vector<CSchnorrPrivNonce>& vPrivateNo
     return true;
 }
 
-void SaveNoncesPool()
+/* store our pool, it must not be relayed unless this succeeded */
+static bool WriteNoncesPool()
 {
-    if (!nCvnNodeId || !mapNoncePool.count(nCvnNodeId) || !fNoncePoolInitialsed)
-        return;
-
-    CNoncesPoolDB pooldb;
     vector<uint8_t> vNonceHandles;
 #ifdef USE_FASITO
     vNonceHandles = fasito.vNonceHandles;
 #endif
-    pooldb.Write(mapNoncePool[nCvnNodeId], vNoncePrivate, vNonceHandles);
+    if (!nonceRing.Write(mapNoncePool[nCvnNodeId], vNoncePrivate, vNonceHandles))
+        return error("%s: could not store the nonce pool, not relaying it", __func__);
 
-    LogPrint("cvnsig", "Flushed pool with %d public nonces and %d private nonces and %d nonces handles to pool.dat\n",
+    LogPrint("cvnsig", "Stored pool with %d public nonces and %d private nonces and %d nonces handles in the nonce ring\n",
             mapNoncePool[nCvnNodeId].vPublicNonces.size(), vNoncePrivate.size(), vNonceHandles.size());
+    return true;
+}
+
+void SaveNoncesPool()
+{
+    if (!nCvnNodeId || !mapNoncePool.count(nCvnNodeId) || !fNoncePoolInitialsed)
+        return;
+
+    nonceRing.Flush();
+    LogPrint("cvnsig", "Flushed nonce ring file\n");
 }
 
 bool static CreateNonceWithKey(const uint256& hashData, const CKey& privKey, unsigned char *pPrivateData, CSchnorrNonce& noncePublic)
@@ -1954,11 +3911,45 @@ bool AdminSignPartial(const uint256 &hashToSign, CAdminPartialSignatureUnsinged
     return VerifyPartialSignature(hashToSign, signature.signature, mapChainAdmins[nAdminId].pubKey, sumPublicNoncesOthers);
 }
 
-bool CvnSignPartial(const uint256 &hashPrevBlock, CCvnPartialSignatureUnsinged &signature, const uint32_t &nNextCreator, const uint32_t &nNodeId, const vector<uint32_t> &vMissingSignerIds, const int nPoolOffset)
+/* the hash a partial chain signature signs and the sum of the public nonces of the other signers */
+static bool CreateCvnSignPartialInput(uint256 &hashToSign, CSchnorrPubKey &sumPublicNoncesOthers, const uint256 &hashPrevBlock, const uint32_t &nNextCreator, const uint32_t &nNodeId, const vector<uint32_t> &vMissingSignerIds)
 {
+    if (!CreateSumPublicNoncesOthers(sumPublicNoncesOthers, nNextCreator, nNodeId, vMissingSignerIds))
+        return false;
+
     CHashWriter hasher(SER_GETHASH, 0);
     hasher << hashPrevBlock << nNextCreator;
+    UpdateHashWithMissingIDs(hasher, vMissingSignerIds);
+
+    hashToSign = hasher.GetHash();
+    return true;
+}
+
+static bool CvnSignPartialInput(CSchnorrSig &signature, const uint256 &hashToSign, const CSchnorrPubKey &sumPublicNoncesOthers, const uint32_t &nNodeId, const int nPoolOffset)
+{
+    if (GetArg("-cvn", "") == "fasito") {
+#ifdef USE_FASITO
+        if (!fasito.fLoggedIn) {
+            LogPrint("cvn", "%s : not logged into Fasito. Cannot create partial signature.\n", __func__);
+            return false;
+        }
 
+        if (!CvnSignPartialWithFasito(hashToSign, fasito.nCVNKeyIndex, sumPublicNoncesOthers, signature, nPoolOffset))
+            return false;
+#else
+        LogPrintf("%s : this wallet was not compiled with Fasito support.\n", __func__);
+        return false;
+#endif
+    } else {
+        if (!CvnSignPartialWithKey(hashToSign, cvnPrivKey, sumPublicNoncesOthers, signature, nPoolOffset))
+            return false;
+    }
+
+    return VerifyPartialSignature(hashToSign, signature, mapCVNs[nNodeId].pubKey, sumPublicNoncesOthers);
+}
+
+bool CvnSignPartial(const uint256 &hashPrevBlock, CCvnPartialSignatureUnsinged &signature, const uint32_t &nNextCreator, const uint32_t &nNodeId, const vector<uint32_t> &vMissingSignerIds, const int nPoolOffset)
+{
     if (!nNodeId) {
         LogPrintf("%s : CVN node not initialised\n", __func__);
         return false;
@@ -1979,39 +3970,21 @@ bool CvnSignPartial(const uint256 &hashPrevBlock, CCvnPartialSignatureUnsinged &
     signature.hashPrevBlock = hashPrevBlock;
     signature.nCreationTime = GetTime();
 
-    /* create a plain Schnorr signature in case only one CVN is available (e.g. during bootstrap) */
-    if (mapCVNs.size() == 1)
-        return CvnSignHash(hasher.GetHash(), signature.signature);
-
-    CSchnorrPubKey sumPublicNoncesOthers;
-    if (!CreateSumPublicNoncesOthers(sumPublicNoncesOthers, nNextCreator, nNodeId, vMissingSignerIds))
-        return false;
-
-    UpdateHashWithMissingIDs(hasher, vMissingSignerIds);
-
-    uint256 hashToSign = hasher.GetHash();
-
-    if (GetArg("-cvn", "") == "fasito") {
-#ifdef USE_FASITO
-        if (!fasito.fLoggedIn) {
-            LogPrint("cvn", "%s : not logged into Fasito. Cannot create partial signature.\n", __func__);
-            return false;
-        }
-
-        if (!CvnSignPartialWithFasito(hashToSign, fasito.nCVNKeyIndex, sumPublicNoncesOthers, signature.signature, nPoolOffset))
-            return false;
-#else
-        LogPrintf("%s : this wallet was not compiled with Fasito support.\n", __func__);
-        return false;
-#endif
-    } else {
-        if (!CvnSignPartialWithKey(hashToSign, cvnPrivKey, sumPublicNoncesOthers, signature.signature, nPoolOffset))
-            return false;
+    /* create a plain Schnorr signature in case only one CVN is available (e.g. during bootstrap) */
+    if (mapCVNs.size() == 1) {
+        CHashWriter hasher(SER_GETHASH, 0);
+        hasher << hashPrevBlock << nNextCreator;
+        return CvnSignHash(hasher.GetHash(), signature.signature);
     }
 
+    uint256 hashToSign;
+    CSchnorrPubKey sumPublicNoncesOthers;
+    if (!CreateCvnSignPartialInput(hashToSign, sumPublicNoncesOthers, hashPrevBlock, nNextCreator, nNodeId, vMissingSignerIds))
+        return false;
+
     signature.vMissingSignerIds = vMissingSignerIds;
 
-    return VerifyPartialSignature(hashToSign, signature.signature, mapCVNs[nNodeId].pubKey, sumPublicNoncesOthers);
+    return CvnSignPartialInput(signature.signature, hashToSign, sumPublicNoncesOthers, nNodeId, nPoolOffset);
 }
 
 int CombinePartialSignatures(CSchnorrSig& allsig, uint8_t *sigs[], int nSignatures)
@@ -2050,6 +4023,49 @@ bool CvnSignBlock(CBlock& block)
     return true;
 }
 
+/**
+ * Takes the prepared signature if it was made for this round, otherwise the
+ * signature has to be created from scratch. A prepared signature is only
+ * used once.
+ */
+static bool UsePreparedCvnSignature(POCStateHolder &s, CCvnPartialSignatureUnsinged &signature, const uint256 &hashPrevBlock,
+        const uint32_t nNextCreator, const vector<uint32_t> &vMissingSignerIds, const int nPoolOffset)
+{
+    if (s.prepared.IsNull())
+        return false;
+
+    CPreparedCvnSignature p = s.prepared;
+    s.prepared.SetNull();
+
+    bool fMatch = p.Matches(hashPrevBlock, nNextCreator, vMissingSignerIds, nPoolOffset) && mapCVNs.count(nCvnNodeId);
+    if (fMatch) {
+        LOCK(cs_mapNoncePool);
+        // the cached nonce sums are dropped whenever a nonce pool changes
+        fMatch = chainActive.Tip() == s.pindexPrev && p.nNonceGeneration == nonceSumCache.nGeneration;
+    }
+
+    if (!fMatch) {
+        LogPrint("cvnsig", "%s : round changed, discarding prepared signature\n", __func__);
+        return false;
+    }
+
+    if (p.fSigned) {
+        signature = p.signature;
+    } else {
+        signature.nSignerId         = nCvnNodeId;
+        signature.nCreatorId        = nNextCreator;
+        signature.hashPrevBlock     = hashPrevBlock;
+        signature.vMissingSignerIds = vMissingSignerIds;
+        if (!CvnSignPartialInput(signature.signature, p.hashToSign, p.sumPublicNoncesOthers, nCvnNodeId, nPoolOffset))
+            return false;
+    }
+    signature.nCreationTime = GetTime();
+
+    pocStateStats.AddPrepared(true, p.nPrepareMicros);
+
+    return true;
+}
+
 static bool SendCVNSignature(POCStateHolder &s, const vector<uint32_t> &vMissingSignatures)
 {
     const CBlockIndex *pTip = s.pindexPrev;
@@ -2065,7 +4081,8 @@ static bool SendCVNSignature(POCStateHolder &s, const vector<uint32_t> &vMissing
     int nPoolOffset = chainActive.Tip()->nHeight - mapNoncePool[nCvnNodeId].nHeightAdded;
     CCvnPartialSignatureUnsinged signature;
 
-    if (!CvnSignPartial(hashPrevBlock, signature, nNextCreator, nCvnNodeId, vMissingSignatures, nPoolOffset)) {
+    if (!UsePreparedCvnSignature(s, signature, hashPrevBlock, nNextCreator, vMissingSignatures, nPoolOffset) &&
+            !CvnSignPartial(hashPrevBlock, signature, nNextCreator, nCvnNodeId, vMissingSignatures, nPoolOffset)) {
         LogPrintf("%s : could not create sig for 0x%08x by 0x%08x, hash %s\n", __func__,
                 nNextCreator, nCvnNodeId, hashPrevBlock.ToString());
         return false;
@@ -2143,10 +4160,15 @@ static bool SetUpNoncePool()
     vector<uint8_t> vNonceHandles;
     bool fUseFasito = false;
 #endif
-    CNoncesPoolDB pooldb;
     CNoncePool pool;
-    if (!pooldb.Read(pool, vNoncePrivate, vNonceHandles)) {
-        return false;
+    if (!nonceRing.Read(pool, vNoncePrivate, vNonceHandles)) {
+        const boost::filesystem::path pathLegacy = GetDataDir() / "pool.dat";
+        if (!boost::filesystem::exists(pathLegacy) || !ReadLegacyNoncesPool(pathLegacy, pool, vNoncePrivate, vNonceHandles))
+            return false;
+
+        LogPrintf("%s : moving nonce pool from pool.dat to the nonce ring file\n", __func__);
+        if (nonceRing.Write(pool, vNoncePrivate, vNonceHandles))
+            boost::filesystem::remove(pathLegacy);
     }
 
     if (pool.vPublicNonces.empty()) {
@@ -2178,6 +4200,7 @@ static bool SetUpNoncePool()
     {
         LOCK(cs_mapNoncePool);
         mapNoncePool.erase(pool.nCvnId);
+        nonceSumCache.Invalidate();
     }
     return AddNoncePool(pool);
 }
@@ -2195,9 +4218,8 @@ static bool CreateNoncePoolFile(CNoncePool& pool, const uint16_t nPoolSize, CNon
         if (nOldPoolAge > 0 && vNoncePrivate.size() == oldPool->vPublicNonces.size()) {
             vNoncePrivate.erase(vNoncePrivate.begin(), vNoncePrivate.begin() + nOldPoolAge);
 
-            vector<CSchnorrNonce> &nonces = oldPool->vPublicNonces;
-            nonces.erase(nonces.begin(), nonces.begin() + nOldPoolAge);
-            pool.vPublicNonces = nonces;
+            // the old pool stays untouched, it is the base of the delta that is relayed
+            pool.vPublicNonces.assign(oldPool->vPublicNonces.begin() + nOldPoolAge, oldPool->vPublicNonces.end());
         } else {
             vNoncePrivate.clear();
             nOldPoolAge = 0;
@@ -2225,58 +4247,211 @@ static bool CreateNoncePoolFile(CNoncePool& pool, const uint16_t nPoolSize, CNon
 }
 
 #ifdef USE_FASITO
-static bool CreateNoncePoolFasito(CNoncePool& pool, const uint16_t nPoolSize, CNoncePool * const oldPool)
+/**
+ * A nonce pool refill that was queued on the Fasito. The NONCE commands are
+ * pipelined by the Fasito queue thread, which also runs the callbacks below one
+ * after the other. The pool is committed once the last response arrived, the
+ * POC thread keeps running in the meantime.
+ */
+class CFasitoNoncePoolJob
 {
-    uint256 hash4noncePool;
-    GetStrongRandBytes(&hash4noncePool.begin()[0], 32);
+public:
+    CCriticalSection cs_job;
+    CNoncePool pool;
+    vector<uint8_t> vNonceHandles;
+    size_t nFirstNew;
+    size_t nPending;
+    bool fFailed;
+    int64_t nStartTime;
 
-    bool fClearPool = false;
+    CFasitoNoncePoolJob() : nFirstNew(0), nPending(1), fFailed(false), nStartTime(GetTimeMillis()) {}
+};
 
-    LOCK(cs_mapNoncePool);
+typedef boost::shared_ptr<CFasitoNoncePoolJob> CFasitoNoncePoolJobRef;
 
-    int32_t nOldPoolAge = 0;
-    if (oldPool) {
-        nOldPoolAge = GetPoolAge(*oldPool, chainActive.Tip());
-        if (nOldPoolAge > 0 && fasito.vNonceHandles.size() == oldPool->vPublicNonces.size()) {
-            fasito.vNonceHandles.erase(fasito.vNonceHandles.begin(), fasito.vNonceHandles.begin() + nOldPoolAge);
+/** Set while a nonce pool is being created by the Fasito, guarded by cs_mapNoncePool */
+static bool fFasitoNoncePoolPending = false;
 
-            vector<CSchnorrNonce> &nonces = oldPool->vPublicNonces;
-            nonces.erase(nonces.begin(), nonces.begin() + nOldPoolAge);
-            pool.vPublicNonces = nonces;
-        } else {
-            fClearPool = true;
-            nOldPoolAge = 0;
-        }
+static void CommitFasitoNoncePool(CFasitoNoncePoolJob& job)
+{
+    CNoncePool& pool = job.pool;
+
+    if (job.fFailed) {
+        LogPrintf("could not create nonce pool with Fasito\n");
+        LOCK(cs_mapNoncePool);
+        fFasitoNoncePoolPending = false;
+        return;
+    }
+
+    LOCK2(cs_main, cs_mapNoncePool);
+    fFasitoNoncePoolPending = false;
+
+    // the handles have to match the pool in mapNoncePool, keep the current ones if it was not taken
+    vector<uint8_t> vNonceHandlesOld;
+    vNonceHandlesOld.swap(fasito.vNonceHandles);
+    fasito.vNonceHandles = job.vNonceHandles;
+
+    CNoncePoolDelta delta;
+    if (!AddNoncePool(pool, &delta) || !mapNoncePool.count(pool.nCvnId) || mapNoncePool[pool.nCvnId].nCreationTime != pool.nCreationTime) {
+        fasito.vNonceHandles.swap(vNonceHandlesOld);
+        return;
+    }
+
+    LogPrint("cvnsig", "CreateNoncePoolFasito : created %d nonces in %dms\n", pool.vPublicNonces.size() - job.nFirstNew, GetTimeMillis() - job.nStartTime);
+    if (WriteNoncesPool())
+        RelayNoncePool(pool, &delta);
+}
+
+static void FasitoNoncePoolSigned(CFasitoNoncePoolJobRef job, const CFasitoRequest& request)
+{
+    CNoncePool& pool = job->pool;
+
+    if (!request.fSuccess || !ParseFasitoSignature(request.vLines, pool.msgSig) ||
+            !CvnVerifySignature(pool.GetHash(), pool.msgSig, fasito.mapKeys[fasito.nCVNKeyIndex].pubKey)) {
+        LogPrintf("could not sign nonce pool with Fasito: %s\n", request.strError);
+        job->fFailed = true;
+    }
+
+    CommitFasitoNoncePool(*job);
+}
+
+static void FasitoNoncePoolCompleted(CFasitoNoncePoolJobRef job, const bool fSuccess)
+{
+    {
+        LOCK(job->cs_job);
+        if (!fSuccess)
+            job->fFailed = true;
+
+        if (--job->nPending > 0)
+            return;
+    }
+
+    // the pool is signed on the queue too, a blocking SCHNORR could be matched with a late NONCE response
+    if (!job->fFailed && !fasito.SubmitCommand(GetFasitoSignCommand(job->pool.GetHash(), fasito.nCVNKeyIndex),
+            boost::bind(&FasitoNoncePoolSigned, job, _1)))
+        job->fFailed = true;
+
+    if (job->fFailed)
+        CommitFasitoNoncePool(*job);
+}
+
+static void FasitoNoncePoolCleared(CFasitoNoncePoolJobRef job, const CFasitoRequest& request)
+{
+    if (!request.fSuccess)
+        LogPrintf("could not clear nonce pool on Fasito: %s\n", request.strError);
+
+    FasitoNoncePoolCompleted(job, request.fSuccess);
+}
+
+static void FasitoNonceCreated(CFasitoNoncePoolJobRef job, const size_t nIndex, const CFasitoRequest& request)
+{
+    uint8_t nHandle = 0;
+    CSchnorrNonce nonce;
+
+    const bool fSuccess = request.fSuccess && ParseFasitoNonce(request.vLines, nHandle, nonce);
+    if (fSuccess) {
+        LOCK(job->cs_job);
+        job->pool.vPublicNonces[nIndex] = nonce;
+        job->vNonceHandles[nIndex] = nHandle;
+        LogPrint("cvnsig", "CreateNoncePoolFasito : add to pool key #%d (handle: %d): %s\n", nIndex, nHandle, nonce.ToString());
     } else {
-        fClearPool = true;
+        LogPrintf("CreateNoncePoolFasito : could not create nonce pair: %s\n", request.strError);
+    }
+
+    FasitoNoncePoolCompleted(job, fSuccess);
+}
+
+static bool SubmitFasitoNoncePoolCommand(CFasitoNoncePoolJobRef job, const string& strCommand, const CFasitoCallback& callback)
+{
+    {
+        LOCK(job->cs_job);
+        job->nPending++;
+    }
+
+    if (!fasito.SubmitCommand(strCommand, callback)) {
+        LOCK(job->cs_job);
+        job->nPending--;
+        job->fFailed = true;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Queues the creation of a new nonce pool on the Fasito. It is signed on
+ * the queue when the last nonce was created, and committed and relayed by
+ * CommitFasitoNoncePool() once the signature arrived.
+ */
+static bool CreateNoncePoolFasito(const CNoncePool& poolIn, const uint16_t nPoolSize, CNoncePool * const oldPool)
+{
+    if (!fasito.fLoggedIn) {
+        LogPrint("cvn", "%s : Fasito is not ready.\n", __func__);
+        return false;
     }
 
-    if (fClearPool) {
-        fasito.vNonceHandles.clear();
-        if (!fasito.sendCommand("CLRPOOL")) {
-            LogPrintf("could not clear nonce pool on Fasito\n");
+    CSchnorrPubKey pubKey;
+    {
+        LOCK(cs_mapCVNs);
+        if (!mapCVNs.count(poolIn.nCvnId)) {
+            LogPrintf("%s : could not find CvnInfo for signer ID 0x%08x\n", __func__, poolIn.nCvnId);
             return false;
         }
+        pubKey = mapCVNs[poolIn.nCvnId].pubKey;
     }
 
-    const uint16_t nCreateNew = nPoolSize - pool.vPublicNonces.size();
+    if (!CheckFasitoNonceKey(fasito.nCVNKeyIndex, pubKey))
+        return false;
 
-    for (uint16_t i = 0 ; i < nCreateNew ; i++) {
-        CSchnorrNonce nonce;
-        unsigned char privateData[32];
-        if (!CreateNoncePairForHash(nonce, privateData, hash4noncePool, pool.nCvnId, true, false)) {
-            pool.vPublicNonces.clear();
-            return false;
+    uint256 hash4noncePool;
+    GetStrongRandBytes(&hash4noncePool.begin()[0], 32);
+
+    CFasitoNoncePoolJobRef job(new CFasitoNoncePoolJob());
+    job->pool = poolIn;
+
+    bool fClearPool = false;
+
+    {
+        LOCK(cs_mapNoncePool);
+        if (fFasitoNoncePoolPending) {
+            LogPrint("cvnsig", "%s : nonce pool creation already in progress\n", __func__);
+            return true;
         }
 
-        uint8_t *nHandle = (uint8_t *) privateData;
+        int32_t nOldPoolAge = 0;
+        if (oldPool) {
+            nOldPoolAge = GetPoolAge(*oldPool, chainActive.Tip());
+            if (nOldPoolAge > 0 && fasito.vNonceHandles.size() == oldPool->vPublicNonces.size()) {
+                // recycle the unused nonces, the current pool stays in use until the new one is ready
+                job->vNonceHandles.assign(fasito.vNonceHandles.begin() + nOldPoolAge, fasito.vNonceHandles.end());
+                job->pool.vPublicNonces.assign(oldPool->vPublicNonces.begin() + nOldPoolAge, oldPool->vPublicNonces.end());
+            } else {
+                fClearPool = true;
+            }
+        } else {
+            fClearPool = true;
+        }
 
-        fasito.vNonceHandles.push_back(*nHandle);
-        pool.vPublicNonces.push_back(nonce);
-        LogPrint("cvnsig", "CreateNoncePoolFasito : add to pool key #%d (handle: %d): %s\n", i, *nHandle, nonce.ToString());
+        fFasitoNoncePoolPending = true;
     }
 
-    return false;
+    job->nFirstNew = job->pool.vPublicNonces.size();
+    const size_t nCreateNew = nPoolSize > job->nFirstNew ? nPoolSize - job->nFirstNew : 0;
+    job->pool.vPublicNonces.resize(job->nFirstNew + nCreateNew);
+    job->vNonceHandles.resize(job->nFirstNew + nCreateNew);
+
+    // the Fasito executes the commands in order, CLRPOOL is done before the first NONCE
+    bool fSubmitted = !fClearPool || SubmitFasitoNoncePoolCommand(job, "CLRPOOL", boost::bind(&FasitoNoncePoolCleared, job, _1));
+
+    for (size_t i = job->nFirstNew; fSubmitted && i < job->pool.vPublicNonces.size(); i++) {
+        fSubmitted = SubmitFasitoNoncePoolCommand(job, GetFasitoNonceCommand(hash4noncePool, fasito.nCVNKeyIndex),
+                boost::bind(&FasitoNonceCreated, job, i, _1));
+    }
+
+    // drop the reference of the submitter, commits the pool if the Fasito was faster
+    FasitoNoncePoolCompleted(job, fSubmitted);
+
+    return fSubmitted;
 }
 #endif
 
@@ -2304,7 +4479,9 @@ void CreateNewNoncePool(const POCStateHolder& s)
     }
 #ifdef USE_FASITO
     else {
+        // completed asynchronously by the Fasito queue
         CreateNoncePoolFasito(pool, nPoolSize, oldPool);
+        return;
     }
 #else
     else {
@@ -2319,9 +4496,10 @@ void CreateNewNoncePool(const POCStateHolder& s)
     }
 
     LOCK(cs_main);
-    if (AddNoncePool(pool)) {
-        SaveNoncesPool();
-        RelayNoncePool(pool);
+    CNoncePoolDelta delta;
+    if (AddNoncePool(pool, &delta)) {
+        if (WriteNoncesPool())
+            RelayNoncePool(pool, &delta);
     }
 }
 
@@ -2338,11 +4516,14 @@ static void FindSignerIDsWithMissingNonces(vector<uint32_t> &vSignerIdsWithMissi
 
 static bool NoncePoolsAvailable(const vector<uint32_t> &vMissingSignerIds)
 {
+    vector<uint32_t> vMissing(vMissingSignerIds);
+    sort(vMissing.begin(), vMissing.end());
+
     LOCK(cs_mapNoncePool);
 
     BOOST_FOREACH(const CvnMapType::value_type& cvn, mapCVNs) {
         // ignore those that are expected to be missing
-        if (find(vMissingSignerIds.begin(), vMissingSignerIds.end(), cvn.first) != vMissingSignerIds.end())
+        if (binary_search(vMissing.begin(), vMissing.end(), cvn.first))
             continue;
 
         if (mapNoncePool.find(cvn.first) == mapNoncePool.end()) {
@@ -2353,6 +4534,59 @@ static bool NoncePoolsAvailable(const vector<uint32_t> &vMissingSignerIds)
     return true;
 }
 
+/**
+ * Prepares the partial signature of the round while the POC thread waits for
+ * the last block to propagate: the creator, the missing signers, the sum of
+ * the public nonces and the hash to sign. With a key file the signature
+ * itself is created as well, if the round changes before it is due it is
+ * dropped without ever leaving this node. The Fasito is left alone, it is
+ * busy enough creating nonces.
+ */
+static void PrepareCvnSignature(POCStateHolder &s)
+{
+    CPreparedCvnSignature &p = s.prepared;
+    p.SetNull();
+
+    if (mapCVNs.size() < 2 || chainActive.Tip() != s.pindexPrev || !mapNoncePool.count(nCvnNodeId))
+        return;
+
+    const int64_t nStart = GetTimeMicros();
+
+    const uint32_t nNextCreator = CheckNextBlockCreator(s.pindexPrev, GetAdjustedTime());
+    if (!nNextCreator)
+        return;
+
+    const uint256 hashPrevBlock = s.pindexPrev->GetBlockHash();
+    FindSignerIDsWithMissingNonces(p.vMissingSignerIds);
+
+    {
+        LOCK(cs_mapNoncePool);
+        p.nPoolOffset = s.pindexPrev->nHeight - mapNoncePool[nCvnNodeId].nHeightAdded;
+
+        if (!CreateCvnSignPartialInput(p.hashToSign, p.sumPublicNoncesOthers, hashPrevBlock, nNextCreator, nCvnNodeId, p.vMissingSignerIds)) {
+            p.SetNull();
+            return;
+        }
+        p.nNonceGeneration = nonceSumCache.nGeneration;
+    }
+
+    if (GetArg("-cvn", "") == "file") {
+        p.signature.nSignerId         = nCvnNodeId;
+        p.signature.nCreatorId        = nNextCreator;
+        p.signature.hashPrevBlock     = hashPrevBlock;
+        p.signature.vMissingSignerIds = p.vMissingSignerIds;
+        p.fSigned = CvnSignPartialInput(p.signature.signature, p.hashToSign, p.sumPublicNoncesOthers, nCvnNodeId, p.nPoolOffset);
+    }
+
+    p.nNextCreator   = nNextCreator;
+    p.hashPrevBlock  = hashPrevBlock;
+    p.nPrepareMicros = GetTimeMicros() - nStart;
+
+    pocStateStats.AddPrepared(false, p.nPrepareMicros);
+    LogPrint("cvnsig", "%s : prepared signature for 0x%08x in %.2fms%s\n", __func__, nNextCreator,
+            0.001 * p.nPrepareMicros, p.fSigned ? "" : " (unsigned)");
+}
+
 static void handleCreateSignature(POCStateHolder& s)
 {
     const bool fIsOverdue = (s.state == CREATE_SIGNATURE_OVERDUE);
@@ -2390,33 +4624,51 @@ static void handleCompleteSignatureSets(POCStateHolder& s)
     s.state  = WAITING_FOR_SIGNATURES;
 }
 
+/**
+ * The first time not before nTime at which a signature set with fewer members
+ * should be tried. This is every nRetryNewSigSetInterval seconds after the block
+ * propagation wait time, or after the start of each grace period if overdue.
+ */
+static int64_t GetNextSigSetRetry(const POCStateHolder& s, const int64_t nTime)
+{
+    const int64_t nInterval = dynParams.nRetryNewSigSetInterval;
+
+    if (s.state == WAITING_FOR_SIGNATURES_OVERDUE) {
+        const int64_t nBase = s.pindexPrev->nTime + dynParams.nBlockSpacing;
+        if (nTime <= nBase)
+            return nBase;
+
+        const int64_t nGracePeriod = dynParams.nBlockSpacingGracePeriod;
+        const int64_t nPeriodStart = nBase + (nTime - nBase) / nGracePeriod * nGracePeriod;
+        const int64_t nRetry = nPeriodStart + (nTime - nPeriodStart + nInterval - 1) / nInterval * nInterval;
+
+        return std::min(nRetry, nPeriodStart + nGracePeriod);
+    }
+
+    const int64_t nBase = s.pindexPrev->nTime + dynParams.nBlockPropagationWaitTime;
+    if (nTime <= nBase)
+        return nBase;
+
+    return nBase + (nTime - nBase + nInterval - 1) / nInterval * nInterval;
+}
+
 static void handleWaitingForSignatures(POCStateHolder& s)
 {
+    UpdatePreparedBlock(s);
+
     if (sigHolder.HasCompleteSigSets(mapCVNs.size())) {
         s.state = WAITING_FOR_BLOCK;
         return;
     }
 
-    const bool fIsOverdue = (s.state == WAITING_FOR_SIGNATURES_OVERDUE);
-    int32_t nBaseTime = 0;
-
-    if (fIsOverdue) {
-        nBaseTime = GetAdjustedTime() - s.pindexPrev->nTime - dynParams.nBlockSpacing;
-
-        if (nBaseTime  < 0)
-            return;
-
-        nBaseTime %= dynParams.nBlockSpacingGracePeriod;
-    } else {
-        nBaseTime = GetAdjustedTime() - s.pindexPrev->nTime;
+    const int64_t nNow = GetAdjustedTime();
 
-        if (nBaseTime - (int32_t) dynParams.nBlockPropagationWaitTime < 0)
-            return;
+    if (!s.nNextSigSetRetry)
+        s.nNextSigSetRetry = GetNextSigSetRetry(s, nNow);
 
-        nBaseTime -= dynParams.nBlockPropagationWaitTime;
-    }
+    if (nNow >= s.nNextSigSetRetry) {
+        s.nNextSigSetRetry = GetNextSigSetRetry(s, nNow + 1);
 
-    if (!(nBaseTime % dynParams.nRetryNewSigSetInterval)) {
         /* We have not received all the expected partial signatures for any set.
          * Periodically (nRetryNewSigSetInterval) find the missing node IDs and try without them. */
 
@@ -2437,7 +4689,7 @@ static void handleWaitingForSignatures(POCStateHolder& s)
         }
 
         s.state  = COMPLETE_SIGNATURE_SETS;
-        s.nSleep = dynParams.nRetryNewSigSetInterval - 5;
+        s.nSleep = dynParams.nRetryNewSigSetInterval > 5 ? dynParams.nRetryNewSigSetInterval - 5 : 0;
     }
 }
 
@@ -2445,7 +4697,9 @@ static void handleWaitingForBlock(POCStateHolder& s)
 {
     if (s.nNextCreator == s.nNodeId) {
         int32_t nBlockTime = GetAdjustedTime() - s.pindexPrev->nTime;
-        if (nBlockTime >= (int32_t)dynParams.nBlockSpacing) {
+        if (nBlockTime < (int32_t)dynParams.nBlockSpacing) {
+            UpdatePreparedBlock(s);
+        } else {
             LOCK(cs_main);
             if (CreateBlock(s)) {
                 s.state = WAITING_FOR_NEW_TIP;
@@ -2491,6 +4745,10 @@ static void handleWaitingForBlockPropagation(POCStateHolder& s)
 
     CheckNoncePools(s.pindexPrev);
 
+    // use the time until the block has propagated to get the signature ready
+    if (s.nSleep)
+        PrepareCvnSignature(s);
+
     s.state = CREATE_SIGNATURE;
 }
 
@@ -2503,18 +4761,20 @@ static void handleWaitingForCvnData(POCStateHolder& s)
 
         CreateNewNoncePool(s);
         fNoncePoolInitialsed = true;
-    } else {
-        s.nSleep = 3;
     }
+    // otherwise woken up by the next tip or chain admin data
 }
 
 static void handleInit(POCStateHolder& s)
 {
-    int nCount = 0;
-    while (GetBoolArg("-cvnwaitforpeers", true) && vNodes.size() < 2 && !ShutdownRequested()) {
-        if (!(nCount++ % 10))
+    // stays in INIT until there are peers, a completed version handshake wakes it up
+    static int64_t nLastLogged = 0;
+    if (GetBoolArg("-cvnwaitforpeers", true) && vNodes.size() < 2) {
+        if (GetTime() - nLastLogged >= 10) {
             LogPrintf("Waiting for peers. Delaying to start the POC thread.\n");
-        MilliSleep(1000);
+            nLastLogged = GetTime();
+        }
+        return;
     }
 
     s.nSleep = 2;
@@ -2553,6 +4813,65 @@ static void (*stateHandlers[])(POCStateHolder& s) = {
         handleWaitingForSignatures,
 };
 
+/** Wakes up the POC thread when a new tip is connected, registered for its own lifetime */
+class CPocValidationListener : public CValidationInterface
+{
+public:
+    CPocValidationListener() { RegisterValidationInterface(this); }
+    ~CPocValidationListener() { UnregisterValidationInterface(this); }
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindex)
+    {
+        NotifyPocThread();
+    }
+};
+
+/**
+ * Time in ms until the next timeout the POC thread has to handle in its current
+ * state, if nothing else arrives before that it is waiting for.
+ */
+static int64_t GetPocTimeout(const POCStateHolder& s)
+{
+    const int64_t nNowMillis = GetTimeMillis();
+    if (s.nWaitUntil > nNowMillis)
+        return std::min(s.nWaitUntil - nNowMillis, POC_MAX_WAIT_MILLIS);
+
+    const int64_t nNow = GetAdjustedTime();
+    const int64_t nBlockTime = s.pindexPrev->nTime + dynParams.nBlockSpacing;
+
+    // the next block creator changes with every grace period that elapsed
+    int64_t nDeadline = nBlockTime + dynParams.nBlockSpacingGracePeriod;
+    if (nDeadline <= nNow)
+        nDeadline = nBlockTime + ((nNow - nBlockTime) / dynParams.nBlockSpacingGracePeriod + 1) * dynParams.nBlockSpacingGracePeriod;
+
+    if (s.state == WAITING_FOR_BLOCK && s.nNextCreator == s.nNodeId && nBlockTime > nNow)
+        nDeadline = std::min(nDeadline, nBlockTime);
+
+    if ((s.state == WAITING_FOR_SIGNATURES || s.state == WAITING_FOR_SIGNATURES_OVERDUE) && s.nNextSigSetRetry > nNow)
+        nDeadline = std::min(nDeadline, s.nNextSigSetRetry);
+
+    int64_t nMaxWait = POC_MAX_WAIT_MILLIS;
+
+    // the creator keeps its prepared block up to date with the mempool
+    if ((s.state == WAITING_FOR_SIGNATURES || s.state == WAITING_FOR_SIGNATURES_OVERDUE || s.state == WAITING_FOR_BLOCK) && s.nNextCreator == s.nNodeId)
+        nMaxWait = BLOCK_TEMPLATE_REFRESH_MILLIS;
+
+    return std::max((int64_t)0, std::min((nDeadline - nNow) * 1000, nMaxWait));
+}
+
+static void WaitForPocEvent(const int64_t nTimeoutMillis)
+{
+    boost::unique_lock<boost::mutex> lock(csPocEvent);
+    const boost::system_time timeout = boost::get_system_time() + boost::posix_time::milliseconds(nTimeoutMillis);
+
+    while (!fPocEvent) {
+        if (!condPocEvent.timed_wait(lock, timeout))
+            break;
+    }
+    fPocEvent = false;
+}
+
 void static POCThread(const CChainParams& chainparams, const uint32_t& nNodeId)
 {
     POCState lastState = WAITING_FOR_NEW_TIP;
@@ -2567,16 +4886,18 @@ void static POCThread(const CChainParams& chainparams, const uint32_t& nNodeId)
         return;
     }
 
+    CPocValidationListener listener;
+
     while (IsInitialBlockDownload() && !ShutdownRequested()) {
         LogPrintf("Block chain download in progress. Waiting...\n");
-        MilliSleep(5000);
+        WaitForPocEvent(5000);
     }
 
     uint32_t nNextCreator = CheckNextBlockCreator(chainActive.Tip(), GetAdjustedTime());
 
     while (!nNextCreator && !ShutdownRequested()) {
         LogPrintf("Next creator ID not available. Waiting...\n");
-        MilliSleep(5000);
+        WaitForPocEvent(5000);
         nNextCreator = CheckNextBlockCreator(chainActive.Tip(), GetAdjustedTime());
     }
 
@@ -2584,27 +4905,38 @@ void static POCThread(const CChainParams& chainparams, const uint32_t& nNodeId)
 
     LogPrintf("POC thread started for node ID 0x%08x\n", nNodeId);
 
+    POCState statsState = s.state;
+    int64_t nStateStart = GetTimeMicros();
+    pocStateStats.SetNull();
+    {
+        LOCK(pocStateStats.cs_stats);
+        pocStateStats.currentState = s.state;
+    }
+
     try {
         while (!ShutdownRequested()) {
             s.pindexPrev = chainActive.Tip();
             s.nNextCreator = CheckNextBlockCreator(s.pindexPrev, GetAdjustedTime());
 
             if (!s.nNextCreator) { // should not happen! And if it did, behave nice
-                MilliSleep(2000);
+                WaitForPocEvent(2000);
                 continue;
             }
 
-            if (s.state != WAITING_FOR_CVN_DATA) {
+            bool fNewRound = false;
+            if (s.state != WAITING_FOR_CVN_DATA && s.state != INIT) {
                 if ((s.NewTip())) {
                     LogPrintf("POCThread new tip detected. Next creator: 0x%08x\n", s.nNextCreator);
                     s.Reset(s.nNextCreator, s.pindexPrev, WAITING_FOR_BLOCK_PROPAGATION);
                     sigHolder.clear(s.nNextCreator);
                     lastState = UNDEFINED; // force print the new state
+                    fNewRound = true;
                 } else if (s.BlockSpacingTimeout()) {
                     LogPrintf("POCThread block spacing timeout detected. Next creator: 0x%08x\n", s.nNextCreator);
                     s.Reset(s.nNextCreator, s.pindexPrev, CREATE_SIGNATURE_OVERDUE);
                     sigHolder.clear(s.nNextCreator);
                     lastState = UNDEFINED; // force print the new state
+                    fNewRound = true;
                 }
             }
 
@@ -2613,19 +4945,34 @@ void static POCThread(const CChainParams& chainparams, const uint32_t& nNodeId)
                 break;
             }
 
-            stateHandlers[s.state](s);
+            const POCState stateBefore = s.state;
+
+            // a handler that asked to sleep is only woken up early by a new round
+            if (GetTimeMillis() >= s.nWaitUntil) {
+                s.nWaitUntil = 0;
+                stateHandlers[s.state](s);
+
+                if (s.nSleep) {
+                    s.nWaitUntil = GetTimeMillis() + s.nSleep * 1000;
+                    s.nSleep = 0;
+                }
+            }
 
-            if (s.nSleep) {
-                while (s.nSleep-- && !ShutdownRequested())
-                    MilliSleep(1000);
-                s.nSleep = 0;
-            } else
-                MilliSleep(1000);
+            if (fNewRound || s.state != statsState) {
+                const int64_t nNow = GetTimeMicros();
+                pocStateStats.Add(statsState, nNow - nStateStart, s.state);
+                statsState  = s.state;
+                nStateStart = nNow;
+            }
 
             if (s.state != lastState) {
                 LogPrintf("POCThread state: %s\n", pocStateNames[s.state]);
                 lastState = s.state;
             }
+
+            // run the handler of a new state right away, otherwise wait for something to arrive
+            if (s.state == stateBefore || s.nWaitUntil)
+                WaitForPocEvent(GetPocTimeout(s));
         }
 
         LogPrintf("POC thread stopped\n");
@@ -2642,12 +4989,97 @@ void static POCThread(const CChainParams& chainparams, const uint32_t& nNodeId)
     }
 }
 
+static bool GetCvnOverlayAddress(CService& addr)
+{
+    if (mapArgs.count("-cvnoverlayaddr"))
+        return Lookup(GetArg("-cvnoverlayaddr", "").c_str(), addr, GetListenPort(), fNameLookup);
+
+    return GetLocal(addr);
+}
+
+static void AnnounceCvnAddr(const uint32_t nNodeId)
+{
+    CCvnAddrMsg msg;
+    msg.nNodeId       = nNodeId;
+    msg.nCreationTime = GetAdjustedTime();
+
+    if (!GetCvnOverlayAddress(msg.addr)) {
+        LogPrintf("%s : no address to announce for CVN overlay connections\n", __func__);
+        return;
+    }
+
+    if (!CvnSignHash(msg.GetHash(), msg.msgSig)) {
+        LogPrintf("%s : could not sign CVN address announcement\n", __func__);
+        return;
+    }
+
+    LOCK(cs_main);
+    CValidationState state;
+    if (AddCvnAddr(msg, state))
+        RelayCvnAddr(msg);
+}
+
+static void ConnectCvnOverlay(const uint32_t nNodeId)
+{
+    vector<CService> vAddrs;
+    {
+        LOCK2(cs_main, cs_mapCvnAddrs);
+        LOCK(cs_vNodes);
+        const int64_t nNow = GetAdjustedTime();
+
+        CvnAddrMapType::iterator it = mapCvnAddrs.begin();
+        while (it != mapCvnAddrs.end()) {
+            const CvnAddrMapType::iterator itErase = it++;
+            const CCvnAddrMsg& msg = itErase->second;
+
+            if (!mapCVNs.count(msg.nNodeId) || msg.nCreationTime + CVN_ADDR_MAX_AGE < nNow) {
+                mapCvnAddrs.erase(itErase);
+                continue;
+            }
+
+            // the CVN may have connected to us already
+            if (msg.nNodeId != nNodeId && !FindCvnNode(msg.nNodeId) && !FindNode(msg.addr))
+                vAddrs.push_back(msg.addr);
+        }
+    }
+
+    BOOST_FOREACH(const CService& addr, vAddrs) {
+        LogPrint("cvn", "%s : connecting to CVN at %s\n", __func__, addr.ToString());
+        if (!OpenCvnOverlayConnection(addr))
+            LogPrint("cvn", "%s : could not connect to CVN at %s\n", __func__, addr.ToString());
+    }
+}
+
+/** Announces the overlay address of this CVN and keeps connections to the other CVNs */
+void static ThreadCvnOverlay(const uint32_t& nNodeId)
+{
+    RenameThread("CVN-overlay");
+
+    int64_t nNextAnnouncement = 0;
+
+    while (true) {
+        if (!IsInitialBlockDownload()) {
+            if (GetTime() >= nNextAnnouncement) {
+                AnnounceCvnAddr(nNodeId);
+                nNextAnnouncement = GetTime() + CVN_ADDR_ANNOUNCE_INTERVAL;
+            }
+
+            ConnectCvnOverlay(nNodeId);
+        }
+
+        MilliSleep(CVN_OVERLAY_CONNECT_INTERVAL * 1000);
+    }
+}
+
 void RunPOCThread(const bool fGenerate, const CChainParams& chainparams, const uint32_t& nNodeId)
 {
     static boost::thread_group* pocThread = NULL;
 
     if (pocThread != NULL) {
+        fCvnOverlay = false;
         pocThread->interrupt_all();
+        // the overlay thread opens connections, it must be gone before the network is stopped
+        pocThread->join_all();
         delete pocThread;
         pocThread = NULL;
 
@@ -2664,5 +5096,10 @@ void RunPOCThread(const bool fGenerate, const CChainParams& chainparams, const u
 
     pocThread = new boost::thread_group();
     pocThread->create_thread(boost::bind(&POCThread, boost::cref(chainparams), boost::cref(nNodeId)));
+
+    if (GetBoolArg("-cvnoverlay", DEFAULT_CVN_OVERLAY)) {
+        fCvnOverlay = true;
+        pocThread->create_thread(boost::bind(&ThreadCvnOverlay, boost::cref(nNodeId)));
+    }
 }
 #endif // USE_CVN
@@ -9,13 +9,20 @@
 #include "primitives/block.h"
 #include "chainparams.h"
 #include "chain.h"
+#include "netbase.h"
 #include "sync.h"
 
 #include <stdint.h>
+#include <deque>
+#include <list>
+#include <boost/shared_ptr.hpp>
 #include <boost/unordered_set.hpp>
 #include <boost/filesystem.hpp>
 #include <secp256k1.h>
 
+class CNode;
+class CValidationState;
+
 #define GENESIS_NODE_ID  0xc001d00d
 #define GENESIS_ADMIN_ID 0xad000001
 
@@ -43,6 +50,13 @@
 #define DEFAULT_NONCES_TO_KEEP 4
 #define DEFAULT_NONCE_POOL_SIZE 20
 #define MAX_NONCE_POOL_SIZE 100
+#define DEFAULT_SIGNER_PUBKEY_CACHE_SIZE 256
+
+/** CVN overlay: connections between CVNs to send chain signatures straight to the next creator */
+#define DEFAULT_CVN_OVERLAY false
+#define CVN_ADDR_ANNOUNCE_INTERVAL 21600
+#define CVN_ADDR_MAX_AGE 86400
+#define CVN_OVERLAY_CONNECT_INTERVAL 30
 
 #define __DBG_ LogPrintf("DEBUG: In file %s in function %s in line %d\n", __FILE__, __func__, __LINE__);
 
@@ -53,8 +67,6 @@ typedef std::map<uint32_t, CSchnorrNonce> CNoncesMapType;
 
 typedef std::map<const uint256, CChainDataMsg> ChainDataMapType;
 
-typedef std::map<uint32_t, CCvnPartialSignature> MapSigSigner;
-typedef std::map<const CSchnorrRx, MapSigSigner> MapSigCommonR;
 typedef std::map<uint32_t, CAdminPartialSignature> MapSigAdmin;
 
 typedef boost::unordered_set<uint32_t> TimeWeightSetType;
@@ -83,9 +95,272 @@ public:
 };
 
 typedef std::map<uint32_t, CvnInfoCache> CvnInfoCacheType;
+/** The CVN sets by the hash of the block that introduced them, valid on any fork */
+typedef std::map<uint256, CvnInfoCache> CvnEpochInfoMapType;
+
+/**
+ * A snapshot of the CVN set, the chain admin set and the dynamic chain
+ * parameters together with the data derived from them, e.g. the sum of the
+ * public keys of all CVNs. A new snapshot is derived from the previous one when
+ * a block with an admin payload gets connected or disconnected, for the sum
+ * only the keys that were added or removed are combined. A published snapshot
+ * is never modified, readers keep a reference to it and do not need
+ * cs_mapCVNs or cs_mapChainAdmins.
+ */
+class CCvnSetInfo
+{
+public:
+    uint64_t nEpoch;                                        // incremented with every published snapshot
+    uint32_t nHeight;                                       // the height of the block the CVN set was introduced by
+    secp256k1_pubkey sumOfAllPubKeys;
+    CvnMapType mapCVNs;
+    ChainAdminMapType mapChainAdmins;
+    CDynamicChainParams dynParams;
+
+    CCvnSetInfo()
+    {
+        SetNull();
+    }
+
+    void SetNull();
+
+    uint32_t GetActiveCvns() const
+    {
+        return mapCVNs.size();
+    }
+};
+
+/**
+ * Changes to the CVN set info made while an instance of this class exists are
+ * published as one snapshot when the outermost instance goes out of scope.
+ * The writers are serialized by cs_main.
+ */
+class CCvnSetInfoBatch
+{
+public:
+    CCvnSetInfoBatch();
+    ~CCvnSetInfoBatch();
+};
+
+typedef boost::shared_ptr<const CCvnSetInfo> CCvnSetInfoRef;
 typedef std::map<uint256, vector<CCvnInfo> > CachedCvnType;
 
+/**
+ * The admin payload of a block (CVN set and the sum of its public keys, chain
+ * admins, dynamic chain parameters and coin supply) as it is kept in the block
+ * tree DB, so it can be restored at startup without reading the block from disk.
+ */
+class CCvnStateRecord
+{
+public:
+    static const int32_t CURRENT_VERSION = 1;
+
+    int32_t nRecordVersion;
+    int32_t nPayload;                                       // the payload bits of the block's nVersion
+    std::vector<CCvnInfo> vCvns;
+    CSchnorrPubKey sumOfAllPubKeys;
+    std::vector<CChainAdmin> vChainAdmins;
+    CDynamicChainParams dynamicChainParams;
+    CCoinSupply coinSupply;
+
+    CCvnStateRecord()
+    {
+        SetNull();
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(nRecordVersion);
+        READWRITE(nPayload);
+        if (nPayload & CBlock::CVN_PAYLOAD) {
+            READWRITE(vCvns);
+            READWRITE(sumOfAllPubKeys);
+        }
+        if (nPayload & CBlock::CHAIN_ADMINS_PAYLOAD)
+            READWRITE(vChainAdmins);
+        if (nPayload & CBlock::CHAIN_PARAMETERS_PAYLOAD)
+            READWRITE(dynamicChainParams);
+        if (nPayload & CBlock::COIN_SUPPLY_PAYLOAD)
+            READWRITE(coinSupply);
+    }
+
+    void SetNull()
+    {
+        nRecordVersion = CURRENT_VERSION;
+        nPayload = 0;
+        vCvns.clear();
+        sumOfAllPubKeys = CSchnorrPubKey();
+        vChainAdmins.clear();
+        dynamicChainParams = CDynamicChainParams();
+        coinSupply = CCoinSupply();
+    }
+
+    bool FromBlock(const CBlock &block);
+    void ToBlock(CBlock &block) const;
+};
+
+/**
+ * A CVN that joined the network, i.e. the first CVN of a CVN_PAYLOAD block
+ * that was added at the height of that block.
+ */
+class CCvnAdmission
+{
+public:
+    int nHeight;
+    uint256 hashBlock;
+    uint32_t nNodeId;
+    int nFirstCreatedHeight;                                // height of the first block the CVN created, 0 if none yet
+
+    CCvnAdmission()
+    {
+        SetNull();
+    }
+
+    CCvnAdmission(const CBlockIndex *pindex, const uint32_t nNodeIdIn);
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(nHeight);
+        READWRITE(hashBlock);
+        READWRITE(nNodeId);
+        READWRITE(nFirstCreatedHeight);
+    }
+
+    void SetNull()
+    {
+        nHeight = 0;
+        hashBlock.SetNull();
+        nNodeId = 0;
+        nFirstCreatedHeight = 0;
+    }
+};
+
+/**
+ * Height ordered index of the CVN admissions in the active chain. It is kept
+ * in the block tree DB and advanced by ConnectTip()/DisconnectTip(), so
+ * CheckNextBlockCreator() finds a CVN that still needs to be bootstrapped
+ * without walking the chain back to the last admission.
+ */
+class CCvnAdmissionIndex
+{
+private:
+    const CBlockIndex *pindexTip;
+    std::vector<CCvnAdmission> vAdmissions;
+
+    bool Apply(const CBlockIndex *pindex, const std::vector<CCvnInfo> *pvCvns, std::vector<CCvnAdmission> &vChanged);
+
+public:
+    CCriticalSection cs_admissions;
+
+    CCvnAdmissionIndex()
+    {
+        SetNull();
+    }
+
+    void SetNull();
+    bool Load(const CBlockIndex *pindexNew);
+    void ConnectTip(const CBlockIndex *pindexNew, const CBlock &block);
+    void DisconnectTip(const CBlockIndex *pindexDelete);
+
+    /** The CVN that was added last and did not create a block since, as of pindexStart.
+     * Returns false if the index cannot answer for pindexStart. */
+    bool GetNewlyAddedCVN(const CBlockIndex *pindexStart, uint32_t &nNodeId);
+};
+
+extern CCvnAdmissionIndex cvnAdmissions;
+
 extern CvnInfoCacheType mapCVNInfoCache;
+extern CvnEpochInfoMapType mapCvnEpochInfo;
+
+/**
+ * LRU cache of the combined public keys of the CVNs that signed a block. The
+ * key is the height of the CVN set in use and the hash of the (sorted) missing
+ * signer IDs, as usually the same few CVNs are missing for many blocks in a row.
+ */
+class CSignerPubKeyCache
+{
+private:
+    typedef std::pair<uint32_t, uint256> CacheKeyType;
+    typedef std::list<std::pair<CacheKeyType, secp256k1_pubkey> > CacheListType;
+
+    CacheListType listEntries;                                      // most recently used first
+    std::map<CacheKeyType, CacheListType::iterator> mapEntries;
+    size_t nMaxSize;
+
+public:
+    CCriticalSection cs_cache;
+
+    uint64_t nHits;
+    uint64_t nMisses;
+    uint64_t nSubtracted;                                           // misses calculated by subtracting from the sum of all pubkeys
+    uint64_t nCombined;                                             // misses calculated by combining all signers pubkeys
+    uint64_t nEvicted;
+
+    CSignerPubKeyCache(const size_t nMaxSizeIn = DEFAULT_SIGNER_PUBKEY_CACHE_SIZE) : nMaxSize(nMaxSizeIn)
+    {
+        SetNull();
+    }
+
+    void SetNull();
+    /** Remove all entries of CVN sets at or above nHeight (e.g. a CVN set was replaced) */
+    void EraseFrom(const uint32_t nHeight);
+    bool Get(const uint32_t nHeight, const uint256 &hashMissing, secp256k1_pubkey &pubKey);
+    void Put(const uint32_t nHeight, const uint256 &hashMissing, const secp256k1_pubkey &pubKey, const bool fSubtracted);
+
+    size_t size() const { return mapEntries.size(); }
+    size_t max_size() const { return nMaxSize; }
+};
+
+extern CSignerPubKeyCache signerPubKeyCache;
+
+/**
+ * The sums of the current public nonces of all CVNs that take part in a round,
+ * i.e. the ones with a nonce pool that are not listed as missing. The sum of
+ * the other signers' nonces a partial signature is created and verified with
+ * is derived from it by subtracting the nonce of the signer. Entries are
+ * valid for one tip and CVN set and are dropped whenever a nonce pool is
+ * added, replaced or removed. Guarded by cs_mapNoncePool.
+ */
+class CNonceSumCache
+{
+public:
+    class CNonceSum
+    {
+    public:
+        secp256k1_pubkey sum;
+        uint32_t nNonces;                                           // the number of nonces in sum
+        vector<uint32_t> vWithoutPool;                              // taking part but without a nonce pool
+    };
+
+private:
+    static const size_t MAX_ENTRIES = 32;
+
+    uint256 hashTip;
+    uint32_t nCvnSetHeight;
+    std::map<uint256, CNonceSum> mapSums;                           // key is the hash of the sorted missing signer IDs
+
+public:
+    uint64_t nHits;
+    uint64_t nMisses;
+    uint64_t nGeneration;                                           // incremented whenever the cached sums are dropped
+
+    CNonceSumCache()
+    {
+        nGeneration = 0;
+        SetNull();
+    }
+
+    void SetNull();
+    void Invalidate();
+    const CNonceSum* Get(const uint256 &hashTipIn, const uint32_t nCvnSetHeightIn, const uint256 &hashMissing);
+    const CNonceSum* Put(const uint256 &hashMissing, const CNonceSum &entry);
+};
+
+extern CNonceSumCache nonceSumCache;
 
 extern uint32_t nCvnNodeId;
 extern uint32_t nChainAdminId;
@@ -126,6 +401,57 @@ enum POCState {
     UNDEFINED
 };
 
+/**
+ * The partial chain signature of the next round, prepared while the POC thread
+ * waits for the last block to propagate. It is only used if the round still
+ * looks the same when the signature is due, i.e. the tip, the creator, the
+ * missing signers, the pool offset and the nonce pools did not change.
+ */
+class CPreparedCvnSignature
+{
+public:
+    uint256 hashPrevBlock;
+    uint32_t nNextCreator;
+    vector<uint32_t> vMissingSignerIds;
+    int nPoolOffset;
+    uint64_t nNonceGeneration;                              // nonceSumCache.nGeneration the nonce sum belongs to
+
+    uint256 hashToSign;
+    CSchnorrPubKey sumPublicNoncesOthers;
+    bool fSigned;                                           // signature holds the final partial signature
+    CCvnPartialSignatureUnsinged signature;
+    int64_t nPrepareMicros;                                 // time spent preparing
+
+    CPreparedCvnSignature()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        hashPrevBlock.SetNull();
+        nNextCreator = 0;
+        vMissingSignerIds.clear();
+        nPoolOffset = 0;
+        nNonceGeneration = 0;
+        hashToSign.SetNull();
+        sumPublicNoncesOthers.SetNull();
+        fSigned = false;
+        signature.SetNull();
+        nPrepareMicros = 0;
+    }
+
+    bool IsNull() const
+    {
+        return hashPrevBlock.IsNull();
+    }
+
+    bool Matches(const uint256 &hashPrevBlockIn, const uint32_t nNextCreatorIn, const vector<uint32_t> &vMissingSignerIdsIn, const int nPoolOffsetIn) const
+    {
+        return hashPrevBlock == hashPrevBlockIn && nNextCreator == nNextCreatorIn && vMissingSignerIds == vMissingSignerIdsIn && nPoolOffset == nPoolOffsetIn;
+    }
+};
+
 class POCStateHolder {
 public:
     POCState state;
@@ -134,8 +460,11 @@ public:
     uint32_t nNextCreator;
     uint32_t nLastCreator;
     uint32_t nSleep;
+    int64_t nWaitUntil;                                     // time in ms until the state handler is not called
+    int64_t nNextSigSetRetry;                               // time to try a signature set with fewer members
 
     vector<CSchnorrRx> commonRxs;
+    CPreparedCvnSignature prepared;                         // speculatively created signature of the round
 
     CBlockIndex *pindexLastTip, *pindexPrev;
     const CChainParams& chainparams;
@@ -149,6 +478,8 @@ public:
         nNextCreator  = nNextCreatorIn;
         nLastCreator  = nNextCreatorIn;
         nSleep        = 0;
+        nWaitUntil    = 0;
+        nNextSigSetRetry = 0;
 
         pindexPrev    = pindexPrevIn;
         pindexLastTip = pindexPrevIn;
@@ -163,7 +494,10 @@ public:
         pindexLastTip = pindexPrev;
         pindexPrev    = pindexPrevIn;
         nSleep        = 0;
+        nWaitUntil    = 0;
+        nNextSigSetRetry = 0;
         commonRxs.clear();
+        prepared.SetNull();
     }
 
     bool NewTip() const
@@ -182,45 +516,417 @@ public:
     }
 };
 
+/**
+ * A partial signature stored in a signature set. The fields all signatures of
+ * a set have in common (tip, creator and missing signer IDs) are kept once in
+ * CSigSet. An empty slot has nSignerId 0.
+ */
+class CSigSlot
+{
+public:
+    uint32_t nSignerId;
+    uint32_t nCreationTime;
+    int32_t nVersion;
+    bool fValidated;
+    CSchnorrSig signature;
+    CSchnorrSig msgSig;
+    uint256 hash;                                                   // inventory hash of the signature message
+
+    CSigSlot()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        nSignerId     = 0;
+        nCreationTime = 0;
+        nVersion      = 0;
+        fValidated    = false;
+        signature.SetNull();
+        msgSig.SetNull();
+        hash.SetNull();
+    }
+
+    bool IsNull() const { return nSignerId == 0; }
+};
+
+/**
+ * All partial signatures created for one common R. The signatures live in the
+ * arena of their round, in nSlots consecutive slots starting at nOffset.
+ */
+class CSigSet
+{
+public:
+    CSchnorrRx commonRx;
+    vector<uint32_t> vMissingSignerIds;                             // shared by all signatures of the set
+    size_t nOffset;
+    size_t nSigs;
+
+    CSigSet() : nOffset(0), nSigs(0) {}
+};
+
+/**
+ * The signature sets received for the block of nCreatorId on top of
+ * hashPrevBlock. Slots are indexed by the position of the signer ID in
+ * vSlotIds, the CVN IDs known when the round was created. All slots of a round
+ * are allocated from one arena that is released at once with the round.
+ */
+class CSigRound
+{
+public:
+    uint256 hashPrevBlock;
+    uint32_t nCreatorId;
+    vector<uint32_t> vSlotIds;
+    vector<CSigSet> vSets;
+    vector<CSigSlot> vArena;
+
+    CSigRound() : nCreatorId(0) {}
+
+    int GetSlot(const uint32_t nSignerId) const;
+    void SetSlotIds(const vector<uint32_t> &vIds);
+    CSigSet* GetSet(const CSchnorrRx &commonRx);
+    CSigSet& AddSet(const CSchnorrRx &commonRx, const vector<uint32_t> &vMissingSignerIds);
+
+    CSigSlot* begin(const CSigSet &set) { return &vArena[set.nOffset]; }
+    CSigSlot* end(const CSigSet &set) { return &vArena[set.nOffset] + vSlotIds.size(); }
+    const CSigSlot* begin(const CSigSet &set) const { return &vArena[set.nOffset]; }
+    const CSigSlot* end(const CSigSet &set) const { return &vArena[set.nOffset] + vSlotIds.size(); }
+
+    CCvnPartialSignature GetSignature(const CSigSet &set, const CSigSlot &slot) const;
+};
+
+/**
+ * Read access to the signature sets held by CSignatureHolder. Visit() is
+ * called for each set while the lock of its shard is held, so it must not
+ * call back into the holder or take other locks. Work like verifying the
+ * signatures is done on a copy after the iteration. Returning false stops it.
+ */
+class CSigSetVisitor
+{
+public:
+    virtual ~CSigSetVisitor() {}
+    virtual bool Visit(CSigRound &round, CSigSet &set) = 0;
+};
+
+/**
+ * Holds the partial chain signatures of the current rounds. The signature sets
+ * are spread over SHARDS shards by their common R, each with its own lock,
+ * so that signatures arriving from the network do not serialize on the POC
+ * thread and the block creation.
+ */
 class CSignatureHolder
 {
+public:
+    static const int SHARDS = 8;
+
 private:
+    typedef std::map<std::pair<uint256, uint32_t>, CSigRound> RoundMapType;
 
-public:
-    MapSigCommonR sigs;     // map signatures per common R point
+    class CShard
+    {
+    public:
+        CCriticalSection cs_shard;
+        RoundMapType mapRounds;
+    };
 
-    CCriticalSection cs_sigHolder;
+    CShard shards[SHARDS];
 
-    CSignatureHolder()
+    CShard& GetShard(const CSchnorrRx &commonRx)
     {
-        SetNull();
+        return shards[commonRx.begin()[0] % SHARDS];
     }
 
-    void SetNull()
+    static CSigRound* GetRound(CShard &shard, const uint256 &hashPrevBlock, const uint32_t nCreatorId);
+
+public:
+    CSignatureHolder()
     {
-        LOCK(cs_sigHolder);
-        sigs.clear();
+        SetNull();
     }
 
-    void AddSig(const CCvnPartialSignature &sig);
-    MapSigSigner* GetSignatureSet(const CSchnorrRx &commonRx);
-    CCvnPartialSignature* GetSignature(const uint32_t nSignerId, const CSchnorrRx &commonRx);
-    bool GetSignatures(vector<CCvnPartialSignature> &sigs);
+    void SetNull();
+
+    void AddSig(const CCvnPartialSignature &sig, const uint256 &hash);
+    /** Mark a signature that was verified outside the shard lock, if it is still held */
+    void SetValidated(const CCvnPartialSignature &sig);
+    void ForEachSigSet(CSigSetVisitor &visitor, const uint256 &hashPrevBlock, const uint32_t nCreatorId);
+    void ForEachSigSet(CSigSetVisitor &visitor);
+    bool GetSignatureHashes(vector<uint256> &vHashes, const uint256 &hashPrevBlock, const uint32_t nCreatorId);
     bool HasSigSetsToContributeTo(vector<vector<uint32_t> > &vSigSetsToContributeTo, const uint32_t nNodeId, const uint32_t nMaxSignatures);
     bool GetAllMissing(vector<uint32_t> &vMissingSignerIds, const uint32_t nNodeId, const vector<CSchnorrRx> &commonRxs, const CNoncePoolType &mapNoncePool, const uint32_t nMaxSignatures);
-    bool HasCompleteSigSets(const uint32_t nMaxSignatures) const;
+    bool HasCompleteSigSets(const uint32_t nMaxSignatures);
     void clear(const uint32_t nNextCreator);
+    size_t size();
 
     std::string ToString();
 };
 
+/**
+ * Statistics of the time the POC thread spent in each POCState. The histogram
+ * buckets are powers of ten of milliseconds (<1ms, <10ms, ..., >=100s).
+ */
+class CPocStateStats
+{
+public:
+    static const int NUM_BUCKETS = 7;
+
+    CCriticalSection cs_stats;
+
+    POCState currentState;
+    uint64_t nCount[UNDEFINED];
+    int64_t nTotalMicros[UNDEFINED];
+    int64_t nMaxMicros[UNDEFINED];
+    uint64_t nBuckets[UNDEFINED][NUM_BUCKETS];
+
+    /* signatures prepared while waiting for the block propagation */
+    uint64_t nPrepared;
+    uint64_t nPreparedUsed;
+    int64_t nSavedMicros;
+    int64_t nMaxSavedMicros;
+
+    CPocStateStats()
+    {
+        SetNull();
+    }
+
+    void SetNull();
+    void Add(const POCState state, const int64_t nMicros, const POCState nextState);
+    void AddPrepared(const bool fUsed, const int64_t nMicros);
+};
+
+extern CPocStateStats pocStateStats;
+
+/**
+ * End to end latency of the chain signatures received from the network,
+ * measured from the creation time set by their signer. The histogram buckets are
+ * <100ms, <200ms, <500ms, <1s, <2s, <5s, <10s and >=10s.
+ */
+class CSigLatencyStats
+{
+public:
+    static const int NUM_BUCKETS = 8;
+
+    /** received from the signer over the CVN overlay or relayed by other peers */
+    enum { DIRECT, RELAYED, NUM_ROUTES };
+
+    CCriticalSection cs_stats;
+
+    uint256 hashTip;
+    uint64_t nCount[NUM_ROUTES];
+    int64_t nTotalMillis[NUM_ROUTES];
+    int64_t nMaxMillis[NUM_ROUTES];
+    uint64_t nBuckets[NUM_ROUTES][NUM_BUCKETS];
+
+    CSigLatencyStats()
+    {
+        SetNull();
+    }
+
+    void SetNull();
+    void NewTip(const uint256& hash);
+    void Add(const CCvnPartialSignature& sig, const bool fDirect);
+};
+
+extern CSigLatencyStats sigLatencyStats;
+
+/** The address a CVN accepts overlay connections on, signed by the CVN */
+class CCvnAddrMsgUnsigned
+{
+public:
+    static const int32_t CURRENT_VERSION = 1;
+    int32_t nVersion;
+    uint32_t nNodeId;
+    CService addr;
+    uint32_t nCreationTime;
+
+    CCvnAddrMsgUnsigned()
+    {
+        SetNull();
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(this->nVersion);
+        nVersion = this->nVersion;
+        READWRITE(nNodeId);
+        READWRITE(addr);
+        READWRITE(nCreationTime);
+    }
+
+    void SetNull()
+    {
+        nVersion      = CURRENT_VERSION;
+        nNodeId       = 0;
+        nCreationTime = 0;
+        addr          = CService();
+    }
+
+    uint256 GetHash() const;
+    string ToString() const;
+};
+
+class CCvnAddrMsg : public CCvnAddrMsgUnsigned
+{
+public:
+    CSchnorrSig msgSig;
+
+    CCvnAddrMsg()
+    {
+        SetNull();
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(*(CCvnAddrMsgUnsigned*)this);
+        READWRITE(msgSig);
+    }
+
+    void SetNull()
+    {
+        CCvnAddrMsgUnsigned::SetNull();
+        msgSig.SetNull();
+    }
+};
+
+typedef std::map<uint32_t, CCvnAddrMsg> CvnAddrMapType;
+
+/** The answer of a CVN to the challenge a peer sent it, proves the CVN ID of the connection */
+class CCvnHelloMsg
+{
+public:
+    uint32_t nNodeId;
+    uint256 hashChallenge;
+    CSchnorrSig msgSig;
+
+    CCvnHelloMsg()
+    {
+        SetNull();
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(nNodeId);
+        READWRITE(hashChallenge);
+        READWRITE(msgSig);
+    }
+
+    void SetNull()
+    {
+        nNodeId = 0;
+        hashChallenge.SetNull();
+        msgSig.SetNull();
+    }
+
+    // the hash that is signed, tagged so it can not be mistaken for another message
+    uint256 GetHash() const;
+};
+
+extern CCriticalSection cs_mapCvnAddrs;
+extern CvnAddrMapType mapCvnAddrs;
+
 extern CSignatureHolder sigHolder;
 
+/**
+ * Closure representing one creator or chain signature of a block to be
+ * verified. The public key is resolved by the caller so the check does not
+ * depend on the CVN set and can run on the PoC signature check queue.
+ */
+class CPocSignatureCheck
+{
+private:
+    uint256 hash;
+    CSchnorrSig sig;
+    CSchnorrPubKey pubKey;
+    uint32_t nSignerId;                                     // creator ID, 0 for the chain signature
+
+public:
+    CPocSignatureCheck() : nSignerId(0) {}
+    CPocSignatureCheck(const uint256 &hashIn, const CSchnorrSig &sigIn, const CSchnorrPubKey &pubKeyIn, const uint32_t nSignerIdIn = 0) :
+        hash(hashIn), sig(sigIn), pubKey(pubKeyIn), nSignerId(nSignerIdIn) {}
+
+    bool operator()();
+
+    void swap(CPocSignatureCheck &check) {
+        std::swap(hash, check.hash);
+        std::swap(sig, check.sig);
+        std::swap(pubKey, check.pubKey);
+        std::swap(nSignerId, check.nSignerId);
+    }
+};
+
+/**
+ * Keeps the creator schedule of the active chain up to date. It is advanced
+ * by ConnectTip()/DisconnectTip() so CheckNextBlockCreator() does not need to
+ * rescan the last POC_BLOCKS_TO_SCAN block indexes each time it is called.
+ * Creators that are banned or not in the CVN set are filtered out as blocks
+ * are added and removed. The filter is only rebuilt if the CVN set or the
+ * banned CVNs changed.
+ */
+class CCreatorCandidateTracker
+{
+private:
+    const CBlockIndex *pindexTip;
+    uint32_t nSigWindow;                                    // # of blocks in the signature window
+    uint32_t nSigBlocks;                                    // # of blocks in the signature window at pindexTip
+
+    std::map<uint32_t, std::deque<int> > mapCreatedHeights; // creator ID -> heights of its blocks within the scan window
+    std::map<int, uint32_t> mapCandidatesByHeight;          // height of last created block -> creator ID
+    std::map<uint32_t, uint32_t> mapMissingSigs;            // signer ID -> # of blocks within the signature window it did not sign
+    std::map<uint32_t, uint32_t> mapSigWindowCreators;      // creator ID -> # of blocks within the signature window
+
+    CCvnSetInfoRef pinfo;                                   // the CVN set the filter was built for
+    size_t nBannedCVNs;                                     // size of mapBannedCVNs the filter was built for
+    std::map<int, uint32_t> mapEligibleByHeight;            // mapCandidatesByHeight without banned or deactivated creators
+    uint32_t nIneligibleSigWindowCreators;                  // # of banned or deactivated creators within the signature window
+    std::map<uint32_t, uint32_t> mapLastSigs;               // CVN ID -> # of blocks within the signature window it signed
+    bool fLastSigsDirty;                                    // mapLastSigs needs to be recomputed
+
+    bool IsEligible(const uint32_t nCreatorId) const;
+    void AddCreated(const CBlockIndex *pindex, const bool fFront);
+    void RemoveCreated(const CBlockIndex *pindex, const bool fFront);
+    void UpdateSigWindow(const CBlockIndex *pindex, const int nDelta);
+    void SetSigBlocks(const CBlockIndex *pindex);
+    void UpdateLastSigs(const CBlockIndex *pindex);
+    void Refilter(const CCvnSetInfoRef &info);
+
+public:
+    CCriticalSection cs_tracker;
+
+    CCreatorCandidateTracker()
+    {
+        SetNull();
+    }
+
+    void SetNull();
+    void Rebuild(const CBlockIndex *pindexNew);
+    void ConnectTip(const CBlockIndex *pindexNew);
+    void DisconnectTip(const CBlockIndex *pindexDelete);
+
+    /** Fill in the candidates and signature counts for pindexStart. Returns false if
+     * pindexStart is not the tracked tip or the result would differ from a full scan. */
+    bool GetCandidates(const CCvnSetInfoRef &info, const CBlockIndex *pindexStart, vector<uint32_t> &vCreatorCandidates, TimeWeightSetType &setCreatorCandidates, map<uint32_t, uint32_t> &mapLastSignatures);
+};
+
+extern CCreatorCandidateTracker creatorTracker;
+
 extern void CheckNoncePools(CBlockIndex *pindex);
 extern void ExpireChainAdminData();
 extern int32_t GetPoolAge(const CNoncePool &pool, CBlockIndex *pTip);
-extern bool AddToCvnInfoCache(const CBlock *pblock, const uint32_t nHeight);
+extern bool AddToCvnInfoCache(const CBlock *pblock, const uint32_t nHeight, const uint256 &hashBlock, const CSchnorrPubKey *pSumOfAllPubKeys = NULL);
+extern void RemoveFromCvnInfoCache(const CBlockIndex *pindexDelete);
+/** The current CVN set info, never NULL */
+extern CCvnSetInfoRef GetCvnSetInfo();
+/** Publish info as the current CVN set info */
+extern void SetCvnSetInfo(const CCvnSetInfoRef &info);
 extern uint32_t GetNumChainSigs(const CBlockIndex *pindex);
+extern void SetChainSigs(CBlockIndex *pindex);
 extern uint32_t GetNumChainSigs(const CBlock *pblock);
 extern bool CvnSignHash(const uint256 &hashToSign, CSchnorrSig& signature);
 extern bool AdminSignHash(const uint256 &hashToSign, CSchnorrSig& signature, bool fFasito);
@@ -228,10 +934,11 @@ extern bool AdminSignPartial(const uint256 &hashToSign, CAdminPartialSignatureUn
 extern bool CvnSignPartial(const uint256 &hashPrevBlock, CCvnPartialSignatureUnsinged &signature, const uint32_t &nNextCreator, const uint32_t &nNodeId, const vector<uint32_t> &vMissingCvnIds, const int nPoolOffset);
 extern int CombinePartialSignatures(CSchnorrSig& allsig, uint8_t *sigs[], int nSignatures);
 extern bool CvnSignBlock(CBlock& block);
-extern bool CvnVerifyChainSignature(const CBlock& block);
+extern bool CvnVerifyChainSignature(const CBlock& block, std::vector<CPocSignatureCheck> *pvChecks = NULL);
+extern bool GetSignersPubKey(secp256k1_pubkey &sumOfSignersPubkeys, const vector<uint32_t> &vMissingSignerIds);
 extern bool CvnVerifySignature(const uint256 &hash, const CSchnorrSig &sig, const CSchnorrPubKey &pubKey);
 extern bool CvnVerifySignature(const uint256 &hash, const CSchnorrSig &sig, const uint32_t nCvnId);
-extern bool CvnVerifyAdminSignature(const vector<uint32_t> &nAdminIds, const uint256 &hashAdmin, const CSchnorrSig &sig);
+extern bool CvnVerifyAdminSignature(const CCvnSetInfo &info, const vector<uint32_t> &nAdminIds, const uint256 &hashAdmin, const CSchnorrSig &sig);
 extern bool CheckForDuplicateCvns(const CBlock& block);
 extern bool CheckForSufficientNumberOfCvns(const CBlock& block, const Consensus::Params& params);
 extern bool CheckForDuplicateChainAdmins(const CBlock& block);
@@ -240,11 +947,20 @@ extern bool CheckForDuplicateMissingChainSigs(const CBlock& block);
 extern bool AddCvnSignature(CCvnPartialSignature& msg);
 extern bool AddChainData(const CChainDataMsg& msg);
 extern bool CvnVerifyPartialSignature(const CCvnPartialSignature &sig);
+extern bool CvnVerifyPartialSignatures(const vector<CCvnPartialSignature*> &vSigs, vector<uint32_t> &vInvalidSignerIds);
 extern bool VerifyPartialAdminSignature(const CAdminPartialSignature& sig, const uint256 hash2Sign);
 extern bool VerifyPartialSignature(const uint256 &hash, const CSchnorrSig &sig, const CSchnorrPubKey &pubKey, const CSchnorrPubKey &sumPublicNoncesOthers);
 extern bool CheckAdminSignature(const vector<uint32_t> &vAdminIds, const uint256 &hashAdmin, const CSchnorrSig &sig, const bool fCoinSupply);
 extern void RelayChainData(const CChainDataMsg& msg);
 extern void RelayCvnSignature(const CCvnPartialSignature& msg);
+extern bool HaveCvnAddr(const CCvnAddrMsg& msg);
+extern bool AddCvnAddr(const CCvnAddrMsg& msg, CValidationState& state);
+extern void RelayCvnAddr(const CCvnAddrMsg& msg, const CNode* pfrom = NULL);
+extern void AdvertiseCvnAddrs(CNode* pto);
+extern bool IsCvnNode(const CNode* pnode, const uint32_t nNodeId);
+extern void SendCvnChallenge(CNode* pto);
+extern void AnswerCvnChallenge(CNode* pfrom, const uint256& hashChallenge);
+extern bool AcceptCvnHello(CNode* pfrom, const CCvnHelloMsg& msg);
 extern bool CreateNoncePairForHash(CSchnorrNonce& noncePublic, unsigned char *pPrivateData, const uint256& hashData, const uint32_t& nNodeId, const bool fUseFasito, const bool fAdmin);
 
 extern bool AddNonceAdmin(const CAdminNonce& msg);
@@ -252,9 +968,11 @@ extern void RelayNonceAdmin(const CAdminNonce& msg);
 extern bool AddAdminSignature(const CAdminPartialSignature& msg);
 extern void RelayAdminSignature(const CAdminPartialSignature& msg);
 
-extern bool AddNoncePool(CNoncePool& msg);
+extern bool AddNoncePool(CNoncePool& msg, CNoncePoolDelta *pdelta = NULL);
+extern bool ApplyNoncePoolDelta(const CNoncePoolDelta& delta, CNoncePool& pool, bool& fMalformed);
+extern bool IsNewerNoncePool(const CNoncePoolDelta& delta);
 extern void CreateNewNoncePool(const POCStateHolder& s);
-extern void RelayNoncePool(const CNoncePool& msg);
+extern void RelayNoncePool(const CNoncePool& msg, const CNoncePoolDelta *pdelta = NULL);
 extern void RemoveCvnPubNonces(const uint256& hashPrevBlock);
 
 extern uint32_t CheckNextBlockCreator(const CBlockIndex* pindexStart, const int64_t nTimeToTest, CCvnStatus* state = NULL);
@@ -262,9 +980,9 @@ extern uint32_t CheckNextBlockCreator(const CBlockIndex* pindexStart, const int6
 extern const string CreateSignerIdList(const std::vector<uint32_t>& vNodeIds);
 
 /** Check whether a block hash satisfies the proof-of-cooperation requirements */
-extern bool CheckProofOfCooperation(const CBlock& block, const Consensus::Params&);
+extern bool CheckProofOfCooperation(const CBlock& block, const Consensus::Params&, std::vector<CPocSignatureCheck> *pvChecks = NULL);
 
-extern void UpdateCvnInfo(const CBlock* pblock, const uint32_t nHeight);
+extern void UpdateCvnInfo(const CBlock* pblock, const uint32_t nHeight, const uint256 &hashBlock, const CSchnorrPubKey *pSumOfAllPubKeys = NULL);
 extern void UpdateChainParameters(const CBlock* pblock);
 extern void UpdateChainAdmins(const CBlock* pblock);
 extern void SetCoinSupplyStatus(const CBlock* pblock);
@@ -274,16 +992,51 @@ extern void POC_destroy_secp256k1_context();
 
 /** start the proof-of-cooperation thread */
 extern void RunPOCThread(const bool fGenerate, const CChainParams& chainparams, const uint32_t& nNodeId);
+extern void NotifyPocThread();
 
-/** Access to the nonces pool database (pool.dat) */
-class CNoncesPoolDB
+namespace boost { namespace interprocess { class mapped_region; } }
+
+/**
+ * The nonce pool of this CVN in a memory mapped ring file (noncering.dat).
+ *
+ * The file has a fixed layout: a header, two head records and RING_SLOTS
+ * slots. Each slot holds one public nonce with its private nonce (or Fasito
+ * handle) and a checksum. A head record holds the pool meta data, the first
+ * slot and the number of slots of the pool. A new pool is committed by
+ * writing the changed slots after the live ones and then the head record
+ * that is not in use, so refilling the pool only touches the new nonces.
+ *
+ * Write() syncs the new slots and then the new head record to disk before
+ * it returns, a pool must not be relayed before that. Slots and head records
+ * that did not make it to disk in full are detected by their checksums, in
+ * which case the previous pool is used, whose slots are left untouched by the
+ * next refill. A file of another CVN is refused rather than overwritten.
+ */
+class CNonceRingFile
 {
+public:
+    static const uint32_t RING_SLOTS = 2 * MAX_NONCE_POOL_SIZE;
+
 private:
-    boost::filesystem::path pathNonces;
+    boost::filesystem::path pathRing;
+    boost::interprocess::mapped_region *pRegion;
+    int nActiveHead;                                                // head record in use, -1 if none
+
+    bool Open();
+    void Init();
+    bool SyncRange(const size_t nOffset, const size_t nSize);
+
 public:
-    CNoncesPoolDB();
+    CCriticalSection cs_ring;
+
+    CNonceRingFile();
+    ~CNonceRingFile();
+
+    void SetPath(const boost::filesystem::path &path) { pathRing = path; }
+
     bool Write(const CNoncePool& pool, const vector<CSchnorrPrivNonce>& vPrivateNonces, const vector<uint8_t>& vNonceHandles);
     bool Read(CNoncePool& pool, vector<CSchnorrPrivNonce>& vPrivateNonces, vector<uint8_t>& vNonceHandles);
+    void Flush();
 };
 
 void SaveNoncesPool();
@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 
 #include <boost/foreach.hpp>
 
@@ -193,6 +194,61 @@ std::string CNoncePoolUnsigned::ToString(const bool fVerbose) const
     return s.str();
 }
 
+bool CNoncePoolDelta::Create(const CNoncePool& prevPool, const CNoncePool& pool)
+{
+    SetNull();
+
+    if (prevPool.nCvnId != pool.nCvnId || pool.vPublicNonces.empty())
+        return false;
+
+    // the nonces that were not used yet are at the start of the new pool
+    const vector<CSchnorrNonce>& vPrev = prevPool.vPublicNonces;
+    const vector<CSchnorrNonce>& vNew = pool.vPublicNonces;
+    size_t nFirstKept = std::find(vPrev.begin(), vPrev.end(), vNew[0]) - vPrev.begin();
+    size_t nKept = vPrev.size() - nFirstKept;
+
+    if (!nKept || nKept > vNew.size() || !std::equal(vPrev.begin() + nFirstKept, vPrev.end(), vNew.begin()))
+        return false;
+
+    nCvnId        = pool.nCvnId;
+    hashPrevPool  = prevPool.GetHash();
+    hashPool      = pool.GetHash();
+    hashRootBlock = pool.hashRootBlock;
+    nCreationTime = pool.nCreationTime;
+    nSkip         = nFirstKept;
+    msgSig        = pool.msgSig;
+    vAppendedNonces.assign(vNew.begin() + nKept, vNew.end());
+
+    return true;
+}
+
+bool CNoncePoolDelta::AppliesTo(const CNoncePool& prevPool) const
+{
+    return nVersion <= CURRENT_VERSION && prevPool.nCvnId == nCvnId && prevPool.GetHash() == hashPrevPool;
+}
+
+bool CNoncePoolDelta::Apply(const CNoncePool& prevPool, CNoncePool& pool) const
+{
+    if (!AppliesTo(prevPool) || nSkip > prevPool.vPublicNonces.size())
+        return false;
+
+    pool.SetNull();
+    pool.nCvnId        = nCvnId;
+    pool.hashRootBlock = hashRootBlock;
+    pool.nCreationTime = nCreationTime;
+    pool.msgSig        = msgSig;
+    pool.vPublicNonces.assign(prevPool.vPublicNonces.begin() + nSkip, prevPool.vPublicNonces.end());
+    pool.vPublicNonces.insert(pool.vPublicNonces.end(), vAppendedNonces.begin(), vAppendedNonces.end());
+
+    return pool.GetHash() == hashPool;
+}
+
+std::string CNoncePoolDelta::ToString() const
+{
+    return strprintf("CNoncePoolDelta(ver=%d, cvnID=0x%08x, skip=%u, appended=%u, rootHash=%s, prevPool=%s, pool=%s, creationTime=%u)",
+            nVersion, nCvnId, nSkip, vAppendedNonces.size(), hashRootBlock.ToString(), hashPrevPool.ToString(), hashPool.ToString(), nCreationTime);
+}
+
 template <unsigned int BYTES>
 poc_storage<BYTES>::poc_storage(const std::vector<unsigned char>& vch)
 {
@@ -677,6 +677,76 @@ public:
     }
 };
 
+/**
+ * A nonce pool relayed as the difference to the previous pool of the same CVN.
+ * The first nSkip nonces of the pool hashPrevPool are dropped and the nonces in
+ * vAppendedNonces are appended. msgSig is the signature of the resulting pool.
+ */
+class CNoncePoolDelta
+{
+public:
+    static const int32_t CURRENT_VERSION = 1;
+    int32_t  nVersion;
+    uint32_t nCvnId;
+    uint256  hashPrevPool;
+    uint256  hashPool;
+    uint256  hashRootBlock;
+    uint32_t nCreationTime;
+    uint16_t nSkip;
+    vector<CSchnorrNonce> vAppendedNonces;
+    CSchnorrSig msgSig;
+
+    CNoncePoolDelta()
+    {
+        SetNull();
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(this->nVersion);
+        nVersion = this->nVersion;
+        READWRITE(nCvnId);
+        READWRITE(hashPrevPool);
+        READWRITE(hashPool);
+        READWRITE(hashRootBlock);
+        READWRITE(nCreationTime);
+        READWRITE(nSkip);
+        READWRITE(vAppendedNonces);
+        READWRITE(msgSig);
+    }
+
+    void SetNull()
+    {
+        nVersion      = CURRENT_VERSION;
+        nCvnId        = 0;
+        nCreationTime = 0;
+        nSkip         = 0;
+        hashPrevPool.SetNull();
+        hashPool.SetNull();
+        hashRootBlock.SetNull();
+        vAppendedNonces.clear();
+        msgSig.SetNull();
+    }
+
+    bool IsNull() const
+    {
+        return hashPool.IsNull();
+    }
+
+    // creates the delta from prevPool to pool, returns false if pool does not continue prevPool
+    bool Create(const CNoncePool& prevPool, const CNoncePool& pool);
+
+    // whether prevPool is the pool the delta is based on and the delta can be read
+    bool AppliesTo(const CNoncePool& prevPool) const;
+
+    // rebuilds the full pool from prevPool, returns false if the delta does not apply to it
+    bool Apply(const CNoncePool& prevPool, CNoncePool& pool) const;
+
+    string ToString() const;
+};
+
 class CAdminNonceUnsigned
 {
 public:
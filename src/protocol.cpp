@@ -39,7 +39,11 @@ const char *FILTERCLEAR="filterclear";
 const char *REJECT="reject";
 const char *SENDHEADERS="sendheaders";
 const char *NONCEPOOL="noncepool";
+const char *NONCEPOOLDELTA="noncepooldelta";
 const char *SIG="sig";
+const char *CVNADDR="cvnaddr";
+const char *CVNCHALLENGE="cvnchallenge";
+const char *CVNHELLO="cvnhello";
 const char *CHAINDATA="chaindata";
 const char *NONCEADMIN="nonceadmin";
 const char *SIGADMIN="sigadmin";
@@ -56,6 +60,8 @@ static const char* ppszTypeName[] =
     NetMsgType::CHAINDATA,
     NetMsgType::NONCEADMIN,
     NetMsgType::SIGADMIN,
+    "filtered extended block", // Should never occur
+    NetMsgType::NONCEPOOLDELTA,
 };
 
 /** All known message types. Keep this in the same order as the list of
@@ -88,7 +94,11 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::REJECT,
     NetMsgType::SENDHEADERS,
     NetMsgType::NONCEPOOL,
+    NetMsgType::NONCEPOOLDELTA,
     NetMsgType::SIG,
+    NetMsgType::CVNADDR,
+    NetMsgType::CVNCHALLENGE,
+    NetMsgType::CVNHELLO,
     NetMsgType::CHAINDATA,
     NetMsgType::NONCEADMIN,
     NetMsgType::SIGADMIN,
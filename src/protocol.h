@@ -244,11 +244,35 @@ extern const char *SENDHEADERS;
  * The CVN noncepool message transmits a single serialised CVN public nonce pool
  */
 extern const char *NONCEPOOL;
+/**
+ * The CVN noncepooldelta message transmits a serialised CNoncePoolDelta, the
+ * nonces that were appended to a public nonce pool the peer already has.
+ * @since protocol version 92002.
+ */
+extern const char *NONCEPOOLDELTA;
 /**
  * The CVN signature message transmits a single serialised CVN signature,
  * hashPrev and nCreatorId.
  */
 extern const char *SIG;
+/**
+ * The cvnaddr message transmits a single serialised CCvnAddrMsg, the signed
+ * address a CVN accepts overlay connections from other CVNs on.
+ * @since protocol version 92003.
+ */
+extern const char *CVNADDR;
+/**
+ * The cvnchallenge message transmits a random uint256 a CVN has to sign to
+ * prove its CVN ID on this connection.
+ * @since protocol version 92003.
+ */
+extern const char *CVNCHALLENGE;
+/**
+ * The cvnhello message transmits a single serialised CCvnHelloMsg, the
+ * answer to a cvnchallenge.
+ * @since protocol version 92003.
+ */
+extern const char *CVNHELLO;
 /**
  * The admin nonce message transmits a single serialised CAdminNonce
  */
@@ -367,6 +391,8 @@ enum {
     MSG_CHAIN_ADMIN_NONCE,
     MSG_CHAIN_ADMIN_SIGNATURE,
     MSG_FILTERED_EXTENDED_BLOCK,
+    // Requests a nonce pool as CNoncePoolDelta if the peer has one, only appears in getdata
+    MSG_CVN_PUB_NONCE_POOL_DELTA,
 };
 
 #endif // BITCOIN_PROTOCOL_H
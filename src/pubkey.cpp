@@ -205,6 +205,43 @@ bool CPubKey::Verify(const uint256 &hash, const std::vector<unsigned char>& vchS
     return secp256k1_schnorr_partial_verify(secp256k1_context_verify, &schnorrSig.begin()[0], hash.begin(), (secp256k1_pubkey *) pubKey.begin(), (secp256k1_pubkey *) sumPubNoncesOthers.begin());
 }
 
+/** verify the signatures [nBegin, nEnd) and bisect the range on failure */
+static void BisectPartialSchnorrBatch(const uint256 &hash, const std::vector<const unsigned char*> &vSigs, const std::vector<const secp256k1_pubkey*> &vPubKeys, const std::vector<const secp256k1_pubkey*> &vPubNonces, const CSchnorrPubKey &sumPubNonces, size_t nBegin, size_t nEnd, std::vector<size_t> &vInvalid)
+{
+    if (secp256k1_schnorr_partial_verify_batch(secp256k1_context_verify, &vSigs[nBegin], hash.begin(), &vPubKeys[nBegin], &vPubNonces[nBegin], (secp256k1_pubkey *) sumPubNonces.begin(), nEnd - nBegin))
+        return;
+
+    if (nEnd - nBegin == 1) {
+        vInvalid.push_back(nBegin);
+        return;
+    }
+
+    size_t nMiddle = nBegin + (nEnd - nBegin) / 2;
+    BisectPartialSchnorrBatch(hash, vSigs, vPubKeys, vPubNonces, sumPubNonces, nBegin, nMiddle, vInvalid);
+    BisectPartialSchnorrBatch(hash, vSigs, vPubKeys, vPubNonces, sumPubNonces, nMiddle, nEnd, vInvalid);
+}
+
+/* static */ bool CPubKey::VerifyPartialSchnorrBatch(const uint256 &hash, const std::vector<CSchnorrSig> &vSigs, const std::vector<CSchnorrPubKey> &vPubKeys, const std::vector<CSchnorrNonce> &vPubNonces, const CSchnorrPubKey &sumPubNonces, std::vector<size_t> *pvInvalid) {
+    if (vSigs.empty() || vSigs.size() != vPubKeys.size() || vSigs.size() != vPubNonces.size())
+        return false;
+
+    std::vector<const unsigned char*> vSigPtrs(vSigs.size());
+    std::vector<const secp256k1_pubkey*> vPubKeyPtrs(vSigs.size()), vPubNoncePtrs(vSigs.size());
+    for (size_t i = 0; i < vSigs.size(); i++) {
+        vSigPtrs[i]      = vSigs[i].begin();
+        vPubKeyPtrs[i]   = (const secp256k1_pubkey *) vPubKeys[i].begin();
+        vPubNoncePtrs[i] = (const secp256k1_pubkey *) vPubNonces[i].begin();
+    }
+
+    if (!pvInvalid)
+        return secp256k1_schnorr_partial_verify_batch(secp256k1_context_verify, &vSigPtrs[0], hash.begin(), &vPubKeyPtrs[0], &vPubNoncePtrs[0], (secp256k1_pubkey *) sumPubNonces.begin(), vSigs.size());
+
+    const size_t nInvalid = pvInvalid->size();
+    BisectPartialSchnorrBatch(hash, vSigPtrs, vPubKeyPtrs, vPubNoncePtrs, sumPubNonces, 0, vSigs.size(), *pvInvalid);
+
+    return pvInvalid->size() == nInvalid;
+}
+
 bool CPubKey::RecoverCompact(const uint256 &hash, const std::vector<unsigned char>& vchSig) {
     if (vchSig.size() != 65)
         return false;
@@ -190,6 +190,14 @@ public:
       */
     static bool VerifyPartialSchnorr(const uint256 &hash, const CSchnorrSig &schnorrSig, const CSchnorrPubKey &pubKey, const CSchnorrPubKey &sumPubNoncesOthers);
 
+    /**
+      * Verify partial schnorr signatures of the same hash and set of nonces at once.
+      * sumPubNonces is the sum of the public nonces of all signers of the set. If the
+      * batch fails and pvInvalid is given it receives the indexes of all invalid
+      * signatures, which are found by bisection.
+      */
+    static bool VerifyPartialSchnorrBatch(const uint256 &hash, const std::vector<CSchnorrSig> &vSigs, const std::vector<CSchnorrPubKey> &vPubKeys, const std::vector<CSchnorrNonce> &vPubNonces, const CSchnorrPubKey &sumPubNonces, std::vector<size_t> *pvInvalid = NULL);
+
     /**
      * Check whether a signature is normalized (lower-S).
      */
@@ -49,7 +49,7 @@ UniValue getactivecvns(const UniValue& params, bool fHelp)
             "       \"pubKey\": \"public key\",  (string) The public key of the CVN\n"
             "       \"heightAdded\": n,        (numeric) The height when the CVN was added to the network\n"
             "       \"predictedNextBlock\": n, (numeric) The height of the next block this CVNs most probably will create\n"
-            "       \"lastBlocksSigned\": n    (numeric) The number of blocks signed within the last " + strprintf("%d", (int)dynParams.nMinSuccessiveSignatures) + " blocks\n"
+            "       \"lastBlocksSigned\": n    (numeric) The number of blocks signed within the last " + strprintf("%d", (int)GetCvnSetInfo()->dynParams.nMinSuccessiveSignatures) + " blocks\n"
             "     }\n"
             "     ,...\n"
             "  ],\n"
@@ -59,14 +59,14 @@ UniValue getactivecvns(const UniValue& params, bool fHelp)
             + HelpExampleCli("getactivecvns","")
         );
 
-    LOCK(cs_mapCVNs);
+    const CCvnSetInfoRef info = GetCvnSetInfo();
 
     UniValue result(UniValue::VOBJ);
-    result.push_back(Pair("count", (int)mapCVNs.size()));
+    result.push_back(Pair("count", (int)info->mapCVNs.size()));
     result.push_back(Pair("currentHeight", chainActive.Tip()->nHeight));
     UniValue cvns(UniValue::VARR);
 
-    BOOST_FOREACH(const CvnMapType::value_type& cvn, mapCVNs)
+    BOOST_FOREACH(const CvnMapType::value_type& cvn, info->mapCVNs)
     {
         const CCvnInfo& c = cvn.second;
 
@@ -113,14 +113,14 @@ UniValue getactiveadmins(const UniValue& params, bool fHelp)
             + HelpExampleCli("getactiveadmins","")
         );
 
-    LOCK(cs_mapChainAdmins);
+    const CCvnSetInfoRef info = GetCvnSetInfo();
 
     UniValue result(UniValue::VOBJ);
-    result.push_back(Pair("count", (int)mapChainAdmins.size()));
+    result.push_back(Pair("count", (int)info->mapChainAdmins.size()));
     result.push_back(Pair("currentHeight", chainActive.Tip()->nHeight));
     UniValue admins(UniValue::VARR);
 
-    BOOST_FOREACH(const ChainAdminMapType::value_type& admin, mapChainAdmins)
+    BOOST_FOREACH(const ChainAdminMapType::value_type& admin, info->mapChainAdmins)
     {
         const CChainAdmin& a = admin.second;
 
@@ -202,7 +202,7 @@ UniValue getchainparameters(const UniValue& params, bool fHelp)
         );
 
     UniValue result(UniValue::VOBJ);
-    DynamicChainparametersToJSON(dynParams, result);
+    DynamicChainparametersToJSON(GetCvnSetInfo()->dynParams, result);
 
     return result;
 }
@@ -222,7 +222,7 @@ UniValue estimatefee(const UniValue& params, bool fHelp)
             + HelpExampleCli("estimatefee", "123")
             );
 
-    return ValueFromAmount(dynParams.nTransactionFee);
+    return ValueFromAmount(GetCvnSetInfo()->dynParams.nTransactionFee);
 }
 
 #ifdef USE_CVN
@@ -237,23 +237,24 @@ static bool AddAdminSignatures(CChainDataMsg &msg)
         return false;
     }
 
+    const CCvnSetInfoRef info = GetCvnSetInfo();
     const uint32_t nSigs = mapAdminSigs.size();
     const uint256 hash2Sign = msg.GetHash();
 
-    if (nSigs < dynParams.nMinAdminSigs)
+    if (nSigs < info->dynParams.nMinAdminSigs)
         throw runtime_error(
             strprintf("not enough signatures supplied "
-                      "(got %u signatures, but need at least %u to sign)", nSigs, dynParams.nMinAdminSigs));
-    if (nSigs > dynParams.nMaxAdminSigs || nSigs > MAX_NUMBER_OF_CHAIN_ADMINS || nSigs > mapChainAdmins.size())
+                      "(got %u signatures, but need at least %u to sign)", nSigs, info->dynParams.nMinAdminSigs));
+    if (nSigs > info->dynParams.nMaxAdminSigs || nSigs > MAX_NUMBER_OF_CHAIN_ADMINS || nSigs > info->mapChainAdmins.size())
         throw runtime_error(
-            strprintf("too many signatures supplied %u (%u/%u max)\nReduce the number", nSigs, mapChainAdmins.size(), dynParams.nMaxAdminSigs));
+            strprintf("too many signatures supplied %u (%u/%u max)\nReduce the number", nSigs, info->mapChainAdmins.size(), info->dynParams.nMaxAdminSigs));
 
-    if (msg.HasCoinSupplyPayload() && nSigs != mapChainAdmins.size())
+    if (msg.HasCoinSupplyPayload() && nSigs != info->mapChainAdmins.size())
         throw runtime_error(
                 strprintf("not enough signatures supplied "
-                       "(got %u signatures, but need at least %u to sign for coin supply)", nSigs, mapChainAdmins.size()));
+                       "(got %u signatures, but need at least %u to sign for coin supply)", nSigs, info->mapChainAdmins.size()));
 
-    if (mapChainAdmins.size() == 1 || (dynParams.nMinAdminSigs == 1 && mapAdminNonces.size() == 1)) {
+    if (info->mapChainAdmins.size() == 1 || (info->dynParams.nMinAdminSigs == 1 && mapAdminNonces.size() == 1)) {
         msg.vAdminIds     = sigFirst.vSignerIds;
         msg.adminMultiSig = sigFirst.signature;
         return CheckAdminSignature(msg.vAdminIds, msg.GetHash(), msg.adminMultiSig, msg.HasCoinSupplyPayload());
@@ -329,10 +330,11 @@ static bool AddAdminIds(CChainDataMsg &msg)
 static void AddCvnInfoToMsg(CChainDataMsg &msg, const uint32_t nNodeId, const uint32_t nHeightAdded, const CSchnorrPubKey &pubKey)
 {
     msg.nPayload |= CChainDataMsg::CVN_PAYLOAD;
-    msg.vCvns.resize(mapCVNs.size() + 1);
+    const CCvnSetInfoRef info = GetCvnSetInfo();
+    msg.vCvns.resize(info->mapCVNs.size() + 1);
 
     uint32_t index = 0;
-    BOOST_FOREACH(const CvnMapType::value_type& cvn, mapCVNs) {
+    BOOST_FOREACH(const CvnMapType::value_type& cvn, info->mapCVNs) {
         msg.vCvns[index++] = cvn.second;
     }
 
@@ -343,10 +345,11 @@ static void AddCvnInfoToMsg(CChainDataMsg &msg, const uint32_t nNodeId, const ui
 static void AddChainAdminToMsg(CChainDataMsg &msg, const uint32_t nAdminId, const uint32_t nHeightAdded, const CSchnorrPubKey &pubKey)
 {
     msg.nPayload |= CChainDataMsg::CHAIN_ADMINS_PAYLOAD;
-    msg.vChainAdmins.resize(mapChainAdmins.size() + 1);
+    const CCvnSetInfoRef info = GetCvnSetInfo();
+    msg.vChainAdmins.resize(info->mapChainAdmins.size() + 1);
 
     uint32_t index = 0;
-    BOOST_FOREACH(const ChainAdminMapType::value_type& cvn, mapChainAdmins) {
+    BOOST_FOREACH(const ChainAdminMapType::value_type& cvn, info->mapChainAdmins) {
         msg.vChainAdmins[index++] = cvn.second;
     }
 
@@ -371,21 +374,22 @@ static bool AddDynParamsToMsg(CChainDataMsg& msg, UniValue jsonParams)
     msg.nPayload = CChainDataMsg::CHAIN_PARAMETERS_PAYLOAD;
 
     CDynamicChainParams& params = msg.dynamicChainParams;
-
-    params.nVersion                     = dynParams.nVersion;
-    params.nBlockSpacing                = dynParams.nBlockSpacing;
-    params.nBlockSpacingGracePeriod     = dynParams.nBlockSpacingGracePeriod;
-    params.nTransactionFee              = dynParams.nTransactionFee;
-    params.nDustThreshold               = dynParams.nDustThreshold;
-    params.nMaxAdminSigs                = dynParams.nMaxAdminSigs;
-    params.nMinAdminSigs                = dynParams.nMinAdminSigs;
-    params.nMinSuccessiveSignatures     = dynParams.nMinSuccessiveSignatures;
-    params.nBlocksToConsiderForSigCheck = dynParams.nBlocksToConsiderForSigCheck;
-    params.nPercentageOfSignaturesMean  = dynParams.nPercentageOfSignaturesMean;
-    params.nMaxBlockSize                = dynParams.nMaxBlockSize;
-    params.nBlockPropagationWaitTime    = dynParams.nBlockPropagationWaitTime;
-    params.nCoinbaseMaturity            = dynParams.nCoinbaseMaturity;
-    params.nRetryNewSigSetInterval      = dynParams.nRetryNewSigSetInterval;
+    const CCvnSetInfoRef info = GetCvnSetInfo();
+
+    params.nVersion                     = info->dynParams.nVersion;
+    params.nBlockSpacing                = info->dynParams.nBlockSpacing;
+    params.nBlockSpacingGracePeriod     = info->dynParams.nBlockSpacingGracePeriod;
+    params.nTransactionFee              = info->dynParams.nTransactionFee;
+    params.nDustThreshold               = info->dynParams.nDustThreshold;
+    params.nMaxAdminSigs                = info->dynParams.nMaxAdminSigs;
+    params.nMinAdminSigs                = info->dynParams.nMinAdminSigs;
+    params.nMinSuccessiveSignatures     = info->dynParams.nMinSuccessiveSignatures;
+    params.nBlocksToConsiderForSigCheck = info->dynParams.nBlocksToConsiderForSigCheck;
+    params.nPercentageOfSignaturesMean  = info->dynParams.nPercentageOfSignaturesMean;
+    params.nMaxBlockSize                = info->dynParams.nMaxBlockSize;
+    params.nBlockPropagationWaitTime    = info->dynParams.nBlockPropagationWaitTime;
+    params.nCoinbaseMaturity            = info->dynParams.nCoinbaseMaturity;
+    params.nRetryNewSigSetInterval      = info->dynParams.nRetryNewSigSetInterval;
 
     bool fAllGood = true;
     vector<string> paramsList = jsonParams.getKeys();
@@ -931,28 +935,28 @@ UniValue removecvn(const UniValue& params, bool fHelp)
     msg.nPayload      |= (fRemoveCvn ? CChainDataMsg::CVN_PAYLOAD : CChainDataMsg::CHAIN_ADMINS_PAYLOAD);
     msg.hashPrevBlock  = chainActive.Tip()->GetBlockHash();
 
-    if (msg.HasCvnInfo()) {
-        LOCK(cs_mapCVNs);
-        msg.vCvns.resize(mapCVNs.size() - 1);
+    const CCvnSetInfoRef info = GetCvnSetInfo();
 
-        if (!mapCVNs.count(nNodeId))
+    if (msg.HasCvnInfo()) {
+        if (!info->mapCVNs.count(nNodeId))
             throw runtime_error("CVN ID not found");
 
+        msg.vCvns.resize(info->mapCVNs.size() - 1);
+
         uint32_t index = 0;
-        BOOST_FOREACH(const CvnMapType::value_type& cvn, mapCVNs)
+        BOOST_FOREACH(const CvnMapType::value_type& cvn, info->mapCVNs)
         {
             if (cvn.first != nNodeId)
                 msg.vCvns[index++] = cvn.second;
         }
     } else {
-        LOCK(cs_mapChainAdmins);
-        msg.vChainAdmins.resize(mapChainAdmins.size() - 1);
-
-        if (!mapChainAdmins.count(nNodeId))
+        if (!info->mapChainAdmins.count(nNodeId))
             throw runtime_error("Admin ID not found");
 
+        msg.vChainAdmins.resize(info->mapChainAdmins.size() - 1);
+
         uint32_t index = 0;
-        BOOST_FOREACH(const ChainAdminMapType::value_type& adm, mapChainAdmins)
+        BOOST_FOREACH(const ChainAdminMapType::value_type& adm, info->mapChainAdmins)
         {
             if (adm.first != nNodeId)
                 msg.vChainAdmins[index++] = adm.second;
@@ -1150,8 +1154,55 @@ UniValue getcvninfo(const UniValue& params, bool fHelp)
             "1. \"cvnId\"   (string, optional) The ID (in hex) of the CVN to display infos about\n"
             "\nResult:\n"
             "{\n"
-                "  \"nextBlockToCreate\":height     ,           (int) The estimated next block to create\n"
-                "  \"reserved\":\"reserved\",                   (string) reserved\n"
+            "  \"nodeId\": \"id\",                (string) The ID of the CVN\n"
+            "  \"nextBlockToCreate\": n,          (numeric) The estimated next block to create\n"
+            "  \"lastBlocksSigned\": n,           (numeric) The number of blocks signed within the last " + strprintf("%d", (int)GetCvnSetInfo()->dynParams.nMinSuccessiveSignatures) + " blocks\n"
+            "  \"signerPubKeyCache\": {           (json object) Statistics of the combined signer public key cache\n"
+            "     \"size\": n,                    (numeric) The number of cached public keys\n"
+            "     \"maxSize\": n,                 (numeric) The maximum number of cached public keys\n"
+            "     \"hits\": n,                    (numeric) The number of lookups served from the cache\n"
+            "     \"misses\": n,                  (numeric) The number of lookups not found in the cache\n"
+            "     \"subtracted\": n,              (numeric) The number of misses calculated by subtracting the missing signers\n"
+            "     \"combined\": n,                (numeric) The number of misses calculated by combining all signers\n"
+            "     \"evicted\": n                  (numeric) The number of public keys evicted from the cache\n"
+            "  },\n"
+            "  \"nonceSumCache\": {               (json object) Statistics of the cache of the summed up public nonces of a round\n"
+            "     \"hits\": n,                    (numeric) The number of nonce sums served from the cache\n"
+            "     \"misses\": n                   (numeric) The number of nonce sums calculated by combining all nonces\n"
+            "  },\n"
+            "  \"pocState\": \"state\",           (string) The current state of the POC thread\n"
+            "  \"pocStateLatency\": {             (json object) The time the POC thread spent in each state\n"
+            "     \"state\": {                    (json object) The name of the state\n"
+            "        \"count\": n,                (numeric) The number of times the state was left\n"
+            "        \"avgMs\": n,                (numeric) The average time spent in the state in ms\n"
+            "        \"maxMs\": n,                (numeric) The longest time spent in the state in ms\n"
+            "        \"histogram\": [n,...]       (array) Number of times the state was left after <1ms, <10ms, <100ms, <1s, <10s, <100s and >=100s\n"
+            "     }\n"
+            "     ,...\n"
+            "  },\n"
+            "  \"preparedSignatures\": {          (json object) Chain signatures prepared while waiting for the block propagation\n"
+            "     \"prepared\": n,                (numeric) The number of signatures prepared\n"
+            "     \"used\": n,                    (numeric) The number of prepared signatures sent, the others were discarded as the round changed\n"
+            "     \"savedMs\": n,                 (numeric) The total time saved in ms by sending prepared signatures\n"
+            "     \"maxSavedMs\": n               (numeric) The most time saved by a single signature in ms\n"
+            "  },\n"
+            "  \"preparedBlock\": {               (json object) The block prepared ahead of time when this node creates the next block\n"
+            "     \"refreshes\": n,               (numeric) The number of times the prepared block was populated from the mempool\n"
+            "     \"used\": n,                    (numeric) The number of blocks created from a prepared block\n"
+            "     \"populatedOnDemand\": n,       (numeric) The number of blocks populated when they were due\n"
+            "     \"avgPopulateMs\": n,           (numeric) The average time in ms it took to prepare a block\n"
+            "     \"lastCreateMs\": n             (numeric) The time in ms it took to create the last block\n"
+            "  },\n"
+            "  \"overlayPeers\": n,               (numeric) The number of CVNs that announced an overlay address\n"
+            "  \"signatureLatency\": {            (json object) The time from the creation of the chain signatures for the tip until they arrived\n"
+            "     \"route\": {                    (json object) direct: sent by the signer over the CVN overlay, relayed: by other peers\n"
+            "        \"count\": n,                (numeric) The number of signatures received\n"
+            "        \"avgMs\": n,                (numeric) The average latency in ms\n"
+            "        \"maxMs\": n,                (numeric) The highest latency in ms\n"
+            "        \"histogram\": [n,...]       (array) Number of signatures received after <100ms, <200ms, <500ms, <1s, <2s, <5s, <10s and >=10s\n"
+            "     }\n"
+            "     ,...\n"
+            "  }\n"
             "}\n"
             "\nExamples:\n"
             "\nDisplay CVN state\n"
@@ -1162,11 +1213,108 @@ UniValue getcvninfo(const UniValue& params, bool fHelp)
 
     if (params.size() == 1) {
         stringstream ss;
-        ss << hex << params[1].get_str();
+        ss << hex << params[0].get_str();
         ss >> nNodeId;
     }
 
-    return "to be implemented";
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("nodeId", strprintf("0x%08x", nNodeId)));
+
+    {
+        LOCK(cs_main);
+        CCvnStatus status(nNodeId);
+        CheckNextBlockCreator(chainActive.Tip(), GetAdjustedTime(), &status);
+        result.push_back(Pair("nextBlockToCreate", (int)status.nPredictedNextBlock));
+        result.push_back(Pair("lastBlocksSigned", (int)status.nBlockSigned));
+    }
+
+    UniValue cache(UniValue::VOBJ);
+    {
+        LOCK(signerPubKeyCache.cs_cache);
+        cache.push_back(Pair("size", (uint64_t)signerPubKeyCache.size()));
+        cache.push_back(Pair("maxSize", (uint64_t)signerPubKeyCache.max_size()));
+        cache.push_back(Pair("hits", signerPubKeyCache.nHits));
+        cache.push_back(Pair("misses", signerPubKeyCache.nMisses));
+        cache.push_back(Pair("subtracted", signerPubKeyCache.nSubtracted));
+        cache.push_back(Pair("combined", signerPubKeyCache.nCombined));
+        cache.push_back(Pair("evicted", signerPubKeyCache.nEvicted));
+    }
+    result.push_back(Pair("signerPubKeyCache", cache));
+
+    UniValue nonceCache(UniValue::VOBJ);
+    {
+        LOCK(cs_mapNoncePool);
+        nonceCache.push_back(Pair("hits", nonceSumCache.nHits));
+        nonceCache.push_back(Pair("misses", nonceSumCache.nMisses));
+    }
+    result.push_back(Pair("nonceSumCache", nonceCache));
+
+    UniValue states(UniValue::VOBJ);
+    {
+        LOCK(pocStateStats.cs_stats);
+        result.push_back(Pair("pocState", pocStateNames[pocStateStats.currentState]));
+
+        for (int i = 0; i < UNDEFINED; i++) {
+            if (!pocStateStats.nCount[i])
+                continue;
+
+            UniValue entry(UniValue::VOBJ), histogram(UniValue::VARR);
+            entry.push_back(Pair("count", pocStateStats.nCount[i]));
+            entry.push_back(Pair("avgMs", 0.001 * pocStateStats.nTotalMicros[i] / pocStateStats.nCount[i]));
+            entry.push_back(Pair("maxMs", 0.001 * pocStateStats.nMaxMicros[i]));
+            for (int j = 0; j < CPocStateStats::NUM_BUCKETS; j++)
+                histogram.push_back(pocStateStats.nBuckets[i][j]);
+            entry.push_back(Pair("histogram", histogram));
+            states.push_back(Pair(pocStateNames[i], entry));
+        }
+    }
+    result.push_back(Pair("pocStateLatency", states));
+
+    UniValue prepared(UniValue::VOBJ);
+    {
+        LOCK(pocStateStats.cs_stats);
+        prepared.push_back(Pair("prepared", pocStateStats.nPrepared));
+        prepared.push_back(Pair("used", pocStateStats.nPreparedUsed));
+        prepared.push_back(Pair("savedMs", 0.001 * pocStateStats.nSavedMicros));
+        prepared.push_back(Pair("maxSavedMs", 0.001 * pocStateStats.nMaxSavedMicros));
+    }
+    result.push_back(Pair("preparedSignatures", prepared));
+
+    UniValue block(UniValue::VOBJ);
+    {
+        LOCK(preparedBlock.cs);
+        block.push_back(Pair("refreshes", preparedBlock.nRefreshes));
+        block.push_back(Pair("used", preparedBlock.nUsed));
+        block.push_back(Pair("populatedOnDemand", preparedBlock.nPopulatedOnDemand));
+        block.push_back(Pair("avgPopulateMs", preparedBlock.nRefreshes ? 0.001 * preparedBlock.nTotalPopulateMicros / preparedBlock.nRefreshes : 0));
+        block.push_back(Pair("lastCreateMs", 0.001 * preparedBlock.nLastCreateMicros));
+    }
+    result.push_back(Pair("preparedBlock", block));
+
+    {
+        LOCK(cs_mapCvnAddrs);
+        result.push_back(Pair("overlayPeers", (uint64_t)mapCvnAddrs.size()));
+    }
+
+    UniValue latency(UniValue::VOBJ);
+    {
+        LOCK(sigLatencyStats.cs_stats);
+        const char* routeNames[] = { "direct", "relayed" };
+
+        for (int i = 0; i < CSigLatencyStats::NUM_ROUTES; i++) {
+            UniValue entry(UniValue::VOBJ), histogram(UniValue::VARR);
+            entry.push_back(Pair("count", sigLatencyStats.nCount[i]));
+            entry.push_back(Pair("avgMs", sigLatencyStats.nCount[i] ? sigLatencyStats.nTotalMillis[i] / (int64_t)sigLatencyStats.nCount[i] : 0));
+            entry.push_back(Pair("maxMs", sigLatencyStats.nMaxMillis[i]));
+            for (int j = 0; j < CSigLatencyStats::NUM_BUCKETS; j++)
+                histogram.push_back(sigLatencyStats.nBuckets[i][j]);
+            entry.push_back(Pair("histogram", histogram));
+            latency.push_back(Pair(routeNames[i], entry));
+        }
+    }
+    result.push_back(Pair("signatureLatency", latency));
+
+    return result;
 }
 
 UniValue bancvn(const UniValue& params, bool fHelp)
@@ -1193,7 +1341,7 @@ UniValue bancvn(const UniValue& params, bool fHelp)
         ss >> nNodeId;
     }
 
-    if (!mapCVNs.count(nNodeId))
+    if (!GetCvnSetInfo()->mapCVNs.count(nNodeId))
         return "ERROR";
 
     mapBannedCVNs[nNodeId] = chainActive.Tip()->nHeight;
@@ -65,6 +65,35 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorr_partial_verify(
   const secp256k1_pubkey *sumOthers
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5);
 
+/** Verify several partial signatures created by secp256k1_schnorr_partial_sign
+ *  for the same message and the same set of nonces at once.
+ *  Returns: 1: all signatures are correct
+ *           0: at least one signature is incorrect
+ *  Args:    ctx:       a secp256k1 context object, initialized for verification.
+ *  In:      sig64:     pointer to an array of n pointers to 64-byte partial
+ *                      signatures (cannot be NULL)
+ *           msg32:     the 32-byte message hash being verified (cannot be NULL)
+ *           pubkeys:   pointer to an array of n pointers to the signers' public
+ *                      keys (cannot be NULL)
+ *           pubnonces: pointer to an array of n pointers to the signers' public
+ *                      nonces (cannot be NULL)
+ *           sumnonces: the sum of the public nonces of all participating
+ *                      signers, including the ones not passed in (cannot be NULL)
+ *           n:         the number of signatures to verify (at least 1)
+ *
+ *  As sumnonces covers all signers, any subset of a signature set can be passed
+ *  in. This allows to narrow down an invalid signature by bisection.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorr_partial_verify_batch(
+  const secp256k1_context* ctx,
+  const unsigned char * const *sig64,
+  const unsigned char *msg32,
+  const secp256k1_pubkey * const *pubkeys,
+  const secp256k1_pubkey * const *pubnonces,
+  const secp256k1_pubkey *sumnonces,
+  size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5) SECP256K1_ARG_NONNULL(6);
+
 /** Recover an EC public key from a Schnorr signature created using
  *  secp256k1_schnorr_sign.
  *  Returns: 1: public key successfully recovered (which guarantees a correct
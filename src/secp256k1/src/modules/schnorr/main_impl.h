@@ -84,6 +84,33 @@ int secp256k1_schnorr_partial_verify(const secp256k1_context* ctx, const unsigne
     return secp256k1_schnorr_sig_verify(&ctx->ecmult_ctx, sig64, &q, secp256k1_schnorr_msghash_sha256, msg32, &o);
 }
 
+int secp256k1_schnorr_partial_verify_batch(const secp256k1_context* ctx, const unsigned char * const *sig64, const unsigned char *msg32, const secp256k1_pubkey * const *pubkeys, const secp256k1_pubkey * const *pubnonces, const secp256k1_pubkey *sumnonces, size_t n) {
+    secp256k1_ge *q, *r;
+    secp256k1_ge o;
+    size_t i;
+    int ret;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(sig64 != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(pubkeys != NULL);
+    ARG_CHECK(pubnonces != NULL);
+    ARG_CHECK(sumnonces != NULL);
+    ARG_CHECK(n >= 1);
+
+    q = (secp256k1_ge*)checked_malloc(&ctx->error_callback, sizeof(secp256k1_ge) * n);
+    r = (secp256k1_ge*)checked_malloc(&ctx->error_callback, sizeof(secp256k1_ge) * n);
+    for (i = 0; i < n; i++) {
+        secp256k1_pubkey_load(ctx, &q[i], pubkeys[i]);
+        secp256k1_pubkey_load(ctx, &r[i], pubnonces[i]);
+    }
+    secp256k1_pubkey_load(ctx, &o, sumnonces);
+    ret = secp256k1_schnorr_sig_verify_batch(&ctx->ecmult_ctx, sig64, q, r, &o, secp256k1_schnorr_msghash_sha256, msg32, n, &ctx->error_callback);
+    free(r);
+    free(q);
+    return ret;
+}
+
 int secp256k1_schnorr_recover(const secp256k1_context* ctx, secp256k1_pubkey *pubkey, const unsigned char *sig64, const unsigned char *msg32) {
     secp256k1_ge q;
 
@@ -14,6 +14,7 @@ typedef void (*secp256k1_schnorr_msghash)(unsigned char *h32, const unsigned cha
 
 static int secp256k1_schnorr_sig_sign(const secp256k1_ecmult_gen_context* ctx, unsigned char *sig64, const secp256k1_scalar *key, const secp256k1_scalar *nonce, const secp256k1_ge *pubnonce, secp256k1_schnorr_msghash hash, const unsigned char *msg32);
 static int secp256k1_schnorr_sig_verify(const secp256k1_ecmult_context* ctx, const unsigned char *sig64, const secp256k1_ge *pubkey, secp256k1_schnorr_msghash hash, const unsigned char *msg32, const secp256k1_ge *sumOthers);
+static int secp256k1_schnorr_sig_verify_batch(const secp256k1_ecmult_context* ctx, const unsigned char * const *sig64, const secp256k1_ge *pubkeys, const secp256k1_ge *pubnonces, const secp256k1_ge *sumnonces, secp256k1_schnorr_msghash hash, const unsigned char *msg32, size_t n, const secp256k1_callback *cb);
 static int secp256k1_schnorr_sig_recover(const secp256k1_ecmult_context* ctx, const unsigned char *sig64, secp256k1_ge *pubkey, secp256k1_schnorr_msghash hash, const unsigned char *msg32);
 static int secp256k1_schnorr_sig_combine(unsigned char *sig64, size_t n, const unsigned char * const *sig64ins);
 
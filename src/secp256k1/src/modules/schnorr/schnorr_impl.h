@@ -15,6 +15,8 @@
 #include "group.h"
 #include "ecmult.h"
 #include "ecmult_gen.h"
+#include "ecmult_impl.h"
+#include "hash.h"
 
 /**
  * Custom Schnorr-based signature scheme. They support multiparty signing, public key
@@ -161,6 +163,167 @@ static int secp256k1_schnorr_sig_verify(const secp256k1_ecmult_context* ctx, con
     return checkR(&Qj, &Rx);
 }
 
+/** Compute r = sum(na[i] * a[i]) for i in [0, n) using interleaved wNAFs (Strauss'
+ *  method). All points share one sequence of doublings and their tables of odd
+ *  multiples are brought to affine coordinates with a single field inversion.
+ *  None of the points may be infinity.
+ */
+static void secp256k1_schnorr_ecmult_multi(secp256k1_gej *r, const secp256k1_ge *a, const secp256k1_scalar *na, size_t n, const secp256k1_callback *cb) {
+    secp256k1_gej *prej = (secp256k1_gej*)checked_malloc(cb, sizeof(secp256k1_gej) * ECMULT_TABLE_SIZE(WINDOW_A) * n);
+    secp256k1_ge *pre = (secp256k1_ge*)checked_malloc(cb, sizeof(secp256k1_ge) * ECMULT_TABLE_SIZE(WINDOW_A) * n);
+    int *wnaf = (int*)checked_malloc(cb, sizeof(int) * 256 * n);
+    int *bits_na = (int*)checked_malloc(cb, sizeof(int) * n);
+    secp256k1_ge tmpa;
+    secp256k1_gej d;
+    int bits = 0;
+    int i;
+    size_t j;
+
+    for (j = 0; j < n; j++) {
+        /* odd multiples [1*a,3*a,...] in plain Jacobian form */
+        secp256k1_gej *t = prej + j * ECMULT_TABLE_SIZE(WINDOW_A);
+        VERIFY_CHECK(!secp256k1_ge_is_infinity(&a[j]));
+        secp256k1_gej_set_ge(&t[0], &a[j]);
+        secp256k1_gej_double_var(&d, &t[0], NULL);
+        for (i = 1; i < ECMULT_TABLE_SIZE(WINDOW_A); i++) {
+            secp256k1_gej_add_var(&t[i], &t[i - 1], &d, NULL);
+        }
+        bits_na[j] = secp256k1_ecmult_wnaf(wnaf + j * 256, 256, &na[j], WINDOW_A);
+        if (bits_na[j] > bits) {
+            bits = bits_na[j];
+        }
+    }
+    secp256k1_ge_set_all_gej_var(ECMULT_TABLE_SIZE(WINDOW_A) * n, pre, prej, cb);
+
+    secp256k1_gej_set_infinity(r);
+    for (i = bits - 1; i >= 0; i--) {
+        int m;
+        secp256k1_gej_double_var(r, r, NULL);
+        for (j = 0; j < n; j++) {
+            if (i < bits_na[j] && (m = wnaf[j * 256 + i])) {
+                ECMULT_TABLE_GET_GE(&tmpa, pre + j * ECMULT_TABLE_SIZE(WINDOW_A), m, WINDOW_A);
+                secp256k1_gej_add_ge_var(r, r, &tmpa, NULL);
+            }
+        }
+    }
+
+    free(bits_na);
+    free(wnaf);
+    free(pre);
+    free(prej);
+}
+
+/** Batch verification of partial signatures which were created for the same message
+ *  and the same set of nonces (see secp256k1_schnorr_partial_sign).
+ *
+ *  Every partial signature (r, s[i]) of signer i with public key Q[i] and public nonce
+ *  R[i] satisfies s[i] * G + h * Q[i] = e * R[i], where e is -1 if the y coordinate of
+ *  the sum of all nonces is odd and 1 otherwise. Using randomizers a[i] (a[0] = 1) that
+ *  are derived from all inputs, the signatures are verified at once by checking
+ *    sum(a[i] * s[i]) * G + sum(a[i] * h * Q[i]) - sum(a[i] * e * R[i]) == 0
+ *  with a single multi-scalar multiplication.
+ */
+static int secp256k1_schnorr_sig_verify_batch(const secp256k1_ecmult_context* ctx, const unsigned char * const *sig64, const secp256k1_ge *pubkeys, const secp256k1_ge *pubnonces, const secp256k1_ge *sumnonces, secp256k1_schnorr_msghash hash, const unsigned char *msg32, size_t n, const secp256k1_callback *cb) {
+    secp256k1_sha256_t sha;
+    secp256k1_ge *pts;
+    secp256k1_scalar *sc;
+    secp256k1_gej Qj, Rj, Sj;
+    secp256k1_ge Ra;
+    secp256k1_fe Rx;
+    secp256k1_scalar h, s, a, sum, one;
+    unsigned char hh[32], seed[32], buf[32];
+    int overflow, fnegate;
+    size_t i;
+
+    if (n == 0 || secp256k1_ge_is_infinity(sumnonces)) {
+        return 0;
+    }
+    /* all partial signatures share r, the x coordinate of the sum of all nonces */
+    if (!secp256k1_fe_set_b32(&Rx, sig64[0])) {
+        return 0;
+    }
+    Ra = *sumnonces;
+    secp256k1_fe_normalize_var(&Ra.x);
+    secp256k1_fe_normalize_var(&Ra.y);
+    if (!secp256k1_fe_equal_var(&Rx, &Ra.x)) {
+        return 0;
+    }
+    fnegate = secp256k1_fe_is_odd(&Ra.y);
+    hash(hh, sig64[0], msg32);
+    overflow = 0;
+    secp256k1_scalar_set_b32(&h, hh, &overflow);
+    if (overflow || secp256k1_scalar_is_zero(&h)) {
+        return 0;
+    }
+
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, msg32, 32);
+    for (i = 0; i < n; i++) {
+        if (secp256k1_ge_is_infinity(&pubkeys[i]) || secp256k1_ge_is_infinity(&pubnonces[i])) {
+            return 0;
+        }
+        if (i && memcmp(sig64[0], sig64[i], 32) != 0) {
+            return 0;
+        }
+        secp256k1_sha256_write(&sha, sig64[i], 64);
+        secp256k1_fe_get_b32(buf, &pubkeys[i].x);
+        secp256k1_sha256_write(&sha, buf, 32);
+        secp256k1_fe_get_b32(buf, &pubnonces[i].x);
+        secp256k1_sha256_write(&sha, buf, 32);
+    }
+    secp256k1_sha256_finalize(&sha, seed);
+
+    pts = (secp256k1_ge*)checked_malloc(cb, sizeof(secp256k1_ge) * 2 * n);
+    sc = (secp256k1_scalar*)checked_malloc(cb, sizeof(secp256k1_scalar) * 2 * n);
+    secp256k1_scalar_set_int(&one, 1);
+    secp256k1_scalar_set_int(&sum, 0);
+    for (i = 0; i < n; i++) {
+        overflow = 0;
+        secp256k1_scalar_set_b32(&s, sig64[i] + 32, &overflow);
+        if (overflow) {
+            free(sc);
+            free(pts);
+            return 0;
+        }
+        if (i == 0) {
+            a = one;
+        } else {
+            /* 128 bit randomizer a[i] = SHA256(seed || i) */
+            unsigned char c[4];
+            c[0] = i >> 24; c[1] = i >> 16; c[2] = i >> 8; c[3] = i;
+            secp256k1_sha256_initialize(&sha);
+            secp256k1_sha256_write(&sha, seed, 32);
+            secp256k1_sha256_write(&sha, c, 4);
+            secp256k1_sha256_finalize(&sha, buf);
+            memset(buf, 0, 16);
+            secp256k1_scalar_set_b32(&a, buf, NULL);
+            if (secp256k1_scalar_is_zero(&a)) {
+                a = one;
+            }
+        }
+        secp256k1_scalar_mul(&s, &s, &a);
+        secp256k1_scalar_add(&sum, &sum, &s);
+
+        pts[2 * i] = pubkeys[i];
+        secp256k1_scalar_mul(&sc[2 * i], &a, &h);
+        pts[2 * i + 1] = pubnonces[i];
+        sc[2 * i + 1] = a;
+        if (!fnegate) {
+            secp256k1_scalar_negate(&sc[2 * i + 1], &sc[2 * i + 1]);
+        }
+    }
+
+    /* the first point goes together with the G term, the others are interleaved */
+    secp256k1_gej_set_ge(&Qj, &pts[0]);
+    secp256k1_ecmult(ctx, &Rj, &Qj, &sc[0], &sum);
+    secp256k1_schnorr_ecmult_multi(&Sj, pts + 1, sc + 1, 2 * n - 1, cb);
+    secp256k1_gej_add_var(&Rj, &Rj, &Sj, NULL);
+
+    free(sc);
+    free(pts);
+    return secp256k1_gej_is_infinity(&Rj);
+}
+
 static int secp256k1_schnorr_sig_recover(const secp256k1_ecmult_context* ctx, const unsigned char *sig64, secp256k1_ge *pubkey, secp256k1_schnorr_msghash hash, const unsigned char *msg32) {
     secp256k1_gej Qj, Rj;
     secp256k1_ge Ra;
@@ -70,13 +70,13 @@ void test_schnorr_sign_verify(void) {
 
         secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &pubkeyj[k], &key[k]);
         secp256k1_ge_set_gej_var(&pubkey[k], &pubkeyj[k]);
-        CHECK(secp256k1_schnorr_sig_verify(&ctx->ecmult_ctx, sig64[k], &pubkey[k], &test_schnorr_hash, msg32));
+        CHECK(secp256k1_schnorr_sig_verify(&ctx->ecmult_ctx, sig64[k], &pubkey[k], &test_schnorr_hash, msg32, NULL));
 
         for (i = 0; i < 4; i++) {
             int pos = secp256k1_rand_bits(6);
             int mod = 1 + secp256k1_rand_int(255);
             sig64[k][pos] ^= mod;
-            CHECK(secp256k1_schnorr_sig_verify(&ctx->ecmult_ctx, sig64[k], &pubkey[k], &test_schnorr_hash, msg32) == 0);
+            CHECK(secp256k1_schnorr_sig_verify(&ctx->ecmult_ctx, sig64[k], &pubkey[k], &test_schnorr_hash, msg32, NULL) == 0);
             sig64[k][pos] ^= mod;
         }
     }
@@ -143,6 +143,68 @@ void test_schnorr_threshold(void) {
     CHECK((ret == 0) == (damage == 0));
 }
 
+void test_schnorr_partial_verify_batch(void) {
+    unsigned char msg[32];
+    unsigned char sec[5][32];
+    secp256k1_pubkey pub[5];
+    unsigned char nonce[5][32];
+    secp256k1_pubkey pubnonce[5];
+    unsigned char sig[5][64];
+    const unsigned char* sigs[5];
+    const secp256k1_pubkey* pubs[5];
+    const secp256k1_pubkey* pubnonces[5];
+    secp256k1_pubkey allpubnonce;
+    unsigned char saved[64];
+    int n, i, bad;
+
+    secp256k1_rand256_test(msg);
+    n = 2 + secp256k1_rand_int(4);
+    for (i = 0; i < n; i++) {
+        do {
+            secp256k1_rand256_test(sec[i]);
+        } while (!secp256k1_ec_seckey_verify(ctx, sec[i]));
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pub[i], sec[i]));
+        CHECK(secp256k1_schnorr_generate_nonce_pair(ctx, &pubnonce[i], nonce[i], msg, sec[i], NULL, NULL));
+        pubs[i] = &pub[i];
+        pubnonces[i] = &pubnonce[i];
+    }
+    CHECK(secp256k1_ec_pubkey_combine(ctx, &allpubnonce, pubnonces, n));
+    for (i = 0; i < n; i++) {
+        secp256k1_pubkey othernonces;
+        const secp256k1_pubkey *others[4];
+        int j;
+        for (j = 0; j < i; j++) {
+            others[j] = &pubnonce[j];
+        }
+        for (j = i + 1; j < n; j++) {
+            others[j - 1] = &pubnonce[j];
+        }
+        CHECK(secp256k1_ec_pubkey_combine(ctx, &othernonces, others, n - 1));
+        CHECK(secp256k1_schnorr_partial_sign(ctx, sig[i], msg, sec[i], &othernonces, nonce[i]) == 1);
+        CHECK(secp256k1_schnorr_partial_verify(ctx, sig[i], msg, &pub[i], &othernonces) == 1);
+        sigs[i] = sig[i];
+    }
+    CHECK(secp256k1_schnorr_partial_verify_batch(ctx, sigs, msg, pubs, pubnonces, &allpubnonce, n) == 1);
+    /* every subset verifies against the sum of all nonces */
+    for (i = 0; i < n; i++) {
+        CHECK(secp256k1_schnorr_partial_verify_batch(ctx, sigs + i, msg, pubs + i, pubnonces + i, &allpubnonce, 1) == 1);
+    }
+
+    /* damage the s value of one signature, only that one must be detected */
+    bad = secp256k1_rand_int(n);
+    memcpy(saved, sig[bad], 64);
+    sig[bad][32 + secp256k1_rand_int(32)] ^= 1 + secp256k1_rand_int(255);
+    CHECK(secp256k1_schnorr_partial_verify_batch(ctx, sigs, msg, pubs, pubnonces, &allpubnonce, n) == 0);
+    for (i = 0; i < n; i++) {
+        CHECK(secp256k1_schnorr_partial_verify_batch(ctx, sigs + i, msg, pubs + i, pubnonces + i, &allpubnonce, 1) == (i != bad));
+    }
+
+    /* signatures for a different message must not verify */
+    memcpy(sig[bad], saved, 64);
+    msg[secp256k1_rand_int(32)] ^= 1 + secp256k1_rand_int(255);
+    CHECK(secp256k1_schnorr_partial_verify_batch(ctx, sigs, msg, pubs, pubnonces, &allpubnonce, n) == 0);
+}
+
 void test_schnorr_recovery(void) {
     unsigned char msg32[32];
     unsigned char sig64[64];
@@ -152,7 +214,7 @@ void test_schnorr_recovery(void) {
     secp256k1_rand256_test(sig64);
     secp256k1_rand256_test(sig64 + 32);
     if (secp256k1_schnorr_sig_recover(&ctx->ecmult_ctx, sig64, &Q, &test_schnorr_hash, msg32) == 1) {
-        CHECK(secp256k1_schnorr_sig_verify(&ctx->ecmult_ctx, sig64, &Q, &test_schnorr_hash, msg32) == 1);
+        CHECK(secp256k1_schnorr_sig_verify(&ctx->ecmult_ctx, sig64, &Q, &test_schnorr_hash, msg32, NULL) == 1);
     }
 }
 
@@ -170,6 +232,9 @@ void run_schnorr_tests(void) {
     for (i = 0; i < 10 * count; i++) {
          test_schnorr_threshold();
     }
+    for (i = 0; i < 10 * count; i++) {
+         test_schnorr_partial_verify_batch();
+    }
 }
 
 #endif
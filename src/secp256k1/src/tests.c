@@ -2048,6 +2048,35 @@ void run_ec_combine(void) {
     }
 }
 
+void test_ec_pubkey_negate(void) {
+    secp256k1_scalar s;
+    secp256k1_gej Qj;
+    secp256k1_ge Q;
+    secp256k1_pubkey p, pneg, sum;
+    const secp256k1_pubkey* d[2];
+
+    random_scalar_order_test(&s);
+    secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &Qj, &s);
+    secp256k1_ge_set_gej(&Q, &Qj);
+    secp256k1_pubkey_save(&p, &Q);
+    pneg = p;
+    CHECK(secp256k1_ec_pubkey_negate(ctx, &pneg) == 1);
+    CHECK(memcmp(&p, &pneg, sizeof(p)) != 0);
+    /* P + (-P) is the point at infinity */
+    d[0] = &p;
+    d[1] = &pneg;
+    CHECK(secp256k1_ec_pubkey_combine(ctx, &sum, d, 2) == 0);
+    CHECK(secp256k1_ec_pubkey_negate(ctx, &pneg) == 1);
+    CHECK(memcmp(&p, &pneg, sizeof(p)) == 0);
+}
+
+void run_ec_pubkey_negate(void) {
+    int i;
+    for (i = 0; i < count * 8; i++) {
+         test_ec_pubkey_negate();
+    }
+}
+
 void test_group_decompress(const secp256k1_fe* x) {
     /* The input itself, normalized. */
     secp256k1_fe fex = *x;
@@ -4335,6 +4364,7 @@ int main(int argc, char **argv) {
     run_ecmult_gen_blind();
     run_ecmult_const_tests();
     run_ec_combine();
+    run_ec_pubkey_negate();
 
     /* endomorphism tests */
 #ifdef USE_ENDOMORPHISM
@@ -0,0 +1,177 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "coinsflush.h"
+#include "random.h"
+#include "test/test_bitcoin.h"
+
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace
+{
+/** A base view whose BatchWrite() blocks until it is released */
+class CCoinsViewGateTest : public CCoinsView
+{
+    mutable boost::mutex mutex;
+    boost::condition_variable cond;
+    bool fOpen;
+    bool fFail;
+
+    uint256 hashBestBlock_;
+    std::map<uint256, CCoins> map_;
+
+public:
+    CCoinsViewGateTest() : fOpen(false), fFail(false) {}
+
+    void Open(bool fFailIn = false)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fOpen = true;
+        fFail = fFailIn;
+        cond.notify_all();
+    }
+
+    bool GetCoins(const uint256& txid, CCoins& coins) const
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        std::map<uint256, CCoins>::const_iterator it = map_.find(txid);
+        if (it == map_.end())
+            return false;
+        coins = it->second;
+        return true;
+    }
+
+    bool HaveCoins(const uint256& txid) const
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        return map_.count(txid) > 0;
+    }
+
+    uint256 GetBestBlock() const
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        return hashBestBlock_;
+    }
+
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (!fOpen)
+            cond.wait(lock);
+        if (fFail)
+            return false;
+
+        for (CCoinsMap::const_iterator it = mapCoins.begin(); it != mapCoins.end(); it++) {
+            if (!(it->second.flags & CCoinsCacheEntry::DIRTY))
+                continue;
+            if (it->second.coins.IsPruned())
+                map_.erase(it->first);
+            else
+                map_[it->first] = it->second.coins;
+        }
+        hashBestBlock_ = hashBlock;
+        return true;
+    }
+};
+
+CCoinsMap DirtyCoins(const uint256& txid, int nHeight)
+{
+    CCoinsMap mapCoins;
+    CCoinsCacheEntry& entry = mapCoins[txid];
+    entry.coins.nHeight = nHeight;
+    entry.coins.vout.resize(1);
+    entry.coins.vout[0].nValue = nHeight;
+    entry.flags = CCoinsCacheEntry::DIRTY;
+    return mapCoins;
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(coinsflush_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(coinsflush_background)
+{
+    CCoinsViewGateTest base;
+    CCoinsViewFlusher flusher(&base, true);
+    BOOST_CHECK(flusher.IsBackground());
+
+    uint256 txid = GetRandHash();
+    uint256 hashBlock = GetRandHash();
+    CCoinsMap mapCoins = DirtyCoins(txid, 1);
+
+    // the write is blocked, the frozen generation answers lookups
+    BOOST_CHECK(flusher.BatchWrite(mapCoins, hashBlock));
+    BOOST_CHECK(mapCoins.empty());
+    CCoins coins;
+    BOOST_CHECK(flusher.GetCoins(txid, coins));
+    BOOST_CHECK_EQUAL(coins.nHeight, 1);
+    BOOST_CHECK(flusher.HaveCoins(txid));
+    BOOST_CHECK(flusher.GetBestBlock() == hashBlock);
+    BOOST_CHECK(!base.HaveCoins(txid));
+    BOOST_CHECK(flusher.DynamicMemoryUsage() > 0);
+
+    // once the write has committed, the base has the coins
+    base.Open();
+    BOOST_CHECK(flusher.Sync());
+    BOOST_CHECK(base.GetCoins(txid, coins));
+    BOOST_CHECK_EQUAL(coins.nHeight, 1);
+    BOOST_CHECK(flusher.GetBestBlock() == hashBlock);
+
+    // a spent entry removes the coins from the base
+    mapCoins = DirtyCoins(txid, 1);
+    mapCoins[txid].coins.Clear();
+    BOOST_CHECK(flusher.BatchWrite(mapCoins, GetRandHash()));
+    BOOST_CHECK(flusher.Sync());
+    BOOST_CHECK(!flusher.HaveCoins(txid));
+    BOOST_CHECK(!base.HaveCoins(txid));
+}
+
+BOOST_AUTO_TEST_CASE(coinsflush_failure)
+{
+    CCoinsViewGateTest base;
+    CCoinsViewFlusher flusher(&base, true);
+
+    uint256 txid = GetRandHash();
+    CCoinsMap mapCoins = DirtyCoins(txid, 2);
+    BOOST_CHECK(flusher.BatchWrite(mapCoins, GetRandHash()));
+
+    // the failure is reported later, the unwritten coins stay visible
+    base.Open(true);
+    BOOST_CHECK(!flusher.Sync());
+    CCoins coins;
+    BOOST_CHECK(flusher.GetCoins(txid, coins));
+    BOOST_CHECK_EQUAL(coins.nHeight, 2);
+
+    mapCoins = DirtyCoins(GetRandHash(), 3);
+    BOOST_CHECK(!flusher.BatchWrite(mapCoins, GetRandHash()));
+
+    // once the base accepts writes again, the failed generation is written first
+    base.Open();
+    uint256 txidNext = GetRandHash();
+    mapCoins = DirtyCoins(txidNext, 5);
+    BOOST_CHECK(flusher.BatchWrite(mapCoins, GetRandHash()));
+    BOOST_CHECK(flusher.Sync());
+    BOOST_CHECK(base.GetCoins(txid, coins));
+    BOOST_CHECK_EQUAL(coins.nHeight, 2);
+    BOOST_CHECK(base.HaveCoins(txidNext));
+    BOOST_CHECK_EQUAL(flusher.DynamicMemoryUsage(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(coinsflush_foreground)
+{
+    CCoinsViewGateTest base;
+    CCoinsViewFlusher flusher(&base, false);
+    BOOST_CHECK(!flusher.IsBackground());
+
+    uint256 txid = GetRandHash();
+    CCoinsMap mapCoins = DirtyCoins(txid, 4);
+    base.Open();
+    BOOST_CHECK(flusher.BatchWrite(mapCoins, GetRandHash()));
+    BOOST_CHECK(base.HaveCoins(txid));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,95 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "coinsprefetch.h"
+#include "random.h"
+#include "test/test_bitcoin.h"
+#include "utiltime.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+/** A base view that has coins for every txid, pruned ones if the first byte is odd */
+class CCoinsViewEverything : public CCoinsView
+{
+public:
+    bool GetCoins(const uint256& txid, CCoins& coins) const
+    {
+        coins = CCoins();
+        if (!(*txid.begin() & 1)) {
+            coins.vout.resize(1);
+            coins.vout[0].nValue = 1;
+        }
+        return true;
+    }
+
+    bool HaveCoins(const uint256& txid) const { return !(*txid.begin() & 1); }
+};
+
+std::vector<uint256> RandomTxids(size_t nCount)
+{
+    std::vector<uint256> vTxids(nCount);
+    for (size_t i = 0; i < nCount; i++)
+        vTxids[i] = GetRandHash();
+    return vTxids;
+}
+
+void WaitForFetched(const CCoinsViewPrefetch& prefetch, uint64_t nExpected)
+{
+    uint64_t nRequested, nDropped, nFetched, nHits, nMisses;
+    for (int i = 0; i < 3000; i++) {
+        prefetch.GetPrefetchStats(nRequested, nDropped, nFetched, nHits, nMisses);
+        if (nFetched >= nExpected)
+            return;
+        MilliSleep(10);
+    }
+    BOOST_ERROR("prefetch threads did not catch up");
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(coinsprefetch_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(coinsprefetch_limits)
+{
+    CCoinsViewEverything base;
+    CCoinsViewPrefetch prefetch(&base, 2);
+    uint64_t nRequested, nDropped, nFetched, nHits, nMisses;
+
+    // requests beyond the queue limit are dropped
+    prefetch.Prefetch(RandomTxids(MAX_PREFETCH_QUEUE + 100));
+    prefetch.GetPrefetchStats(nRequested, nDropped, nFetched, nHits, nMisses);
+    BOOST_CHECK_EQUAL(nRequested, MAX_PREFETCH_QUEUE);
+    BOOST_CHECK_EQUAL(nDropped, 100U);
+    WaitForFetched(prefetch, MAX_PREFETCH_QUEUE);
+    BOOST_CHECK(prefetch.DynamicMemoryUsage() > 0);
+
+    // once full, the oldest coins make room for new ones
+    uint64_t nTotal = MAX_PREFETCH_QUEUE;
+    while (nTotal < MAX_PREFETCH_COINS) {
+        prefetch.Prefetch(RandomTxids(MAX_PREFETCH_QUEUE));
+        nTotal += MAX_PREFETCH_QUEUE;
+        WaitForFetched(prefetch, nTotal);
+    }
+    std::vector<uint256> vTxids = RandomTxids(100);
+    prefetch.Prefetch(vTxids);
+    WaitForFetched(prefetch, nTotal + vTxids.size());
+
+    size_t nUsage = prefetch.DynamicMemoryUsage();
+    CCoins coins;
+    BOOST_FOREACH(const uint256& txid, vTxids) {
+        BOOST_CHECK_EQUAL(prefetch.HaveCoins(txid), !(*txid.begin() & 1));
+        BOOST_CHECK(prefetch.GetCoins(txid, coins));
+    }
+    prefetch.GetPrefetchStats(nRequested, nDropped, nFetched, nHits, nMisses);
+    BOOST_CHECK_EQUAL(nHits, vTxids.size());
+    BOOST_CHECK(prefetch.DynamicMemoryUsage() < nUsage);
+
+    // a write drops everything
+    CCoinsMap mapCoins;
+    prefetch.BatchWrite(mapCoins, uint256());
+    BOOST_CHECK_EQUAL(prefetch.DynamicMemoryUsage(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,360 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "fasito/fasito.h"
+#include "random.h"
+#include "util.h"
+#include "utilstrencodings.h"
+
+#include "test/test_bitcoin.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+/**
+ * Simulates a Fasito on a pseudo terminal. CFasito opens the slave side like
+ * a real device, the simulator answers the commands on the master side.
+ */
+class CFasitoSimulator
+{
+private:
+    int fdMaster;
+    int fdSlave;
+    string strBuffer;
+    boost::thread thread;
+
+    void Respond(const string& strLine)
+    {
+        string strOut = strLine + "\r\n";
+        if (write(fdMaster, strOut.c_str(), strOut.size()) != (ssize_t)strOut.size())
+            throw std::runtime_error("could not write to pseudo terminal");
+    }
+
+    void Execute(const string& strCommand)
+    {
+        if (strCommand.empty())
+            return;
+
+        if (nDelayMillis)
+            MilliSleep(nDelayMillis);
+
+        vector<string> vArgs;
+        boost::split(vArgs, strCommand, boost::is_any_of(" "));
+
+        if (vArgs[0] == "INFO") {
+            Respond(strprintf("%-18s: %s", "Fasito version", "1.0-sim"));
+            Respond(strprintf("%-18s: %s", "Serial number", "012345678999"));
+            Respond(strprintf("%-18s: %s", "Token status", "CONFIGURED"));
+            Respond(strprintf("%-18s: %s", "Protection status", "0x01100010"));
+            Respond(strprintf("%-18s: %s", "Config version", "1"));
+            Respond(strprintf("%-18s: %s", "Config checksum", "1234"));
+            Respond(strprintf("%-18s: %s", "Nonce pool size", "100"));
+            Respond("");
+            Respond(strprintf("%-18s: %s", "User PIN", "SET (tries left: 3)"));
+            Respond("");
+            Respond(strprintf("%-18s: %s", "Key #0", "0x70000001 (CONFIGURED)"));
+            Respond(strprintf("%-18s: %s", "Key #1", "0x00000000 (SEEDED)"));
+        } else if (vArgs[0] == "NONCE" && vArgs.size() == 4) {
+            const int nHandle = nNextHandle++ % 100;
+            Respond(strprintf("%02d %s", nHandle, HexStr(vector<unsigned char>(64, (unsigned char)(nHandle + 1)))));
+        } else if (vArgs[0] == "ECHO" && vArgs.size() == 2) {
+            Respond(vArgs[1]);
+        } else if (vArgs[0] == "LATE" && vArgs.size() == 3) {
+            MilliSleep(atoi(vArgs[1].c_str()));
+            Respond(vArgs[2]);
+        } else if (vArgs[0] == "HANG") {
+            return;
+        } else if (vArgs[0] != "LOGOUT" && vArgs[0] != "CLRPOOL") {
+            Respond("ERROR unknown command");
+            return;
+        }
+
+        Respond("OK");
+    }
+
+    /* read everything that is available, returns the number of complete commands received */
+    size_t Receive(const int nTimeout)
+    {
+        struct pollfd pfd;
+        pfd.fd = fdMaster;
+        pfd.events = POLLIN;
+
+        char buf[256];
+        while (poll(&pfd, 1, nTimeout) > 0 && (pfd.revents & POLLIN)) {
+            ssize_t n = read(fdMaster, buf, sizeof(buf));
+            if (n <= 0)
+                break;
+            strBuffer.append(buf, n);
+            if (nTimeout)
+                break;
+        }
+
+        return std::count(strBuffer.begin(), strBuffer.end(), '\r');
+    }
+
+    void Run()
+    {
+        while (!boost::this_thread::interruption_requested()) {
+            size_t nPending = Receive(20);
+
+            while (nPending > 0) {
+                {
+                    boost::unique_lock<boost::mutex> lock(cs);
+                    nMaxPending = std::max(nMaxPending, nPending);
+                }
+
+                size_t nEnd = strBuffer.find('\r');
+                string strCommand = strBuffer.substr(0, nEnd);
+                strBuffer.erase(0, nEnd + 1);
+
+                Execute(strCommand);
+                nPending = Receive(0);
+            }
+        }
+    }
+
+public:
+    string strDevice;
+    boost::mutex cs;
+    size_t nMaxPending;
+    int nDelayMillis;
+    int nNextHandle;
+
+    CFasitoSimulator() : nMaxPending(0), nDelayMillis(0), nNextHandle(0)
+    {
+        fdMaster = posix_openpt(O_RDWR | O_NOCTTY);
+        BOOST_REQUIRE(fdMaster >= 0);
+        BOOST_REQUIRE(grantpt(fdMaster) == 0 && unlockpt(fdMaster) == 0);
+        strDevice = ptsname(fdMaster);
+
+        // keep the slave side open, the master would see a hang up whenever CFasito closes it
+        fdSlave = open(strDevice.c_str(), O_RDWR | O_NOCTTY);
+        BOOST_REQUIRE(fdSlave >= 0);
+
+        thread = boost::thread(boost::bind(&CFasitoSimulator::Run, this));
+    }
+
+    ~CFasitoSimulator()
+    {
+        thread.interrupt();
+        thread.join();
+        close(fdSlave);
+        close(fdMaster);
+    }
+};
+
+/** Collects the completed requests of the Fasito queue */
+class CFasitoRequestCollector
+{
+public:
+    boost::mutex cs;
+    boost::condition_variable cond;
+    vector<CFasitoRequest> vCompleted;
+
+    void Completed(const CFasitoRequest& request)
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        vCompleted.push_back(request);
+        cond.notify_all();
+    }
+
+    bool WaitFor(const size_t nRequests)
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        const boost::system_time timeout = boost::get_system_time() + boost::posix_time::seconds(20);
+        while (vCompleted.size() < nRequests) {
+            if (!cond.timed_wait(lock, timeout))
+                return false;
+        }
+        return true;
+    }
+
+    CFasitoCallback Callback()
+    {
+        return boost::bind(&CFasitoRequestCollector::Completed, this, _1);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(fasito_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(fasito_open)
+{
+    CFasitoSimulator sim;
+    CFasito token;
+
+    token.open(sim.strDevice);
+    BOOST_CHECK(token.fInitialized);
+    BOOST_CHECK_EQUAL(token.strSerialNumber, "012345678999");
+    BOOST_CHECK_EQUAL(token.strTokenStatus, "CONFIGURED");
+    BOOST_CHECK_EQUAL(token.nNoncePoolSize, 100U);
+    BOOST_CHECK_EQUAL(token.mapKeys.size(), 2U);
+    BOOST_CHECK_EQUAL(token.mapKeys[0].nCvnId, 0x70000001U);
+    BOOST_CHECK(token.mapKeys[0].status == CONFIGURED);
+    BOOST_CHECK(token.mapKeys[1].status == SEEDED);
+
+    token.close();
+    BOOST_CHECK(!token.fInitialized);
+    BOOST_CHECK_EQUAL(token.SubmitCommand("ECHO closed", CFasitoCallback()), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(fasito_queue_pipelined)
+{
+    CFasitoSimulator sim;
+    CFasito token;
+    CFasitoRequestCollector collector;
+
+    mapArgs["-fasitopipeline"] = "4";
+    token.open(sim.strDevice);
+    token.setTimeout(boost::posix_time::seconds(FASITO_TIMEOUT));
+    sim.nDelayMillis = 10;
+
+    vector<uint64_t> vIds;
+    for (int i = 0; i < 16; i++)
+        vIds.push_back(token.SubmitCommand(strprintf("ECHO %d", i), collector.Callback()));
+
+    BOOST_REQUIRE(collector.WaitFor(16));
+    for (int i = 0; i < 16; i++) {
+        const CFasitoRequest& request = collector.vCompleted[i];
+        BOOST_CHECK(request.fSuccess);
+        BOOST_CHECK_EQUAL(request.nId, vIds[i]);
+        BOOST_CHECK(i == 0 || vIds[i] > vIds[i - 1]);
+        BOOST_REQUIRE_EQUAL(request.vLines.size(), 2U);
+        BOOST_CHECK_EQUAL(request.vLines[0], strprintf("%d", i));
+    }
+
+    // more than one command was on its way to the simulator
+    boost::unique_lock<boost::mutex> lock(sim.cs);
+    BOOST_CHECK(sim.nMaxPending > 1);
+    BOOST_CHECK(sim.nMaxPending <= 4);
+    lock.unlock();
+
+    mapArgs.erase("-fasitopipeline");
+    token.close();
+}
+
+BOOST_AUTO_TEST_CASE(fasito_queue_errors)
+{
+    CFasitoSimulator sim;
+    CFasito token;
+    CFasitoRequestCollector collector;
+
+    token.open(sim.strDevice);
+    token.setTimeout(boost::posix_time::millisec(300));
+
+    // a failed command does not affect the commands that follow
+    token.SubmitCommand("ECHO a", collector.Callback());
+    token.SubmitCommand("BOGUS", collector.Callback());
+    token.SubmitCommand("ECHO b", collector.Callback());
+    BOOST_REQUIRE(collector.WaitFor(3));
+    BOOST_CHECK(collector.vCompleted[0].fSuccess);
+    BOOST_CHECK(!collector.vCompleted[1].fSuccess);
+    BOOST_CHECK_EQUAL(collector.vCompleted[1].strError, "ERROR unknown command");
+    BOOST_CHECK(collector.vCompleted[2].fSuccess);
+    BOOST_CHECK_EQUAL(collector.vCompleted[2].vLines[0], "b");
+
+    // the queue recovers from a response that never arrives
+    token.SubmitCommand("HANG", collector.Callback());
+    BOOST_REQUIRE(collector.WaitFor(4));
+    BOOST_CHECK(!collector.vCompleted[3].fSuccess);
+
+    token.SubmitCommand("ECHO c", collector.Callback());
+    BOOST_REQUIRE(collector.WaitFor(5));
+    BOOST_CHECK(collector.vCompleted[4].fSuccess);
+    BOOST_CHECK_EQUAL(collector.vCompleted[4].vLines[0], "c");
+
+    token.close();
+}
+
+BOOST_AUTO_TEST_CASE(fasito_queue_late_response)
+{
+    CFasitoSimulator sim;
+    CFasito token;
+    CFasitoRequestCollector collector;
+
+    token.open(sim.strDevice);
+    token.setTimeout(boost::posix_time::millisec(300));
+
+    // the response arrives after the timeout, the rest of its batch fails
+    token.SubmitCommand("LATE 500 a", collector.Callback());
+    token.SubmitCommand("ECHO b", collector.Callback());
+    BOOST_REQUIRE(collector.WaitFor(2));
+    BOOST_CHECK(!collector.vCompleted[0].fSuccess);
+    BOOST_CHECK(!collector.vCompleted[1].fSuccess);
+
+    // the late answers are not taken for the answers of the next commands
+    token.SubmitCommand("ECHO c", collector.Callback());
+    BOOST_REQUIRE(collector.WaitFor(3));
+    BOOST_CHECK(collector.vCompleted[2].fSuccess);
+    BOOST_CHECK_EQUAL(collector.vCompleted[2].vLines[0], "c");
+
+    token.SubmitCommand("LATE 500 x", collector.Callback());
+    BOOST_REQUIRE(collector.WaitFor(4));
+    BOOST_CHECK(!collector.vCompleted[3].fSuccess);
+
+    vector<string> vLines;
+    BOOST_CHECK(token.sendAndReceive("ECHO d", vLines));
+    BOOST_REQUIRE(!vLines.empty());
+    BOOST_CHECK_EQUAL(vLines[0], "d");
+
+    token.close();
+}
+
+BOOST_AUTO_TEST_CASE(fasito_queue_nonce)
+{
+    CFasitoSimulator sim;
+    CFasito token;
+    CFasitoRequestCollector collector;
+
+    token.open(sim.strDevice);
+    token.setTimeout(boost::posix_time::seconds(FASITO_TIMEOUT));
+
+    for (int i = 0; i < 3; i++)
+        token.SubmitCommand(GetFasitoNonceCommand(GetRandHash(), 0), collector.Callback());
+
+    BOOST_REQUIRE(collector.WaitFor(3));
+    for (int i = 0; i < 3; i++) {
+        uint8_t nHandle;
+        CSchnorrNonce nonce;
+        BOOST_CHECK(ParseFasitoNonce(collector.vCompleted[i].vLines, nHandle, nonce));
+        BOOST_CHECK_EQUAL(nHandle, i);
+        BOOST_CHECK_EQUAL(nonce.begin()[0], i + 1);
+    }
+
+    vector<string> vInvalid(1, "00 0102");
+    uint8_t nHandle;
+    CSchnorrNonce nonce;
+    BOOST_CHECK(!ParseFasitoNonce(vInvalid, nHandle, nonce));
+
+    token.close();
+}
+
+BOOST_AUTO_TEST_CASE(fasito_queue_close)
+{
+    CFasitoSimulator sim;
+    CFasito token;
+    CFasitoRequestCollector collector;
+
+    token.open(sim.strDevice);
+    token.setTimeout(boost::posix_time::seconds(FASITO_TIMEOUT));
+    sim.nDelayMillis = 50;
+
+    for (int i = 0; i < 20; i++)
+        BOOST_CHECK(token.SubmitCommand(strprintf("ECHO %d", i), collector.Callback()) != 0);
+
+    // every request gets its callback, the ones still queued fail
+    token.close();
+    BOOST_REQUIRE(collector.WaitFor(20));
+    BOOST_CHECK(!collector.vCompleted.back().fSuccess);
+    BOOST_CHECK_EQUAL(collector.vCompleted.back().strError, "Fasito closed");
+    BOOST_CHECK_EQUAL(token.GetQueueSize(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
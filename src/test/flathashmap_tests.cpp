@@ -0,0 +1,118 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "flathashmap.h"
+#include "random.h"
+#include "test/test_bitcoin.h"
+
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+/** A poor hash, so that probe sequences collide and run through tombstones */
+class CCollidingHasher
+{
+public:
+    size_t operator()(uint32_t n) const { return n % 97; }
+};
+
+typedef CFlatHashMap<uint32_t, uint64_t, CCollidingHasher> CTestMap;
+
+void CheckEqual(const CTestMap& map, const std::map<uint32_t, uint64_t>& real)
+{
+    BOOST_CHECK_EQUAL(map.size(), real.size());
+    BOOST_CHECK_EQUAL(map.empty(), real.empty());
+
+    size_t nCount = 0;
+    for (CTestMap::const_iterator it = map.begin(); it != map.end(); it++) {
+        std::map<uint32_t, uint64_t>::const_iterator itReal = real.find(it->first);
+        BOOST_CHECK(itReal != real.end() && itReal->second == it->second);
+        nCount++;
+    }
+    BOOST_CHECK_EQUAL(nCount, real.size());
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(flathashmap_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(flathashmap_random)
+{
+    for (int nRun = 0; nRun < 8; nRun++) {
+        CTestMap map;
+        std::map<uint32_t, uint64_t> real;
+
+        for (int i = 0; i < 20000; i++) {
+            uint32_t nKey = insecure_rand() % 2000;
+            uint64_t nValue = insecure_rand();
+            switch (insecure_rand() % 6) {
+            case 0:
+            case 1:
+                map[nKey] = nValue;
+                real[nKey] = nValue;
+                break;
+            case 2: {
+                std::pair<CTestMap::iterator, bool> ret = map.insert(std::make_pair(nKey, nValue));
+                BOOST_CHECK_EQUAL(ret.second, real.insert(std::make_pair(nKey, nValue)).second);
+                BOOST_CHECK_EQUAL(ret.first->second, real[nKey]);
+                break;
+            }
+            case 3:
+                BOOST_CHECK_EQUAL(map.erase(nKey), real.erase(nKey));
+                break;
+            case 4: {
+                CTestMap::iterator it = map.find(nKey);
+                BOOST_CHECK_EQUAL(it != map.end(), real.count(nKey) > 0);
+                if (it != map.end()) {
+                    BOOST_CHECK_EQUAL(it->second, real[nKey]);
+                    real.erase(nKey);
+                    map.erase(it);
+                }
+                break;
+            }
+            case 5:
+                BOOST_CHECK_EQUAL(map.count(nKey), real.count(nKey));
+                break;
+            }
+        }
+        CheckEqual(map, real);
+
+        CTestMap copy(map);
+        CheckEqual(copy, real);
+
+        // erase while iterating, as CCoinsViewCache::BatchWrite does
+        for (CTestMap::iterator it = map.begin(); it != map.end(); ) {
+            if (it->first % 2) {
+                real.erase(it->first);
+                map.erase(it++);
+            } else {
+                it++;
+            }
+        }
+        CheckEqual(map, real);
+
+        map.swap(copy);
+        BOOST_CHECK_EQUAL(map.size() >= copy.size(), true);
+        map.clear();
+        BOOST_CHECK(map.empty());
+        BOOST_CHECK(map.begin() == map.end());
+        BOOST_CHECK_EQUAL(map.slot_bytes(), 0U);
+        BOOST_CHECK_EQUAL(map.chunk_count(), 0U);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(flathashmap_stable_elements)
+{
+    // CCoinsModifier keeps a pointer into the cache while others are added
+    CTestMap map;
+    uint64_t* pvalue = &map[12345];
+    *pvalue = 42;
+    for (uint32_t n = 0; n < 10000; n++)
+        map[n] = n;
+    BOOST_CHECK(&map[12345] == pvalue);
+    BOOST_CHECK_EQUAL(*pvalue, 42U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "poc.h"
+#include "primitives/cvn.h"
+#include "random.h"
+#include "serialize.h"
+#include "streams.h"
+#include "version.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+static CSchnorrNonce RandomNonce()
+{
+    CSchnorrNonce nonce;
+    GetRandBytes(nonce.begin(), nonce.size());
+    return nonce;
+}
+
+static CNoncePool RandomPool(const uint32_t nCvnId, const size_t nSize)
+{
+    CNoncePool pool;
+    pool.nCvnId        = nCvnId;
+    pool.hashRootBlock = GetRandHash();
+    pool.nCreationTime = 1500000000;
+    GetRandBytes(pool.msgSig.begin(), pool.msgSig.size());
+
+    for (size_t i = 0; i < nSize; i++)
+        pool.vPublicNonces.push_back(RandomNonce());
+
+    return pool;
+}
+
+/* drops the first nUsed nonces of prevPool and appends new ones, like a refill does */
+static CNoncePool RefillPool(const CNoncePool& prevPool, const size_t nUsed)
+{
+    CNoncePool pool = RandomPool(prevPool.nCvnId, 0);
+    pool.nCreationTime = prevPool.nCreationTime + 180;
+    pool.vPublicNonces.assign(prevPool.vPublicNonces.begin() + nUsed, prevPool.vPublicNonces.end());
+
+    for (size_t i = 0; i < nUsed; i++)
+        pool.vPublicNonces.push_back(RandomNonce());
+
+    return pool;
+}
+
+BOOST_FIXTURE_TEST_SUITE(noncepool_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(noncepool_delta_roundtrip)
+{
+    const CNoncePool prevPool = RandomPool(0x70000001, 100);
+    const CNoncePool pool = RefillPool(prevPool, 7);
+
+    CNoncePoolDelta delta;
+    BOOST_REQUIRE(delta.Create(prevPool, pool));
+    BOOST_CHECK_EQUAL(delta.nSkip, 7);
+    BOOST_CHECK_EQUAL(delta.vAppendedNonces.size(), 7U);
+    BOOST_CHECK(delta.hashPrevPool == prevPool.GetHash());
+    BOOST_CHECK(delta.hashPool == pool.GetHash());
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << delta;
+    const size_t nDeltaSize = ss.size();
+
+    CNoncePoolDelta deltaIn;
+    ss >> deltaIn;
+
+    CNoncePool poolOut;
+    BOOST_REQUIRE(deltaIn.Apply(prevPool, poolOut));
+    BOOST_CHECK(poolOut.GetHash() == pool.GetHash());
+    BOOST_CHECK(poolOut.msgSig == pool.msgSig);
+    BOOST_CHECK(poolOut.vPublicNonces == pool.vPublicNonces);
+
+    // a refill of 7 nonces is a fraction of the full pool on the wire
+    BOOST_CHECK(nDeltaSize * 5 < GetSerializeSize(pool, SER_NETWORK, PROTOCOL_VERSION));
+}
+
+BOOST_AUTO_TEST_CASE(noncepool_delta_mismatch)
+{
+    const CNoncePool prevPool = RandomPool(0x70000001, 20);
+    const CNoncePool pool = RefillPool(prevPool, 3);
+
+    CNoncePoolDelta delta;
+
+    // an unrelated pool or one of another CVN is not a continuation
+    BOOST_CHECK(!delta.Create(prevPool, RandomPool(0x70000001, 20)));
+    BOOST_CHECK(delta.IsNull());
+    BOOST_CHECK(!delta.Create(RandomPool(0x70000002, 20), pool));
+
+    // the kept nonces have to match exactly
+    CNoncePool poolChanged = pool;
+    poolChanged.vPublicNonces[5] = RandomNonce();
+    BOOST_CHECK(!delta.Create(prevPool, poolChanged));
+
+    BOOST_REQUIRE(delta.Create(prevPool, pool));
+
+    // the receiver does not have the pool the delta is based on
+    CNoncePool poolOut;
+    BOOST_CHECK(!delta.AppliesTo(RefillPool(prevPool, 1)));
+    BOOST_CHECK(!delta.Apply(RefillPool(prevPool, 1), poolOut));
+    BOOST_CHECK(!delta.AppliesTo(pool));
+    BOOST_CHECK(!delta.Apply(pool, poolOut));
+
+    // a manipulated delta is based on the pool but does not result in the announced pool
+    CNoncePoolDelta deltaBad = delta;
+    deltaBad.vAppendedNonces[0] = RandomNonce();
+    BOOST_CHECK(deltaBad.AppliesTo(prevPool));
+    BOOST_CHECK(!deltaBad.Apply(prevPool, poolOut));
+
+    deltaBad = delta;
+    deltaBad.nSkip = 21;
+    BOOST_CHECK(deltaBad.AppliesTo(prevPool));
+    BOOST_CHECK(!deltaBad.Apply(prevPool, poolOut));
+
+    // deltas of a newer version are not understood
+    deltaBad = delta;
+    deltaBad.nVersion = CNoncePoolDelta::CURRENT_VERSION + 1;
+    BOOST_CHECK(!deltaBad.AppliesTo(prevPool));
+    BOOST_CHECK(!deltaBad.Apply(prevPool, poolOut));
+
+    BOOST_CHECK(delta.Apply(prevPool, poolOut));
+}
+
+BOOST_AUTO_TEST_CASE(noncepool_delta_outdated)
+{
+    const CNoncePool prevPool = RandomPool(0x70000003, 20);
+    const CNoncePool pool = RefillPool(prevPool, 3);
+    const CNoncePool nextPool = RefillPool(pool, 2);
+
+    CNoncePoolDelta deltaOld, deltaNext;
+    BOOST_REQUIRE(deltaOld.Create(prevPool, pool));
+    BOOST_REQUIRE(deltaNext.Create(pool, nextPool));
+
+    // without a pool of the CVN any delta is news
+    BOOST_CHECK(IsNewerNoncePool(deltaOld));
+
+    {
+        LOCK(cs_mapNoncePool);
+        mapNoncePool[pool.nCvnId] = pool;
+    }
+
+    // a replayed delta for the pool we hold, or an older one, must not trigger a full request
+    BOOST_CHECK(!IsNewerNoncePool(deltaOld));
+    BOOST_CHECK(IsNewerNoncePool(deltaNext));
+
+    LOCK(cs_mapNoncePool);
+    mapNoncePool.erase(pool.nCvnId);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,114 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "poc.h"
+#include "random.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace boost::filesystem;
+
+#ifdef USE_CVN
+namespace
+{
+template<typename T>
+T RandomStorage(size_t nSize)
+{
+    std::vector<unsigned char> vch(nSize);
+    GetRandBytes(&vch[0], nSize);
+    return T(vch);
+}
+
+CNoncePool RandomPool(uint32_t nCvnId, size_t nSize, vector<CSchnorrPrivNonce>& vPrivateNonces)
+{
+    CNoncePool pool;
+    pool.nCvnId        = nCvnId;
+    pool.nCreationTime = 1500000000;
+    pool.hashRootBlock = GetRandHash();
+    vPrivateNonces.clear();
+    for (size_t i = 0; i < nSize; i++) {
+        pool.vPublicNonces.push_back(RandomStorage<CSchnorrNonce>(64));
+        vPrivateNonces.push_back(RandomStorage<CSchnorrPrivNonce>(32));
+    }
+    return pool;
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(noncering_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(noncering_write_read)
+{
+    const uint32_t nCvnNodeIdOld = nCvnNodeId;
+    nCvnNodeId = 0x12345678;
+    path ph = temp_directory_path() / unique_path();
+
+    CNonceRingFile ring;
+    ring.SetPath(ph);
+
+    vector<CSchnorrPrivNonce> vPrivateNonces, vPrivateNoncesRead;
+    vector<uint8_t> vNonceHandles;
+    CNoncePool pool = RandomPool(nCvnNodeId, 20, vPrivateNonces), poolRead;
+    BOOST_CHECK(ring.Write(pool, vPrivateNonces, vNonceHandles));
+
+    // a refill keeps the remaining nonces and appends new ones
+    vector<CSchnorrPrivNonce> vPrivateNoncesNew;
+    CNoncePool poolNew = RandomPool(nCvnNodeId, 5, vPrivateNoncesNew);
+    pool.vPublicNonces.erase(pool.vPublicNonces.begin(), pool.vPublicNonces.begin() + 5);
+    pool.vPublicNonces.insert(pool.vPublicNonces.end(), poolNew.vPublicNonces.begin(), poolNew.vPublicNonces.end());
+    vPrivateNonces.erase(vPrivateNonces.begin(), vPrivateNonces.begin() + 5);
+    vPrivateNonces.insert(vPrivateNonces.end(), vPrivateNoncesNew.begin(), vPrivateNoncesNew.end());
+    BOOST_CHECK(ring.Write(pool, vPrivateNonces, vNonceHandles));
+
+    CNonceRingFile ringReopened;
+    ringReopened.SetPath(ph);
+    BOOST_CHECK(ringReopened.Read(poolRead, vPrivateNoncesRead, vNonceHandles));
+    BOOST_CHECK(poolRead.GetHash() == pool.GetHash());
+    BOOST_CHECK(vPrivateNoncesRead == vPrivateNonces);
+
+    remove(ph);
+    nCvnNodeId = nCvnNodeIdOld;
+}
+
+BOOST_AUTO_TEST_CASE(noncering_other_cvn)
+{
+    const uint32_t nCvnNodeIdOld = nCvnNodeId;
+    nCvnNodeId = 0x12345678;
+    path ph = temp_directory_path() / unique_path();
+
+    vector<CSchnorrPrivNonce> vPrivateNonces, vPrivateNoncesRead;
+    vector<uint8_t> vNonceHandles;
+    CNoncePool pool = RandomPool(nCvnNodeId, 10, vPrivateNonces), poolRead;
+    {
+        CNonceRingFile ring;
+        ring.SetPath(ph);
+        BOOST_CHECK(ring.Write(pool, vPrivateNonces, vNonceHandles));
+    }
+
+    // the private nonces of another CVN are neither read nor overwritten
+    nCvnNodeId = 0x87654321;
+    {
+        CNonceRingFile ring;
+        ring.SetPath(ph);
+        BOOST_CHECK(!ring.Read(poolRead, vPrivateNoncesRead, vNonceHandles));
+        CNoncePool poolOther = RandomPool(nCvnNodeId, 10, vPrivateNoncesRead);
+        BOOST_CHECK(!ring.Write(poolOther, vPrivateNoncesRead, vNonceHandles));
+    }
+
+    nCvnNodeId = 0x12345678;
+    {
+        CNonceRingFile ring;
+        ring.SetPath(ph);
+        BOOST_CHECK(ring.Read(poolRead, vPrivateNoncesRead, vNonceHandles));
+        BOOST_CHECK(poolRead.GetHash() == pool.GetHash());
+        BOOST_CHECK(vPrivateNoncesRead == vPrivateNonces);
+    }
+
+    remove(ph);
+    nCvnNodeId = nCvnNodeIdOld;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif // USE_CVN
@@ -0,0 +1,131 @@
+// Copyright (c) 2017 The FairCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilemap.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "clientversion.h"
+#include "main.h"
+#include "random.h"
+#include "streams.h"
+#include "util.h"
+#include "test/test_bitcoin.h"
+
+#include <cstdio>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+/** Stores blocks in the block files of a temporary data directory */
+struct RawBlockSetup : public BasicTestingSetup
+{
+    boost::filesystem::path pathTemp;
+
+    RawBlockSetup()
+    {
+        pathTemp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::create_directories(pathTemp);
+        mapArgs["-datadir"] = pathTemp.string();
+        ClearDatadirCache();
+    }
+
+    ~RawBlockSetup()
+    {
+        blockFileMapCache.SetMaxFiles(0);
+        blockFileMapCache.Clear();
+        mapArgs.erase("-datadir");
+        ClearDatadirCache();
+        boost::filesystem::remove_all(pathTemp);
+    }
+};
+
+void WriteBlock(const CBlock& block, const CDiskBlockPos& posIn, CBlockIndex& index, uint256& hash)
+{
+    CDiskBlockPos pos = posIn;
+    BOOST_REQUIRE(WriteBlockToDisk(block, pos, Params().MessageStart()));
+
+    hash = block.GetHash();
+    index.phashBlock = &hash;
+    index.nFile = pos.nFile;
+    index.nDataPos = pos.nPos;
+    index.nStatus |= BLOCK_HAVE_DATA;
+}
+
+/** The raw bytes must be what serializing the decoded block gives */
+void CheckRawBlock(const CBlockIndex& index)
+{
+    CBlock block;
+    BOOST_REQUIRE(ReadBlockFromDisk(block, &index, Params().GetConsensus()));
+    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+    ssBlock << block;
+
+    CRawBlock raw;
+    BOOST_REQUIRE(ReadRawBlockFromDisk(raw, &index));
+    BOOST_CHECK_EQUAL(raw.size(), ssBlock.size());
+    BOOST_CHECK(std::equal(raw.begin(), raw.end(), ssBlock.begin()));
+
+    CDataStream ssRaw(SER_NETWORK, PROTOCOL_VERSION);
+    ssRaw << raw;
+    BOOST_CHECK(ssRaw.str() == ssBlock.str());
+}
+
+void CorruptHeader(const CBlockIndex& index)
+{
+    FILE* file = OpenBlockFile(index.GetBlockPos());
+    BOOST_REQUIRE(file);
+    int ch = fgetc(file);
+    fseek(file, index.nDataPos, SEEK_SET);
+    fputc(ch ^ 0x01, file);
+    fclose(file);
+    blockFileMapCache.Erase(index.nFile);
+}
+
+void TestRawBlock(size_t nMapFiles)
+{
+    blockFileMapCache.SetMaxFiles(nMapFiles);
+
+    // a second block behind the first is found at its offset as well
+    const CBlock& genesis = Params().GenesisBlock();
+    CBlock block = genesis;
+    block.nTime++;
+    block.vtx.push_back(block.vtx[0]);
+
+    CBlockIndex indexGenesis, index;
+    uint256 hashGenesis, hash;
+    WriteBlock(genesis, CDiskBlockPos(0, 0), indexGenesis, hashGenesis);
+    const unsigned int nNext = indexGenesis.nDataPos + ::GetSerializeSize(genesis, SER_DISK, CLIENT_VERSION);
+    WriteBlock(block, CDiskBlockPos(0, nNext), index, hash);
+
+    uint64_t nHits, nMaps, nHitsBefore, nMapsBefore;
+    blockFileMapCache.GetStats(nHitsBefore, nMapsBefore);
+    CheckRawBlock(indexGenesis);
+    CheckRawBlock(index);
+    blockFileMapCache.GetStats(nHits, nMaps);
+    BOOST_CHECK_EQUAL(nHits + nMaps > nHitsBefore + nMapsBefore, nMapFiles > 0);
+
+    // a block whose header does not hash to the index entry is rejected
+    CorruptHeader(index);
+    CRawBlock raw;
+    BOOST_CHECK(!ReadRawBlockFromDisk(raw, &index));
+    CBlock blockRead;
+    BOOST_CHECK(!ReadBlockFromDisk(blockRead, &index, Params().GetConsensus()));
+    CheckRawBlock(indexGenesis);
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(rawblock_tests, RawBlockSetup)
+
+BOOST_AUTO_TEST_CASE(rawblock_file)
+{
+    TestRawBlock(0);
+}
+
+BOOST_AUTO_TEST_CASE(rawblock_mapped)
+{
+    TestRawBlock(1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "clientversion.h"
 #include "streams.h"
 #include "support/allocators/zeroafterfree.h"
 #include "test/test_bitcoin.h"
@@ -64,4 +65,26 @@ BOOST_AUTO_TEST_CASE(streams_serializedata_xor)
             std::string(ds.begin(), ds.end()));  
 }         
 
+BOOST_AUTO_TEST_CASE(streams_buffer_reader)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    std::vector<unsigned char> vch(3, 0x42);
+    ss << (uint32_t)0x01020304 << vch;
+
+    CBufferReader reader(&ss[0], &ss[0] + ss.size(), SER_DISK, CLIENT_VERSION);
+    uint32_t n;
+    std::vector<unsigned char> vchRead;
+    reader >> n >> vchRead;
+    BOOST_CHECK_EQUAL(n, 0x01020304U);
+    BOOST_CHECK(vchRead == vch);
+    BOOST_CHECK(reader.empty());
+
+    // reading past the end of the range fails and does not advance
+    CBufferReader readerShort(&ss[0], &ss[0] + 2, SER_DISK, CLIENT_VERSION);
+    BOOST_CHECK_THROW(readerShort >> n, std::ios_base::failure);
+    BOOST_CHECK_EQUAL(readerShort.size(), 2U);
+    readerShort.ignore(2);
+    BOOST_CHECK(readerShort.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -9,6 +9,7 @@
 #include "chainparams.h"
 #include "hash.h"
 #include "main.h"
+#include "poc.h"
 #include "uint256.h"
 
 #include <stdint.h>
@@ -21,8 +22,11 @@ static const char DB_COINS = 'c';
 static const char DB_BLOCK_FILES = 'f';
 static const char DB_TXINDEX = 't';
 static const char DB_BLOCK_INDEX = 'b';
+static const char DB_CVN_STATE = 'p';
+static const char DB_CVN_ADMISSION = 'a';
 
 static const char DB_BEST_BLOCK = 'B';
+static const char DB_CVN_ADMISSION_TIP = 'A';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
@@ -51,7 +55,8 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
     CDBBatch batch(&db.GetObfuscateKey());
     size_t count = 0;
     size_t changed = 0;
-    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
+    // mapCoins is left untouched, it may be read concurrently (see CCoinsViewFlusher)
+    for (CCoinsMap::const_iterator it = mapCoins.begin(); it != mapCoins.end(); it++) {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
             if (it->second.coins.IsPruned())
                 batch.Erase(make_pair(DB_COINS, it->first));
@@ -60,8 +65,6 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
             changed++;
         }
         count++;
-        CCoinsMap::iterator itOld = it++;
-        mapCoins.erase(itOld);
     }
     if (!hashBlock.IsNull())
         batch.Write(DB_BEST_BLOCK, hashBlock);
@@ -162,6 +165,49 @@ bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos>
     return WriteBatch(batch);
 }
 
+bool CBlockTreeDB::ReadCvnState(const uint256 &hashBlock, CCvnStateRecord &record) {
+    if (!Read(make_pair(DB_CVN_STATE, hashBlock), record))
+        return false;
+    return record.nRecordVersion == CCvnStateRecord::CURRENT_VERSION;
+}
+
+bool CBlockTreeDB::WriteCvnState(const uint256 &hashBlock, const CCvnStateRecord &record) {
+    return Write(make_pair(DB_CVN_STATE, hashBlock), record);
+}
+
+bool CBlockTreeDB::ReadCvnAdmissions(std::vector<CCvnAdmission> &vAdmissions, uint256 &hashBestBlock) {
+    if (!Read(DB_CVN_ADMISSION_TIP, hashBestBlock))
+        return false;
+
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(make_pair(DB_CVN_ADMISSION, 0));
+
+    while (pcursor->Valid()) {
+        std::pair<char, int> key;
+        if (!pcursor->GetKey(key) || key.first != DB_CVN_ADMISSION)
+            break;
+
+        CCvnAdmission admission;
+        if (!pcursor->GetValue(admission))
+            return error("%s : failed to read CVN admission", __func__);
+
+        vAdmissions.push_back(admission);
+        pcursor->Next();
+    }
+
+    return true;
+}
+
+bool CBlockTreeDB::WriteCvnAdmissions(const std::vector<CCvnAdmission> &vWrite, const std::vector<int> &vErase, const uint256 &hashBestBlock) {
+    CDBBatch batch(&GetObfuscateKey());
+    for (std::vector<int>::const_iterator it = vErase.begin(); it != vErase.end(); it++)
+        batch.Erase(make_pair(DB_CVN_ADMISSION, *it));
+    for (std::vector<CCvnAdmission>::const_iterator it = vWrite.begin(); it != vWrite.end(); it++)
+        batch.Write(make_pair(DB_CVN_ADMISSION, it->nHeight), *it);
+    batch.Write(DB_CVN_ADMISSION_TIP, hashBestBlock);
+    return WriteBatch(batch);
+}
+
 bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
     return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
 }
@@ -199,7 +245,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
                 pindexNew->hashPayload        = diskindex.hashPayload;
                 pindexNew->nTime              = diskindex.nTime;
                 pindexNew->nCreatorId         = diskindex.nCreatorId;
-                pindexNew->vMissingSignerIds  = diskindex.vMissingSignerIds;
+                pindexNew->SetMissingSignerIds(diskindex.vMissingSignerIds);
                 pindexNew->nStatus            = diskindex.nStatus;
                 pindexNew->nTx                = diskindex.nTx;
                 pindexNew->creatorSig         = diskindex.creatorSig;
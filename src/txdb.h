@@ -16,6 +16,8 @@
 
 class CBlockFileInfo;
 class CBlockIndex;
+class CCvnAdmission;
+class CCvnStateRecord;
 struct CDiskTxPos;
 class uint256;
 
@@ -57,6 +59,10 @@ public:
     bool ReadReindexing(bool &fReindex);
     bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &list);
+    bool ReadCvnState(const uint256 &hashBlock, CCvnStateRecord &record);
+    bool WriteCvnState(const uint256 &hashBlock, const CCvnStateRecord &record);
+    bool ReadCvnAdmissions(std::vector<CCvnAdmission> &vAdmissions, uint256 &hashBestBlock);
+    bool WriteCvnAdmissions(const std::vector<CCvnAdmission> &vWrite, const std::vector<int> &vErase, const uint256 &hashBestBlock);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts();
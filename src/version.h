@@ -9,7 +9,7 @@
  * network protocol versioning
  */
 
-static const int PROTOCOL_VERSION = 92001;
+static const int PROTOCOL_VERSION = 92003;
 
 //! initial proto version, to be increased after version/verack negotiation
 static const int INIT_PROTO_VERSION = 209;
@@ -17,4 +17,10 @@ static const int INIT_PROTO_VERSION = 209;
 //! disconnect from peers older than this proto version
 static const int MIN_PEER_PROTO_VERSION = 92000;
 
+//! "noncepooldelta" messages and MSG_CVN_PUB_NONCE_POOL_DELTA requests start with this version
+static const int NONCEPOOL_DELTA_VERSION = 92002;
+
+//! "cvnaddr" messages are sent to peers starting with this version
+static const int CVN_OVERLAY_VERSION = 92003;
+
 #endif // BITCOIN_VERSION_H